@@ -49,4 +49,23 @@ static void CCoinsCaching(benchmark::State& state)
     }
 }
 
+// Fill the cache with coins and flush it, which releases the memory of the
+// cache's pool in bulk, like the chainstate cache during IBD.
+static void CCoinsCachingFlush(benchmark::State& state)
+{
+    CCoinsView coinsDummy;
+    CCoinsViewCache coins(&coinsDummy);
+    const uint256 txid = uint256S("0x38fbcb1c2e9d2c2a51d5ca4bd0e7ee69d32b5fc3a2f8f0e5b1c1e3f1d1f0e3a5");
+    const CTxOut txout(50 * COIN, CScript() << OP_1);
+
+    while (state.KeepRunning()) {
+        for (uint32_t i = 0; i < 10000; ++i) {
+            coins.AddCoin(COutPoint(txid, i), Coin(txout, 1, false, false), false);
+        }
+        assert(coins.GetCacheSize() == 10000);
+        coins.Flush();
+    }
+}
+
 BENCHMARK(CCoinsCaching, 170 * 1000);
+BENCHMARK(CCoinsCachingFlush, 200);
@@ -5,6 +5,8 @@
 
 #include <chain.h>
 
+#include <memusage.h>
+
 /**
  * CChain implementation
  */
@@ -119,6 +121,19 @@ void CBlockIndex::BuildSkip()
         pskip = pprev->GetAncestor(GetSkipHeight(nHeight));
 }
 
+void CBlockIndex::BuildAlgoSkip()
+{
+    if (!pprev)
+        return;
+
+    const int algo = CBlockHeader::GetAlgoType(pprev->nVersion);
+    for (int i = 0; i < CBlockHeader::AlgoType::ALGO_COUNT; i++) {
+        pprevAlgo[i] = (algo == i) ? pprev : pprev->pprevAlgo[i];
+    }
+    pprevPoS = pprev->IsProofOfStake() ? pprev : pprev->pprevPoS;
+    pprevPoW = pprev->IsProofOfWork() ? pprev : pprev->pprevPoW;
+}
+
 arith_uint256 GetBlockProof(const CBlockIndex& block)
 {
     arith_uint256 bnTarget;
@@ -169,3 +184,122 @@ const CBlockIndex* LastCommonAncestor(const CBlockIndex* pa, const CBlockIndex*
     assert(pa == pb);
     return pa;
 }
+
+void CBlockIndex::SetStakeModifierV2(uint256 nModifier, bool fGeneratedStakeModifier)
+{
+    CBlockIndexColdData data;
+    data.nStakeModifierV2 = nModifier;
+    g_blockindex_cold.Put(this, data, CBlockIndexColdStore::FIELD_STAKE_MODIFIER_V2);
+    if (fGeneratedStakeModifier)
+        nFlags |= BLOCK_STAKE_MODIFIER | BLOCK_STAKE_MOD_V2;
+}
+
+uint256 CBlockIndex::GetStakeModifierV2() const
+{
+    if (!UsesStakeModifierV2()) return uint256();
+    return g_blockindex_cold.Get(this, CBlockIndexColdStore::FIELD_STAKE_MODIFIER_V2).nStakeModifierV2;
+}
+
+uint256 CBlockIndex::GetHashProofOfStake() const
+{
+    if (!IsProofOfStake()) return uint256();
+    return g_blockindex_cold.Get(this, CBlockIndexColdStore::FIELD_PROOF_OF_STAKE).hashProofOfStake;
+}
+
+void CBlockIndex::SetHashProofOfStake(const uint256& hashProofOfStake)
+{
+    CBlockIndexColdData data;
+    data.hashProofOfStake = hashProofOfStake;
+    g_blockindex_cold.Put(this, data, CBlockIndexColdStore::FIELD_PROOF_OF_STAKE);
+}
+
+int64_t CBlockIndex::GetTreasuryPayment() const
+{
+    if (!IsTreasuryBlock()) return 0;
+    return g_blockindex_cold.Get(this, CBlockIndexColdStore::FIELD_TREASURY_PAYMENT).nTreasuryPayment;
+}
+
+void CBlockIndex::SetTreasuryPayment(int64_t nTreasuryPayment)
+{
+    CBlockIndexColdData data;
+    data.nTreasuryPayment = nTreasuryPayment;
+    g_blockindex_cold.Put(this, data, CBlockIndexColdStore::FIELD_TREASURY_PAYMENT);
+}
+
+CDiskBlockIndex::CDiskBlockIndex(const CBlockIndex* pindex) : CBlockIndex(*pindex)
+{
+    hashPrev = (pprev ? pprev->GetBlockHash() : uint256());
+
+    // only the fields, which are serialized, are needed
+    uint8_t nFields = 0;
+    if (pindex->UsesStakeModifierV2()) nFields |= CBlockIndexColdStore::FIELD_STAKE_MODIFIER_V2;
+    if (pindex->IsProofOfStake()) nFields |= CBlockIndexColdStore::FIELD_PROOF_OF_STAKE;
+    if (pindex->IsTreasuryBlock()) nFields |= CBlockIndexColdStore::FIELD_TREASURY_PAYMENT;
+    cold = g_blockindex_cold.Get(pindex, nFields);
+}
+
+/**
+ * CBlockIndexColdStore implementation
+ */
+static void MergeColdData(CBlockIndexColdData& to, const CBlockIndexColdData& from, uint8_t nFields)
+{
+    if (nFields & CBlockIndexColdStore::FIELD_STAKE_MODIFIER_V2) to.nStakeModifierV2 = from.nStakeModifierV2;
+    if (nFields & CBlockIndexColdStore::FIELD_PROOF_OF_STAKE) to.hashProofOfStake = from.hashProofOfStake;
+    if (nFields & CBlockIndexColdStore::FIELD_TREASURY_PAYMENT) to.nTreasuryPayment = from.nTreasuryPayment;
+}
+
+CBlockIndexColdData CBlockIndexColdStore::Get(const CBlockIndex* pindex, uint8_t nFields) const
+{
+    CBlockIndexColdData data;
+    uint8_t nFieldsInTable = 0;
+    {
+        LOCK(cs_cold);
+        auto it = entries.find(pindex);
+        if (it != entries.end()) {
+            data = it->second.data;
+            nFieldsInTable = it->second.nFields;
+        }
+    }
+    if ((nFields & ~nFieldsInTable) == 0) return data;
+
+    // fields, which are not in the table, are unchanged since the entry was written
+    CBlockIndexColdData stored;
+    if (loader && pindex->phashBlock && loader(pindex->GetBlockHash(), stored)) {
+        MergeColdData(data, stored, nFields & ~nFieldsInTable);
+    }
+    return data;
+}
+
+void CBlockIndexColdStore::Put(const CBlockIndex* pindex, const CBlockIndexColdData& data, uint8_t nFields)
+{
+    LOCK(cs_cold);
+    Entry& entry = entries[pindex];
+    MergeColdData(entry.data, data, nFields);
+    entry.nFields |= nFields;
+}
+
+void CBlockIndexColdStore::Release(const std::vector<const CBlockIndex*>& vIndex)
+{
+    LOCK(cs_cold);
+    for (const CBlockIndex* pindex : vIndex) {
+        entries.erase(pindex);
+    }
+}
+
+void CBlockIndexColdStore::Clear()
+{
+    LOCK(cs_cold);
+    entries.clear();
+}
+
+size_t CBlockIndexColdStore::Size() const
+{
+    LOCK(cs_cold);
+    return entries.size();
+}
+
+size_t CBlockIndexColdStore::DynamicMemoryUsage() const
+{
+    LOCK(cs_cold);
+    return memusage::DynamicUsage(entries);
+}
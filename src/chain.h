@@ -10,11 +10,14 @@
 #include <consensus/params.h>
 #include <flatfile.h>
 #include <primitives/block.h>
+#include <sync.h>
 #include <tinyformat.h>
 #include <uint256.h>
 
 #include <util/moneystr.h>
 
+#include <functional>
+#include <unordered_map>
 #include <vector>
 
 /**
@@ -131,6 +134,14 @@ enum BlockStatus: uint32_t {
     BLOCK_OPT_WITNESS       =   128, //!< block data in blk*.data was received with a witness-enforcing client
 };
 
+/** Per-block proof-of-stake data, which is rarely read once a block is connected. */
+struct CBlockIndexColdData
+{
+    uint256 nStakeModifierV2{}; // hash modifier for proof-of-stake
+    uint256 hashProofOfStake{};
+    int64_t nTreasuryPayment{0};
+};
+
 /** The block chain is a tree shaped structure starting with the
  * genesis block at the root, with each block potentially having multiple
  * candidates to be the next block. A blockindex may have multiple pprev pointing
@@ -148,6 +159,13 @@ public:
     //! pointer to the index of some further predecessor of this block
     CBlockIndex* pskip{nullptr};
 
+    //! (memory only) pointers to the closest predecessor of each algo type (see CBlockHeader::GetAlgoType)
+    CBlockIndex* pprevAlgo[CBlockHeader::AlgoType::ALGO_COUNT]{};
+
+    //! (memory only) pointers to the closest proof-of-stake and proof-of-work predecessors of this block
+    CBlockIndex* pprevPoS{nullptr};
+    CBlockIndex* pprevPoW{nullptr};
+
     //! height of the entry in the chain. The genesis block has height 0
     int nHeight{0};
     int nHeightPoW{0};
@@ -194,10 +212,11 @@ public:
     // peercoin: money supply related block index fields
     int64_t nMint{0};
     int64_t nMoneySupply{0};
-    int64_t nTreasuryPayment{0};
 
     // peercoin: proof-of-stake related block index fields
+    // (the rarely used ones are kept in g_blockindex_cold, see CBlockIndexColdData)
     unsigned int nFlags{0}; // peercoin: block index flags
+    unsigned int nStakeModifierChecksum{0}; // checksum of index; in-memory only
     enum
     {
         BLOCK_PROOF_OF_STAKE = (1 << 0), // is proof-of-stake block
@@ -207,9 +226,6 @@ public:
         BLOCK_TREASURY_AWARD = (1 << 4), // is treasury payment block
     };
     uint64_t nStakeModifier{0}; // hash modifier for proof-of-stake
-    uint256 nStakeModifierV2{}; // hash modifier for proof-of-stake
-    unsigned int nStakeModifierChecksum{0}; // checksum of index; in-memory only
-    uint256 hashProofOfStake{};
 
     bool IsProofOfWork() const
     {
@@ -256,12 +272,14 @@ public:
             nFlags |= BLOCK_STAKE_MODIFIER;
     }
 
-    void SetStakeModifierV2(uint256 nModifier, bool fGeneratedStakeModifier)
-    {
-        nStakeModifierV2 = nModifier;
-        if (fGeneratedStakeModifier)
-            nFlags |= BLOCK_STAKE_MODIFIER | BLOCK_STAKE_MOD_V2;
-    }
+    void SetStakeModifierV2(uint256 nModifier, bool fGeneratedStakeModifier);
+    uint256 GetStakeModifierV2() const;
+
+    uint256 GetHashProofOfStake() const;
+    void SetHashProofOfStake(const uint256& hashProofOfStake);
+
+    int64_t GetTreasuryPayment() const;
+    void SetTreasuryPayment(int64_t nTreasuryPayment);
 // peercoin end
 
     bool IsTreasuryBlock() const
@@ -395,6 +413,9 @@ public:
     //! Build the skiplist pointer for this entry.
     void BuildSkip();
 
+    //! Build the per-algo and per-proof-type predecessor pointers for this entry.
+    void BuildAlgoSkip();
+
     //! Efficiently find an ancestor of this block.
     CBlockIndex* GetAncestor(int height);
     const CBlockIndex* GetAncestor(int height) const;
@@ -413,13 +434,13 @@ class CDiskBlockIndex : public CBlockIndex
 public:
     uint256 hashPrev;
 
+    CBlockIndexColdData cold;
+
     CDiskBlockIndex() {
         hashPrev = uint256();
     }
 
-    explicit CDiskBlockIndex(const CBlockIndex* pindex) : CBlockIndex(*pindex) {
-        hashPrev = (pprev ? pprev->GetBlockHash() : uint256());
-    }
+    explicit CDiskBlockIndex(const CBlockIndex* pindex);
 
     SERIALIZE_METHODS(CDiskBlockIndex, obj)
     {
@@ -439,15 +460,15 @@ public:
         READWRITE(obj.nMoneySupply);
         READWRITE(obj.nFlags);
         if (obj.UsesStakeModifierV2()) {
-            READWRITE(obj.nStakeModifierV2);
+            READWRITE(obj.cold.nStakeModifierV2);
         } else {
             READWRITE(obj.nStakeModifier);
         }
         if (obj.IsTreasuryBlock()) {
-            READWRITE(obj.nTreasuryPayment);
+            READWRITE(obj.cold.nTreasuryPayment);
         }
         if (obj.IsProofOfStake()) {
-            READWRITE(obj.hashProofOfStake);
+            READWRITE(obj.cold.hashProofOfStake);
         }
 
         // block header
@@ -483,6 +504,61 @@ public:
     }
 };
 
+/**
+ * Side table for the cold data of block index entries.
+ *
+ * Values, which were changed in memory and are not yet written to the block
+ * tree database, are kept here. Everything else is read back from the
+ * database when it is asked for, so the table stays small once the block
+ * index was flushed.
+ */
+class CBlockIndexColdStore
+{
+public:
+    //! Reads the cold data of a block from the database, returns false if the block is unknown
+    typedef std::function<bool(const uint256& hash, CBlockIndexColdData& data)> Loader;
+
+    enum : uint8_t
+    {
+        FIELD_STAKE_MODIFIER_V2 = (1 << 0),
+        FIELD_PROOF_OF_STAKE    = (1 << 1),
+        FIELD_TREASURY_PAYMENT  = (1 << 2),
+    };
+
+private:
+    struct Entry
+    {
+        CBlockIndexColdData data;
+        //! The fields of data, which were changed since the entry was written to the database
+        uint8_t nFields{0};
+    };
+
+    mutable Mutex cs_cold;
+    std::unordered_map<const CBlockIndex*, Entry> entries GUARDED_BY(cs_cold);
+    const Loader loader;
+
+public:
+    explicit CBlockIndexColdStore(Loader loaderIn) : loader(std::move(loaderIn)) {}
+
+    /** Returns the requested fields of an entry, reading them from the database, if they aren't in the table. */
+    CBlockIndexColdData Get(const CBlockIndex* pindex, uint8_t nFields) const;
+
+    /** Changes fields of an entry. They are kept until Release() is called for the entry. */
+    void Put(const CBlockIndex* pindex, const CBlockIndexColdData& data, uint8_t nFields);
+
+    /** Drops entries, which were written to the database. */
+    void Release(const std::vector<const CBlockIndex*>& vIndex);
+
+    /** Drops all entries, when the block index is unloaded. */
+    void Clear();
+
+    size_t Size() const;
+    size_t DynamicMemoryUsage() const;
+};
+
+/** The cold data of all block index entries, backed by the block tree database */
+extern CBlockIndexColdStore g_blockindex_cold;
+
 /** An in-memory indexed chain of blocks. */
 class CChain {
 private:
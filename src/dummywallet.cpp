@@ -40,6 +40,8 @@ void DummyWalletInit::AddWalletOptions() const
         "-rescan",
         "-salvagewallet",
         "-spendzeroconfchange",
+        "-staking",
+        "-stakingthreads=<n>",
         "-txconfirmtarget=<n>",
         "-upgradewallet",
         "-wallet=<path>",
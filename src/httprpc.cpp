@@ -30,6 +30,9 @@
 /** Sanitize UTF-8 encoded strings in RPC responses */
 static bool fSanitizeResponse = true;
 
+/** Maximum number of threads to execute a batch request */
+static unsigned int nBatchThreads = DEFAULT_HTTP_BATCH_THREADS;
+
 /** WWW-Authenticate to present with 401 Unauthorized response */
 static const char* WWW_AUTH_HEADER_DATA = "Basic realm=\"jsonrpc\"";
 
@@ -95,6 +98,50 @@ static void JSONErrorReply(HTTPRequest* req, const UniValue& objError, const Uni
     req->WriteReply(nStatus, strReply);
 }
 
+/**
+ * Reply of an RPC handler, which writes its result to a stream, sent as chunked HTTP reply.
+ *
+ * The HTTP status is only sent with the first chunk, which is handed over by the writer once
+ * its buffer is full. Until then, an error is replied as usual, with its own status.
+ */
+class HTTPRPCStreamReply
+{
+private:
+    HTTPRequest* req;
+    bool fStarted{false};
+
+    void WriteChunk(const std::string& strChunk)
+    {
+        if (!fStarted) {
+            req->WriteHeader("Content-Type", "application/json");
+            req->WriteReplyStart(HTTP_OK);
+            req->WriteReplyChunk("{\"result\":");
+            fStarted = true;
+        }
+        req->WriteReplyChunk(fSanitizeResponse ? mastercore::SanitizeInvalidUTF8(strChunk) : strChunk);
+    }
+
+public:
+    JSONStreamWriter writer;
+
+    explicit HTTPRPCStreamReply(HTTPRequest* reqIn) : req(reqIn), writer([this](const std::string& strChunk) { WriteChunk(strChunk); }) {}
+
+    /** Whether the status and a part of the result were already sent */
+    bool Started() const { return fStarted; }
+
+    /**
+     * Completes the reply. When failing after the result was partially sent, the
+     * open arrays and objects of the result are closed and the error is set as well.
+     */
+    void Finish(const UniValue& error, const UniValue& id)
+    {
+        writer.Close();
+        writer.Flush();
+        WriteChunk(",\"error\":" + error.write() + ",\"id\":" + id.write() + "}\n");
+        req->WriteReplyEnd();
+    }
+};
+
 //This function checks username and password against -rpcauth
 //entries from config file.
 static bool multiUserAuthorized(std::string strUserPass)
@@ -186,6 +233,7 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         return false;
     }
 
+    HTTPRPCStreamReply streamReply(req);
     try {
         // Parse request
         UniValue valRequest;
@@ -210,7 +258,12 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
                 req->WriteReply(HTTP_FORBIDDEN);
                 return false;
             }
+            jreq.stream = &streamReply.writer;
             UniValue result = tableRPC.execute(jreq);
+            if (streamReply.writer.HasOutput()) {
+                streamReply.Finish(NullUniValue, jreq.id);
+                return true;
+            }
 
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
@@ -236,7 +289,7 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
                     }
                 }
             }
-            strReply = JSONRPCExecBatch(jreq, valRequest.get_array());
+            strReply = JSONRPCExecBatch(jreq, valRequest.get_array(), QueueHTTPTask, nBatchThreads);
         }
         else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
@@ -244,10 +297,18 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         req->WriteHeader("Content-Type", "application/json");
         req->WriteReply(HTTP_OK, strReply);
     } catch (const UniValue& objError) {
-        JSONErrorReply(req, objError, jreq.id);
+        if (streamReply.Started()) {
+            streamReply.Finish(objError, jreq.id);
+        } else {
+            JSONErrorReply(req, objError, jreq.id);
+        }
         return false;
     } catch (const std::exception& e) {
-        JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
+        if (streamReply.Started()) {
+            streamReply.Finish(JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
+        } else {
+            JSONErrorReply(req, JSONRPCError(RPC_PARSE_ERROR, e.what()), jreq.id);
+        }
         return false;
     }
     return true;
@@ -305,6 +366,8 @@ bool StartHTTPRPC()
     // Sanitize non-UTF8 compliant RPC responses
     fSanitizeResponse = gArgs.GetBoolArg("-rpcforceutf8", true);
 
+    nBatchThreads = std::max((long)gArgs.GetArg("-rpcbatchthreads", DEFAULT_HTTP_BATCH_THREADS), 1L);
+
     RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
     if (g_wallet_init_interface.HasWalletSupport()) {
         RegisterHTTPHandler("/wallet/", false, HTTPReq_JSONRPC);
@@ -15,6 +15,8 @@
 #include <sync.h>
 #include <ui_interface.h>
 
+#include <chrono>
+#include <condition_variable>
 #include <deque>
 #include <memory>
 #include <stdio.h>
@@ -62,6 +64,22 @@ private:
     HTTPRequestHandler func;
 };
 
+/** Work item of a task queued by another module */
+class HTTPTaskItem final : public HTTPClosure
+{
+public:
+    explicit HTTPTaskItem(const std::function<void()>& _task): task(_task)
+    {
+    }
+    void operator()() override
+    {
+        task();
+    }
+
+private:
+    std::function<void()> task;
+};
+
 /** Simple work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
  */
@@ -86,11 +104,11 @@ public:
     ~WorkQueue()
     {
     }
-    /** Enqueue a work item */
-    bool Enqueue(WorkItem* item)
+    /** Enqueue a work item, background items may only fill up half of the queue */
+    bool Enqueue(WorkItem* item, bool fBackground = false)
     {
         LOCK(cs);
-        if (queue.size() >= maxDepth) {
+        if (queue.size() >= (fBackground ? maxDepth / 2 : maxDepth)) {
             return false;
         }
         queue.emplace_back(std::unique_ptr<WorkItem>(item));
@@ -134,6 +152,17 @@ struct HTTPPathHandler
     HTTPRequestHandler handler;
 };
 
+/** Flow control of a chunked reply, shared between the worker writing it and the event loop */
+struct HTTPReplyStream
+{
+    Mutex cs;
+    std::condition_variable cond;
+    //! Chunks handed to libevent, which are not yet completely sent
+    int nChunksPending GUARDED_BY(cs){0};
+    //! Whether the connection was closed, which frees the request; only used by the event loop
+    bool fClosed{false};
+};
+
 /** HTTP module state */
 
 //! libevent event loop
@@ -484,6 +513,16 @@ struct event_base* EventBase()
     return eventBase;
 }
 
+bool QueueHTTPTask(const std::function<void()>& task)
+{
+    if (!workQueue) return false;
+    std::unique_ptr<HTTPTaskItem> item(new HTTPTaskItem(task));
+    if (!workQueue->Enqueue(item.get(), true /* fBackground */))
+        return false;
+    item.release(); /* queue took ownership */
+    return true;
+}
+
 static void httpevent_callback_fn(evutil_socket_t, short, void* data)
 {
     // Static handler: simply call inner handler
@@ -516,7 +555,9 @@ HTTPRequest::HTTPRequest(struct evhttp_request* _req, bool _replySent) : req(_re
 
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (!replySent && stream) {
+        WriteReplyEnd();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL_SERVER_ERROR, "Unhandled request");
@@ -569,7 +610,7 @@ void HTTPRequest::WriteHeader(const std::string& hdr, const std::string& value)
  */
 void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
 {
-    assert(!replySent && req);
+    assert(!replySent && !stream && req);
     if (ShutdownRequested()) {
         WriteHeader("Connection", "close");
     }
@@ -597,6 +638,101 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = nullptr; // transferred back to main thread
 }
 
+/** Called by libevent, once all chunks handed to it so far are sent */
+static void http_reply_chunk_cb(struct evhttp_connection* conn, void* arg)
+{
+    HTTPReplyStream* stream = static_cast<HTTPReplyStream*>(arg);
+    LOCK(stream->cs);
+    stream->nChunksPending = 0;
+    stream->cond.notify_all();
+}
+
+/** Called by libevent, when the connection of a chunked reply is closed before the reply is finished */
+static void http_reply_close_cb(struct evhttp_connection* conn, void* arg)
+{
+    HTTPReplyStream* stream = static_cast<HTTPReplyStream*>(arg);
+    stream->fClosed = true;
+    LOCK(stream->cs);
+    stream->nChunksPending = 0;
+    stream->cond.notify_all();
+}
+
+void HTTPRequest::WriteReplyStart(int nStatus)
+{
+    assert(!replySent && !stream && req);
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    stream = std::make_shared<HTTPReplyStream>();
+    auto req_copy = req;
+    auto stream_copy = stream;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, stream_copy, nStatus]{
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            evhttp_connection_set_closecb(conn, http_reply_close_cb, stream_copy.get());
+        }
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::WriteReplyChunk(const std::string& strChunk)
+{
+    assert(!replySent && stream && req);
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+    {
+        // Wait for the client, but not beyond shutdown; libevent closes stalled connections after -rpcservertimeout
+        WAIT_LOCK(stream->cs, lock);
+        while (stream->nChunksPending > 1 && !ShutdownRequested()) {
+            stream->cond.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        ++stream->nChunksPending;
+    }
+#endif
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, strChunk.data(), strChunk.size());
+    auto req_copy = req;
+    auto stream_copy = stream;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, stream_copy, evb]{
+        if (!stream_copy->fClosed) {
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+            evhttp_send_reply_chunk_with_cb(req_copy, evb, http_reply_chunk_cb, stream_copy.get());
+#else
+            evhttp_send_reply_chunk(req_copy, evb);
+#endif
+        }
+        evbuffer_free(evb);
+    });
+    ev->trigger(nullptr);
+}
+
+void HTTPRequest::WriteReplyEnd()
+{
+    assert(!replySent && stream && req);
+    auto req_copy = req;
+    auto stream_copy = stream;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [req_copy, stream_copy]{
+        if (stream_copy->fClosed) return;
+        evhttp_connection* conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            evhttp_connection_set_closecb(conn, nullptr, nullptr);
+            // Re-enable reading from the socket, as in WriteReply(). This is done
+            // first, because the request may be freed by the time the call returns.
+            if (event_get_version_number() >= 0x02010600 && event_get_version_number() < 0x02020001) {
+                bufferevent* bev = evhttp_connection_get_bufferevent(conn);
+                if (bev) {
+                    bufferevent_enable(bev, EV_READ | EV_WRITE);
+                }
+            }
+        }
+        evhttp_send_reply_end(req_copy);
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer() const
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
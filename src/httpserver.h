@@ -7,15 +7,18 @@
 
 #include <string>
 #include <functional>
+#include <memory>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
+static const int DEFAULT_HTTP_BATCH_THREADS=4;
 
 struct evhttp_request;
 struct event_base;
 class CService;
 class HTTPRequest;
+struct HTTPReplyStream;
 
 /** Initialize HTTP server.
  * Call this before RegisterHTTPHandler or EventBase().
@@ -50,6 +53,12 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
  */
 struct event_base* EventBase();
 
+/** Queue a task on the HTTP work queue, to be run by one of the worker threads.
+ * Tasks can only fill up half of the queue, so that they don't crowd out requests.
+ * Returns false, if the task was not queued.
+ */
+bool QueueHTTPTask(const std::function<void()>& task);
+
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
@@ -58,6 +67,8 @@ class HTTPRequest
 private:
     struct evhttp_request* req;
     bool replySent;
+    //! Flow control of a chunked reply, once started
+    std::shared_ptr<HTTPReplyStream> stream;
 
 public:
     explicit HTTPRequest(struct evhttp_request* req, bool replySent = false);
@@ -113,6 +124,29 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a chunked HTTP reply, for replies written piece by piece.
+     * nStatus is the HTTP status code to send.
+     *
+     * @note Call WriteReplyChunk() for the body and WriteReplyEnd() to finish
+     * the reply, instead of WriteReply().
+     */
+    void WriteReplyStart(int nStatus);
+
+    /**
+     * Write a chunk of a chunked reply. Blocks, while the previous chunks are
+     * not yet sent to the client, so that no more than two chunks are buffered.
+     */
+    void WriteReplyChunk(const std::string& strChunk);
+
+    /**
+     * Finish a chunked reply.
+     *
+     * @note As this will give the request back to the main thread, do not call
+     * any other HTTPRequest methods after calling this.
+     */
+    void WriteReplyEnd();
 };
 
 /** Event handler closure.
@@ -0,0 +1,405 @@
+// Copyright (c) 2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <index/addressindex.h>
+
+#include <chainparams.h>
+#include <coins.h>
+#include <script/standard.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+#include <map>
+
+#include <boost/thread.hpp>
+
+constexpr char DB_ADDRESSINDEX = 'a';
+constexpr char DB_ADDRESSUNSPENTINDEX = 'u';
+constexpr char DB_ADDRESSBALANCE = 'b';
+constexpr char DB_SPENTINDEX = 'p';
+constexpr char DB_TIMESTAMPINDEX = 'S';
+constexpr char DB_BLOCKHASHINDEX = 'z';
+constexpr char DB_INDEX_TIP = 'T';
+
+std::unique_ptr<AddressIndex> g_addressindex;
+
+namespace {
+
+typedef std::pair<unsigned int, uint256> AddressKey;
+
+/** Extracts the address type and the zero padded address hash of a script, as used in the index keys. */
+bool GetAddressKey(const CScript& script, AddressKey& key)
+{
+    CTxDestination dest;
+    if (!ExtractDestination(script, dest)) {
+        return false;
+    }
+    std::vector<unsigned char> bytesID(boost::apply_visitor(DataVisitor(), dest));
+    if (bytesID.empty()) {
+        return false;
+    }
+    std::vector<unsigned char> addressBytes(32);
+    std::copy(bytesID.begin(), bytesID.end(), addressBytes.begin());
+    key = std::make_pair(dest.which(), uint256(addressBytes));
+    return true;
+}
+
+/** Changes of the running totals of the addresses touched by a block. */
+typedef std::map<AddressKey, CAddressBalance> BalanceChanges;
+
+void AddBalanceChange(BalanceChanges& changes, const AddressKey& key, CAmount nDelta, bool fConnect)
+{
+    CAddressBalance& change = changes[key];
+    const CAmount nReceived = nDelta > 0 ? nDelta : 0;
+    change.nBalance += fConnect ? nDelta : -nDelta;
+    change.nReceived += fConnect ? nReceived : -nReceived;
+}
+
+} // namespace
+
+/**
+ * Access to the address index database (indexes/addressindex/)
+ *
+ * Besides the block locator of BaseIndex, the database stores the hash of the
+ * last block whose entries were written, in the same batch as the entries. This
+ * is the block the running balances correspond to.
+ */
+class AddressIndex::DB : public BaseIndex::DB
+{
+public:
+    explicit DB(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    /// Add the entries of a connected block to the batch, or remove them when disconnecting.
+    bool WriteBlockEntries(CDBBatch& batch, const CBlock& block, const CBlockUndo& block_undo,
+                           const CBlockIndex* pindex, bool fConnect) const;
+
+    /// Add the logical timestamp of a connected block to the batch.
+    void WriteTimestamp(CDBBatch& batch, const CBlockIndex* pindex) const;
+
+    bool ReadIndexTip(uint256& hash) const;
+    void WriteIndexTip(CDBBatch& batch, const uint256& hash);
+
+    bool IsBlockOnActiveChain(const uint256& hash) const;
+};
+
+AddressIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe) :
+    BaseIndex::DB(GetDataDir() / "indexes" / "addressindex", n_cache_size, f_memory, f_wipe)
+{}
+
+bool AddressIndex::DB::WriteBlockEntries(CDBBatch& batch, const CBlock& block, const CBlockUndo& block_undo,
+                                         const CBlockIndex* pindex, bool fConnect) const
+{
+    if (pindex->nHeight > 0 && block_undo.vtxundo.size() + 1 != block.vtx.size()) {
+        return error("%s: block %s and undo data inconsistent", __func__, pindex->GetBlockHash().ToString());
+    }
+
+    BalanceChanges changes;
+    AddressKey key;
+
+    // entries are added in the order of the block when connecting, and in
+    // reverse order when disconnecting, so that an output created and spent
+    // within the same block ends up without an unspent entry either way
+    for (size_t n = 0; n < block.vtx.size(); n++) {
+        const size_t i = fConnect ? n : block.vtx.size() - 1 - n;
+        const CTransaction& tx = *block.vtx[i];
+        const uint256 txid = tx.GetHash();
+
+        if (!fConnect) {
+            for (unsigned int k = tx.vout.size(); k-- > 0;) {
+                const CTxOut& out = tx.vout[k];
+                if (!GetAddressKey(out.scriptPubKey, key)) continue;
+                batch.Erase(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(key.first, key.second, pindex->nHeight, i, txid, k, false)));
+                batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(key.first, key.second, txid, k)));
+                AddBalanceChange(changes, key, out.nValue, false);
+            }
+        }
+
+        if (!tx.IsCoinBase()) {
+            const CTxUndo& txundo = block_undo.vtxundo[i - 1];
+            if (txundo.vprevout.size() != tx.vin.size()) {
+                return error("%s: transaction %s and undo data inconsistent", __func__, txid.ToString());
+            }
+            for (size_t j = 0; j < tx.vin.size(); j++) {
+                const COutPoint& prevout = tx.vin[j].prevout;
+                const Coin& coin = txundo.vprevout[j];
+                if (!GetAddressKey(coin.out.scriptPubKey, key)) continue;
+                const CAddressIndexKey addressKey(key.first, key.second, pindex->nHeight, i, txid, j, true);
+                const CAddressUnspentKey unspentKey(key.first, key.second, prevout.hash, prevout.n);
+                const CSpentIndexKey spentKey(prevout.hash, prevout.n);
+                if (fConnect) {
+                    batch.Write(std::make_pair(DB_ADDRESSINDEX, addressKey), coin.out.nValue * -1);
+                    batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, unspentKey));
+                    batch.Write(std::make_pair(DB_SPENTINDEX, spentKey), CSpentIndexValue(txid, j, pindex->nHeight, coin.out.nValue, key.first, key.second));
+                } else {
+                    batch.Erase(std::make_pair(DB_ADDRESSINDEX, addressKey));
+                    batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, unspentKey), CAddressUnspentValue(coin.out.nValue, coin.out.scriptPubKey, coin.nHeight, coin.fCoinBase));
+                    batch.Erase(std::make_pair(DB_SPENTINDEX, spentKey));
+                }
+                AddBalanceChange(changes, key, coin.out.nValue * -1, fConnect);
+            }
+        }
+
+        if (fConnect) {
+            for (unsigned int k = 0; k < tx.vout.size(); k++) {
+                const CTxOut& out = tx.vout[k];
+                if (!GetAddressKey(out.scriptPubKey, key)) continue;
+                batch.Write(std::make_pair(DB_ADDRESSINDEX, CAddressIndexKey(key.first, key.second, pindex->nHeight, i, txid, k, false)), out.nValue);
+                batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressUnspentKey(key.first, key.second, txid, k)), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight, tx.IsCoinBase()));
+                AddBalanceChange(changes, key, out.nValue, true);
+            }
+        }
+    }
+
+    for (const auto& change : changes) {
+        const auto dbKey = std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(change.first.first, change.first.second));
+        CAddressBalance balance;
+        if (!Read(dbKey, balance) && Exists(dbKey)) {
+            return error("%s: failed to read address balance", __func__);
+        }
+        balance.nBalance += change.second.nBalance;
+        balance.nReceived += change.second.nReceived;
+        if (balance.IsNull()) {
+            batch.Erase(dbKey);
+        } else {
+            batch.Write(dbKey, balance);
+        }
+    }
+
+    return true;
+}
+
+void AddressIndex::DB::WriteTimestamp(CDBBatch& batch, const CBlockIndex* pindex) const
+{
+    unsigned int logicalTS = pindex->nTime;
+    CTimestampBlockIndexValue prevLogicalTS;
+
+    // retrieve logical timestamp of the previous block
+    if (pindex->pprev && !Read(std::make_pair(DB_BLOCKHASHINDEX, CTimestampBlockIndexKey(pindex->pprev->GetBlockHash())), prevLogicalTS)) {
+        LogPrintf("%s: Failed to read previous block's logical timestamp\n", __func__);
+    }
+
+    if (logicalTS <= prevLogicalTS.ltimestamp) {
+        logicalTS = prevLogicalTS.ltimestamp + 1;
+        LogPrintf("%s: Previous logical timestamp is newer Actual[%d] prevLogical[%d] Logical[%d]\n", __func__, pindex->nTime, prevLogicalTS.ltimestamp, logicalTS);
+    }
+
+    batch.Write(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexKey(logicalTS, pindex->GetBlockHash())), 0);
+    batch.Write(std::make_pair(DB_BLOCKHASHINDEX, CTimestampBlockIndexKey(pindex->GetBlockHash())), CTimestampBlockIndexValue(logicalTS));
+}
+
+bool AddressIndex::DB::ReadIndexTip(uint256& hash) const
+{
+    return Read(DB_INDEX_TIP, hash);
+}
+
+void AddressIndex::DB::WriteIndexTip(CDBBatch& batch, const uint256& hash)
+{
+    batch.Write(DB_INDEX_TIP, hash);
+}
+
+bool AddressIndex::DB::IsBlockOnActiveChain(const uint256& hash) const
+{
+    LOCK(cs_main);
+    const CBlockIndex* pindex = LookupBlockIndex(hash);
+    return pindex && ::ChainActive().Contains(pindex);
+}
+
+AddressIndex::AddressIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+    : m_db(MakeUnique<AddressIndex::DB>(n_cache_size, f_memory, f_wipe))
+{}
+
+AddressIndex::~AddressIndex() {}
+
+bool AddressIndex::Init()
+{
+    // The locator of BaseIndex is only written from time to time and may
+    // lag behind the entries, or point to a block that has since been
+    // reorganized away. Roll back to the active chain and point the locator
+    // to the block the entries correspond to.
+    uint256 hash;
+    if (m_db->ReadIndexTip(hash)) {
+        const CBlockIndex* pindex;
+        const CBlockIndex* pindex_fork;
+        {
+            LOCK(cs_main);
+            pindex = LookupBlockIndex(hash);
+            if (!pindex) {
+                return error("%s: best block %s of %s not found", __func__, hash.ToString(), GetName());
+            }
+            pindex_fork = ::ChainActive().FindFork(pindex);
+        }
+        if (!pindex_fork) {
+            return error("%s: best block %s of %s has no common ancestor with the active chain", __func__, hash.ToString(), GetName());
+        }
+        if (pindex_fork != pindex) {
+            LogPrintf("%s: rolling back %s from height %d to %d\n", __func__, GetName(), pindex->nHeight, pindex_fork->nHeight);
+            if (!DisconnectBlocks(pindex, pindex_fork)) {
+                return false;
+            }
+        }
+
+        CDBBatch batch(*m_db);
+        {
+            LOCK(cs_main);
+            m_db->WriteBestBlock(batch, ::ChainActive().GetLocator(pindex_fork));
+        }
+        if (!m_db->WriteBatch(batch)) {
+            return error("%s: failed to write locator of %s", __func__, GetName());
+        }
+    }
+
+    return BaseIndex::Init();
+}
+
+bool AddressIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    CBlockUndo block_undo;
+    if (pindex->nHeight > 0 && !UndoReadFromDisk(block_undo, pindex)) {
+        return false;
+    }
+
+    CDBBatch batch(*m_db);
+    if (!m_db->WriteBlockEntries(batch, block, block_undo, pindex, true)) {
+        return false;
+    }
+    m_db->WriteTimestamp(batch, pindex);
+    m_db->WriteIndexTip(batch, pindex->GetBlockHash());
+    return m_db->WriteBatch(batch);
+}
+
+bool AddressIndex::DisconnectBlocks(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+
+    // one block per batch, as the balances of each block are computed from the previous ones
+    for (const CBlockIndex* pindex = current_tip; pindex != new_tip; pindex = pindex->pprev) {
+        CBlock block;
+        CBlockUndo block_undo;
+        if (!ReadBlockFromDisk(block, pindex, consensus_params)) {
+            return error("%s: failed to read block %s from disk", __func__, pindex->GetBlockHash().ToString());
+        }
+        if (pindex->nHeight > 0 && !UndoReadFromDisk(block_undo, pindex)) {
+            return error("%s: failed to read undo data of block %s", __func__, pindex->GetBlockHash().ToString());
+        }
+
+        // The timestamp entries of disconnected blocks are kept, they can be
+        // filtered with the noOrphans option of getblockhashes.
+        CDBBatch batch(*m_db);
+        if (!m_db->WriteBlockEntries(batch, block, block_undo, pindex, false)) {
+            return false;
+        }
+        m_db->WriteIndexTip(batch, pindex->pprev->GetBlockHash());
+        if (!m_db->WriteBatch(batch)) {
+            return error("%s: failed to write %s entries", __func__, GetName());
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    if (!DisconnectBlocks(current_tip, new_tip)) {
+        return false;
+    }
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+BaseIndex::DB& AddressIndex::GetDB() const { return *m_db; }
+
+bool AddressIndex::ReadAddressIndex(const uint256& addressHash, int type,
+                                    std::vector<std::pair<CAddressIndexKey, CAmount>>& addressIndex,
+                                    int start, int end) const
+{
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+
+    if (start > 0 && end > 0) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
+    } else {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
+    }
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CAddressIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSINDEX && key.second.type == (unsigned int)type && key.second.hashBytes == addressHash) {
+            if (end > 0 && key.second.blockHeight > end) {
+                break;
+            }
+            CAmount nValue;
+            if (pcursor->GetValue(nValue)) {
+                addressIndex.push_back(std::make_pair(key.second, nValue));
+                pcursor->Next();
+            } else {
+                return error("failed to get address index value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::ReadAddressUnspentIndex(const uint256& addressHash, int type,
+                                           std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& unspentOutputs) const
+{
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+    pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CAddressUnspentKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.type == (unsigned int)type && key.second.hashBytes == addressHash) {
+            CAddressUnspentValue nValue;
+            if (pcursor->GetValue(nValue)) {
+                unspentOutputs.push_back(std::make_pair(key.second, nValue));
+                pcursor->Next();
+            } else {
+                return error("failed to get address unspent value");
+            }
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool AddressIndex::ReadAddressBalance(const uint256& addressHash, int type, CAddressBalance& balance) const
+{
+    const auto key = std::make_pair(DB_ADDRESSBALANCE, CAddressIndexIteratorKey(type, addressHash));
+    balance = CAddressBalance();
+    return m_db->Read(key, balance) || !m_db->Exists(key);
+}
+
+bool AddressIndex::ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value) const
+{
+    return m_db->Read(std::make_pair(DB_SPENTINDEX, key), value);
+}
+
+bool AddressIndex::ReadTimestampIndex(unsigned int high, unsigned int low, bool fActiveOnly,
+                                      std::vector<std::pair<uint256, unsigned int>>& hashes) const
+{
+    std::unique_ptr<CDBIterator> pcursor(m_db->NewIterator());
+    pcursor->Seek(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(low)));
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, CTimestampIndexKey> key;
+        if (pcursor->GetKey(key) && key.first == DB_TIMESTAMPINDEX && key.second.timestamp < high) {
+            if (!fActiveOnly || m_db->IsBlockOnActiveChain(key.second.blockHash)) {
+                hashes.push_back(std::make_pair(key.second.blockHash, key.second.timestamp));
+            }
+            pcursor->Next();
+        } else {
+            break;
+        }
+    }
+
+    return true;
+}
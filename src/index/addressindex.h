@@ -0,0 +1,105 @@
+// Copyright (c) 2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef XEP_INDEX_ADDRESSINDEX_H
+#define XEP_INDEX_ADDRESSINDEX_H
+
+#include <amount.h>
+#include <chain.h>
+#include <index/base.h>
+#include <serialize.h>
+
+#include <utility>
+#include <vector>
+
+struct CAddressIndexKey;
+struct CAddressUnspentKey;
+struct CAddressUnspentValue;
+struct CSpentIndexKey;
+struct CSpentIndexValue;
+class uint256;
+
+/** Running totals of an address, as kept by the address index */
+struct CAddressBalance
+{
+    //! Sum of all deltas, i.e. the value of the unspent outputs
+    CAmount nBalance{0};
+    //! Sum of all positive deltas, including change
+    CAmount nReceived{0};
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(nBalance);
+        READWRITE(nReceived);
+    }
+
+    bool IsNull() const { return nBalance == 0 && nReceived == 0; }
+};
+
+/**
+ * AddressIndex maintains the address, unspent, spent and timestamp indexes
+ * (-experimental-xep-balances) in its own database, along with the running
+ * balance and received total of every address.
+ *
+ * The index is built in the background and can be enabled or rebuilt at any
+ * time. Balances are updated in the same batch as the block's entries, and the
+ * last block written is stored alongside them, so that a block is never
+ * counted twice after an unclean shutdown.
+ */
+class AddressIndex final : public BaseIndex
+{
+protected:
+    class DB;
+
+private:
+    const std::unique_ptr<DB> m_db;
+
+    /// Undo the entries of all blocks from current_tip down to, but excluding, new_tip.
+    bool DisconnectBlocks(const CBlockIndex* current_tip, const CBlockIndex* new_tip);
+
+protected:
+    /// Override base class init to roll back blocks not on the active chain.
+    bool Init() override;
+
+    bool WriteBlock(const CBlock& block, const CBlockIndex* pindex) override;
+
+    bool Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip) override;
+
+    BaseIndex::DB& GetDB() const override;
+
+    const char* GetName() const override { return "addressindex"; }
+
+public:
+    /// Constructs the index, which becomes available to be queried.
+    explicit AddressIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+
+    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    virtual ~AddressIndex() override;
+
+    /// Look up the deltas of an address, optionally restricted to a range of block heights.
+    bool ReadAddressIndex(const uint256& addressHash, int type,
+                          std::vector<std::pair<CAddressIndexKey, CAmount>>& addressIndex,
+                          int start = 0, int end = 0) const;
+
+    /// Look up the unspent outputs of an address.
+    bool ReadAddressUnspentIndex(const uint256& addressHash, int type,
+                                 std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& unspentOutputs) const;
+
+    /// Look up the running totals of an address. Unknown addresses have a zero balance.
+    bool ReadAddressBalance(const uint256& addressHash, int type, CAddressBalance& balance) const;
+
+    /// Look up the input spending an output.
+    bool ReadSpentIndex(const CSpentIndexKey& key, CSpentIndexValue& value) const;
+
+    /// Look up the blocks with a logical timestamp in [low, high).
+    bool ReadTimestampIndex(unsigned int high, unsigned int low, bool fActiveOnly,
+                            std::vector<std::pair<uint256, unsigned int>>& hashes) const;
+};
+
+/// The global address index, used by the address RPCs. May be null.
+extern std::unique_ptr<AddressIndex> g_addressindex;
+
+#endif // XEP_INDEX_ADDRESSINDEX_H
@@ -31,6 +31,12 @@ constexpr char DB_FILTER_POS = 'P';
 constexpr unsigned int MAX_FLTR_FILE_SIZE = 0x1000000; // 16 MiB
 /** The pre-allocation chunk size for fltr?????.dat files */
 constexpr unsigned int FLTR_FILE_CHUNK_SIZE = 0x100000; // 1 MiB
+/** Maximum size of the cfheaders cache
+ *  We have a limit to prevent a bug in filling this cache
+ *  potentially turning into an OOM. At 2000 entries, this cache
+ *  is big enough for a 2,000,000 length block chain, which
+ *  we should be enough until ~2047. */
+constexpr size_t CF_HEADERS_CACHE_MAX_SZ{2000};
 
 namespace {
 
@@ -146,24 +152,33 @@ bool BlockFilterIndex::CommitInternal(CDBBatch& batch)
     return BaseIndex::CommitInternal(batch);
 }
 
-bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos& pos, BlockFilter& filter) const
+/** Read the filter at the current position of an open filter file and return its size on disk. */
+static size_t ReadFilterFromFile(CAutoFile& filein, BlockFilterType filter_type, BlockFilter& filter)
 {
-    CAutoFile filein(m_filter_fileseq->Open(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return false;
-    }
-
     uint256 block_hash;
     std::vector<unsigned char> encoded_filter;
     try {
         filein >> block_hash >> encoded_filter;
-        filter = BlockFilter(GetFilterType(), block_hash, std::move(encoded_filter));
     }
     catch (const std::exception& e) {
-        return error("%s: Failed to deserialize block filter from disk: %s", __func__, e.what());
+        error("%s: Failed to deserialize block filter from disk: %s", __func__, e.what());
+        return 0;
     }
 
-    return true;
+    size_t data_size = GetSerializeSize(block_hash, CLIENT_VERSION) +
+                       GetSerializeSize(encoded_filter, CLIENT_VERSION);
+    filter = BlockFilter(filter_type, block_hash, std::move(encoded_filter));
+    return data_size;
+}
+
+bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos& pos, BlockFilter& filter) const
+{
+    CAutoFile filein(m_filter_fileseq->Open(pos, true), SER_DISK, CLIENT_VERSION);
+    if (filein.IsNull()) {
+        return false;
+    }
+
+    return ReadFilterFromFile(filein, GetFilterType(), filter) > 0;
 }
 
 size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos& pos, const BlockFilter& filter)
@@ -389,11 +404,30 @@ bool BlockFilterIndex::LookupFilter(const CBlockIndex* block_index, BlockFilter&
 
 bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out) const
 {
+    LOCK(m_cs_headers_cache);
+
+    bool is_checkpoint{block_index->nHeight % CFCHECKPT_INTERVAL == 0};
+
+    if (is_checkpoint) {
+        // Try to find the block in the headers cache if this is a checkpoint height.
+        auto header = m_headers_cache.find(block_index->GetBlockHash());
+        if (header != m_headers_cache.end()) {
+            header_out = header->second;
+            return true;
+        }
+    }
+
     DBVal entry;
     if (!LookupOne(*m_db, block_index, entry)) {
         return false;
     }
 
+    if (is_checkpoint &&
+        m_headers_cache.size() < CF_HEADERS_CACHE_MAX_SZ) {
+        // Add to the headers cache if this is a checkpoint height.
+        m_headers_cache.emplace(block_index->GetBlockHash(), entry.header);
+    }
+
     header_out = entry.header;
     return true;
 }
@@ -408,10 +442,24 @@ bool BlockFilterIndex::LookupFilterRange(int start_height, const CBlockIndex* st
 
     filters_out.resize(entries.size());
     auto filter_pos_it = filters_out.begin();
+
+    // Filters of consecutive blocks are usually written next to each other, so keep the file open
+    // and only reopen it when the next filter is in another file or not at the current offset.
+    std::unique_ptr<CAutoFile> filein;
+    FlatFilePos next_pos;
     for (const auto& entry : entries) {
-        if (!ReadFilterFromDisk(entry.pos, *filter_pos_it)) {
+        if (!filein || entry.pos.nFile != next_pos.nFile || entry.pos.nPos != next_pos.nPos) {
+            filein = MakeUnique<CAutoFile>(m_filter_fileseq->Open(entry.pos, true), SER_DISK, CLIENT_VERSION);
+            if (filein->IsNull()) {
+                return false;
+            }
+        }
+
+        size_t data_size = ReadFilterFromFile(*filein, GetFilterType(), *filter_pos_it);
+        if (data_size == 0) {
             return false;
         }
+        next_pos = FlatFilePos(entry.pos.nFile, entry.pos.nPos + data_size);
         ++filter_pos_it;
     }
 
@@ -7,8 +7,20 @@
 
 #include <blockfilter.h>
 #include <chain.h>
+#include <crypto/common.h>
 #include <flatfile.h>
 #include <index/base.h>
+#include <sync.h>
+
+#include <unordered_map>
+
+/** Interval between compact filter checkpoints. See BIP 157. */
+static constexpr int CFCHECKPT_INTERVAL = 1000;
+
+struct FilterHeaderHasher
+{
+    size_t operator()(const uint256& hash) const { return ReadLE64(hash.begin()); }
+};
 
 /**
  * BlockFilterIndex is used to store and retrieve block filters, hashes, and headers for a range of
@@ -30,6 +42,10 @@ private:
     bool ReadFilterFromDisk(const FlatFilePos& pos, BlockFilter& filter) const;
     size_t WriteFilterToDisk(FlatFilePos& pos, const BlockFilter& filter);
 
+    mutable Mutex m_cs_headers_cache;
+    /** cache of block hash to filter header, to avoid disk access when responding to getcfcheckpt. */
+    mutable std::unordered_map<uint256, uint256, FilterHeaderHasher> m_headers_cache GUARDED_BY(m_cs_headers_cache);
+
 protected:
     bool Init() override;
 
@@ -56,7 +72,8 @@ public:
     /** Get a single filter header by block. */
     bool LookupFilterHeader(const CBlockIndex* block_index, uint256& header_out) const;
 
-    /** Get a range of filters between two heights on a chain. */
+    /** Get a range of filters between two heights on a chain. Filters stored next to each other
+     *  are read in one pass over the filter file. */
     bool LookupFilterRange(int start_height, const CBlockIndex* stop_index,
                            std::vector<BlockFilter>& filters_out) const;
 
@@ -0,0 +1,369 @@
+// Copyright (c) 2020-2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <coins.h>
+#include <index/coinstatsindex.h>
+#include <node/coinstats.h>
+#include <undo.h>
+#include <util/system.h>
+#include <validation.h>
+
+/* The index database stores the UTXO set statistics as of each block: the finalized MuHash of the
+ * UTXO set, the number of unspent outputs, their bogo size and their total amount. As in the block
+ * filter index, the entries of blocks on the active chain are indexed by height, and those of blocks
+ * that have been reorganized out of the active chain are indexed by block hash.
+ *
+ * The running MuHash of the UTXO set, from which the statistics of the next block are derived, is
+ * stored under the DB_MUHASH key and committed together with the best block locator.
+ */
+constexpr char DB_BLOCK_HASH = 's';
+constexpr char DB_BLOCK_HEIGHT = 't';
+constexpr char DB_MUHASH = 'M';
+
+namespace {
+
+struct DBVal {
+    uint256 muhash;
+    uint64_t transaction_output_count;
+    uint64_t bogo_size;
+    CAmount total_amount;
+
+    DBVal() : transaction_output_count(0), bogo_size(0), total_amount(0) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(muhash);
+        READWRITE(transaction_output_count);
+        READWRITE(bogo_size);
+        READWRITE(total_amount);
+    }
+};
+
+struct DBHeightKey {
+    int height;
+
+    DBHeightKey() : height(0) {}
+    explicit DBHeightKey(int height_in) : height(height_in) {}
+
+    template<typename Stream>
+    void Serialize(Stream& s) const
+    {
+        ser_writedata8(s, DB_BLOCK_HEIGHT);
+        ser_writedata32be(s, height);
+    }
+
+    template<typename Stream>
+    void Unserialize(Stream& s)
+    {
+        char prefix = ser_readdata8(s);
+        if (prefix != DB_BLOCK_HEIGHT) {
+            throw std::ios_base::failure("Invalid format for coinstatsindex DB height key");
+        }
+        height = ser_readdata32be(s);
+    }
+};
+
+struct DBHashKey {
+    uint256 hash;
+
+    explicit DBHashKey(const uint256& hash_in) : hash(hash_in) {}
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        char prefix = DB_BLOCK_HASH;
+        READWRITE(prefix);
+        if (prefix != DB_BLOCK_HASH) {
+            throw std::ios_base::failure("Invalid format for coinstatsindex DB hash key");
+        }
+
+        READWRITE(hash);
+    }
+};
+
+/** Whether an output is added to the UTXO set, see CCoinsViewCache::AddCoin. */
+bool IsUTXOSetOutput(const CTxOut& out)
+{
+    return !out.scriptPubKey.IsUnspendable() && out.nValue != 0 && !out.scriptPubKey.empty();
+}
+
+}; // namespace
+
+std::unique_ptr<CoinStatsIndex> g_coin_stats_index;
+
+CoinStatsIndex::CoinStatsIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
+{
+    fs::path path = GetDataDir() / "indexes" / "coinstats";
+    fs::create_directories(path);
+
+    m_name = "coinstatsindex";
+    m_db = MakeUnique<BaseIndex::DB>(path / "db", n_cache_size, f_memory, f_wipe);
+}
+
+static bool LookUpOne(const CDBWrapper& db, const CBlockIndex* block_index, DBVal& result)
+{
+    // First check if the result is stored under the height index and the value there matches the
+    // block hash. This should be the case if the block is on the active chain.
+    std::pair<uint256, DBVal> read_out;
+    if (!db.Read(DBHeightKey(block_index->nHeight), read_out)) {
+        return false;
+    }
+    if (read_out.first == block_index->GetBlockHash()) {
+        result = std::move(read_out.second);
+        return true;
+    }
+
+    // If value at the height index corresponds to an different block, the result will be stored in
+    // the hash index.
+    return db.Read(DBHashKey(block_index->GetBlockHash()), result);
+}
+
+bool CoinStatsIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    CBlockUndo block_undo;
+
+    if (pindex->nHeight > 0) {
+        if (!UndoReadFromDisk(block_undo, pindex)) {
+            return false;
+        }
+
+        std::pair<uint256, DBVal> read_out;
+        if (!m_db->Read(DBHeightKey(pindex->nHeight - 1), read_out)) {
+            return false;
+        }
+
+        uint256 expected_block_hash = pindex->pprev->GetBlockHash();
+        if (read_out.first != expected_block_hash) {
+            return error("%s: previous block header belongs to unexpected block %s; expected %s",
+                         __func__, read_out.first.ToString(), expected_block_hash.ToString());
+        }
+    }
+
+    // The genesis block is connected like any other block, so its outputs are part of the set.
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransactionRef& tx = block.vtx.at(i);
+
+        for (size_t j = 0; j < tx->vout.size(); ++j) {
+            const CTxOut& out = tx->vout[j];
+            if (!IsUTXOSetOutput(out)) continue;
+
+            Coin coin(out, pindex->nHeight, tx->IsCoinBase(), tx->IsCoinStake());
+            ApplyCoinHash(m_muhash, COutPoint(tx->GetHash(), j), coin);
+            ++m_transaction_output_count;
+            m_bogo_size += GetBogoSize(out.scriptPubKey);
+            m_total_amount += out.nValue;
+        }
+
+        // The coinbase spends no coins and has no undo data.
+        if (i == 0) continue;
+
+        const CTxUndo& tx_undo = block_undo.vtxundo.at(i - 1);
+        for (size_t j = 0; j < tx->vin.size(); ++j) {
+            const Coin& coin = tx_undo.vprevout.at(j);
+            RemoveCoinHash(m_muhash, tx->vin[j].prevout, coin);
+            --m_transaction_output_count;
+            m_bogo_size -= GetBogoSize(coin.out.scriptPubKey);
+            m_total_amount -= coin.out.nValue;
+        }
+    }
+
+    std::pair<uint256, DBVal> value;
+    value.first = pindex->GetBlockHash();
+    value.second.transaction_output_count = m_transaction_output_count;
+    value.second.bogo_size = m_bogo_size;
+    value.second.total_amount = m_total_amount;
+    m_muhash.Finalize(value.second.muhash);
+
+    return m_db->Write(DBHeightKey(pindex->nHeight), value);
+}
+
+static bool CopyHeightIndexToHashIndex(CDBIterator& db_it, CDBBatch& batch,
+                                       const std::string& index_name,
+                                       int start_height, int stop_height)
+{
+    DBHeightKey key(start_height);
+    db_it.Seek(key);
+
+    for (int height = start_height; height <= stop_height; ++height) {
+        if (!db_it.GetKey(key) || key.height != height) {
+            return error("%s: unexpected key in %s: expected (%c, %d)",
+                         __func__, index_name, DB_BLOCK_HEIGHT, height);
+        }
+
+        std::pair<uint256, DBVal> value;
+        if (!db_it.GetValue(value)) {
+            return error("%s: unable to read value in %s at key (%c, %d)",
+                         __func__, index_name, DB_BLOCK_HEIGHT, height);
+        }
+
+        batch.Write(DBHashKey(value.first), std::move(value.second));
+
+        db_it.Next();
+    }
+    return true;
+}
+
+bool CoinStatsIndex::Rewind(const CBlockIndex* current_tip, const CBlockIndex* new_tip)
+{
+    assert(current_tip->GetAncestor(new_tip->nHeight) == new_tip);
+
+    CDBBatch batch(*m_db);
+    std::unique_ptr<CDBIterator> db_it(m_db->NewIterator());
+
+    // During a reorg, we need to copy all entries for blocks that are getting disconnected from the
+    // height index to the hash index so we can still find them when the height index entries are
+    // overwritten.
+    if (!CopyHeightIndexToHashIndex(*db_it, batch, m_name, new_tip->nHeight, current_tip->nHeight)) {
+        return false;
+    }
+
+    if (!m_db->WriteBatch(batch)) return false;
+
+    const Consensus::Params& consensus_params = Params().GetConsensus();
+    for (const CBlockIndex* iter_tip = current_tip; iter_tip != new_tip; iter_tip = iter_tip->pprev) {
+        CBlock block;
+        if (!ReadBlockFromDisk(block, iter_tip, consensus_params)) {
+            return error("%s: Failed to read block %s from disk",
+                         __func__, iter_tip->GetBlockHash().ToString());
+        }
+        if (!ReverseBlock(block, iter_tip)) {
+            return false;
+        }
+    }
+
+    return BaseIndex::Rewind(current_tip, new_tip);
+}
+
+bool CoinStatsIndex::ReverseBlock(const CBlock& block, const CBlockIndex* pindex)
+{
+    assert(pindex->nHeight > 0);
+
+    CBlockUndo block_undo;
+    if (!UndoReadFromDisk(block_undo, pindex)) {
+        return error("%s: Failed to read undo data of block %s",
+                     __func__, pindex->GetBlockHash().ToString());
+    }
+
+    for (size_t i = 0; i < block.vtx.size(); ++i) {
+        const CTransactionRef& tx = block.vtx.at(i);
+
+        for (size_t j = 0; j < tx->vout.size(); ++j) {
+            const CTxOut& out = tx->vout[j];
+            if (!IsUTXOSetOutput(out)) continue;
+
+            Coin coin(out, pindex->nHeight, tx->IsCoinBase(), tx->IsCoinStake());
+            RemoveCoinHash(m_muhash, COutPoint(tx->GetHash(), j), coin);
+        }
+
+        if (i == 0) continue;
+
+        const CTxUndo& tx_undo = block_undo.vtxundo.at(i - 1);
+        for (size_t j = 0; j < tx->vin.size(); ++j) {
+            ApplyCoinHash(m_muhash, tx->vin[j].prevout, tx_undo.vprevout.at(j));
+        }
+    }
+
+    // The totals are restored from the entry of the previous block, whose MuHash must now match.
+    DBVal read_out;
+    if (!LookUpOne(*m_db, pindex->pprev, read_out)) {
+        return error("%s: Failed to read the %s entry of block %s",
+                     __func__, GetName(), pindex->pprev->GetBlockHash().ToString());
+    }
+
+    uint256 out;
+    m_muhash.Finalize(out);
+    if (read_out.muhash != out) {
+        return error("%s: MuHash of block %s does not match the %s entry after reverting block %s",
+                     __func__, pindex->pprev->GetBlockHash().ToString(), GetName(),
+                     pindex->GetBlockHash().ToString());
+    }
+
+    m_transaction_output_count = read_out.transaction_output_count;
+    m_bogo_size = read_out.bogo_size;
+    m_total_amount = read_out.total_amount;
+    return true;
+}
+
+bool CoinStatsIndex::LookUpStats(const CBlockIndex* block_index, CCoinsStats& coins_stats) const
+{
+    DBVal entry;
+    if (!LookUpOne(*m_db, block_index, entry)) {
+        return false;
+    }
+
+    coins_stats.nHeight = block_index->nHeight;
+    coins_stats.hashBlock = block_index->GetBlockHash();
+    coins_stats.hashSerialized = entry.muhash;
+    coins_stats.nTransactionOutputs = entry.transaction_output_count;
+    coins_stats.nBogoSize = entry.bogo_size;
+    coins_stats.nTotalAmount = entry.total_amount;
+    return true;
+}
+
+bool CoinStatsIndex::Init()
+{
+    if (!m_db->Read(DB_MUHASH, m_muhash)) {
+        // Check that the cause of the read failure is that the key does not exist. Any other errors
+        // indicate database corruption or a disk failure, and starting the index would cause
+        // further corruption.
+        if (m_db->Exists(DB_MUHASH)) {
+            return error("%s: Cannot read current %s state; index may be corrupted",
+                         __func__, GetName());
+        }
+    }
+
+    // The committed MuHash belongs to the block the locator was written for, which may have been
+    // reorganized out of the active chain while the node was down.
+    const CBlockIndex* committed_tip = nullptr;
+    CBlockLocator locator;
+    if (m_db->ReadBestBlock(locator) && !locator.IsNull()) {
+        LOCK(cs_main);
+        committed_tip = LookupBlockIndex(locator.vHave.front());
+    }
+
+    if (!BaseIndex::Init()) return false;
+
+    const CBlockIndex* pindex = CurrentIndex();
+    if (!pindex) return true;
+
+    if (committed_tip && committed_tip != pindex) {
+        const Consensus::Params& consensus_params = Params().GetConsensus();
+        for (const CBlockIndex* iter_tip = committed_tip; iter_tip != pindex; iter_tip = iter_tip->pprev) {
+            CBlock block;
+            if (!ReadBlockFromDisk(block, iter_tip, consensus_params) || !ReverseBlock(block, iter_tip)) {
+                return error("%s: Cannot revert %s to the active chain", __func__, GetName());
+            }
+        }
+    }
+
+    DBVal entry;
+    if (!LookUpOne(*m_db, pindex, entry)) {
+        return error("%s: Cannot read current %s state; index may be corrupted",
+                     __func__, GetName());
+    }
+
+    uint256 out;
+    m_muhash.Finalize(out);
+    if (entry.muhash != out) {
+        return error("%s: Cannot read current %s state; index may be corrupted",
+                     __func__, GetName());
+    }
+
+    m_transaction_output_count = entry.transaction_output_count;
+    m_bogo_size = entry.bogo_size;
+    m_total_amount = entry.total_amount;
+    return true;
+}
+
+bool CoinStatsIndex::CommitInternal(CDBBatch& batch)
+{
+    // The running MuHash is committed atomically with the best block locator, so that it always
+    // describes the UTXO set as of that block.
+    batch.Write(DB_MUHASH, m_muhash);
+    return BaseIndex::CommitInternal(batch);
+}
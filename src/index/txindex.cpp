@@ -3,12 +3,20 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <index/txindex.h>
+#include <core_memusage.h>
 #include <shutdown.h>
+#include <sync.h>
+#include <txmempool.h>
 #include <ui_interface.h>
 #include <util/system.h>
 #include <util/translation.h>
 #include <validation.h>
 
+#include <array>
+#include <atomic>
+#include <list>
+#include <unordered_map>
+
 #include <boost/thread.hpp>
 
 constexpr char DB_BEST_BLOCK = 'B';
@@ -224,8 +232,116 @@ bool TxIndex::DB::MigrateData(CBlockTreeDB& block_tree_db, const CBlockLocator&
     return true;
 }
 
-TxIndex::TxIndex(size_t n_cache_size, bool f_memory, bool f_wipe)
-    : m_db(MakeUnique<TxIndex::DB>(n_cache_size, f_memory, f_wipe))
+/**
+ * Memory bounded cache of transactions read from the block files, keyed by txid.
+ *
+ * The cache is split into shards, each with its own lock and least recently
+ * used order, so that concurrent lookups rarely contend.
+ */
+class TxIndex::Cache
+{
+private:
+    static constexpr size_t NUM_SHARDS = 16;
+
+    struct Entry
+    {
+        uint256 block_hash;
+        CTransactionRef tx;
+        size_t usage;
+    };
+    typedef std::list<std::pair<uint256, Entry>> EntryList;
+
+    struct Shard
+    {
+        Mutex cs;
+        EntryList lru GUARDED_BY(cs);
+        std::unordered_map<uint256, EntryList::iterator, SaltedTxidHasher> entries GUARDED_BY(cs);
+        size_t usage GUARDED_BY(cs){0};
+    };
+
+    const size_t m_max_shard_usage;
+    std::array<Shard, NUM_SHARDS> m_shards;
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+
+    Shard& GetShard(const uint256& txid)
+    {
+        // the low bits are used by the hasher of the map, so select the shard by another word
+        return m_shards[txid.GetUint64(1) % NUM_SHARDS];
+    }
+
+    static size_t EntryUsage(const CTransactionRef& tx)
+    {
+        return RecursiveDynamicUsage(tx) + memusage::MallocUsage(sizeof(EntryList::value_type) + 2 * sizeof(void*)) +
+               memusage::MallocUsage(sizeof(std::pair<const uint256, EntryList::iterator>) + sizeof(void*) + sizeof(size_t));
+    }
+
+public:
+    explicit Cache(size_t max_usage) : m_max_shard_usage(max_usage / NUM_SHARDS) {}
+
+    bool Get(const uint256& txid, uint256& block_hash, CTransactionRef& tx)
+    {
+        Shard& shard = GetShard(txid);
+        LOCK(shard.cs);
+        auto it = shard.entries.find(txid);
+        if (it == shard.entries.end()) {
+            ++m_misses;
+            return false;
+        }
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        block_hash = it->second->second.block_hash;
+        tx = it->second->second.tx;
+        ++m_hits;
+        return true;
+    }
+
+    void Put(const uint256& txid, const uint256& block_hash, const CTransactionRef& tx)
+    {
+        const size_t usage = EntryUsage(tx);
+        if (usage > m_max_shard_usage) return;
+
+        Shard& shard = GetShard(txid);
+        LOCK(shard.cs);
+        if (shard.entries.count(txid)) return;
+        while (shard.usage + usage > m_max_shard_usage) {
+            shard.usage -= shard.lru.back().second.usage;
+            shard.entries.erase(shard.lru.back().first);
+            shard.lru.pop_back();
+        }
+        shard.lru.emplace_front(txid, Entry{block_hash, tx, usage});
+        shard.entries.emplace(txid, shard.lru.begin());
+        shard.usage += usage;
+    }
+
+    void Erase(const uint256& txid)
+    {
+        Shard& shard = GetShard(txid);
+        LOCK(shard.cs);
+        auto it = shard.entries.find(txid);
+        if (it == shard.entries.end()) return;
+        shard.usage -= it->second->second.usage;
+        shard.lru.erase(it->second);
+        shard.entries.erase(it);
+    }
+
+    TxCacheStats GetStats()
+    {
+        TxCacheStats stats;
+        stats.hits = m_hits;
+        stats.misses = m_misses;
+        stats.max_usage = m_max_shard_usage * NUM_SHARDS;
+        for (Shard& shard : m_shards) {
+            LOCK(shard.cs);
+            stats.entries += shard.entries.size();
+            stats.usage += shard.usage;
+        }
+        return stats;
+    }
+};
+
+TxIndex::TxIndex(size_t n_cache_size, bool f_memory, bool f_wipe, size_t n_tx_cache_size)
+    : m_db(MakeUnique<TxIndex::DB>(n_cache_size, f_memory, f_wipe)),
+      m_cache(n_tx_cache_size > 0 ? MakeUnique<TxIndex::Cache>(n_tx_cache_size) : nullptr)
 {}
 
 TxIndex::~TxIndex() {}
@@ -256,7 +372,17 @@ bool TxIndex::WriteBlock(const CBlock& block, const CBlockIndex* pindex)
         vPos.emplace_back(tx->GetHash(), pos);
         pos.nTxOffset += ::GetSerializeSize(*tx, CLIENT_VERSION);
     }
-    return m_db->WriteTxs(vPos);
+    if (!m_db->WriteTxs(vPos)) {
+        return false;
+    }
+
+    // transactions cached from a disconnected block are now found in this one
+    if (m_cache) {
+        for (const auto& tx : block.vtx) {
+            m_cache->Erase(tx->GetHash());
+        }
+    }
+    return true;
 }
 
 BaseIndex::DB& TxIndex::GetDB() const { return *m_db; }
@@ -273,6 +399,10 @@ int TxIndex::ReadTxPos(const uint256& txid) const
 
 bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const
 {
+    if (m_cache && m_cache->Get(tx_hash, block_hash, tx)) {
+        return true;
+    }
+
     CDiskTxPos postx;
     if (!m_db->ReadTxPos(tx_hash, postx)) {
         return false;
@@ -296,5 +426,12 @@ bool TxIndex::FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRe
         return error("%s: txid mismatch", __func__);
     }
     block_hash = header.GetHash();
+    if (m_cache) m_cache->Put(tx_hash, block_hash, tx);
     return true;
 }
+
+TxCacheStats TxIndex::GetCacheStats() const
+{
+    if (!m_cache) return TxCacheStats();
+    return m_cache->GetStats();
+}
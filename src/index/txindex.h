@@ -9,6 +9,19 @@
 #include <index/base.h>
 #include <txdb.h>
 
+//! -txcachesize default (MiB)
+static const int64_t DEFAULT_TX_CACHE_SIZE = 16;
+
+/** Statistics of the cache of transactions read by TxIndex::FindTx. */
+struct TxCacheStats
+{
+    uint64_t hits{0};
+    uint64_t misses{0};
+    size_t entries{0};
+    size_t usage{0};
+    size_t max_usage{0};
+};
+
 /**
  * TxIndex is used to look up transactions included in the blockchain by hash.
  * The index is written to a LevelDB database and records the filesystem
@@ -18,9 +31,11 @@ class TxIndex final : public BaseIndex
 {
 protected:
     class DB;
+    class Cache;
 
 private:
     const std::unique_ptr<DB> m_db;
+    const std::unique_ptr<Cache> m_cache;
 
 protected:
     /// Override base class init to migrate from old database.
@@ -33,10 +48,11 @@ protected:
     const char* GetName() const override { return "txindex"; }
 
 public:
-    /// Constructs the index, which becomes available to be queried.
-    explicit TxIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false);
+    /// Constructs the index, which becomes available to be queried. Up to n_tx_cache_size bytes
+    /// of recently read transactions are kept in memory.
+    explicit TxIndex(size_t n_cache_size, bool f_memory = false, bool f_wipe = false, size_t n_tx_cache_size = 0);
 
-    // Destructor is declared because this class contains a unique_ptr to an incomplete type.
+    // Destructor is declared because this class contains unique_ptrs to incomplete types.
     virtual ~TxIndex() override;
 
     /// Look up a transaction by hash.
@@ -48,6 +64,9 @@ public:
     bool FindTx(const uint256& tx_hash, uint256& block_hash, CTransactionRef& tx) const;
 
     int ReadTxPos(const uint256& txid) const;
+
+    /// Get the hit rate and memory usage of the transaction cache.
+    TxCacheStats GetCacheStats() const;
 };
 
 /// The global transaction index, used in GetTransaction. May be null.
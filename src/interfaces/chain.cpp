@@ -6,6 +6,7 @@
 
 #include <chain.h>
 #include <chainparams.h>
+#include <index/blockfilterindex.h>
 #include <interfaces/handler.h>
 #include <interfaces/wallet.h>
 #include <net.h>
@@ -32,12 +33,42 @@
 #include <validation.h>
 #include <validationinterface.h>
 
+#include <algorithm>
 #include <memory>
+#include <thread>
 #include <utility>
 
 namespace interfaces {
 namespace {
 
+//! Smallest number of filters worth handing to a thread of its own
+static const size_t MIN_FILTERS_PER_THREAD = 50;
+
+//! Test each filter against the elements, spreading the filters over up to one thread per core.
+std::vector<bool> MatchFiltersParallel(const std::vector<BlockFilter>& filters, const GCSFilter::ElementSet& filter_set)
+{
+    // one byte per result, so that the threads never write to the same memory location
+    std::vector<char> matches(filters.size(), 0);
+    const size_t max_threads = (filters.size() + MIN_FILTERS_PER_THREAD - 1) / MIN_FILTERS_PER_THREAD;
+    const size_t num_threads = std::max<size_t>(1, std::min<size_t>(GetNumCores(), max_threads));
+    const size_t per_thread = (filters.size() + num_threads - 1) / num_threads;
+
+    auto match_range = [&filters, &filter_set, &matches](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            matches[i] = filters[i].GetFilter().MatchAny(filter_set);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (size_t t = 1; t < num_threads; ++t) {
+        threads.emplace_back(match_range, std::min(filters.size(), t * per_thread), std::min(filters.size(), (t + 1) * per_thread));
+    }
+    match_range(0, std::min(filters.size(), per_thread));
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    return std::vector<bool>(matches.begin(), matches.end());
+}
+
 class LockImpl : public Chain::Lock, public UniqueLock<RecursiveMutex>
 {
     Optional<int> getHeight() override
@@ -268,6 +299,34 @@ public:
         }
         return true;
     }
+    bool hasBlockFilterIndex(BlockFilterType filter_type) override
+    {
+        return GetBlockFilterIndex(filter_type) != nullptr;
+    }
+    bool blockFiltersMatchAny(BlockFilterType filter_type, int start_height, const uint256& stop_block,
+        const GCSFilter::ElementSet& filter_set, std::vector<std::pair<uint256, bool>>& matches) override
+    {
+        const BlockFilterIndex* block_filter_index = GetBlockFilterIndex(filter_type);
+        if (!block_filter_index) return false;
+
+        const CBlockIndex* stop_index;
+        {
+            LOCK(cs_main);
+            stop_index = LookupBlockIndex(stop_block);
+        }
+        std::vector<BlockFilter> filters;
+        if (!stop_index || !block_filter_index->LookupFilterRange(start_height, stop_index, filters)) {
+            return false;
+        }
+
+        const std::vector<bool> filter_matches = MatchFiltersParallel(filters, filter_set);
+        matches.clear();
+        matches.reserve(filters.size());
+        for (size_t i = 0; i < filters.size(); ++i) {
+            matches.emplace_back(filters[i].GetBlockHash(), filter_matches[i]);
+        }
+        return true;
+    }
     void findCoins(std::map<COutPoint, Coin>& coins) override { return FindCoins(m_node, coins); }
     double guessVerificationProgress(const uint256& block_hash) override
     {
@@ -5,6 +5,7 @@
 #ifndef XEP_INTERFACES_CHAIN_H
 #define XEP_INTERFACES_CHAIN_H
 
+#include <blockfilter.h>            // For BlockFilterType and GCSFilter::ElementSet
 #include <optional.h>               // For Optional and nullopt
 #include <primitives/transaction.h> // For CTransactionRef
 
@@ -137,6 +138,20 @@ public:
         int64_t* time = nullptr,
         int64_t* max_time = nullptr) = 0;
 
+    //! Returns whether a block filter index is available.
+    virtual bool hasBlockFilterIndex(BlockFilterType filter_type) = 0;
+
+    //! Test the block filters of the blocks from start_height up to stop_block
+    //! against a set of elements, spreading the tests over several threads.
+    //! Returns false if a filter could not be read. Otherwise matches holds the
+    //! hash of each block in the range and whether any of the elements may be
+    //! in it.
+    virtual bool blockFiltersMatchAny(BlockFilterType filter_type,
+        int start_height,
+        const uint256& stop_block,
+        const GCSFilter::ElementSet& filter_set,
+        std::vector<std::pair<uint256, bool>>& matches) = 0;
+
     //! Look up unspent output information. Returns coins in the mempool and in
     //! the current chain UTXO set. Iterates through all the keys in the map and
     //! populates the values.
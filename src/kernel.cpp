@@ -6,6 +6,7 @@
 
 #include <chainparams.h>
 #include <consensus/validation.h>
+#include <crypto/common.h>
 #include <hash.h>
 #include <kernel.h>
 #include <policy/policy.h>
@@ -55,7 +56,7 @@ static int64_t GetStakeModifierSelectionIntervalSection(int nSection)
 }
 
 // Get stake modifier selection interval (in seconds)
-static int64_t GetStakeModifierSelectionInterval()
+int64_t GetStakeModifierSelectionInterval()
 {
     int64_t nSelectionInterval = 0;
     for (int nSection = 0; nSection < 64; nSection++)
@@ -276,7 +277,7 @@ uint256 ComputeStakeModifierV2(const CBlockIndex* pindexPrev, const uint256& ker
     ss << kernel;
 
     if (pindexPrev->UsesStakeModifierV2())
-        ss << pindexPrev->nStakeModifierV2;
+        ss << pindexPrev->GetStakeModifierV2();
     else
         ss << pindexPrev->nStakeModifier;
 
@@ -301,13 +302,29 @@ uint64_t ComputeStakeModifierV3(const CBlockIndex* pindexPrev, const uint256& ke
     ss << kernel;
 
     if (pindexPrev->UsesStakeModifierV2())
-        ss << pindexPrev->nStakeModifierV2;
+        ss << pindexPrev->GetStakeModifierV2();
     else
         ss << pindexPrev->nStakeModifier;
 
     return UintToArith256(ss.GetHash()).GetLow64();
 }
 
+// Find the last block up to and including pindex with a timestamp not after nTime
+//
+// Block timestamps strictly increase along a chain (a block must be later than the median time past, which spans a
+// single block), so the ancestors of a block are sorted by time and can be searched via the skiplist in O(log n)
+// instead of walking back one block at a time. Returns nullptr if every block up to the genesis is later than nTime.
+static inline const CBlockIndex* GetLastBlockIndexNotAfter(const CBlockIndex* pindex, int64_t nTime)
+{
+    while (pindex && pindex->GetBlockTime() > nTime) {
+        if (pindex->pskip && pindex->pskip->GetBlockTime() > nTime)
+            pindex = pindex->pskip;
+        else
+            pindex = pindex->pprev;
+    }
+    return pindex;
+}
+
 // V0.5: Stake modifier used to hash for a stake kernel is chosen as the stake
 // modifier that is (nStakeMinAge minus a selection interval) earlier than the
 // stake, thus at least a selection interval later than the coin generating the
@@ -329,21 +346,18 @@ static inline bool GetKernelStakeModifierV05(const CBlockIndex* pindexPrev, unsi
         else
             return false;
     }
-    // loop to find the stake modifier earlier by
-    // (nStakeMinAge minus a selection interval)
-    while (nStakeModifierTime + params.nStakeMinAge - nStakeModifierSelectionInterval > (int64_t)nTimeTx)
-    {
-        if (!pindex->pprev)
-        {   // reached genesis block; should not happen
-            return error("GetKernelStakeModifier() : reached genesis block");
-        }
+    // find the stake modifier earlier by
+    // (nStakeMinAge minus a selection interval): skip to the last block early
+    // enough, then step back to the last block which generated a modifier
+    pindex = GetLastBlockIndexNotAfter(pindex->pprev, (int64_t)nTimeTx - params.nStakeMinAge + nStakeModifierSelectionInterval);
+    while (pindex && !pindex->GeneratedStakeModifier())
         pindex = pindex->pprev;
-        if (pindex->GeneratedStakeModifier())
-        {
-            nStakeModifierHeight = pindex->nHeight;
-            nStakeModifierTime = pindex->GetBlockTime();
-        }
+    if (!pindex)
+    {   // reached genesis block; should not happen
+        return error("GetKernelStakeModifier() : reached genesis block");
     }
+    nStakeModifierHeight = pindex->nHeight;
+    nStakeModifierTime = pindex->GetBlockTime();
     nStakeModifier = pindex->nStakeModifier;
     return true;
 }
@@ -364,42 +378,31 @@ static inline bool GetKernelStakeModifierV03(const CBlockIndex* pindexPrev, uint
     nStakeModifierTime = pindexFrom->GetBlockTime();
     int64_t nStakeModifierSelectionInterval = GetStakeModifierSelectionInterval();
 
-    // we need to iterate index forward but we cannot depend on ::ChainActive().Next()
-    // because there is no guarantee that we are checking blocks in active chain.
-    // So, we construct a temporary chain that we will iterate over.
+    // we need to iterate forward along the chain of pindexPrev, which is not
+    // necessarily the active chain, so the blocks are looked up as ancestors
+    // of pindexPrev. The blocks earlier than a selection interval after
+    // pindexFrom are skipped, the first of the remaining blocks which
+    // generated a modifier is the one we are looking for.
     // pindexFrom - this block contains coins that are used to generate PoS
     // pindexPrev - this is a block that is previous to PoS block that we are checking, you can think of it as tip of our chain
-    std::vector<const CBlockIndex*> tmpChain;
-    int32_t nDepth = pindexPrev->nHeight - (pindexFrom->nHeight-1); // -1 is used to also include pindexFrom
-    tmpChain.reserve(nDepth);
-    const CBlockIndex* it = pindexPrev;
-    for (int i = 1; i <= nDepth && !::ChainActive().Contains(it); i++) {
-        tmpChain.push_back(it);
-        it = it->pprev;
-    }
-    std::reverse(tmpChain.begin(), tmpChain.end());
-    size_t n = 0;
-
-    const CBlockIndex* pindex = pindexFrom;
-    // loop to find the stake modifier later by a selection interval
-    while (nStakeModifierTime < pindexFrom->GetBlockTime() + nStakeModifierSelectionInterval)
-    {
-        const CBlockIndex* old_pindex = pindex;
-        pindex = (!tmpChain.empty() && pindex->nHeight >= tmpChain[0]->nHeight - 1) ? tmpChain[n++] : ::ChainActive().Next(pindex);
-        if (n > tmpChain.size() || pindex == NULL) // check if tmpChain[n+1] exists
-        {   // reached best block; may happen if node is behind on block chain
-            if (fPrintProofOfStake || (old_pindex->GetBlockTime() + params.nStakeMinAge - nStakeModifierSelectionInterval > GetAdjustedTime()))
-                return error("GetKernelStakeModifier() : reached best block %s at height %d from block %s",
-                    old_pindex->GetBlockHash().ToString(), old_pindex->nHeight, hashBlockFrom.ToString());
-            else
-                return false;
-        }
+    const CBlockIndex* pindexSkip = GetLastBlockIndexNotAfter(pindexPrev, pindexFrom->GetBlockTime() + nStakeModifierSelectionInterval - 1);
+    int nHeight = std::max(pindexSkip ? pindexSkip->nHeight : 0, pindexFrom->nHeight) + 1;
+    const CBlockIndex* pindex = nullptr;
+    for (; nHeight <= pindexPrev->nHeight; nHeight++) {
+        pindex = pindexPrev->GetAncestor(nHeight);
         if (pindex->GeneratedStakeModifier())
-        {
-            nStakeModifierHeight = pindex->nHeight;
-            nStakeModifierTime = pindex->GetBlockTime();
-        }
+            break;
     }
+    if (nHeight > pindexPrev->nHeight)
+    {   // reached best block; may happen if node is behind on block chain
+        if (fPrintProofOfStake || (pindexPrev->GetBlockTime() + params.nStakeMinAge - nStakeModifierSelectionInterval > GetAdjustedTime()))
+            return error("GetKernelStakeModifier() : reached best block %s at height %d from block %s",
+                pindexPrev->GetBlockHash().ToString(), pindexPrev->nHeight, hashBlockFrom.ToString());
+        else
+            return false;
+    }
+    nStakeModifierHeight = pindex->nHeight;
+    nStakeModifierTime = pindex->GetBlockTime();
     nStakeModifier = pindex->nStakeModifier;
     return true;
 }
@@ -449,7 +452,7 @@ bool GetKernelStakeModifier(const CBlockIndex* pindexPrev, const uint256& hashBl
         return true;
     } else {
         if (pindexPrev->UsesStakeModifierV2())
-            nStakeModifierV2 = pindexPrev->nStakeModifierV2;
+            nStakeModifierV2 = pindexPrev->GetStakeModifierV2();
         else
             nStakeModifier = pindexPrev->nStakeModifier;
         nStakeModifierHeight = pindexPrev->nHeight;
@@ -610,8 +613,112 @@ bool CheckStakeKernelHash(const unsigned int& nBits, const CBlockIndex* pindexPr
     return fSuccess;
 }
 
+StakeKernelCandidate::StakeKernelCandidate(const COutPoint& prevoutIn, const CAmount& nValueIn, const CBlockIndex* pindexFromIn)
+    : prevout(prevoutIn), nValue(nValueIn), pindexFrom(pindexFromIn)
+{
+    WriteLE32(vchKernel, pindexFrom->GetBlockTime());
+    memcpy(vchKernel + 4, prevout.hash.begin(), 32);
+    WriteLE32(vchKernel + 36, prevout.n);
+}
+
+// Whether a candidate meets the min age and min depth requirement at nTimeTx
+static inline bool IsStakeKernelEligible(const StakeKernelCandidate& candidate, int nHeightCurrent, unsigned int nTimeTx, const Consensus::Params& params)
+{
+    return candidate.pindexFrom->GetBlockTime() + params.nStakeMinAge <= nTimeTx && nHeightCurrent - candidate.pindexFrom->nHeight >= params.nStakeMinDepth;
+}
+
+void GetStakeKernelModifiers(const CBlockIndex* pindexPrev, const std::vector<StakeKernelCandidate>& vCandidates, unsigned int nTimeTx, std::vector<StakeKernelModifier>& vModifiers)
+{
+    AssertLockHeld(cs_main);
+    const Consensus::Params& params = Params().GetConsensus();
+    const int nHeightCurrent = pindexPrev->nHeight + 1;
+
+    vModifiers.assign(vCandidates.size(), StakeKernelModifier());
+    const CBlockIndex* pindexModifier = nullptr;
+    StakeKernelModifier modifier;
+
+    for (size_t i = 0; i < vCandidates.size(); i++) {
+        const StakeKernelCandidate& candidate = vCandidates[i];
+        if (!IsStakeKernelEligible(candidate, nHeightCurrent, nTimeTx, params))
+            continue;
+
+        // The modifier only depends on the block of the kernel for v0.3 modifiers, but looking it up per block is cheap
+        if (candidate.pindexFrom != pindexModifier) {
+            uint64_t nStakeModifier = 0;
+            uint256 nStakeModifierV2 = uint256();
+            int nStakeModifierHeight = 0;
+            int64_t nStakeModifierTime = 0;
+            modifier = StakeKernelModifier();
+            if (GetKernelStakeModifier(pindexPrev, candidate.pindexFrom->GetBlockHash(), nTimeTx, params, nStakeModifier, nStakeModifierV2, nStakeModifierHeight, nStakeModifierTime, false)) {
+                if (pindexPrev->UsesStakeModifierV2()) {
+                    memcpy(modifier.vchModifier, nStakeModifierV2.begin(), 32);
+                    modifier.nSize = 32;
+                } else {
+                    WriteLE64(modifier.vchModifier, nStakeModifier);
+                    modifier.nSize = 8;
+                }
+                modifier.fValid = true;
+            }
+            pindexModifier = candidate.pindexFrom;
+        }
+        vModifiers[i] = modifier;
+    }
+}
+
+// Search the candidates [nBegin, nEnd) for a kernel meeting the hash target at nTimeTx
+//
+// This evaluates the same kernel as CheckStakeKernelHash, but without serializing or looking up anything per
+// attempt: the modifiers come from GetStakeKernelModifiers and the rest of each kernel comes from the candidate,
+// so that a staker can search many outputs within one time slot, on threads that don't hold cs_main. Candidates
+// failing the min age or min depth requirement, or without a modifier, are skipped silently.
+bool SearchStakeKernels(const unsigned int& nBits, const CBlockIndex* pindexPrev, const std::vector<StakeKernelCandidate>& vCandidates, const std::vector<StakeKernelModifier>& vModifiers, size_t nBegin, size_t nEnd, unsigned int nTimeTx, const std::atomic<bool>& fStop, size_t& nFound, uint256& hashProofOfStake, uint64_t& nAttempts)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    const int nHeightCurrent = pindexPrev->nHeight + 1;
+    const bool fUseTimeWeight = Params().NetworkIDString() != CBaseChainParams::MAIN;
+    constexpr int64_t nMinTimeWeight = 1 * 24 * 60 * 60; // 1 day
+
+    // Grab difficulty
+    bool fNegative;
+    bool fOverflow;
+    arith_uint256 bnTargetPerCoinDay;
+    bnTargetPerCoinDay.SetCompactBase256(nBits, &fNegative, &fOverflow);
+
+    // Check range
+    if (fNegative || bnTargetPerCoinDay == 0 || fOverflow || bnTargetPerCoinDay > UintToArith256(params.powLimit[CBlockHeader::ALGO_POS]))
+        return false;
+
+    unsigned char vchTimeTx[4];
+    WriteLE32(vchTimeTx, nTimeTx);
+
+    for (size_t i = nBegin; i < nEnd && !fStop; i++) {
+        const StakeKernelCandidate& candidate = vCandidates[i];
+        const StakeKernelModifier& modifier = vModifiers[i];
+        if (!modifier.fValid || !IsStakeKernelEligible(candidate, nHeightCurrent, nTimeTx, params))
+            continue;
+
+        uint256 hash;
+        CHash256().Write(modifier.vchModifier, modifier.nSize).Write(candidate.vchKernel, sizeof(candidate.vchKernel)).Write(vchTimeTx, sizeof(vchTimeTx)).Finalize(hash.begin());
+        nAttempts++;
+
+        const unsigned int nTimeBlockFrom = candidate.pindexFrom->GetBlockTime();
+        const unsigned int nTimeWeight = CalculateTimeWeight(nTimeTx, nTimeBlockFrom, params.nStakeMinAge, params.nStakeMaxAge, nMinTimeWeight);
+        if (stakeTargetHit(hash, candidate.nValue, nTimeWeight, bnTargetPerCoinDay, true, fUseTimeWeight)) {
+            nFound = i;
+            hashProofOfStake = hash;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 // Check kernel hash target and coinstake signature
-bool CheckProofOfStake(BlockValidationState& state, const CCoinsViewCache& view, const CBlockIndex* pindexPrev, const CTransactionRef& tx, const unsigned int& nBits, unsigned int nTimeTx, uint256& hashProofOfStake)
+//
+// The coinstake signature is verified through the signature cache. If pvChecks is not nullptr, the script check is
+// appended to it instead of being run, so that it can be run by the script check queue, in which case txdata must
+// outlive the check.
+bool CheckProofOfStake(BlockValidationState& state, const CCoinsViewCache& view, const CBlockIndex* pindexPrev, const CTransactionRef& tx, const unsigned int& nBits, unsigned int nTimeTx, uint256& hashProofOfStake, bool cacheStore, PrecomputedTransactionData* txdata, std::vector<CScriptCheck>* pvChecks)
 {
     if (!tx->IsCoinStake())
         return error("CheckProofOfStake() : called on non-coinstake %s", tx->GetHash().ToString());
@@ -643,11 +750,19 @@ bool CheckProofOfStake(BlockValidationState& state, const CCoinsViewCache& view,
     {
         int nIn = 0;
         //const CTxOut& prevTxOut = txPrev->vout[tx->vin[nIn].prevout.n];
-        TransactionSignatureChecker checker(&(*tx), nIn, coin.out.nValue, &::ChainActive(), PrecomputedTransactionData(*tx));
-        ScriptError serror = SCRIPT_ERR_OK;
+        std::unique_ptr<PrecomputedTransactionData> txdataLocal;
+        if (!txdata) {
+            assert(!pvChecks);
+            txdataLocal.reset(new PrecomputedTransactionData(*tx));
+            txdata = txdataLocal.get();
+        }
+        CScriptCheck check(coin.out, *tx, nIn, &::ChainActive(), STANDARD_CONTEXTUAL_SCRIPT_VERIFY_FLAGS, cacheStore, txdata);
 
-        if (!VerifyScript(tx->vin[nIn].scriptSig, coin.out.scriptPubKey, &(tx->vin[nIn].scriptWitness), STANDARD_CONTEXTUAL_SCRIPT_VERIFY_FLAGS, checker, &serror))
-            return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "invalid-pos-script", strprintf("%s: VerifyScript failed on coinstake %s, %s", __func__, tx->GetHash().ToString(), ScriptErrorString(serror)));
+        if (pvChecks) {
+            pvChecks->push_back(CScriptCheck());
+            check.swap(pvChecks->back());
+        } else if (!check())
+            return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "invalid-pos-script", strprintf("%s: VerifyScript failed on coinstake %s, %s", __func__, tx->GetHash().ToString(), ScriptErrorString(check.GetScriptError())));
     }
 
     unsigned int nInterval = 0;
@@ -667,16 +782,16 @@ bool CheckCoinStakeTimestamp(int64_t nTimeBlock, int64_t nTimeTx)
 }
 
 // Get stake modifier checksum
-unsigned int GetStakeModifierChecksum(const CBlockIndex* pindex)
+unsigned int GetStakeModifierChecksum(const CBlockIndex* pindex, const uint256& hashProofOfStake)
 {
     assert(pindex->pprev || pindex->GetBlockHash() == Params().GetConsensus().hashGenesisBlock);
     // Hash previous checksum with flags, hashProofOfStake and nStakeModifier
     CDataStream ss(SER_GETHASH, 0);
     if (pindex->pprev)
         ss << pindex->pprev->nStakeModifierChecksum;
-    ss << pindex->nFlags << pindex->hashProofOfStake;
+    ss << pindex->nFlags << hashProofOfStake;
     if (pindex->UsesStakeModifierV2())
-        ss << pindex->nStakeModifierV2;
+        ss << pindex->GetStakeModifierV2();
     else
         ss << pindex->nStakeModifier;
     arith_uint256 hashChecksum = UintToArith256(Hash(ss.begin(), ss.end()));
@@ -12,16 +12,24 @@
 #include <primitives/transaction.h> // CTransaction(Ref)
 #include <streams.h>
 
+#include <atomic>
+#include <vector>
+
 class CBlockIndex;
+class CScriptCheck;
 class BlockValidationState;
 class CBlockHeader;
 class CBlock;
+struct PrecomputedTransactionData;
 
 
 // MODIFIER_INTERVAL_RATIO:
 // ratio of group interval length between the last group and the first group
 static const int MODIFIER_INTERVAL_RATIO = 3;
 
+// Get stake modifier selection interval (in seconds)
+int64_t GetStakeModifierSelectionInterval();
+
 // Compute the hash modifier for proof-of-stake
 bool ComputeNextStakeModifier(const CBlockIndex* pindexCurrent, uint64_t& nStakeModifier, bool& fGeneratedStakeModifier);
 uint256 ComputeStakeModifierV2(const CBlockIndex* pindexPrev, const uint256& kernel);
@@ -33,15 +41,45 @@ uint256 stakeHash(const unsigned int& nTimeTx, CDataStream& ss, const unsigned i
 bool GetKernelStakeModifier(const CBlockIndex* pindexPrev, const uint256& hashBlockFrom, unsigned int nTimeTx, const Consensus::Params& params, uint64_t& nStakeModifier, uint256& nStakeModifierV2, int& nStakeModifierHeight, int64_t& nStakeModifierTime, bool fPrintProofOfStake);
 bool CheckStakeKernelHash(const unsigned int& nBits, const CBlockIndex* pindexPrev, const CBlockIndex* pindexFrom, const CTxOut& prevTxOut, const unsigned int& nTimeTxPrev, const COutPoint& prevout, unsigned int& nTimeTx, unsigned int nHashDrift, bool fCheck, uint256& hashProofOfStake, bool fPrintProofOfStake = false);
 
+// An output considered for staking, with the part of its kernel that doesn't depend on the stake modifier
+// or the coinstake time serialized in advance
+struct StakeKernelCandidate
+{
+    COutPoint prevout;
+    CAmount nValue;
+    const CBlockIndex* pindexFrom;
+    // nTimeBlockFrom, prevout hash and prevout index, as hashed by stakeHash
+    unsigned char vchKernel[40];
+
+    StakeKernelCandidate(const COutPoint& prevoutIn, const CAmount& nValueIn, const CBlockIndex* pindexFromIn);
+};
+
+// The stake modifier of a candidate, as hashed by stakeHash
+struct StakeKernelModifier
+{
+    bool fValid{false};
+    size_t nSize{0};
+    unsigned char vchModifier[32];
+};
+
+// Look up the stake modifiers of the candidates eligible at nTimeTx, once per run of candidates from the same block
+// Requires cs_main, so that SearchStakeKernels doesn't need to look anything up
+void GetStakeKernelModifiers(const CBlockIndex* pindexPrev, const std::vector<StakeKernelCandidate>& vCandidates, unsigned int nTimeTx, std::vector<StakeKernelModifier>& vModifiers);
+
+// Search the candidates [nBegin, nEnd) for a kernel meeting the hash target at nTimeTx, with the modifiers of GetStakeKernelModifiers
+// Sets nFound and hashProofOfStake on success return; gives up early once fStop is set
+bool SearchStakeKernels(const unsigned int& nBits, const CBlockIndex* pindexPrev, const std::vector<StakeKernelCandidate>& vCandidates, const std::vector<StakeKernelModifier>& vModifiers, size_t nBegin, size_t nEnd, unsigned int nTimeTx, const std::atomic<bool>& fStop, size_t& nFound, uint256& hashProofOfStake, uint64_t& nAttempts);
+
 // Check kernel hash target and coinstake signature
 // Sets hashProofOfStake on success return
-bool CheckProofOfStake(BlockValidationState& state, const CCoinsViewCache& view, const CBlockIndex* pindexPrev, const CTransactionRef& tx, const unsigned int& nBits, unsigned int nTimeTx, uint256& hashProofOfStake);
+// Appends the coinstake script check to pvChecks instead of running it, if given
+bool CheckProofOfStake(BlockValidationState& state, const CCoinsViewCache& view, const CBlockIndex* pindexPrev, const CTransactionRef& tx, const unsigned int& nBits, unsigned int nTimeTx, uint256& hashProofOfStake, bool cacheStore = true, PrecomputedTransactionData* txdata = nullptr, std::vector<CScriptCheck>* pvChecks = nullptr);
 
 // Check whether the coinstake timestamp meets protocol
 bool CheckCoinStakeTimestamp(int64_t nTimeBlock, int64_t nTimeTx);
 
-// Get stake modifier checksum
-unsigned int GetStakeModifierChecksum(const CBlockIndex* pindex);
+// Get stake modifier checksum of a block with the given proof-of-stake hash
+unsigned int GetStakeModifierChecksum(const CBlockIndex* pindex, const uint256& hashProofOfStake);
 
 // Check stake modifier hard checkpoints
 bool CheckStakeModifierCheckpoints(int nHeight, unsigned int nStakeModifierChecksum);
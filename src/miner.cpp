@@ -88,7 +88,7 @@ void BlockAssembler::resetBlock()
 Optional<int64_t> BlockAssembler::m_last_block_num_txs{nullopt};
 Optional<int64_t> BlockAssembler::m_last_block_weight{nullopt};
 
-std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn)
+std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& scriptPubKeyIn, const CMutableTransaction* pcoinstake, unsigned int nCoinStakeTime)
 {
     int64_t nTimeStart = GetTimeMicros();
 
@@ -103,6 +103,15 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     // Add dummy coinbase tx as first transaction
     pblocktemplate->entries.emplace_back(CTransactionRef(), -1, -1); // updated at end
 
+    const bool fProofOfStake = pcoinstake != nullptr;
+    if (fProofOfStake) {
+        // The coinstake follows the coinbase; its signature is added later, so reserve room for it
+        const CTransaction txCoinStake(*pcoinstake);
+        pblocktemplate->entries.emplace_back(MakeTransactionRef(txCoinStake), 0, WITNESS_SCALE_FACTOR * GetLegacySigOpCount(txCoinStake)); // updated at end
+        nBlockWeight += GetTransactionWeight(txCoinStake) + WITNESS_SCALE_FACTOR * 150;
+        nBlockSigOpsCost += pblocktemplate->entries.back().sigOpsCost;
+    }
+
     LOCK2(cs_main, m_mempool.cs);
     CBlockIndex* pindexPrev = ::ChainActive().Tip();
     assert(pindexPrev != nullptr);
@@ -110,13 +119,13 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 
     const Consensus::Params &consensusParams = chainparams.GetConsensus();
 
-    pblock->nVersion = ComputeBlockVersion(pindexPrev, CBlockHeader::AlgoType::ALGO_POW_SHA256, consensusParams);
+    pblock->nVersion = ComputeBlockVersion(pindexPrev, fProofOfStake ? CBlockHeader::AlgoType::ALGO_POS : CBlockHeader::AlgoType::ALGO_POW_SHA256, consensusParams);
     // -regtest only: allow overriding block.nVersion with
     // -blockversion=N to test forking scenarios
     if (chainparams.MineBlocksOnDemand())
         pblock->nVersion = gArgs.GetArg("-blockversion", pblock->nVersion);
 
-    pblock->nTime = GetAdjustedTime();
+    pblock->nTime = fProofOfStake ? nCoinStakeTime : GetAdjustedTime();
     const int64_t nMedianTimePast = pindexPrev->GetMedianTimePast();
 
     nLockTimeCutoff = (STANDARD_LOCKTIME_VERIFY_FLAGS & LOCKTIME_MEDIAN_TIME_PAST)
@@ -170,8 +179,29 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     coinbaseTx.vin.resize(1);
     coinbaseTx.vin[0].prevout.SetNull();
     coinbaseTx.vout.resize(1);
-    coinbaseTx.vout[0].scriptPubKey = scriptPubKeyIn;
-    coinbaseTx.vout[0].nValue = nFees / 2 + GetBlockSubsidy(nHeight, false /* fProofOfStake */, 0, consensusParams);
+    if (fProofOfStake) {
+        // peercoin: the reward goes to the coinstake, the coinbase output stays empty
+        coinbaseTx.vout[0].SetEmpty();
+
+        CMutableTransaction txCoinStake(*pcoinstake);
+        uint64_t nCoinAge = 0;
+        if (!GetCoinAge(CTransaction(txCoinStake), ::ChainstateActive().CoinsTip(), pblock->nTime, nHeight, nCoinAge)) {
+            throw std::runtime_error(strprintf("%s: unable to get coin age for coinstake", __func__));
+        }
+        txCoinStake.vout[1].nValue += nFees / 2 + GetBlockSubsidy(nHeight, true /* fProofOfStake */, nCoinAge, consensusParams);
+
+        const CAmount nTreasuryPayment = GetTreasuryPayment(nHeight, consensusParams);
+        if (nTreasuryPayment > 0) {
+            for (const std::pair<const CScript, unsigned int>& payee : consensusParams.mTreasuryPayees) {
+                txCoinStake.vout.emplace_back(nTreasuryPayment * payee.second / 100, payee.first);
+            }
+        }
+        pblocktemplate->entries[1].tx = MakeTransactionRef(std::move(txCoinStake));
+        pblock->vtx[1] = pblocktemplate->entries[1].tx;
+    } else {
+        coinbaseTx.vout[0].scriptPubKey = scriptPubKeyIn;
+        coinbaseTx.vout[0].nValue = nFees / 2 + GetBlockSubsidy(nHeight, false /* fProofOfStake */, 0, consensusParams);
+    }
     coinbaseTx.vin[0].scriptSig = CScript() << nHeight << OP_0;
     pblocktemplate->entries[0].tx = MakeTransactionRef(std::move(coinbaseTx));
     pblock->vtx[0] = pblocktemplate->entries[0].tx;
@@ -182,13 +212,14 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
 
     // Fill in header
     pblock->hashPrevBlock  = pindexPrev->GetBlockHash();
-    UpdateTime(pblock, consensusParams, pindexPrev);
+    if (!fProofOfStake) UpdateTime(pblock, consensusParams, pindexPrev);
     pblock->nBits          = GetNextWorkRequired(pindexPrev, pblock, consensusParams);
     pblock->nNonce         = 0;
     pblocktemplate->entries[0].sigOpsCost = WITNESS_SCALE_FACTOR * GetLegacySigOpCount(*pblock->vtx[0]);
 
+    // An unsigned coinstake can't pass validation, the caller tests the block once it is signed
     BlockValidationState state;
-    if (!TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false)) {
+    if (!fProofOfStake && !TestBlockValidity(state, chainparams, *pblock, pindexPrev, false, false)) {
         throw std::runtime_error(strprintf("%s: TestBlockValidity failed: %s", __func__, state.ToString()));
     }
     int64_t nTime2 = GetTimeMicros();
@@ -198,6 +229,20 @@ std::unique_ptr<CBlockTemplate> BlockAssembler::CreateNewBlock(const CScript& sc
     return std::move(pblocktemplate);
 }
 
+void RegenerateCommitments(CBlock& block, const CBlockIndex* pindexPrev, const Consensus::Params& consensusParams)
+{
+    CMutableTransaction tx(*block.vtx.at(0));
+    const int commitpos = GetWitnessCommitmentIndex(block);
+    if (commitpos != -1) {
+        tx.vout.erase(tx.vout.begin() + commitpos);
+    }
+    block.vtx.at(0) = MakeTransactionRef(std::move(tx));
+
+    GenerateCoinbaseCommitment(block, pindexPrev, consensusParams);
+
+    block.hashMerkleRoot = BlockMerkleRoot(block);
+}
+
 void BlockAssembler::onlyUnconfirmed(CTxMemPool::setEntries& testSet)
 {
     for (CTxMemPool::setEntries::iterator iit = testSet.begin(); iit != testSet.end(); ) {
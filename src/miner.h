@@ -168,8 +168,13 @@ public:
     explicit BlockAssembler(const CTxMemPool& mempool, const CChainParams& params);
     explicit BlockAssembler(const CTxMemPool& mempool, const CChainParams& params, const Options& options);
 
-    /** Construct a new block template with coinbase to scriptPubKeyIn */
-    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn);
+    /** Construct a new block template with coinbase to scriptPubKeyIn
+     *
+     * If pcoinstake is given, a proof-of-stake block with the coinstake time nCoinStakeTime is
+     * constructed instead: the block reward is added to the second output of the coinstake, which
+     * is left unsigned, and the block is not tested for validity. The caller is expected to sign
+     * the coinstake, call RegenerateCommitments() and sign the block. */
+    std::unique_ptr<CBlockTemplate> CreateNewBlock(const CScript& scriptPubKeyIn, const CMutableTransaction* pcoinstake = nullptr, unsigned int nCoinStakeTime = 0);
 
     static Optional<int64_t> m_last_block_num_txs;
     static Optional<int64_t> m_last_block_weight;
@@ -212,4 +217,7 @@ private:
 void IncrementExtraNonce(CBlock* pblock, const CBlockIndex* pindexPrev, unsigned int& nExtraNonce);
 int64_t UpdateTime(CBlockHeader* pblock, const Consensus::Params& consensusParams, const CBlockIndex* pindexPrev);
 
+/** Update the witness commitment and merkle root after the transactions of a block changed */
+void RegenerateCommitments(CBlock& block, const CBlockIndex* pindexPrev, const Consensus::Params& consensusParams);
+
 #endif // XEP_MINER_H
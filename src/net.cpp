@@ -32,6 +32,11 @@
 #include <poll.h>
 #endif
 
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
 #ifdef USE_UPNP
 #include <miniupnpc/miniupnpc.h>
 #include <miniupnpc/upnpcommands.h>
@@ -41,6 +46,7 @@
 static_assert(MINIUPNPC_API_VERSION >= 10, "miniUPnPc API version >= 10 assumed");
 #endif
 
+#include <limits>
 #include <unordered_map>
 
 #include <math.h>
@@ -75,6 +81,13 @@ enum BindFlags {
 // The sleep time needs to be small to avoid new sockets stalling
 static const uint64_t SELECT_TIMEOUT_MILLISECONDS = 50;
 
+#ifdef USE_EPOLL
+// epoll_event tags of the wakeup eventfd and the listen sockets, nodes are tagged with their id
+static const uint64_t EPOLL_TAG_WAKEUP = std::numeric_limits<uint64_t>::max();
+static const uint64_t EPOLL_TAG_LISTEN = EPOLL_TAG_WAKEUP - 1; // minus the index of the listen socket
+static const int EPOLL_MAX_EVENTS = 256;
+#endif
+
 const std::string NET_MESSAGE_COMMAND_OTHER = "*other*";
 
 static const uint64_t RANDOMIZER_ID_NETGROUP = 0x6c0edd8036ef4036ULL; // SHA256("netgroup")[0:8]
@@ -1045,6 +1058,9 @@ void CConnman::AcceptConnection(const ListenSocket& hListenSocket) {
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
+#ifdef USE_EPOLL
+        if (m_epoll_fd != -1) m_nodes_pending_registration.push_back(pnode);
+#endif
     }
 
     // We received a new connection, harvest entropy from the time (and our peer count)
@@ -1078,6 +1094,13 @@ void CConnman::DisconnectNodes()
                 // release outbound grant (if any)
                 pnode->grantOutbound.Release();
 
+#ifdef USE_EPOLL
+                // closing the socket also removes it from the epoll instance
+                m_nodes_pending_registration.erase(remove(m_nodes_pending_registration.begin(), m_nodes_pending_registration.end(), pnode), m_nodes_pending_registration.end());
+                m_epoll_nodes.erase(pnode->GetId());
+                m_epoll_readable.erase(pnode->GetId());
+#endif
+
                 // close socket and cleanup
                 pnode->CloseSocketDisconnect();
 
@@ -1324,6 +1347,67 @@ void CConnman::SocketEvents(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_s
 }
 #endif
 
+/**
+ * Reads from the socket of a node and hands complete messages to the message handler.
+ * Returns true, if the read filled the buffer, so that more data may be pending.
+ */
+bool CConnman::SocketRecvData(CNode *pnode)
+{
+    // typical socket buffer is 8K-64K
+    char pchBuf[0x10000];
+    int nBytes = 0;
+    {
+        LOCK(pnode->cs_hSocket);
+        if (pnode->hSocket == INVALID_SOCKET)
+            return false;
+        nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+    }
+    if (nBytes > 0)
+    {
+        bool notify = false;
+        if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
+            pnode->CloseSocketDisconnect();
+        RecordBytesRecv(nBytes);
+        if (notify) {
+            size_t nSizeAdded = 0;
+            auto it(pnode->vRecvMsg.begin());
+            for (; it != pnode->vRecvMsg.end(); ++it) {
+                // vRecvMsg contains only completed CNetMessage
+                // the single possible partially deserialized message are held by TransportDeserializer
+                nSizeAdded += it->m_raw_message_size;
+            }
+            {
+                LOCK(pnode->cs_vProcessMsg);
+                pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
+                pnode->nProcessQueueSize += nSizeAdded;
+                pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
+            }
+            WakeMessageHandler();
+        }
+    }
+    else if (nBytes == 0)
+    {
+        // socket closed gracefully
+        if (!pnode->fDisconnect) {
+            LogPrint(BCLog::NET, "socket closed for peer=%d\n", pnode->GetId());
+        }
+        pnode->CloseSocketDisconnect();
+    }
+    else if (nBytes < 0)
+    {
+        // error
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
+        {
+            if (!pnode->fDisconnect) {
+                LogPrint(BCLog::NET, "socket recv error for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(nErr));
+            }
+            pnode->CloseSocketDisconnect();
+        }
+    }
+    return nBytes == (int)sizeof(pchBuf);
+}
+
 void CConnman::SocketHandler()
 {
     std::set<SOCKET> recv_set, send_set, error_set;
@@ -1373,58 +1457,7 @@ void CConnman::SocketHandler()
         }
         if (recvSet || errorSet)
         {
-            // typical socket buffer is 8K-64K
-            char pchBuf[0x10000];
-            int nBytes = 0;
-            {
-                LOCK(pnode->cs_hSocket);
-                if (pnode->hSocket == INVALID_SOCKET)
-                    continue;
-                nBytes = recv(pnode->hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
-            }
-            if (nBytes > 0)
-            {
-                bool notify = false;
-                if (!pnode->ReceiveMsgBytes(pchBuf, nBytes, notify))
-                    pnode->CloseSocketDisconnect();
-                RecordBytesRecv(nBytes);
-                if (notify) {
-                    size_t nSizeAdded = 0;
-                    auto it(pnode->vRecvMsg.begin());
-                    for (; it != pnode->vRecvMsg.end(); ++it) {
-                        // vRecvMsg contains only completed CNetMessage
-                        // the single possible partially deserialized message are held by TransportDeserializer
-                        nSizeAdded += it->m_raw_message_size;
-                    }
-                    {
-                        LOCK(pnode->cs_vProcessMsg);
-                        pnode->vProcessMsg.splice(pnode->vProcessMsg.end(), pnode->vRecvMsg, pnode->vRecvMsg.begin(), it);
-                        pnode->nProcessQueueSize += nSizeAdded;
-                        pnode->fPauseRecv = pnode->nProcessQueueSize > nReceiveFloodSize;
-                    }
-                    WakeMessageHandler();
-                }
-            }
-            else if (nBytes == 0)
-            {
-                // socket closed gracefully
-                if (!pnode->fDisconnect) {
-                    LogPrint(BCLog::NET, "socket closed for peer=%d\n", pnode->GetId());
-                }
-                pnode->CloseSocketDisconnect();
-            }
-            else if (nBytes < 0)
-            {
-                // error
-                int nErr = WSAGetLastError();
-                if (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
-                {
-                    if (!pnode->fDisconnect) {
-                        LogPrint(BCLog::NET, "socket recv error for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(nErr));
-                    }
-                    pnode->CloseSocketDisconnect();
-                }
-            }
+            SocketRecvData(pnode);
         }
 
         //
@@ -1448,12 +1481,232 @@ void CConnman::SocketHandler()
     }
 }
 
+#ifdef USE_EPOLL
+/** Whether to read from a node now, see GenerateSelectSet() for why nodes with data to send are skipped. */
+static bool IsReceiveReady(CNode* pnode)
+{
+    if (pnode->fPauseRecv) return false;
+    LOCK(pnode->cs_vSend);
+    return pnode->vSendMsg.empty();
+}
+
+/**
+ * Creates the epoll instance and registers the listen sockets. On failure the
+ * socket handler falls back to SocketEvents().
+ */
+void CConnman::StartEpoll()
+{
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd == -1) {
+        LogPrintf("epoll_create1 failed: %s, falling back to poll()\n", NetworkErrorString(errno));
+        return;
+    }
+    m_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    bool fSuccess = m_wakeup_fd != -1;
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = EPOLL_TAG_WAKEUP;
+    fSuccess = fSuccess && epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wakeup_fd, &event) == 0;
+    for (size_t i = 0; fSuccess && i < vhListenSocket.size(); i++) {
+        // level-triggered, one connection is accepted per wakeup
+        event.data.u64 = EPOLL_TAG_LISTEN - i;
+        fSuccess = epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, vhListenSocket[i].socket, &event) == 0;
+    }
+    if (!fSuccess) {
+        LogPrintf("epoll setup failed: %s, falling back to poll()\n", NetworkErrorString(errno));
+        StopEpoll();
+    }
+}
+
+void CConnman::StopEpoll()
+{
+    if (m_wakeup_fd != -1) close(m_wakeup_fd);
+    if (m_epoll_fd != -1) close(m_epoll_fd);
+    m_wakeup_fd = -1;
+    m_epoll_fd = -1;
+    {
+        LOCK(cs_vNodes);
+        m_nodes_pending_registration.clear();
+    }
+    m_epoll_nodes.clear();
+    m_epoll_readable.clear();
+}
+
+/**
+ * Registers new nodes with the epoll instance. Nodes are registered edge-triggered
+ * once and stay registered until their socket is closed.
+ */
+void CConnman::RegisterPendingNodes()
+{
+    std::vector<CNode*> vNodesPending;
+    {
+        LOCK(cs_vNodes);
+        vNodesPending.swap(m_nodes_pending_registration);
+    }
+    for (CNode* pnode : vNodesPending) {
+        m_epoll_nodes.emplace(pnode->GetId(), pnode);
+
+        struct epoll_event event;
+        event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+        event.data.u64 = pnode->GetId();
+        LOCK(pnode->cs_hSocket);
+        if (pnode->hSocket == INVALID_SOCKET)
+            continue;
+        if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, pnode->hSocket, &event) != 0) {
+            LogPrint(BCLog::NET, "epoll_ctl failed for peer=%d: %s\n", pnode->GetId(), NetworkErrorString(errno));
+            pnode->fDisconnect = true;
+        }
+    }
+}
+
+/**
+ * Socket handler based on epoll, which only touches the nodes with pending events.
+ *
+ * Readiness is edge-triggered, so nodes stay marked as readable until a read
+ * doesn't fill the buffer. Nodes, which don't accept more data, because their
+ * receive queue is full or they have data to send, are left marked and read
+ * from once that changes. Sends are attempted optimistically by PushMessage()
+ * and only continue here, once the socket reports to be writable again.
+ */
+void CConnman::SocketHandlerEpoll()
+{
+    RegisterPendingNodes();
+
+    // don't wait, if data is left to read from an earlier wakeup
+    int nTimeout = SELECT_TIMEOUT_MILLISECONDS;
+    for (NodeId id : m_epoll_readable) {
+        if (IsReceiveReady(m_epoll_nodes.at(id))) {
+            nTimeout = 0;
+            break;
+        }
+    }
+
+    struct epoll_event events[EPOLL_MAX_EVENTS];
+    int nEvents = epoll_wait(m_epoll_fd, events, EPOLL_MAX_EVENTS, nTimeout);
+
+    if (interruptNet) return;
+
+    if (nEvents < 0) {
+        if (errno != EINTR) {
+            LogPrintf("socket epoll_wait error %s\n", NetworkErrorString(errno));
+            interruptNet.sleep_for(std::chrono::milliseconds(SELECT_TIMEOUT_MILLISECONDS));
+        }
+        return;
+    }
+
+    std::vector<CNode*> vNodesWritable;
+    for (int i = 0; i < nEvents; i++) {
+        const uint64_t tag = events[i].data.u64;
+        if (tag == EPOLL_TAG_WAKEUP) {
+            uint64_t nCount;
+            if (read(m_wakeup_fd, &nCount, sizeof(nCount)) != sizeof(nCount)) {
+                LogPrint(BCLog::NET, "socket handler wakeup read failed\n");
+            }
+            continue;
+        }
+        if (EPOLL_TAG_LISTEN - tag < vhListenSocket.size()) {
+            const ListenSocket& hListenSocket = vhListenSocket[EPOLL_TAG_LISTEN - tag];
+            if (hListenSocket.socket != INVALID_SOCKET) {
+                AcceptConnection(hListenSocket);
+            }
+            continue;
+        }
+        std::unordered_map<NodeId, CNode*>::const_iterator it = m_epoll_nodes.find((NodeId)tag);
+        if (it == m_epoll_nodes.end()) {
+            // node was disconnected since the event was queued
+            continue;
+        }
+        if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) {
+            m_epoll_readable.insert(it->first);
+        }
+        if (events[i].events & EPOLLOUT) {
+            vNodesWritable.push_back(it->second);
+        }
+    }
+
+    //
+    // Receive
+    //
+    for (std::set<NodeId>::iterator it = m_epoll_readable.begin(); it != m_epoll_readable.end(); ) {
+        if (interruptNet)
+            return;
+        CNode* pnode = m_epoll_nodes.at(*it);
+        if (!IsReceiveReady(pnode)) {
+            ++it;
+            continue;
+        }
+        // a short read drains the socket, data arriving later triggers a new event
+        if (SocketRecvData(pnode)) {
+            ++it;
+        } else {
+            it = m_epoll_readable.erase(it);
+        }
+    }
+
+    //
+    // Send
+    //
+    for (CNode* pnode : vNodesWritable) {
+        if (interruptNet)
+            return;
+        LOCK(pnode->cs_vSend);
+        if (pnode->vSendMsg.empty())
+            continue;
+        size_t nBytes = SocketSendData(pnode);
+        if (nBytes) {
+            RecordBytesSent(nBytes);
+        }
+    }
+
+    //
+    // Once per second, check all nodes for inactivity and retry sends, which
+    // were interrupted without filling the socket buffer
+    //
+    const int64_t nTime = GetSystemTimeInSeconds();
+    if (nTime != m_epoll_last_sweep) {
+        m_epoll_last_sweep = nTime;
+        for (const auto& entry : m_epoll_nodes) {
+            CNode* pnode = entry.second;
+            {
+                LOCK(pnode->cs_vSend);
+                if (!pnode->vSendMsg.empty()) {
+                    size_t nBytes = SocketSendData(pnode);
+                    if (nBytes) {
+                        RecordBytesSent(nBytes);
+                    }
+                }
+            }
+            InactivityCheck(pnode);
+        }
+    }
+}
+#endif
+
+void CConnman::WakeSocketHandler()
+{
+#ifdef USE_EPOLL
+    if (m_wakeup_fd != -1) {
+        uint64_t nCount = 1;
+        if (write(m_wakeup_fd, &nCount, sizeof(nCount)) != sizeof(nCount)) {
+            LogPrint(BCLog::NET, "socket handler wakeup failed\n");
+        }
+    }
+#endif
+}
+
 void CConnman::ThreadSocketHandler()
 {
     while (!interruptNet)
     {
         DisconnectNodes();
         NotifyNumConnectionsChanged();
+#ifdef USE_EPOLL
+        if (m_epoll_fd != -1) {
+            SocketHandlerEpoll();
+            continue;
+        }
+#endif
         SocketHandler();
     }
 }
@@ -2018,7 +2271,11 @@ void CConnman::OpenNetworkConnection(const CAddress& addrConnect, bool fCountFai
     {
         LOCK(cs_vNodes);
         vNodes.push_back(pnode);
+#ifdef USE_EPOLL
+        if (m_epoll_fd != -1) m_nodes_pending_registration.push_back(pnode);
+#endif
     }
+    WakeSocketHandler();
 }
 
 void CConnman::ThreadMessageHandler()
@@ -2278,6 +2535,10 @@ bool CConnman::Start(CScheduler& scheduler, const Options& connOptions)
         return false;
     }
 
+#ifdef USE_EPOLL
+    StartEpoll();
+#endif
+
     for (const auto& strDest : connOptions.vSeedNodes) {
         AddOneShot(strDest);
     }
@@ -2379,6 +2640,7 @@ void CConnman::Interrupt()
     condMsgProc.notify_all();
 
     interruptNet();
+    WakeSocketHandler();
     InterruptSocks5(true);
 
     if (semOutbound) {
@@ -2433,6 +2695,9 @@ void CConnman::StopNodes()
     }
     vNodes.clear();
     vNodesDisconnected.clear();
+#ifdef USE_EPOLL
+    StopEpoll();
+#endif
     vhListenSocket.clear();
     semOutbound.reset();
     semAddnode.reset();
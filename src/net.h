@@ -30,6 +30,7 @@
 #include <thread>
 #include <memory>
 #include <condition_variable>
+#include <unordered_map>
 
 #ifndef WIN32
 #include <arpa/inet.h>
@@ -355,6 +356,13 @@ private:
     bool GenerateSelectSet(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set);
     void SocketEvents(std::set<SOCKET> &recv_set, std::set<SOCKET> &send_set, std::set<SOCKET> &error_set);
     void SocketHandler();
+#ifdef USE_EPOLL
+    void StartEpoll();
+    void StopEpoll();
+    void RegisterPendingNodes();
+    void SocketHandlerEpoll();
+#endif
+    void WakeSocketHandler();
     void ThreadSocketHandler();
     void ThreadDNSAddressSeed();
 
@@ -374,6 +382,7 @@ private:
     NodeId GetNewNodeId();
 
     size_t SocketSendData(CNode *pnode) const;
+    bool SocketRecvData(CNode *pnode);
     void DumpAddresses();
 
     // Network stats
@@ -419,6 +428,21 @@ private:
     std::atomic<NodeId> nLastNodeId{0};
     unsigned int nPrevNodeCount{0};
 
+#ifdef USE_EPOLL
+    //! epoll instance of the socket handler, or -1 when falling back to poll()
+    int m_epoll_fd{-1};
+    //! eventfd to wake the socket handler from epoll_wait()
+    int m_wakeup_fd{-1};
+    //! Nodes added to vNodes, but not yet registered with the epoll instance
+    std::vector<CNode*> m_nodes_pending_registration GUARDED_BY(cs_vNodes);
+    //! Nodes registered with the epoll instance, only used by the socket handler thread
+    std::unordered_map<NodeId, CNode*> m_epoll_nodes;
+    //! Registered nodes that may have data left to read, only used by the socket handler thread
+    std::set<NodeId> m_epoll_readable;
+    //! Time of the last inactivity check of all nodes
+    int64_t m_epoll_last_sweep{0};
+#endif
+
     /**
      * Services this instance offers.
      *
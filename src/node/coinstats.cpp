@@ -6,7 +6,9 @@
 #include <node/coinstats.h>
 
 #include <coins.h>
+#include <crypto/muhash.h>
 #include <hash.h>
+#include <index/coinstatsindex.h>
 #include <serialize.h>
 #include <validation.h>
 #include <uint256.h>
@@ -14,38 +16,88 @@
 
 #include <map>
 
-static void ApplyStats(CCoinsStats &stats, CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+uint64_t GetBogoSize(const CScript& script_pub_key)
+{
+    return 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
+           2 /* scriptPubKey len */ + script_pub_key.size() /* scriptPubKey */;
+}
+
+//! The serialization of a coin committed to by the MuHash: the outpoint, the
+//! height and coinbase/coinstake flags encoded as in the chainstate, and the output.
+static CDataStream TxOutSer(const COutPoint& outpoint, const Coin& coin)
+{
+    CDataStream ss(SER_DISK, PROTOCOL_VERSION);
+    ss << outpoint;
+    ss << static_cast<uint32_t>(coin.nHeight | (coin.fCoinStake ? 1u << 30 : 0) | (coin.fCoinBase ? 1u << 31 : 0));
+    ss << coin.out;
+    return ss;
+}
+
+void ApplyCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin)
+{
+    CDataStream ss = TxOutSer(outpoint, coin);
+    muhash.Insert(reinterpret_cast<const unsigned char*>(ss.data()), ss.size());
+}
+
+void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin)
+{
+    CDataStream ss = TxOutSer(outpoint, coin);
+    muhash.Remove(reinterpret_cast<const unsigned char*>(ss.data()), ss.size());
+}
+
+static void ApplyHash(CHashWriter& ss, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
 {
-    assert(!outputs.empty());
     ss << hash;
     ss << VARINT(outputs.begin()->second.nHeight * 2 + outputs.begin()->second.fCoinBase ? 1u : 0u);
-    stats.nTransactions++;
     for (const auto& output : outputs) {
         ss << VARINT(output.first + 1);
         ss << output.second.out.scriptPubKey;
         ss << VARINT_MODE(output.second.out.nValue, VarIntMode::NONNEGATIVE_SIGNED);
+    }
+    ss << VARINT(0u);
+}
+
+static void ApplyHash(MuHash3072& muhash, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+{
+    for (const auto& output : outputs) {
+        ApplyCoinHash(muhash, COutPoint(hash, output.first), output.second);
+    }
+}
+
+static void ApplyHash(std::nullptr_t, const uint256& hash, const std::map<uint32_t, Coin>& outputs) {}
+
+template <typename T>
+static void ApplyStats(CCoinsStats& stats, T& hash_obj, const uint256& hash, const std::map<uint32_t, Coin>& outputs)
+{
+    assert(!outputs.empty());
+    stats.nTransactions++;
+    for (const auto& output : outputs) {
         stats.nTransactionOutputs++;
         stats.nTotalAmount += output.second.out.nValue;
-        stats.nBogoSize += 32 /* txid */ + 4 /* vout index */ + 4 /* height + coinbase */ + 8 /* amount */ +
-                           2 /* scriptPubKey len */ + output.second.out.scriptPubKey.size() /* scriptPubKey */;
+        stats.nBogoSize += GetBogoSize(output.second.out.scriptPubKey);
     }
-    ss << VARINT(0u);
+    ApplyHash(hash_obj, hash, outputs);
 }
 
+static void PrepareHash(CHashWriter& ss, const CCoinsStats& stats) { ss << stats.hashBlock; }
+static void PrepareHash(MuHash3072& muhash, const CCoinsStats& stats) {}
+static void PrepareHash(std::nullptr_t, const CCoinsStats& stats) {}
+
+static void FinalizeHash(CHashWriter& ss, CCoinsStats& stats) { stats.hashSerialized = ss.GetHash(); }
+static void FinalizeHash(MuHash3072& muhash, CCoinsStats& stats) { muhash.Finalize(stats.hashSerialized); }
+static void FinalizeHash(std::nullptr_t, CCoinsStats& stats) {}
+
 //! Calculate statistics about the unspent transaction output set
-bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
+template <typename T>
+static bool ComputeUTXOStats(CCoinsView* view, CCoinsStats& stats, T hash_obj)
 {
-    stats = CCoinsStats();
     std::unique_ptr<CCoinsViewCursor> pcursor(view->Cursor());
     assert(pcursor);
-
-    CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
-    stats.hashBlock = pcursor->GetBestBlock();
-    {
-        LOCK(cs_main);
-        stats.nHeight = LookupBlockIndex(stats.hashBlock)->nHeight;
+    if (pcursor->GetBestBlock() != stats.hashBlock) {
+        return error("%s: chainstate is not at block %s", __func__, stats.hashBlock.ToString());
     }
-    ss << stats.hashBlock;
+
+    PrepareHash(hash_obj, stats);
     uint256 prevkey;
     std::map<uint32_t, Coin> outputs;
     while (pcursor->Valid()) {
@@ -53,7 +105,7 @@ bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
         Coin coin;
         if (pcursor->GetKey(key) && pcursor->GetValue(coin)) {
             if (!outputs.empty() && key.hash != prevkey) {
-                ApplyStats(stats, ss, prevkey, outputs);
+                ApplyStats(stats, hash_obj, prevkey, outputs);
                 outputs.clear();
             }
             prevkey = key.hash;
@@ -65,9 +117,42 @@ bool GetUTXOStats(CCoinsView *view, CCoinsStats &stats)
         pcursor->Next();
     }
     if (!outputs.empty()) {
-        ApplyStats(stats, ss, prevkey, outputs);
+        ApplyStats(stats, hash_obj, prevkey, outputs);
     }
-    stats.hashSerialized = ss.GetHash();
+    FinalizeHash(hash_obj, stats);
     stats.nDiskSize = view->EstimateSize();
     return true;
 }
+
+bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats, const CBlockIndex* pindex)
+{
+    stats = CCoinsStats(stats.m_hash_type, stats.index_requested);
+    if (!pindex) {
+        LOCK(cs_main);
+        pindex = LookupBlockIndex(view->GetBestBlock());
+    }
+    stats.nHeight = pindex->nHeight;
+    stats.hashBlock = pindex->GetBlockHash();
+
+    // The index only maintains the MuHash, so it can't serve the legacy hash.
+    if (stats.index_requested && stats.m_hash_type != CoinStatsHashType::HASH_SERIALIZED &&
+        g_coin_stats_index && g_coin_stats_index->BlockUntilSyncedToCurrentChain()) {
+        stats.index_used = true;
+        return g_coin_stats_index->LookUpStats(pindex, stats);
+    }
+
+    switch (stats.m_hash_type) {
+    case CoinStatsHashType::HASH_SERIALIZED: {
+        CHashWriter ss(SER_GETHASH, PROTOCOL_VERSION);
+        return ComputeUTXOStats(view, stats, ss);
+    }
+    case CoinStatsHashType::MUHASH: {
+        MuHash3072 muhash;
+        return ComputeUTXOStats(view, stats, muhash);
+    }
+    case CoinStatsHashType::NONE: {
+        return ComputeUTXOStats(view, stats, nullptr);
+    }
+    } // no default case, so the compiler can warn about missing cases
+    assert(false);
+}
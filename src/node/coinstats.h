@@ -11,10 +11,22 @@
 
 #include <cstdint>
 
+class CBlockIndex;
 class CCoinsView;
+class COutPoint;
+class CScript;
+class Coin;
+class MuHash3072;
+
+enum class CoinStatsHashType {
+    HASH_SERIALIZED,
+    MUHASH,
+    NONE,
+};
 
 struct CCoinsStats
 {
+    CoinStatsHashType m_hash_type{CoinStatsHashType::HASH_SERIALIZED};
     int nHeight{0};
     uint256 hashBlock{};
     uint64_t nTransactions{0};
@@ -26,9 +38,27 @@ struct CCoinsStats
 
     //! The number of coins contained.
     uint64_t coins_count{0};
+
+    //! Whether the coinstatsindex may be used, if it is enabled and in sync
+    bool index_requested{true};
+    //! Whether the statistics were looked up in the coinstatsindex
+    bool index_used{false};
+
+    CCoinsStats() = default;
+    explicit CCoinsStats(CoinStatsHashType hash_type, bool use_index = true)
+        : m_hash_type(hash_type), index_requested(use_index) {}
 };
 
-//! Calculate statistics about the unspent transaction output set
-bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats);
+//! Calculate statistics about the unspent transaction output set. With a
+//! hash type other than HASH_SERIALIZED the coinstatsindex is used when it is
+//! in sync; it is also required for any block other than the view's best block.
+bool GetUTXOStats(CCoinsView* view, CCoinsStats& stats, const CBlockIndex* pindex = nullptr);
+
+//! The bogo size a coin with this script adds to the statistics
+uint64_t GetBogoSize(const CScript& script_pub_key);
+
+//! Add or remove a coin to or from a MuHash of the UTXO set
+void ApplyCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin);
+void RemoveCoinHash(MuHash3072& muhash, const COutPoint& outpoint, const Coin& coin);
 
 #endif // XEP_NODE_COINSTATS_H
@@ -0,0 +1,140 @@
+/**
+ * @file blockprefetch.cpp
+ *
+ * This file contains the read ahead of blocks for the initial scan.
+ */
+
+#include <omnicore/blockprefetch.h>
+
+#include <omnicore/omnicore.h>
+#include <omnicore/seedblocks.h>
+
+#include <chainparams.h>
+#include <coins.h>
+#include <index/txindex.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <flatfile.h>
+#include <sync.h>
+#include <tinyformat.h>
+#include <uint256.h>
+#include <util/threadnames.h>
+#include <validation.h>
+
+#include <map>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace mastercore
+{
+CMPBlockPrefetcher::CMPBlockPrefetcher(int nFirstBlockIn, std::vector<PrefetchLocation> vLocationsIn, int nThreads, bool fSeedBlockFilterIn) :
+    nNextBlock(nFirstBlockIn),
+    nScanBlock(nFirstBlockIn),
+    fStop(false),
+    nFirstBlock(nFirstBlockIn),
+    nLastBlock(nFirstBlockIn + (int) vLocationsIn.size() - 1),
+    vLocations(std::move(vLocationsIn)),
+    fSeedBlockFilter(fSeedBlockFilterIn)
+{
+    for (int i = 0; i < nThreads; ++i) {
+        threads.emplace_back([this, i] {
+            util::ThreadRename(strprintf("omniscan.%d", i));
+            ThreadPrefetch();
+        });
+    }
+}
+
+CMPBlockPrefetcher::~CMPBlockPrefetcher()
+{
+    {
+        LOCK(cs_prefetch);
+        fStop = true;
+    }
+    condPrefetch.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void CMPBlockPrefetcher::ThreadPrefetch()
+{
+    while (true) {
+        int nBlock;
+        {
+            WAIT_LOCK(cs_prefetch, lock);
+            while (!fStop && nNextBlock <= nLastBlock && nNextBlock >= nScanBlock + OMNI_SCAN_PREFETCH_WINDOW) {
+                condPrefetch.wait(lock);
+            }
+            if (fStop || nNextBlock > nLastBlock) return;
+            nBlock = nNextBlock++;
+        }
+
+        PrefetchedBlock prefetched;
+        Prefetch(nBlock, prefetched);
+
+        {
+            LOCK(cs_prefetch);
+            blocks[nBlock] = std::move(prefetched);
+        }
+        condPrefetch.notify_all();
+    }
+}
+
+/**
+ * Reads a block and looks up the coins spent by its transactions with an
+ * Omni marker. Inputs, which can't be resolved, are left to the scan.
+ * Blocks, which can't be read, are read again by the scan.
+ */
+void CMPBlockPrefetcher::Prefetch(int nBlock, PrefetchedBlock& prefetched) const
+{
+    // the scan doesn't read blocks, which are known to have no Omni transactions
+    if (fSeedBlockFilter && SkipBlock(nBlock)) return;
+
+    const PrefetchLocation& location = vLocations[nBlock - nFirstBlock];
+    if (!ReadBlockFromDisk(prefetched.block, location.pos, Params().GetConsensus())) return;
+    if (prefetched.block.GetHash() != location.hash) return;
+    prefetched.fRead = true;
+
+    if (!g_txindex) return;
+    prefetched.inputs = std::make_shared<std::map<COutPoint, Coin>>();
+
+    for (const CTransactionRef& tx : prefetched.block.vtx) {
+        if (tx->IsCoinBase() || !HasMarkerUnsafe(tx)) continue;
+
+        for (const CTxIn& txIn : tx->vin) {
+            CTransactionRef txPrev;
+            uint256 hashBlock;
+            if (!g_txindex->FindTx(txIn.prevout.hash, hashBlock, txPrev)) continue;
+            if (txIn.prevout.n >= txPrev->vout.size()) continue;
+
+            // the height isn't looked up, because it requires cs_main, and
+            // parsing only depends on the spent output
+            Coin coin;
+            coin.out = txPrev->vout[txIn.prevout.n];
+            coin.nHeight = 1;
+            prefetched.inputs->emplace(txIn.prevout, std::move(coin));
+        }
+    }
+}
+
+void CMPBlockPrefetcher::Take(int nBlock, PrefetchedBlock& prefetched)
+{
+    // blocks, which weren't located, are never read ahead
+    if (nBlock > nLastBlock) return;
+
+    WAIT_LOCK(cs_prefetch, lock);
+    nScanBlock = nBlock;
+    condPrefetch.notify_all();
+
+    // blocks skipped by the scan are dropped
+    blocks.erase(blocks.begin(), blocks.lower_bound(nBlock));
+
+    std::map<int, PrefetchedBlock>::iterator it;
+    while ((it = blocks.find(nBlock)) == blocks.end()) {
+        condPrefetch.wait(lock);
+    }
+    prefetched = std::move(it->second);
+    blocks.erase(it);
+}
+}
@@ -0,0 +1,91 @@
+#ifndef XEP_OMNICORE_BLOCKPREFETCH_H
+#define XEP_OMNICORE_BLOCKPREFETCH_H
+
+#include <coins.h>
+#include <flatfile.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/** Default number of threads, which read blocks ahead of the initial scan (0 = read in the scan thread) */
+static const int DEFAULT_OMNI_SCAN_THREADS = 0;
+/** Number of blocks, which may be read ahead of the initial scan */
+static const int OMNI_SCAN_PREFETCH_WINDOW = 256;
+
+namespace mastercore
+{
+/** A block, read ahead of the initial scan. */
+struct PrefetchedBlock
+{
+    //! Whether the block was read from disk
+    bool fRead;
+    CBlock block;
+    //! Coins spent by transactions with an Omni marker, to be used instead of looking them up
+    std::shared_ptr<std::map<COutPoint, Coin>> inputs;
+
+    PrefetchedBlock() : fRead(false) {};
+};
+
+/** Where a block of the initial scan is stored, resolved by the scan thread. */
+struct PrefetchLocation
+{
+    FlatFilePos pos;
+    uint256 hash;
+
+    PrefetchLocation(const FlatFilePos& posIn, const uint256& hashIn) : pos(posIn), hash(hashIn) {};
+};
+
+/**
+ * Reads the blocks of the initial scan on worker threads, while the scan
+ * thread processes earlier blocks.
+ *
+ * The workers also resolve the inputs of the transactions with an Omni
+ * marker from the transaction index, which is where most of the time of a
+ * scan goes. Nothing is decoded or interpreted here: the state is still
+ * only updated by the scan thread, in block order, so the result of a scan
+ * doesn't depend on the number of threads.
+ *
+ * The locations of the blocks are resolved by the scan thread, before the
+ * workers are started. Workers never take cs_main, because the scan may
+ * run while the caller holds it.
+ */
+class CMPBlockPrefetcher
+{
+private:
+    Mutex cs_prefetch;
+    std::condition_variable condPrefetch;
+    //! Blocks read, but not yet taken by the scan
+    std::map<int, PrefetchedBlock> blocks GUARDED_BY(cs_prefetch);
+    //! Next block to be read by a worker
+    int nNextBlock GUARDED_BY(cs_prefetch);
+    //! Block the scan waits for, workers don't read further than the window ahead of it
+    int nScanBlock GUARDED_BY(cs_prefetch);
+    bool fStop GUARDED_BY(cs_prefetch);
+
+    const int nFirstBlock;
+    const int nLastBlock;
+    const std::vector<PrefetchLocation> vLocations;
+    const bool fSeedBlockFilter;
+    std::vector<std::thread> threads;
+
+    void ThreadPrefetch();
+    void Prefetch(int nBlock, PrefetchedBlock& prefetched) const;
+
+public:
+    /** Reads the blocks stored at vLocations, which start at height nFirstBlock. */
+    CMPBlockPrefetcher(int nFirstBlock, std::vector<PrefetchLocation> vLocations, int nThreads, bool fSeedBlockFilter);
+    ~CMPBlockPrefetcher();
+
+    /** Waits for a block to be read and takes it. Blocks must be taken in ascending order. Leaves fRead unset, if the block couldn't be read. */
+    void Take(int nBlock, PrefetchedBlock& prefetched);
+};
+}
+
+#endif // XEP_OMNICORE_BLOCKPREFETCH_H
@@ -3,12 +3,381 @@
 #include <omnicore/log.h>
 
 #include <fs.h>
+#include <sync.h>
 #include <util/system.h>
 
+#include <leveldb/cache.h>
 #include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
+#include <leveldb/iterator.h>
 #include <leveldb/write_batch.h>
 
 #include <stdint.h>
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <string>
+
+/**
+ * Returns the block cache, which is shared by all Omni databases.
+ */
+static leveldb::Cache* GetSharedBlockCache()
+{
+    static std::unique_ptr<leveldb::Cache> cache([] {
+        const int64_t nCacheMiB = std::max<int64_t>(1, gArgs.GetArg("-omnidbcache", DEFAULT_OMNI_DB_CACHE));
+        PrintToLog("Using %d MiB of block cache for the Omni databases\n", nCacheMiB);
+        return leveldb::NewLRUCache(nCacheMiB << 20);
+    }());
+    return cache.get();
+}
+
+/**
+ * Returns the bloom filter policy, which is shared by all Omni databases.
+ */
+static const leveldb::FilterPolicy* GetSharedFilterPolicy()
+{
+    static std::unique_ptr<const leveldb::FilterPolicy> policy(leveldb::NewBloomFilterPolicy(10));
+    return policy.get();
+}
+
+/**
+ * Iterator over a database, with pending writes of the current block applied.
+ *
+ * Both sources are ordered bytewise, like the databases. For equal keys the
+ * pending write wins, and pending deletions hide the stored entry.
+ */
+class CDBPendingIterator : public leveldb::Iterator
+{
+private:
+    std::unique_ptr<leveldb::Iterator> base;
+    const std::shared_ptr<const CDBBase::PendingWrites> pending;
+    //! Position in the pending writes, end() if there is none in the current direction
+    CDBBase::PendingWrites::const_iterator itPending;
+    bool fForward{true};
+    bool fFromPending{false};
+    bool fValid{false};
+
+    void PendingBack()
+    {
+        if (itPending == pending->begin()) {
+            itPending = pending->end();
+        } else {
+            --itPending;
+        }
+    }
+
+    void FindNextForward()
+    {
+        fValid = false;
+        while (base->Valid() || itPending != pending->end()) {
+            const int cmp = itPending == pending->end() ? -1 : !base->Valid() ? 1 : base->key().compare(itPending->first);
+            if (cmp < 0) {
+                fFromPending = false;
+                fValid = true;
+                return;
+            }
+            if (cmp == 0) base->Next();
+            if (itPending->second) {
+                fFromPending = true;
+                fValid = true;
+                return;
+            }
+            ++itPending;
+        }
+    }
+
+    void FindNextBackward()
+    {
+        fValid = false;
+        while (base->Valid() || itPending != pending->end()) {
+            const int cmp = itPending == pending->end() ? 1 : !base->Valid() ? -1 : base->key().compare(itPending->first);
+            if (cmp > 0) {
+                fFromPending = false;
+                fValid = true;
+                return;
+            }
+            if (cmp == 0) base->Prev();
+            if (itPending->second) {
+                fFromPending = true;
+                fValid = true;
+                return;
+            }
+            PendingBack();
+        }
+    }
+
+public:
+    CDBPendingIterator(leveldb::Iterator* baseIn, const std::shared_ptr<const CDBBase::PendingWrites>& pendingIn)
+        : base(baseIn), pending(pendingIn), itPending(pending->end()) {}
+
+    bool Valid() const override { return fValid; }
+
+    void SeekToFirst() override
+    {
+        base->SeekToFirst();
+        itPending = pending->begin();
+        fForward = true;
+        FindNextForward();
+    }
+
+    void SeekToLast() override
+    {
+        base->SeekToLast();
+        itPending = pending->end();
+        PendingBack();
+        fForward = false;
+        FindNextBackward();
+    }
+
+    void Seek(const leveldb::Slice& target) override
+    {
+        base->Seek(target);
+        itPending = pending->lower_bound(target.ToString());
+        fForward = true;
+        FindNextForward();
+    }
+
+    void Next() override
+    {
+        assert(fValid);
+        if (!fForward) {
+            const std::string strKey = key().ToString();
+            base->Seek(strKey);
+            if (base->Valid() && base->key() == strKey) base->Next();
+            itPending = pending->upper_bound(strKey);
+            fForward = true;
+        } else if (fFromPending) {
+            ++itPending;
+        } else {
+            base->Next();
+        }
+        FindNextForward();
+    }
+
+    void Prev() override
+    {
+        assert(fValid);
+        if (fForward) {
+            const std::string strKey = key().ToString();
+            base->Seek(strKey);
+            if (base->Valid()) {
+                base->Prev();
+            } else {
+                base->SeekToLast();
+            }
+            itPending = pending->lower_bound(strKey);
+            PendingBack();
+            fForward = false;
+        } else if (fFromPending) {
+            PendingBack();
+        } else {
+            base->Prev();
+        }
+        FindNextBackward();
+    }
+
+    leveldb::Slice key() const override
+    {
+        assert(fValid);
+        return fFromPending ? leveldb::Slice(itPending->first) : base->key();
+    }
+
+    leveldb::Slice value() const override
+    {
+        assert(fValid);
+        return fFromPending ? leveldb::Slice(*itPending->second) : base->value();
+    }
+
+    leveldb::Status status() const override { return base->status(); }
+};
+
+/**
+ * Adds the content of a write batch to the pending writes.
+ */
+class CDBPendingBatchHandler : public leveldb::WriteBatch::Handler
+{
+private:
+    CDBBase::PendingWrites& pending;
+
+public:
+    explicit CDBPendingBatchHandler(CDBBase::PendingWrites& pendingIn) : pending(pendingIn) {}
+
+    void Put(const leveldb::Slice& key, const leveldb::Slice& value) override
+    {
+        pending[key.ToString()] = value.ToString();
+    }
+
+    void Delete(const leveldb::Slice& key) override
+    {
+        pending[key.ToString()] = nullopt;
+    }
+};
+
+CDBBase::CDBBase() : pdb(NULL), nRead(0), nWritten(0)
+{
+    options.paranoid_checks = true;
+    options.create_if_missing = true;
+    options.compression = leveldb::kNoCompression;
+    options.max_open_files = 64;
+    options.block_cache = GetSharedBlockCache();
+    options.filter_policy = GetSharedFilterPolicy();
+    readoptions.verify_checksums = true;
+    iteroptions.verify_checksums = true;
+    iteroptions.fill_cache = false;
+    syncoptions.sync = true;
+}
+
+/**
+ * Creates and returns a new LevelDB iterator, which includes pending writes.
+ */
+leveldb::Iterator* CDBBase::NewIterator() const
+{
+    assert(pdb != NULL);
+    LOCK(cs_pending);
+    if (!pending || pending->empty()) {
+        return pdb->NewIterator(iteroptions);
+    }
+    // the iterator keeps the current pending writes, later writes copy them
+    return new CDBPendingIterator(pdb->NewIterator(iteroptions), pending);
+}
+
+CDBBase::PendingWrites& CDBBase::ModifyPending()
+{
+    AssertLockHeld(cs_pending);
+    assert(pending);
+    if (pending.use_count() > 1) {
+        pending = std::make_shared<PendingWrites>(*pending);
+    }
+    return *pending;
+}
+
+/**
+ * Stores a value, or queues it, while a block is processed.
+ */
+leveldb::Status CDBBase::Put(const leveldb::Slice& key, const leveldb::Slice& value)
+{
+    {
+        LOCK(cs_pending);
+        if (pending) {
+            ModifyPending()[key.ToString()] = value.ToString();
+            return leveldb::Status::OK();
+        }
+    }
+    return pdb->Put(writeoptions, key, value);
+}
+
+/**
+ * Reads a value, taking pending writes into account.
+ */
+leveldb::Status CDBBase::Get(const leveldb::Slice& key, std::string* value) const
+{
+    {
+        LOCK(cs_pending);
+        if (pending) {
+            PendingWrites::const_iterator it = pending->find(key.ToString());
+            if (it != pending->end()) {
+                if (!it->second) return leveldb::Status::NotFound(key);
+                *value = *it->second;
+                return leveldb::Status::OK();
+            }
+        }
+    }
+    return pdb->Get(readoptions, key, value);
+}
+
+/**
+ * Deletes a value, or queues the deletion, while a block is processed.
+ */
+leveldb::Status CDBBase::Erase(const leveldb::Slice& key)
+{
+    {
+        LOCK(cs_pending);
+        if (pending) {
+            ModifyPending()[key.ToString()] = nullopt;
+            return leveldb::Status::OK();
+        }
+    }
+    return pdb->Delete(writeoptions, key);
+}
+
+/**
+ * Writes a batch, or queues its content, while a block is processed.
+ */
+leveldb::Status CDBBase::Apply(leveldb::WriteBatch& batch, bool fSync)
+{
+    {
+        LOCK(cs_pending);
+        if (pending) {
+            CDBPendingBatchHandler handler(ModifyPending());
+            fPendingSync |= fSync;
+            return batch.Iterate(&handler);
+        }
+    }
+    return pdb->Write(fSync ? syncoptions : writeoptions, &batch);
+}
+
+/**
+ * Starts collecting writes, until the block is committed.
+ *
+ * Writes of an earlier block, which were not committed, are dropped, so an
+ * incomplete block never leaks into the next one.
+ */
+void CDBBase::StartBlockBatch()
+{
+    LOCK(cs_pending);
+    DropPending();
+    pending = std::make_shared<PendingWrites>();
+}
+
+/**
+ * Drops the collected writes of an incomplete block, and writes directly again.
+ */
+void CDBBase::AbortBlockBatch()
+{
+    LOCK(cs_pending);
+    DropPending();
+}
+
+void CDBBase::DropPending()
+{
+    AssertLockHeld(cs_pending);
+    if (pending && !pending->empty()) {
+        PrintToLog("Dropping %d uncommitted entries of an incomplete block\n", pending->size());
+    }
+    pending.reset();
+    fPendingSync = false;
+}
+
+/**
+ * Commits the collected writes of the block with one batch.
+ */
+bool CDBBase::CommitBlockBatch()
+{
+    LOCK(cs_pending);
+    if (!pending) return true;
+    if (pending->empty()) {
+        pending.reset();
+        return true;
+    }
+
+    leveldb::WriteBatch batch;
+    for (const auto& entry : *pending) {
+        if (entry.second) {
+            batch.Put(entry.first, *entry.second);
+        } else {
+            batch.Delete(entry.first);
+        }
+    }
+    const size_t nEntries = pending->size();
+    leveldb::Status status = pdb->Write(fPendingSync ? syncoptions : writeoptions, &batch);
+    pending.reset();
+
+    if (msc_debug_persistence) PrintToLog("Committed %d entries of block: %s\n", nEntries, status.ToString());
+    if (!status.ok()) {
+        PrintToLog("%s(): ERROR: failed to write block batch: %s\n", __func__, status.ToString());
+    }
+    return status.ok();
+}
 
 /**
  * Opens or creates a LevelDB based database.
@@ -32,6 +401,11 @@ void CDBBase::Clear()
 {
     int64_t nTimeStart = GetTimeMicros();
     unsigned int n = 0;
+    {
+        // everything is removed, including writes not committed yet
+        LOCK(cs_pending);
+        if (pending) pending = std::make_shared<PendingWrites>();
+    }
     leveldb::WriteBatch batch;
     CDBaseIterator it{NewIterator()};
 
@@ -55,6 +429,7 @@ void CDBBase::Clear()
  */
 void CDBBase::Close()
 {
+    AbortBlockBatch();
     if (pdb) {
         delete pdb;
         pdb = NULL;
@@ -5,14 +5,23 @@
 #include <cstdint>
 #include <iterator>
 #include <leveldb/db.h>
+#include <leveldb/write_batch.h>
 
 #include <clientversion.h>
 #include <fs.h>
+#include <optional.h>
 #include <streams.h>
+#include <sync.h>
 
 #include <assert.h>
+#include <map>
 #include <memory>
 #include <stddef.h>
+#include <stdexcept>
+#include <string>
+
+//! -omnidbcache default (MiB), shared by all Omni databases
+static const int64_t DEFAULT_OMNI_DB_CACHE = 64;
 
 template<typename T>
 bool StringToValue(std::string&& s, T& value)
@@ -47,13 +56,39 @@ inline std::string ValueToString(const std::string& value)
 }
 
 /** Base class for LevelDB based storage.
+ *
+ * All databases share one block cache, sized by -omnidbcache, and use bloom
+ * filters for point lookups.
+ *
+ * While a block is processed, writes are collected in memory and committed
+ * with a single batch at the end of the block. Reads and iterators see the
+ * pending writes, so the batching is invisible to the users of the database.
  */
 class CDBBase
 {
+public:
+    //! Pending writes, keyed by database key, where an empty value marks a deletion
+    typedef std::map<std::string, Optional<std::string>> PendingWrites;
+
 private:
     //! Options used when iterating over values of the database
     leveldb::ReadOptions iteroptions;
 
+    //! Guards pending and fPendingSync
+    mutable Mutex cs_pending;
+
+    //! Writes of the current block, or null, if writes go to the database directly
+    std::shared_ptr<PendingWrites> pending GUARDED_BY(cs_pending);
+
+    //! Whether one of the pending writes was requested as sync write
+    bool fPendingSync GUARDED_BY(cs_pending){false};
+
+    //! Returns the pending writes for modification, copying them, if an iterator still refers to them
+    PendingWrites& ModifyPending() EXCLUSIVE_LOCKS_REQUIRED(cs_pending);
+
+    //! Drops the pending writes, and writes directly again
+    void DropPending() EXCLUSIVE_LOCKS_REQUIRED(cs_pending);
+
 protected:
     //! Database options used
     leveldb::Options options;
@@ -76,17 +111,7 @@ protected:
     //! Number of entries written
     unsigned int nWritten;
 
-    CDBBase() : pdb(NULL), nRead(0), nWritten(0)
-    {
-        options.paranoid_checks = true;
-        options.create_if_missing = true;
-        options.compression = leveldb::kNoCompression;
-        options.max_open_files = 64;
-        readoptions.verify_checksums = true;
-        iteroptions.verify_checksums = true;
-        iteroptions.fill_cache = false;
-        syncoptions.sync = true;
-    }
+    CDBBase();
 
     virtual ~CDBBase()
     {
@@ -97,15 +122,24 @@ protected:
      * Creates and returns a new LevelDB iterator.
      *
      * It is expected that the database is not closed. The iterator is owned by the
-     * caller, and the object has to be deleted explicitly.
+     * caller, and the object has to be deleted explicitly. Pending writes of the
+     * current block are merged into the iteration.
      *
      * @return A new LevelDB iterator
      */
-    leveldb::Iterator* NewIterator() const
-    {
-        assert(pdb != NULL);
-        return pdb->NewIterator(iteroptions);
-    }
+    leveldb::Iterator* NewIterator() const;
+
+    /** Stores a value, or queues it, while a block is processed. */
+    leveldb::Status Put(const leveldb::Slice& key, const leveldb::Slice& value);
+
+    /** Reads a value, taking pending writes into account. */
+    leveldb::Status Get(const leveldb::Slice& key, std::string* value) const;
+
+    /** Deletes a value, or queues the deletion, while a block is processed. */
+    leveldb::Status Erase(const leveldb::Slice& key);
+
+    /** Writes a batch, or queues its content, while a block is processed. */
+    leveldb::Status Apply(leveldb::WriteBatch& batch, bool fSync = false);
 
     template<typename K, typename V>
     bool Write(const K& key, const V& value)
@@ -114,7 +148,7 @@ protected:
         CDataStream ssKey(SER_DISK, CLIENT_VERSION, K::prefix, key);
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
         assert(pdb);
-        return pdb->Put(writeoptions, slKey, ValueToString(value)).ok();
+        return Put(slKey, ValueToString(value)).ok();
     }
 
     template<typename K, typename V>
@@ -125,7 +159,7 @@ protected:
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
         std::string strValue;
         assert(pdb);
-        return pdb->Get(readoptions, slKey, &strValue).ok()
+        return Get(slKey, &strValue).ok()
             && StringToValue(std::move(strValue), value);
     }
 
@@ -136,7 +170,7 @@ protected:
         CDataStream ssKey(SER_DISK, CLIENT_VERSION, K::prefix, key);
         leveldb::Slice slKey(ssKey.data(), ssKey.size());
         assert(pdb);
-        return pdb->Delete(leveldb::WriteOptions(), slKey).ok();
+        return Erase(slKey).ok();
     }
 
     /**
@@ -153,6 +187,8 @@ protected:
 
     /**
      * Deinitializes and closes the database.
+     *
+     * Writes of a block, which was not completed, are dropped.
      */
     void Close();
 
@@ -161,6 +197,79 @@ public:
      * Deletes all entries of the database, and resets the counters.
      */
     void Clear();
+
+    /**
+     * Starts collecting writes, until the block is committed.
+     *
+     * Uncommitted writes of an earlier block are dropped.
+     */
+    void StartBlockBatch();
+
+    /**
+     * Drops the collected writes of an incomplete block.
+     */
+    void AbortBlockBatch();
+
+    /**
+     * Commits the collected writes of the block with one batch.
+     *
+     * @return True, if the writes were stored successfully
+     */
+    bool CommitBlockBatch();
+
+    /**
+     * Creates an iterator over all entries, which is not affected by later writes.
+     */
+    std::unique_ptr<leveldb::Iterator> NewSnapshotIterator() const
+    {
+        return std::unique_ptr<leveldb::Iterator>(NewIterator());
+    }
+
+    /**
+     * Writes the entries of an iterator to a stream, followed by an empty key.
+     */
+    template<typename Stream>
+    static void Export(Stream& s, leveldb::Iterator& it)
+    {
+        for (it.SeekToFirst(); it.Valid(); it.Next()) {
+            s << it.key().ToString() << it.value().ToString();
+        }
+        if (!it.status().ok()) {
+            throw std::runtime_error("Failed to read database: " + it.status().ToString());
+        }
+        s << std::string();
+    }
+
+    /**
+     * Replaces all entries of the database with entries written by Export().
+     */
+    template<typename Stream>
+    void Import(Stream& s)
+    {
+        Clear();
+        leveldb::WriteBatch batch;
+        std::string key, value;
+        while (true) {
+            s >> key;
+            if (key.empty()) break;
+            s >> value;
+            batch.Put(key, value);
+            if (batch.ApproximateSize() >= (16 << 20)) {
+                ApplyImported(batch);
+            }
+        }
+        ApplyImported(batch);
+    }
+
+private:
+    void ApplyImported(leveldb::WriteBatch& batch)
+    {
+        leveldb::Status status = Apply(batch);
+        if (!status.ok()) {
+            throw std::runtime_error("Failed to write database: " + status.ToString());
+        }
+        batch.Clear();
+    }
 };
 
 template<typename T>
@@ -232,7 +232,7 @@ bool CMPSPInfo::updateSP(uint32_t propertyId, const Entry& info)
     std::string strSpPrevValue;
 
     // if a value exists move it to the old key
-    if (!pdb->Get(readoptions, slSpKey, &strSpPrevValue).IsNotFound()) {
+    if (!Get(slSpKey, &strSpPrevValue).IsNotFound()) {
         batch.Put(slSpPrevKey, strSpPrevValue);
     }
     batch.Put(slSpKey, slSpValue);
@@ -247,7 +247,7 @@ bool CMPSPInfo::updateSP(uint32_t propertyId, const Entry& info)
         batch.Put(delegateKey, slDelegateValue);
     }
 
-    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    leveldb::Status status = Apply(batch, true);
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR for SP %d: %s\n", __func__, propertyId, status.ToString());
@@ -297,10 +297,10 @@ uint32_t CMPSPInfo::putSP(uint8_t ecosystem, const Entry& info)
 
     // sanity checking
     std::string existingEntry;
-    if (!pdb->Get(readoptions, slSpKey, &existingEntry).IsNotFound() && slSpValue.compare(existingEntry) != 0) {
+    if (!Get(slSpKey, &existingEntry).IsNotFound() && slSpValue.compare(existingEntry) != 0) {
         std::string strError = strprintf("writing SP %d to DB, when a different SP already exists for that identifier", propertyId);
         PrintToLog("%s() ERROR: %s\n", __func__, strError);
-    } else if (!pdb->Get(readoptions, slTxIndexKey, &existingEntry).IsNotFound() && slTxValue.compare(existingEntry) != 0) {
+    } else if (!Get(slTxIndexKey, &existingEntry).IsNotFound() && slTxValue.compare(existingEntry) != 0) {
         std::string strError = strprintf("writing index txid %s : SP %d is overwriting a different value", info.txid.ToString(), propertyId);
         PrintToLog("%s() ERROR: %s\n", __func__, strError);
     }
@@ -309,7 +309,7 @@ uint32_t CMPSPInfo::putSP(uint8_t ecosystem, const Entry& info)
     std::string uniqueKey = strprintf("UE-%d", propertyId);
     if (info.unique) {
         // sanity checking
-        if (!pdb->Get(readoptions, uniqueKey, &existingEntry).IsNotFound() && existingEntry != strprintf("%d", info.unique)) {
+        if (!Get(uniqueKey, &existingEntry).IsNotFound() && existingEntry != strprintf("%d", info.unique)) {
             std::string strError = strprintf("writing SP %d unique field to DB, when a different SP already exists for that identifier", propertyId);
             PrintToLog("%s() ERROR: %s\n", __func__, strError);
         }
@@ -324,7 +324,7 @@ uint32_t CMPSPInfo::putSP(uint8_t ecosystem, const Entry& info)
         batch.Put(uniqueKey, strprintf("%d", info.unique));
     }
 
-    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    leveldb::Status status = Apply(batch, true);
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR for SP %d: %s\n", __func__, propertyId, status.ToString());
@@ -351,7 +351,7 @@ bool CMPSPInfo::getSP(uint32_t propertyId, Entry& info) const
 
     // DB value for property entry
     std::string strSpValue;
-    leveldb::Status status = pdb->Get(readoptions, slSpKey, &strSpValue);
+    leveldb::Status status = Get(slSpKey, &strSpValue);
     if (!status.ok()) {
         if (!status.IsNotFound()) {
             PrintToLog("%s(): ERROR for SP %d: %s\n", __func__, propertyId, status.ToString());
@@ -370,7 +370,7 @@ bool CMPSPInfo::getSP(uint32_t propertyId, Entry& info) const
     // Check for unique entry
     std::string uniqueKey = strprintf("UE-%d", propertyId);
     std::string uniqueValue;
-    leveldb::Status statusUnique = pdb->Get(readoptions, uniqueKey, &uniqueValue);
+    leveldb::Status statusUnique = Get(uniqueKey, &uniqueValue);
     if (statusUnique.ok() && !statusUnique.IsNotFound()) {
         try {
             info.unique = boost::lexical_cast<bool>(uniqueValue);
@@ -383,7 +383,7 @@ bool CMPSPInfo::getSP(uint32_t propertyId, Entry& info) const
     // Check for delegate entry
     std::string delegateKey = strprintf("DE-%d", propertyId);
     std::string delegateValue;
-    leveldb::Status statusDelegate = pdb->Get(readoptions, delegateKey, &delegateValue);
+    leveldb::Status statusDelegate = Get(delegateKey, &delegateValue);
     if (statusDelegate.ok() && !statusDelegate.IsNotFound()) {
         try {
             CDataStream ssDelegateValue(delegateValue.data(), delegateValue.data() + delegateValue.size(), SER_DISK, CLIENT_VERSION);
@@ -412,7 +412,7 @@ bool CMPSPInfo::hasSP(uint32_t propertyId) const
 
     // DB value for property entry
     std::string strSpValue;
-    leveldb::Status status = pdb->Get(readoptions, slSpKey, &strSpValue);
+    leveldb::Status status = Get(slSpKey, &strSpValue);
 
     return status.ok();
 }
@@ -428,7 +428,7 @@ uint32_t CMPSPInfo::findSPByTX(const uint256& txid) const
 
     // DB value for identifier
     std::string strTxIndexValue;
-    if (!pdb->Get(readoptions, slTxIndexKey, &strTxIndexValue).ok()) {
+    if (!Get(slTxIndexKey, &strTxIndexValue).ok()) {
         std::string strError = strprintf("failed to find property created with %s", txid.GetHex());
         PrintToLog("%s(): ERROR: %s", __func__, strError);
         return 0;
@@ -495,7 +495,7 @@ int64_t CMPSPInfo::popBlock(const uint256& block_hash)
                 leveldb::Slice slSpPrevKey(&ssSpPrevKey[0], ssSpPrevKey.size());
 
                 std::string strSpPrevValue;
-                if (!pdb->Get(readoptions, slSpPrevKey, &strSpPrevValue).IsNotFound()) {
+                if (!Get(slSpPrevKey, &strSpPrevValue).IsNotFound()) {
                     // copy the prev state to the current state and delete the old state
                     commitBatch.Put(slSpKey, strSpPrevValue);
                     commitBatch.Delete(slSpPrevKey);
@@ -514,7 +514,7 @@ int64_t CMPSPInfo::popBlock(const uint256& block_hash)
     // clean up the iterator
     delete iter;
 
-    leveldb::Status status = pdb->Write(syncoptions, &commitBatch);
+    leveldb::Status status = Apply(commitBatch, true);
 
     if (!status.ok()) {
         PrintToLog("%s(): ERROR: %s\n", __func__, status.ToString());
@@ -540,7 +540,7 @@ void CMPSPInfo::setWatermark(const uint256& watermark)
     batch.Delete(slKey);
     batch.Put(slKey, slValue);
 
-    leveldb::Status status = pdb->Write(syncoptions, &batch);
+    leveldb::Status status = Apply(batch, true);
     if (!status.ok()) {
         PrintToLog("%s(): ERROR: failed to write watermark: %s\n", __func__, status.ToString());
     }
@@ -553,7 +553,7 @@ bool CMPSPInfo::getWatermark(uint256& watermark) const
     leveldb::Slice slKey(&ssKey[0], ssKey.size());
 
     std::string strValue;
-    leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+    leveldb::Status status = Get(slKey, &strValue);
     if (!status.ok()) {
         if (!status.IsNotFound()) {
             PrintToLog("%s(): ERROR: failed to retrieve watermark: %s\n", __func__, status.ToString());
@@ -48,7 +48,7 @@ void CMPTradeList::recordMatchedTrade(const uint256& txid1, const uint256& txid2
     if (!pdb) return;
     const std::string key = txid1.ToString() + "+" + txid2.ToString();
     const std::string value = strprintf("%s:%s:%u:%u:%lu:%lu:%d:%d", address1, address2, prop1, prop2, amount1, amount2, blockNum, fee);
-    leveldb::Status status = pdb->Put(writeoptions, key, value);
+    leveldb::Status status = Put(key, value);
     ++nWritten;
     if (msc_debug_tradedb) PrintToLog("%s: %s\n", __func__, status.ToString());
 }
@@ -57,7 +57,7 @@ void CMPTradeList::recordNewTrade(const uint256& txid, const std::string& addres
 {
     if (!pdb) return;
     std::string strValue = strprintf("%s:%d:%d:%d:%d", address, propertyIdForSale, propertyIdDesired, blockNum, blockIndex);
-    leveldb::Status status = pdb->Put(writeoptions, txid.ToString(), strValue);
+    leveldb::Status status = Put(txid.ToString(), strValue);
     ++nWritten;
     if (msc_debug_tradedb) PrintToLog("%s: %s\n", __func__, status.ToString());
 }
@@ -86,7 +86,7 @@ int CMPTradeList::deleteAboveBlock(int blockNum)
         if (block >= blockNum) {
             ++n_found;
             PrintToLog("%s() DELETING FROM TRADEDB: %s=%s\n", __func__, skey.ToString(), svalue.ToString());
-            pdb->Delete(writeoptions, skey);
+            Erase(skey);
         }
     }
     
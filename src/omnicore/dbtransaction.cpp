@@ -38,7 +38,7 @@ std::vector<std::string> COmniTransactionDB::FetchTransactionDetails(const uint2
     std::string strValue;
     std::vector<std::string> vTransactionDetails;
 
-    leveldb::Status status = pdb->Get(readoptions, txid.ToString(), &strValue);
+    leveldb::Status status = Get(txid.ToString(), &strValue);
     if (status.ok()) {
         std::vector<std::string> vStr;
         boost::split(vStr, strValue, boost::is_any_of(":"), boost::token_compress_on);
@@ -65,7 +65,7 @@ void COmniTransactionDB::RecordTransaction(const uint256& txid, uint32_t posInBl
     const std::string key = txid.ToString();
     const std::string value = strprintf("%d:%d", posInBlock, processingResult);
 
-    leveldb::Status status = pdb->Put(writeoptions, key, value);
+    leveldb::Status status = Put(key, value);
     ++nWritten;
 }
 
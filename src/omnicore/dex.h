@@ -86,7 +86,7 @@ public:
     {
     }
 
-    void saveOffer(std::ofstream& file, const std::string& address, CHash256& hasher) const
+    void saveOffer(std::ostream& file, const std::string& address, CHash256& hasher) const
     {
         std::string lineOut = strprintf("%s,%d,%d,%d,%d,%d,%d,%d,%s",
                 address,
@@ -194,7 +194,7 @@ public:
         return bRet;
     }
 
-    void saveAccept(std::ofstream& file, const std::string& address, const std::string& buyer, CHash256& hasher) const
+    void saveAccept(std::ostream& file, const std::string& address, const std::string& buyer, CHash256& hasher) const
     {
         std::string lineOut = strprintf("%s,%d,%s,%d,%d,%d,%d,%d,%d,%s",
                 address,
@@ -99,7 +99,7 @@ public:
     /** Used for display of unit prices with 50 decimal places at RPC layer. */
     std::string displayFullUnitPrice() const;
 
-    void saveOffer(std::ofstream& file, CHash256 &hasher) const;
+    void saveOffer(std::ostream& file, CHash256 &hasher) const;
 };
 
 namespace mastercore
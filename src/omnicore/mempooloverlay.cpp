@@ -0,0 +1,184 @@
+/**
+ * @file mempooloverlay.cpp
+ *
+ * This file contains the overlay of pending Omni transactions in the memory pool.
+ */
+
+#include <omnicore/mempooloverlay.h>
+
+#include <omnicore/omnicore.h>
+#include <omnicore/parsing.h>
+#include <omnicore/tx.h>
+
+#include <primitives/transaction.h>
+#include <sync.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace mastercore
+{
+//! Omni transactions in the memory pool
+CMPMempoolOverlay mempoolOverlay;
+
+/**
+ * Decodes a transaction, which just entered the memory pool, and adds it to the overlay.
+ *
+ * @return True, if the transaction is an Omni transaction
+ */
+bool CMPMempoolOverlay::Add(const CTransaction& tx, int nBlock)
+{
+    CMPTransaction mp_obj;
+    // DEx payments (positive return code) can only be matched once confirmed
+    if (ParseTransaction(tx, nBlock, 0, mp_obj) != 0) return false;
+    if (!mp_obj.interpret_Transaction()) return false;
+
+    CMPMempoolEntry entry;
+    entry.sender = mp_obj.getSender();
+    entry.receiver = mp_obj.getReceiver();
+    entry.type = mp_obj.getType();
+    entry.propertyId = mp_obj.getProperty();
+
+    switch (entry.type) {
+        case MSC_TYPE_SIMPLE_SEND:
+        {
+            int64_t amount = static_cast<int64_t>(mp_obj.getAmount());
+            if (amount > 0 && !entry.receiver.empty()) {
+                entry.deltas.emplace_back(entry.sender, entry.propertyId, -amount);
+                entry.deltas.emplace_back(entry.receiver, entry.propertyId, amount);
+            }
+            break;
+        }
+        case MSC_TYPE_SEND_TO_MANY:
+        {
+            int64_t total = 0;
+            for (const std::tuple<uint8_t, uint64_t>& output : mp_obj.getStmOutputValues()) {
+                int64_t amount = static_cast<int64_t>(std::get<1>(output));
+                std::string destination;
+                if (amount <= 0 || !mp_obj.getValidStmAddressAt(std::get<0>(output), destination)) continue;
+                entry.deltas.emplace_back(destination, entry.propertyId, amount);
+                total += amount;
+            }
+            if (total > 0) {
+                entry.deltas.emplace_back(entry.sender, entry.propertyId, -total);
+            }
+            break;
+        }
+    }
+
+    AddEntry(tx.GetHash(), entry);
+    return true;
+}
+
+void CMPMempoolOverlay::ApplyDeltas(const CMPMempoolEntry& entry, bool fAdd)
+{
+    AssertLockHeld(cs_overlay);
+
+    for (const PendingDelta& delta : entry.deltas) {
+        const std::pair<std::string, uint32_t> key(std::get<0>(delta), std::get<1>(delta));
+        int64_t amount = std::get<2>(delta);
+        CMPPendingAmounts& pending = amounts[key];
+        int64_t& sum = (amount > 0) ? pending.incoming : pending.outgoing;
+        int64_t value = (amount > 0) ? amount : -amount;
+        sum += fAdd ? value : -value;
+        if (pending.incoming == 0 && pending.outgoing == 0) {
+            amounts.erase(key);
+        }
+    }
+}
+
+/** Adds an already decoded transaction. */
+void CMPMempoolOverlay::AddEntry(const uint256& txid, const CMPMempoolEntry& entry)
+{
+    LOCK(cs_overlay);
+
+    if (!entries.emplace(txid, entry).second) return;
+    ApplyDeltas(entry, true);
+
+    byAddress[entry.sender].insert(txid);
+    if (!entry.receiver.empty()) byAddress[entry.receiver].insert(txid);
+    for (const PendingDelta& delta : entry.deltas) {
+        byAddress[std::get<0>(delta)].insert(txid);
+    }
+}
+
+/** Removes a transaction, which left the memory pool. */
+void CMPMempoolOverlay::Remove(const uint256& txid)
+{
+    LOCK(cs_overlay);
+
+    std::map<uint256, CMPMempoolEntry>::iterator it = entries.find(txid);
+    if (it == entries.end()) return;
+    const CMPMempoolEntry& entry = it->second;
+    ApplyDeltas(entry, false);
+
+    std::set<std::string> addresses;
+    addresses.insert(entry.sender);
+    addresses.insert(entry.receiver);
+    for (const PendingDelta& delta : entry.deltas) {
+        addresses.insert(std::get<0>(delta));
+    }
+    for (const std::string& address : addresses) {
+        std::map<std::string, std::set<uint256>>::iterator addr_it = byAddress.find(address);
+        if (addr_it == byAddress.end()) continue;
+        addr_it->second.erase(txid);
+        if (addr_it->second.empty()) byAddress.erase(addr_it);
+    }
+
+    entries.erase(it);
+}
+
+void CMPMempoolOverlay::Clear()
+{
+    LOCK(cs_overlay);
+    entries.clear();
+    amounts.clear();
+    byAddress.clear();
+}
+
+bool CMPMempoolOverlay::Exists(const uint256& txid) const
+{
+    LOCK(cs_overlay);
+    return entries.count(txid) > 0;
+}
+
+size_t CMPMempoolOverlay::Size() const
+{
+    LOCK(cs_overlay);
+    return entries.size();
+}
+
+/** Returns the pending amounts of an address for a property. */
+CMPPendingAmounts CMPMempoolOverlay::GetPendingAmounts(const std::string& address, uint32_t propertyId) const
+{
+    LOCK(cs_overlay);
+    std::map<std::pair<std::string, uint32_t>, CMPPendingAmounts>::const_iterator it = amounts.find(std::make_pair(address, propertyId));
+    if (it == amounts.end()) return CMPPendingAmounts();
+    return it->second;
+}
+
+/** Returns the pending transactions, optionally only those sent from or to an address. */
+std::vector<uint256> CMPMempoolOverlay::GetTransactions(const std::string& filterAddress) const
+{
+    LOCK(cs_overlay);
+    std::vector<uint256> vTxid;
+    if (filterAddress.empty()) {
+        vTxid.reserve(entries.size());
+        for (const auto& entry : entries) {
+            vTxid.push_back(entry.first);
+        }
+    } else {
+        std::map<std::string, std::set<uint256>>::const_iterator it = byAddress.find(filterAddress);
+        if (it != byAddress.end()) {
+            vTxid.assign(it->second.begin(), it->second.end());
+        }
+    }
+    return vTxid;
+}
+}
@@ -0,0 +1,86 @@
+#ifndef XEP_OMNICORE_MEMPOOLOVERLAY_H
+#define XEP_OMNICORE_MEMPOOLOVERLAY_H
+
+class CTransaction;
+
+#include <sync.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace mastercore
+{
+/** A balance change claimed by a pending transaction: address, property and amount. */
+typedef std::tuple<std::string, uint32_t, int64_t> PendingDelta;
+
+/** Decoded Omni transaction in the memory pool. */
+struct CMPMempoolEntry
+{
+    std::string sender;
+    std::string receiver;
+    uint32_t type;
+    uint32_t propertyId;
+    //! Balance changes, only derived for simple sends and send-to-many
+    std::vector<PendingDelta> deltas;
+
+    CMPMempoolEntry() : type(0), propertyId(0) {};
+};
+
+/** Pending amounts of an address and property, both as positive numbers. */
+struct CMPPendingAmounts
+{
+    int64_t incoming;
+    int64_t outgoing;
+
+    CMPPendingAmounts() : incoming(0), outgoing(0) {};
+};
+
+/**
+ * Overlay of the Omni transactions in the memory pool.
+ *
+ * Every transaction with an Omni marker is decoded once when it enters the
+ * memory pool, and the balance changes it claims are summed per address and
+ * property. Entries are removed once the transaction leaves the memory pool,
+ * either confirmed or evicted. Pending state is not validated against the
+ * tallies and may never confirm.
+ */
+class CMPMempoolOverlay
+{
+private:
+    mutable Mutex cs_overlay;
+    std::map<uint256, CMPMempoolEntry> entries GUARDED_BY(cs_overlay);
+    std::map<std::pair<std::string, uint32_t>, CMPPendingAmounts> amounts GUARDED_BY(cs_overlay);
+    //! Transactions by sender and receiver address
+    std::map<std::string, std::set<uint256>> byAddress GUARDED_BY(cs_overlay);
+
+    void ApplyDeltas(const CMPMempoolEntry& entry, bool fAdd) EXCLUSIVE_LOCKS_REQUIRED(cs_overlay);
+
+public:
+    /** Decodes a memory pool transaction and adds it, if it is an Omni transaction. */
+    bool Add(const CTransaction& tx, int nBlock);
+    /** Adds an already decoded transaction. */
+    void AddEntry(const uint256& txid, const CMPMempoolEntry& entry);
+    /** Removes a transaction, which left the memory pool. */
+    void Remove(const uint256& txid);
+    void Clear();
+
+    bool Exists(const uint256& txid) const;
+    size_t Size() const;
+
+    /** Returns the pending amounts of an address for a property. */
+    CMPPendingAmounts GetPendingAmounts(const std::string& address, uint32_t propertyId) const;
+    /** Returns the pending transactions, optionally only those sent from or to an address. */
+    std::vector<uint256> GetTransactions(const std::string& filterAddress = "") const;
+};
+
+//! Omni transactions in the memory pool
+extern CMPMempoolOverlay mempoolOverlay;
+}
+
+#endif // XEP_OMNICORE_MEMPOOLOVERLAY_H
@@ -301,14 +301,14 @@ void CMPNonFungibleTokensDB::RollBackAboveBlock(int height)
         }
     }
     assert(pdb);
-    pdb->Write(writeoptions, &batch);
+    Apply(batch);
 }
 
 void CMPNonFungibleTokensDB::StoreBlockCache(const std::string& key)
 {
     if (blockData.find(key) == blockData.end()) {
         CRollbackData rollback{CRollbackData::PERSIST_KEY};
-        leveldb::Status status = pdb->Get(readoptions, key, &rollback.data);
+        leveldb::Status status = Get(key, &rollback.data);
         if (status.IsNotFound()) {
             rollback.type = CRollbackData::DELETE_KEY;
         }
@@ -7,6 +7,7 @@
 #include <omnicore/omnicore.h>
 
 #include <omnicore/activation.h>
+#include <omnicore/blockprefetch.h>
 #include <omnicore/consensushash.h>
 #include <omnicore/convert.h>
 #include <omnicore/dbbase.h>
@@ -19,10 +20,13 @@
 #include <omnicore/dex.h>
 #include <omnicore/log.h>
 #include <omnicore/mdex.h>
+#include <omnicore/mempooloverlay.h>
 #include <omnicore/notifications.h>
+#include <omnicore/parallel.h>
 #include <omnicore/parsing.h>
 #include <omnicore/pending.h>
 #include <omnicore/persistence.h>
+#include <omnicore/rpctxobject.h>
 #include <omnicore/rules.h>
 #include <omnicore/script.h>
 #include <omnicore/seedblocks.h>
@@ -32,6 +36,7 @@
 #include <omnicore/utilsxep.h>
 #include <omnicore/utilsui.h>
 #include <omnicore/version.h>
+#include <omnicore/wallettxindex.h>
 #include <omnicore/walletutils.h>
 
 #include <base58.h>
@@ -66,6 +71,7 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <set>
 #include <string>
 #include <unordered_map>
@@ -100,6 +106,9 @@ static int nWaterlineBlock = 0;
 //! Last processed block
 static int lastProcessedBlock = 0;
 
+//! Called at the end of every block, used by omnixep-replay
+std::function<void(int, const CBlockIndex*)> blockEndObserver;
+
 /**
  * Used to indicate, whether to automatically commit created transactions.
  *
@@ -722,7 +731,7 @@ static RecursiveMutex cs_marker_cache;
  *
  * MUST NOT BE USED FOR CONSENSUS CRITICAL STUFF!
  */
-static bool HasMarkerUnsafe(const CTransactionRef& tx)
+bool HasMarkerUnsafe(const CTransactionRef& tx)
 {
     const std::string strClassC("6f6d6e69");
     const std::string strClassAB("76a914946cb2e08075bcbaf157e47bcb67eb2b2339d24288ac");
@@ -758,8 +767,14 @@ static bool HasMarkerUnsafe(const CTransactionRef& tx)
 void TryToAddToMarkerCache(const CTransactionRef &tx)
 {
     if (HasMarkerUnsafe(tx)) {
-        LOCK(cs_marker_cache);
-        setMarkerCache.insert(tx->GetHash());
+        {
+            LOCK(cs_marker_cache);
+            setMarkerCache.insert(tx->GetHash());
+        }
+        // decode it once, so pending state can be served without scanning the memory pool
+        if (mastercoreInitialized && mempool.exists(tx->GetHash())) {
+            mempoolOverlay.Add(*tx, GetHeight());
+        }
     }
 }
 
@@ -1555,6 +1570,16 @@ public:
     }
 };
 
+/**
+ * Returns the LevelDB based state objects, which are open.
+ */
+static std::vector<CDBBase*> GetOpenDatabases()
+{
+    std::vector<CDBBase*> vDatabases{pDbSpInfo, pDbTransactionList, pDbStoList, pDbTradeList, pDbTransaction, pDbFeeCache, pDbFeeHistory, pDbNFT};
+    vDatabases.erase(std::remove(vDatabases.begin(), vDatabases.end(), nullptr), vDatabases.end());
+    return vDatabases;
+}
+
 /**
  * Scans the blockchain for meta transactions.
  *
@@ -1574,7 +1599,7 @@ public:
  * @param nFirstBlock[in]  The index of the first block to scan
  * @return An exit code, indicating success or failure
  */
-static int msc_initial_scan(int nFirstBlock)
+int msc_initial_scan(int nFirstBlock)
 {
     int nTimeBetweenProgressReports = gArgs.GetArg("-omniprogressfrequency", 30);  // seconds
     int64_t nNow = GetTime();
@@ -1601,6 +1626,25 @@ static int msc_initial_scan(int nFirstBlock)
     // check if using seed block filter should be disabled
     bool seedBlockFilterEnabled = gArgs.GetBoolArg("-omniseedblockfilter", true);
 
+    // read blocks and resolve their inputs ahead of the scan, if requested
+    int nScanThreads = gArgs.GetArg("-omniscanthreads", DEFAULT_OMNI_SCAN_THREADS);
+    std::unique_ptr<CMPBlockPrefetcher> prefetcher;
+    if (nScanThreads > 0) {
+        PrintToLog("Reading blocks of the initial scan with %d threads\n", nScanThreads);
+        // the workers don't take cs_main, so the blocks are located here
+        std::vector<PrefetchLocation> vLocations;
+        {
+            LOCK(cs_main);
+            vLocations.reserve(nLastBlock - nFirstBlock + 1);
+            for (int n = nFirstBlock; n <= nLastBlock; ++n) {
+                const CBlockIndex* pindex = ::ChainActive()[n];
+                if (nullptr == pindex) break;
+                vLocations.emplace_back(pindex->GetBlockPos(), pindex->GetBlockHash());
+            }
+        }
+        prefetcher = MakeUnique<CMPBlockPrefetcher>(nFirstBlock, std::move(vLocations), nScanThreads, seedBlockFilterEnabled);
+    }
+
     for (nBlock = nFirstBlock; nBlock <= nLastBlock; ++nBlock)
     {
         if (ShutdownRequested()) {
@@ -1630,11 +1674,22 @@ static int msc_initial_scan(int nFirstBlock)
         mastercore_handler_block_begin(nBlock, pblockindex);
 
         if (!seedBlockFilterEnabled || !SkipBlock(nBlock)) {
-            CBlock block;
-            if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus())) break;
+            PrefetchedBlock prefetched;
+            if (prefetcher) {
+                prefetcher->Take(nBlock, prefetched);
+            }
+            if (!prefetched.fRead) {
+                prefetched.fRead = ReadBlockFromDisk(prefetched.block, pblockindex, Params().GetConsensus());
+            }
+            if (!prefetched.fRead) {
+                for (CDBBase* pdb : GetOpenDatabases()) {
+                    pdb->AbortBlockBatch();
+                }
+                break;
+            }
 
-            for(const auto tx : block.vtx) {
-                if (mastercore_handler_tx(*tx, nBlock, nTxNum, pblockindex, nullptr)) ++nTxsFoundInBlock;
+            for(const auto tx : prefetched.block.vtx) {
+                if (mastercore_handler_tx(*tx, nBlock, nTxNum, pblockindex, prefetched.inputs)) ++nTxsFoundInBlock;
                 ++nTxNum;
             }
         }
@@ -1683,7 +1738,9 @@ void clear_all_state()
     pDbFeeHistory->Clear();
     pDbNFT->Clear();
     assert(pDbTransactionList->setDBVersion() == DB_VERSION); // new set of databases, set DB version
+    walletTxIndex.Clear();
     exodus_prev = 0;
+    ClearRPCTransactionCache();
 }
 
 void RewindDBsAndState(int nHeight, int nBlockPrev = 0, bool fInitialParse = false)
@@ -1702,6 +1759,7 @@ void RewindDBsAndState(int nHeight, int nBlockPrev = 0, bool fInitialParse = fal
         pDbFeeCache->RollBackCache(nHeight);
         pDbFeeHistory->RollBackHistory(nHeight);
         pDbNFT->RollBackAboveBlock(nHeight);
+        walletTxIndex.RollBackAboveBlock(nHeight);
         reorgRecoveryMaxHeight = 0;
 
         nWaterlineBlock = ConsensusParams().GENESIS_BLOCK - 1;
@@ -1736,6 +1794,111 @@ void RewindDBsAndState(int nHeight, int nBlockPrev = 0, bool fInitialParse = fal
     }
 }
 
+/**
+ * Replaces the Omni state with the state section of a UTXO snapshot.
+ *
+ * The consensus hash of the snapshot must match the expected one, and the
+ * consensus checkpoint of the base block, if there is one. Otherwise the
+ * current state is kept. The state is then restored like at startup, checked
+ * against the expected consensus hash, and brought up to the tip of the
+ * active chain. If the restored state doesn't match, all state is cleared and
+ * reparsed with the next block, rather than here.
+ *
+ * @param file                   The snapshot, positioned after the coins
+ * @param pBlockIndex            The base block of the snapshot, which must be in the active chain
+ * @param expectedConsensusHash  The consensus hash the state of the snapshot must have
+ * @param strError               Set to the reason, if the state of the snapshot was not loaded
+ * @return True, if the state of the snapshot was loaded
+ */
+bool mastercore_load_state_snapshot(CAutoFile& file, const CBlockIndex* pBlockIndex, const uint256& expectedConsensusHash, std::string& strError)
+{
+    AssertLockHeld(cs_main);
+    assert(::ChainActive().Contains(pBlockIndex));
+
+    // check the snapshot, before anything is replaced
+    try {
+        uint256 consensusHash = ReadStateSnapshotHeader(file, pBlockIndex);
+        if (consensusHash != expectedConsensusHash) {
+            strError = strprintf("Omni state of the snapshot has consensus hash %s, expected %s", consensusHash.GetHex(), expectedConsensusHash.GetHex());
+        }
+    } catch (const std::exception& e) {
+        strError = e.what();
+    }
+    for (const ConsensusCheckpoint& checkpoint : ConsensusParams().GetCheckpoints()) {
+        if (strError.empty() && checkpoint.blockHeight == pBlockIndex->nHeight &&
+                (checkpoint.blockHash != pBlockIndex->GetBlockHash() || checkpoint.consensusHash != expectedConsensusHash)) {
+            strError = strprintf("Omni state of the snapshot does not match the checkpoint of block %d", checkpoint.blockHeight);
+        }
+    }
+    if (!strError.empty()) {
+        PrintToLog("Rejected Omni state of snapshot: %s\n", strError);
+        return false;
+    }
+
+    {
+        LOCK(cs_tally);
+        clear_all_state();
+        try {
+            ReadStateSnapshot(file, pBlockIndex);
+            if (pDbTransactionList->getDBVersion() != DB_VERSION) {
+                strError = "Omni state was created with a different database version";
+            }
+        } catch (const std::exception& e) {
+            strError = e.what();
+        }
+    }
+
+    if (strError.empty() && LoadMostRelevantInMemoryState() != pBlockIndex->nHeight) {
+        strError = "Failed to restore the Omni state of the snapshot";
+    }
+
+    int nWaterline;
+    {
+        LOCK(cs_tally);
+        if (strError.empty() && GetConsensusHash() != expectedConsensusHash) {
+            strError = "Restored Omni state does not match the consensus hash of the snapshot";
+        }
+        if (strError.empty()) {
+            nWaterlineBlock = pBlockIndex->nHeight + 1;
+            PrintToConsole("Loaded Omni state of block %d from snapshot\n", pBlockIndex->nHeight);
+        } else {
+            PrintToLog("Failed to load Omni state from snapshot: %s\n", strError);
+            clear_all_state();
+            nWaterlineBlock = ConsensusParams().GENESIS_BLOCK - 1;
+            exodus_prev = 0;
+            // the state is rebuilt by the reorg recovery with the next block
+            reorgRecoveryMode = 1;
+            strError += ", Omni state is reparsed with the next block";
+        }
+        nWaterline = nWaterlineBlock;
+    }
+
+    {
+        LOCK(::mempool.cs);
+        LOCK(cs_tally);
+        pDbTransactionList->LoadActivations(nWaterline);
+        pDbTransactionList->LoadAlerts(nWaterline);
+        if (!pDbTransactionList->LoadFreezeState(nWaterline)) {
+            std::string strShutdownReason = "Failed to load freeze state from levelDB.  It is unsafe to continue.\n";
+            PrintToLog(strShutdownReason);
+            if (!gArgs.GetBoolArg("-overrideforcedshutdown", false)) {
+                AbortNode(strShutdownReason, strShutdownReason);
+            }
+        }
+
+        global_wallet_property_list.clear();
+        CheckWalletUpdate();
+        uiInterface.OmniStateInvalidated();
+    }
+
+    if (!strError.empty()) return false;
+
+    // catch up to the tip of the active chain
+    msc_initial_scan(nWaterline);
+
+    return true;
+}
+
 /**
  * Global handler to initialize Omni Core.
  *
@@ -1937,6 +2100,8 @@ int mastercore_init()
         LogPrintf("OmniXEP: post-sync snapshot skipped (still in initial block download)\n");
     }
 
+    StartParallelWorkers();
+
     LogPrintf("Omni Core initialization completed\n");
 
     return 0;
@@ -1952,6 +2117,8 @@ int mastercore_init()
  */
 int mastercore_shutdown()
 {
+    StopParallelWorkers();
+
     LOCK2(cs_main, cs_tally);
 
     if (lastProcessedBlock > 0) {
@@ -2076,6 +2243,7 @@ bool mastercore_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx,
             bool bValid = (0 <= interp_ret);
             pDbTransactionList->recordTX(tx.GetHash(), bValid, nBlock, mp_obj.getType(), mp_obj.getNewAmount());
             pDbTransaction->RecordTransaction(tx.GetHash(), idx, interp_ret);
+            walletTxIndex.RecordTransaction(tx.GetHash(), nBlock, idx);
         }
         fFoundTx |= (interp_ret == 0);
     }
@@ -2116,6 +2284,11 @@ int mastercore_handler_block_begin(int nBlockPrev, CBlockIndex const * pBlockInd
             reorgRecoveryMode = 0; // clear reorgRecovery here as this is likely re-entrant
             bRecoveryMode = true;
         }
+
+        // a block, which was never completed, must not leak into the rewind or this block
+        for (CDBBase* pdb : GetOpenDatabases()) {
+            pdb->AbortBlockBatch();
+        }
     }
 
     if (bRecoveryMode) {
@@ -2125,6 +2298,11 @@ int mastercore_handler_block_begin(int nBlockPrev, CBlockIndex const * pBlockInd
     {
         LOCK(cs_tally);
 
+        // collect all database writes of the block, they are committed at the end of the block
+        for (CDBBase* pdb : GetOpenDatabases()) {
+            pdb->StartBlockBatch();
+        }
+
         // handle any features that go live with this block
         CheckLiveActivations(pBlockIndex->nHeight);
 
@@ -2194,6 +2372,19 @@ int mastercore_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
         bool sanityCheck = true;
         pDbNFT->WriteBlockCache(nBlockNow, sanityCheck);
 
+        // commit the database writes of the block
+        for (CDBBase* pdb : GetOpenDatabases()) {
+            if (!pdb->CommitBlockBatch()) {
+                const std::string msg = strprintf("Failed to write Omni databases for block %d", nBlockNow);
+                PrintToLog("%s\n", msg);
+                AbortNode(msg, msg);
+            }
+        }
+        // a failed commit leaves the block incomplete, drop what is still pending
+        for (CDBBase* pdb : GetOpenDatabases()) {
+            pdb->AbortBlockBatch();
+        }
+
         // request checkpoint verification
         checkpointValid = VerifyCheckpoint(nBlockNow, pBlockIndex->GetBlockHash());
         if (!checkpointValid) {
@@ -2218,6 +2409,10 @@ int mastercore_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex,
         lastProcessedBlock = nBlockNow;
     }
 
+    if (blockEndObserver) {
+        blockEndObserver(nBlockNow, pBlockIndex);
+    }
+
     return 0;
 }
 
@@ -2227,6 +2422,14 @@ void mastercore_handler_disc_begin(const int nHeight)
 
     reorgRecoveryMode = 1;
     reorgRecoveryMaxHeight = (nHeight > reorgRecoveryMaxHeight) ? nHeight: reorgRecoveryMaxHeight;
+
+    // writes of a block, which was never completed, are not committed on the way back
+    for (CDBBase* pdb : GetOpenDatabases()) {
+        pdb->AbortBlockBatch();
+    }
+
+    // decoded transactions may refer to blocks, which are no longer part of the chain
+    ClearRPCTransactionCache();
 }
 
 /**
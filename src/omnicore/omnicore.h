@@ -1,6 +1,7 @@
 #ifndef XEP_OMNICORE_OMNICORE_H
 #define XEP_OMNICORE_OMNICORE_H
 
+class CAutoFile;
 class CBlockIndex;
 class CCoinsView;
 class CCoinsViewCache;
@@ -19,6 +20,7 @@ class Coin;
 
 #include <stdint.h>
 
+#include <functional>
 #include <map>
 #include <string>
 #include <vector>
@@ -172,12 +174,20 @@ int mastercore_init();
 /** Global handler to shut down Omni Core. */
 int mastercore_shutdown();
 
+/** Replaces the Omni state with the state section of a UTXO snapshot. */
+bool mastercore_load_state_snapshot(CAutoFile& file, const CBlockIndex* pBlockIndex, const uint256& expectedConsensusHash, std::string& strError);
+
 /** Block and transaction handlers. */
 void mastercore_handler_disc_begin(const int nHeight);
 int mastercore_handler_block_begin(int nBlockNow, CBlockIndex const * pBlockIndex);
 int mastercore_handler_block_end(int nBlockNow, CBlockIndex const * pBlockIndex, unsigned int);
 bool mastercore_handler_tx(const CTransaction& tx, int nBlock, unsigned int idx, const CBlockIndex* pBlockIndex, const std::shared_ptr<std::map<COutPoint, Coin>> removedCoins);
 
+/** Optional handler, called once the Omni state of a block is final. */
+extern std::function<void(int, const CBlockIndex*)> blockEndObserver;
+
+/** Checks, if transaction has any Omni marker. Must not be used for consensus critical stuff! */
+bool HasMarkerUnsafe(const CTransactionRef& tx);
 /** Scans for marker and if one is found, add transaction to marker cache. */
 void TryToAddToMarkerCache(const CTransactionRef& tx);
 /** Removes transaction from marker cache. */
@@ -0,0 +1,94 @@
+#include <omnicore/parallel.h>
+
+#include <omnicore/log.h>
+
+#include <checkqueue.h>
+#include <sync.h>
+#include <tinyformat.h>
+#include <util/memory.h>
+#include <util/system.h>
+#include <util/threadnames.h>
+
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace mastercore
+{
+namespace
+{
+/** A single item of a batch, as handled by the workers. */
+class ParallelItem
+{
+private:
+    std::function<void()> m_fn;
+
+public:
+    ParallelItem() {}
+    explicit ParallelItem(std::function<void()> fn) : m_fn(std::move(fn)) {}
+
+    bool operator()()
+    {
+        if (m_fn) m_fn();
+        return true;
+    }
+
+    void swap(ParallelItem& item) { m_fn.swap(item.m_fn); }
+};
+
+Mutex cs_parallel;
+std::unique_ptr<CCheckQueue<ParallelItem>> g_parallel_queue GUARDED_BY(cs_parallel);
+boost::thread_group g_parallel_workers;
+
+} // namespace
+
+void StartParallelWorkers()
+{
+    LOCK(cs_parallel);
+    if (g_parallel_queue) return;
+
+    const int nWorkers = std::min(GetNumCores(), MAX_OMNI_PARALLEL_THREADS) - 1;
+    g_parallel_queue = MakeUnique<CCheckQueue<ParallelItem>>(1);
+    CCheckQueue<ParallelItem>* queue = g_parallel_queue.get();
+    for (int i = 0; i < nWorkers; i++) {
+        g_parallel_workers.create_thread([i, queue]() {
+            util::ThreadRename(strprintf("omniworker.%i", i));
+            queue->Thread();
+        });
+    }
+    PrintToLog("Started %d workers for RPC batches\n", std::max(nWorkers, 0));
+}
+
+void StopParallelWorkers()
+{
+    LOCK(cs_parallel);
+    if (!g_parallel_queue) return;
+
+    g_parallel_workers.interrupt_all();
+    g_parallel_workers.join_all();
+    g_parallel_queue.reset();
+}
+
+void ForEachParallel(size_t nItems, const std::function<void(size_t)>& fn)
+{
+    std::vector<ParallelItem> vItems;
+    vItems.reserve(nItems);
+    for (size_t i = 0; i < nItems; ++i) {
+        vItems.emplace_back([i, &fn] { fn(i); });
+    }
+
+    // the workers are only stopped on shutdown, after the RPC server
+    CCheckQueue<ParallelItem>* queue = WITH_LOCK(cs_parallel, return g_parallel_queue.get());
+    if (!queue || nItems < 2) {
+        for (ParallelItem& item : vItems) item();
+        return;
+    }
+
+    CCheckQueueControl<ParallelItem> control(queue);
+    control.Add(vItems);
+    control.Wait();
+}
+}
@@ -0,0 +1,26 @@
+#ifndef XEP_OMNICORE_PARALLEL_H
+#define XEP_OMNICORE_PARALLEL_H
+
+#include <stddef.h>
+#include <functional>
+
+/** Maximum number of threads, which work on a batch of an RPC call */
+static const int MAX_OMNI_PARALLEL_THREADS = 8;
+
+namespace mastercore
+{
+/** Starts the workers, which are shared by all batches. */
+void StartParallelWorkers();
+
+/** Interrupts and joins the workers. */
+void StopParallelWorkers();
+
+/**
+ * Calls fn for each index in [0, nItems), distributed over the shared workers
+ * and the calling thread. Without workers, all items are handled by the
+ * calling thread. Batches of concurrent callers are handled one after another.
+ */
+void ForEachParallel(size_t nItems, const std::function<void(size_t)>& fn);
+}
+
+#endif // XEP_OMNICORE_PARALLEL_H
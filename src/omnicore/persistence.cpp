@@ -6,9 +6,17 @@
 
 #include <omnicore/persistence.h>
 
+#include <omnicore/consensushash.h>
+#include <omnicore/dbbase.h>
+#include <omnicore/dbfees.h>
+#include <omnicore/dbstolist.h>
+#include <omnicore/dbtradelist.h>
+#include <omnicore/dbtransaction.h>
+#include <omnicore/dbtxlist.h>
 #include <omnicore/dex.h>
 #include <omnicore/log.h>
 #include <omnicore/mdex.h>
+#include <omnicore/nftdb.h>
 #include <omnicore/rules.h>
 #include <omnicore/sp.h>
 #include <omnicore/tally.h>
@@ -17,6 +25,7 @@
 #include <chain.h>
 #include <fs.h>
 #include <hash.h>
+#include <streams.h>
 #include <validation.h>
 #include <tinyformat.h>
 #include <uint256.h>
@@ -27,9 +36,13 @@
 #include <boost/lexical_cast.hpp>
 
 #include <stdint.h>
+#include <string.h>
 
 #include <fstream>
+#include <memory>
 #include <set>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <utility>
@@ -141,7 +154,7 @@ void MaybeCreateStateSnapshot(const CBlockIndex* tip)
     PersistInMemoryState(tip);
 }
 
-static int write_msc_balances(std::ofstream& file, CHash256& hasher)
+static int write_msc_balances(std::ostream& file, CHash256& hasher)
 {
     std::unordered_map<std::string, CMPTally>::iterator iter;
     for (iter = mp_tally_map.begin(); iter != mp_tally_map.end(); ++iter) {
@@ -186,7 +199,7 @@ static int write_msc_balances(std::ofstream& file, CHash256& hasher)
     return 0;
 }
 
-static int write_mp_offers(std::ofstream& file, CHash256& hasher)
+static int write_mp_offers(std::ostream& file, CHash256& hasher)
 {
     OfferMap::const_iterator iter;
     for (iter = my_offers.begin(); iter != my_offers.end(); ++iter) {
@@ -200,7 +213,7 @@ static int write_mp_offers(std::ofstream& file, CHash256& hasher)
     return 0;
 }
 
-static int write_mp_accepts(std::ofstream& file, CHash256& hasher)
+static int write_mp_accepts(std::ostream& file, CHash256& hasher)
 {
     AcceptMap::const_iterator iter;
     for (iter = my_accepts.begin(); iter != my_accepts.end(); ++iter) {
@@ -214,7 +227,7 @@ static int write_mp_accepts(std::ofstream& file, CHash256& hasher)
     return 0;
 }
 
-static int write_globals_state(std::ofstream& file, CHash256& hasher)
+static int write_globals_state(std::ostream& file, CHash256& hasher)
 {
     uint32_t nextSPID = pDbSpInfo->peekNextSPID(OMNI_PROPERTY_MSC);
     uint32_t nextTestSPID = pDbSpInfo->peekNextSPID(OMNI_PROPERTY_TMSC);
@@ -232,7 +245,7 @@ static int write_globals_state(std::ofstream& file, CHash256& hasher)
     return 0;
 }
 
-static int write_mp_crowdsales(std::ofstream& file, CHash256& hasher)
+static int write_mp_crowdsales(std::ostream& file, CHash256& hasher)
 {
     for (CrowdMap::const_iterator it = my_crowds.begin(); it != my_crowds.end(); ++it) {
         // decompose the key for address
@@ -243,7 +256,7 @@ static int write_mp_crowdsales(std::ofstream& file, CHash256& hasher)
     return 0;
 }
 
-static int write_mp_metadex(std::ofstream &file, CHash256& hasher)
+static int write_mp_metadex(std::ostream& file, CHash256& hasher)
 {
     for (md_PropertiesMap::iterator my_it = metadex.begin(); my_it != metadex.end(); ++my_it) {
         md_PricesMap& prices = my_it->second;
@@ -467,14 +480,11 @@ static int input_mp_mdexorder_string(const std::string& s)
     return 0;
 }
 
-static int write_state_file(const CBlockIndex* pBlockIndex, int what)
+/**
+ * Writes one type of the in-memory state, followed by the hash of its lines.
+ */
+static int write_state(std::ostream& file, int what)
 {
-    fs::path path = pathStateFiles / strprintf("%s-%s.dat", statePrefix[what], pBlockIndex->GetBlockHash().ToString());
-    const std::string strFile = path.string();
-
-    std::ofstream file;
-    file.open(strFile.c_str());
-
     CHash256 hasher;
 
     int result = 0;
@@ -510,6 +520,19 @@ static int write_state_file(const CBlockIndex* pBlockIndex, int what)
     hasher.Finalize(hash.begin());
     file << "!" << hash.ToString() << std::endl;
 
+    return result;
+}
+
+static int write_state_file(const CBlockIndex* pBlockIndex, int what)
+{
+    fs::path path = pathStateFiles / strprintf("%s-%s.dat", statePrefix[what], pBlockIndex->GetBlockHash().ToString());
+    const std::string strFile = path.string();
+
+    std::ofstream file;
+    file.open(strFile.c_str());
+
+    int result = write_state(file, what);
+
     file.flush();
     file.close();
     return result;
@@ -934,3 +957,172 @@ int LoadMostRelevantInMemoryState()
     // return the height of the block we settled at
     return res;
 }
+
+//! Marks the Omni state section of a UTXO snapshot
+static const char OMNI_SNAPSHOT_MAGIC[4] = {'o', 'm', 'n', 'i'};
+//! Version of the Omni state section
+static const int OMNI_SNAPSHOT_VERSION = 1;
+
+/**
+ * Returns the databases, which are part of a snapshot, with their names.
+ */
+static std::vector<std::pair<std::string, CDBBase*>> GetSnapshotDatabases()
+{
+    return {
+        {"MP_spinfo", pDbSpInfo},
+        {"MP_txlist", pDbTransactionList},
+        {"MP_stolist", pDbStoList},
+        {"MP_tradelist", pDbTradeList},
+        {"Omni_TXDB", pDbTransaction},
+        {"OMNI_feecache", pDbFeeCache},
+        {"OMNI_feehistory", pDbFeeHistory},
+        {"OMNI_nftdb", pDbNFT},
+    };
+}
+
+/**
+ * Captures the state of the last processed block for a UTXO snapshot.
+ *
+ * The in-memory state is captured in the format of the state files, and the
+ * databases are captured with iterators, so that the snapshot can be written
+ * after the locks are released. Nothing is persisted.
+ */
+std::unique_ptr<OmniStateSnapshot> CaptureStateSnapshot(const CBlockIndex* pBlockIndex)
+{
+    AssertLockHeld(cs_main);
+    AssertLockHeld(cs_tally);
+
+    std::unique_ptr<OmniStateSnapshot> snapshot(new OmniStateSnapshot());
+    snapshot->blockHash = pBlockIndex->GetBlockHash();
+    snapshot->consensusHash = GetConsensusHash();
+
+    for (int i = 0; i < NUM_FILETYPES; ++i) {
+        std::stringstream file;
+        write_state(file, i);
+        std::vector<std::string> vLines;
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty()) vLines.push_back(line);
+        }
+        snapshot->vStateFiles.push_back(std::move(vLines));
+    }
+
+    for (const auto& db : GetSnapshotDatabases()) {
+        snapshot->vDatabases.emplace_back(db.first, db.second->NewSnapshotIterator());
+    }
+
+    return snapshot;
+}
+
+/**
+ * Writes captured state into a UTXO snapshot.
+ *
+ * The section follows the coins and contains the state files and all entries
+ * of the Omni databases of the block.
+ */
+void WriteStateSnapshot(CAutoFile& file, OmniStateSnapshot& snapshot)
+{
+    file.write(OMNI_SNAPSHOT_MAGIC, sizeof(OMNI_SNAPSHOT_MAGIC));
+    file << OMNI_SNAPSHOT_VERSION << snapshot.blockHash << snapshot.consensusHash;
+
+    for (size_t i = 0; i < snapshot.vStateFiles.size(); ++i) {
+        file << std::string(statePrefix[i]);
+        for (const std::string& line : snapshot.vStateFiles[i]) {
+            file << line;
+        }
+        file << std::string();
+    }
+
+    for (auto& db : snapshot.vDatabases) {
+        file << db.first;
+        CDBBase::Export(file, *db.second);
+    }
+}
+
+/**
+ * Reads the header of the state section of a UTXO snapshot.
+ *
+ * Nothing is changed, so that the caller can check the consensus hash before
+ * the current state is replaced.
+ */
+uint256 ReadStateSnapshotHeader(CAutoFile& file, const CBlockIndex* pBlockIndex)
+{
+    char magic[sizeof(OMNI_SNAPSHOT_MAGIC)];
+    try {
+        file.read(magic, sizeof(magic));
+    } catch (const std::ios_base::failure&) {
+        throw std::runtime_error("Snapshot contains no Omni state");
+    }
+    if (memcmp(magic, OMNI_SNAPSHOT_MAGIC, sizeof(magic)) != 0) {
+        throw std::runtime_error("Snapshot contains no Omni state");
+    }
+
+    int nVersion = 0;
+    uint256 blockHash;
+    uint256 consensusHash;
+    file >> nVersion >> blockHash >> consensusHash;
+    if (nVersion != OMNI_SNAPSHOT_VERSION) {
+        throw std::runtime_error(strprintf("Unsupported version %d of the Omni state", nVersion));
+    }
+    if (blockHash != pBlockIndex->GetBlockHash()) {
+        throw std::runtime_error("Omni state does not belong to the base block of the snapshot");
+    }
+
+    return consensusHash;
+}
+
+/**
+ * Reads the state of a UTXO snapshot into the databases and state files.
+ *
+ * Expects the file to be positioned after the header. Existing state files
+ * are removed, the content of the databases is replaced, and the watermark
+ * of the SP database is moved to the block. The in-memory state is not
+ * touched.
+ */
+void ReadStateSnapshot(CAutoFile& file, const CBlockIndex* pBlockIndex)
+{
+    AssertLockHeld(cs_tally);
+
+    const uint256 blockHash = pBlockIndex->GetBlockHash();
+
+    std::vector<fs::path> vObsolete;
+    for (fs::directory_iterator it(pathStateFiles); it != fs::directory_iterator(); ++it) {
+        if (fs::is_regular_file(it->status())) vObsolete.push_back(it->path());
+    }
+    for (const fs::path& path : vObsolete) {
+        fs::remove(path);
+    }
+
+    for (int i = 0; i < NUM_FILETYPES; ++i) {
+        std::string prefix;
+        file >> prefix;
+        if (prefix != statePrefix[i]) {
+            throw std::runtime_error(strprintf("Unexpected state file %s in Omni state", prefix));
+        }
+        fs::path path = pathStateFiles / strprintf("%s-%s.dat", statePrefix[i], blockHash.ToString());
+        std::ofstream out(path.string().c_str());
+        std::string line;
+        while (true) {
+            file >> line;
+            if (line.empty()) break;
+            out << line << std::endl;
+        }
+        out.close();
+        if (out.fail()) {
+            throw std::runtime_error(strprintf("Unable to write state file %s", path.string()));
+        }
+    }
+
+    for (const auto& db : GetSnapshotDatabases()) {
+        std::string name;
+        file >> name;
+        if (name != db.first) {
+            throw std::runtime_error(strprintf("Unexpected database %s in Omni state", name));
+        }
+        db.second->Import(file);
+        PrintToLog("%s(): loaded %s of block %s\n", __func__, name, blockHash.ToString());
+    }
+
+    // the state files belong to the block, whichever block was persisted last
+    pDbSpInfo->setWatermark(blockHash);
+}
@@ -1,10 +1,33 @@
 #ifndef XEP_OMNICORE_PERSISTENCE_H
 #define XEP_OMNICORE_PERSISTENCE_H
 
+#include <uint256.h>
+
+#include <leveldb/iterator.h>
+
 #include <boost/filesystem.hpp>
 
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+class CAutoFile;
 class CBlockIndex;
 
+/** Omni state of a block, captured to be written into a UTXO snapshot. */
+struct OmniStateSnapshot
+{
+    //! Hash of the block of the state
+    uint256 blockHash;
+    //! Consensus hash of the state
+    uint256 consensusHash;
+    //! Lines of the state files of the block
+    std::vector<std::vector<std::string>> vStateFiles;
+    //! Names of the databases and iterators over their entries
+    std::vector<std::pair<std::string, std::unique_ptr<leveldb::Iterator>>> vDatabases;
+};
+
 /** Indicates whether persistence is enabled and the state is stored. */
 bool IsPersistenceEnabled(int blockHeight);
 
@@ -26,4 +49,16 @@ void MaybeCreateStateSnapshot(const CBlockIndex* tip);
 /** Clean old snapshots */
 void prune_state_files(const CBlockIndex* topIndex);
 
+/** Captures the state of the last processed block for a UTXO snapshot. */
+std::unique_ptr<OmniStateSnapshot> CaptureStateSnapshot(const CBlockIndex* pBlockIndex);
+
+/** Writes captured state into a UTXO snapshot. */
+void WriteStateSnapshot(CAutoFile& file, OmniStateSnapshot& snapshot);
+
+/** Reads the header of the state section of a UTXO snapshot. Returns the consensus hash of the state. */
+uint256 ReadStateSnapshotHeader(CAutoFile& file, const CBlockIndex* pBlockIndex);
+
+/** Reads the state of a UTXO snapshot, after its header, into the databases and state files. */
+void ReadStateSnapshot(CAutoFile& file, const CBlockIndex* pBlockIndex);
+
 #endif // XEP_OMNICORE_PERSISTENCE_H
@@ -18,6 +18,7 @@
 #include <omnicore/errors.h>
 #include <omnicore/log.h>
 #include <omnicore/mdex.h>
+#include <omnicore/mempooloverlay.h>
 #include <omnicore/notifications.h>
 #include <omnicore/omnicore.h>
 #include <omnicore/parsing.h>
@@ -59,6 +60,7 @@
 #include <univalue.h>
 
 #include <stdint.h>
+#include <algorithm>
 #include <map>
 #include <stdexcept>
 #include <string>
@@ -1038,6 +1040,7 @@ static UniValue omni_getbalance(const JSONRPCRequest& request)
        {
            {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "the address"},
            {"propertyid", RPCArg::Type::NUM, RPCArg::Optional::NO, ""},
+           {"includepending", RPCArg::Type::BOOL, /* default */ "false", "include the amounts of unconfirmed simple sends and send-to-many transactions"},
        },
        RPCResult{
            RPCResult::Type::OBJ, "", "",
@@ -1045,21 +1048,41 @@ static UniValue omni_getbalance(const JSONRPCRequest& request)
                {RPCResult::Type::STR_AMOUNT, "balance", "the available balance of the address"},
                {RPCResult::Type::STR_AMOUNT, "reserved", "the amount reserved by sell offers and accepts"},
                {RPCResult::Type::STR_AMOUNT, "frozen", "the amount frozen by the issuer (applies to managed properties only)"},
+               {RPCResult::Type::STR_AMOUNT, "pendingincoming", /* optional */ true, "the amount pending to be received in the memory pool (only with includepending)"},
+               {RPCResult::Type::STR_AMOUNT, "pendingoutgoing", /* optional */ true, "the amount pending to be sent in the memory pool (only with includepending)"},
            },
        },
        RPCExamples{
            HelpExampleCli("omni_getbalance", "\"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\" 1")
+           + HelpExampleCli("omni_getbalance", "\"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\" 1 true")
            + HelpExampleRpc("omni_getbalance", "\"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\", 1")
        }
     }.Check(request);
 
     std::string address = ParseAddress(request.params[0]);
     uint32_t propertyId = ParsePropertyId(request.params[1]);
+    bool fIncludePending = false;
+    if (request.params.size() > 2) {
+        fIncludePending = request.params[2].get_bool();
+    }
 
     RequireExistingProperty(propertyId);
 
+    bool fDivisible = isPropertyDivisible(propertyId);
     UniValue balanceObj(UniValue::VOBJ);
-    BalanceToJSON(address, propertyId, balanceObj, isPropertyDivisible(propertyId));
+    BalanceToJSON(address, propertyId, balanceObj, fDivisible);
+
+    if (fIncludePending) {
+        // pending amounts are unconfirmed and may never be applied to the balance
+        CMPPendingAmounts pending = mempoolOverlay.GetPendingAmounts(address, propertyId);
+        if (fDivisible) {
+            balanceObj.pushKV("pendingincoming", FormatDivisibleMP(pending.incoming));
+            balanceObj.pushKV("pendingoutgoing", FormatDivisibleMP(pending.outgoing));
+        } else {
+            balanceObj.pushKV("pendingincoming", FormatIndivisibleMP(pending.incoming));
+            balanceObj.pushKV("pendingoutgoing", FormatIndivisibleMP(pending.outgoing));
+        }
+    }
 
     return balanceObj;
 }
@@ -1093,32 +1116,62 @@ static UniValue omni_getallbalancesforid(const JSONRPCRequest& request)
 
     RequireExistingProperty(propertyId);
 
-    UniValue response(UniValue::VARR);
     bool isDivisible = isPropertyDivisible(propertyId); // we want to check this BEFORE the loop
 
-    LOCK(cs_tally);
+    // Collect plain balances under the lock, the result is only built, or streamed, afterwards
+    struct AddressBalance {
+        std::string address;
+        int64_t available;
+        int64_t reserved;
+        int64_t frozen;
+    };
+    std::vector<AddressBalance> balances;
+    {
+        LOCK(cs_tally);
 
-    for (std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
-        uint32_t id = 0;
-        bool includeAddress = false;
-        std::string address = it->first;
-        (it->second).init();
-        while (0 != (id = (it->second).next())) {
-            if (id == propertyId) {
-                includeAddress = true;
-                break;
+        for (std::unordered_map<std::string, CMPTally>::iterator it = mp_tally_map.begin(); it != mp_tally_map.end(); ++it) {
+            uint32_t id = 0;
+            bool includeAddress = false;
+            const std::string& address = it->first;
+            (it->second).init();
+            while (0 != (id = (it->second).next())) {
+                if (id == propertyId) {
+                    includeAddress = true;
+                    break;
+                }
+            }
+            if (!includeAddress) {
+                continue; // ignore this address, has never transacted in this propertyId
+            }
+            // confirmed balance minus unconfirmed, spent amounts
+            AddressBalance balance{address, GetAvailableTokenBalance(address, propertyId), GetReservedTokenBalance(address, propertyId), GetFrozenTokenBalance(address, propertyId)};
+            if (balance.available || balance.reserved || balance.frozen) {
+                balances.push_back(std::move(balance));
             }
         }
-        if (!includeAddress) {
-            continue; // ignore this address, has never transacted in this propertyId
-        }
+    }
+
+    auto balanceToJSON = [isDivisible](const AddressBalance& balance) {
         UniValue balanceObj(UniValue::VOBJ);
-        balanceObj.pushKV("address", address);
-        bool nonEmptyBalance = BalanceToJSON(address, propertyId, balanceObj, isDivisible);
+        balanceObj.pushKV("address", balance.address);
+        balanceObj.pushKV("balance", isDivisible ? FormatDivisibleMP(balance.available) : FormatIndivisibleMP(balance.available));
+        balanceObj.pushKV("reserved", isDivisible ? FormatDivisibleMP(balance.reserved) : FormatIndivisibleMP(balance.reserved));
+        balanceObj.pushKV("frozen", isDivisible ? FormatDivisibleMP(balance.frozen) : FormatIndivisibleMP(balance.frozen));
+        return balanceObj;
+    };
+
+    if (request.stream) {
+        request.stream->BeginArray();
+        for (const AddressBalance& balance : balances) {
+            request.stream->Value(balanceToJSON(balance));
+        }
+        request.stream->EndArray();
+        return NullUniValue;
+    }
 
-        if (nonEmptyBalance) {
-            response.push_back(balanceObj);
-        }
+    UniValue response(UniValue::VARR);
+    for (const AddressBalance& balance : balances) {
+        response.push_back(balanceToJSON(balance));
     }
 
     return response;
@@ -1185,6 +1238,170 @@ static UniValue omni_getallbalancesforaddress(const JSONRPCRequest& request)
     return response;
 }
 
+/** The number of addresses, whose balances are resolved per lock of the state. */
+static const size_t BALANCES_BATCH_CHUNK_SIZE = 1000;
+/** The number of times the balances are resolved again, because a block was connected in between. */
+static const unsigned int BALANCES_BATCH_MAX_RESTARTS = 3;
+
+static UniValue omni_getbalancesbatch(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"omni_getbalancesbatch",
+       "\nReturns the token balances for many addresses at once.\n"
+       "\nAll balances are resolved in one pass at the same block. Entries given as plain address return all "
+       "non-zero balances of that address, entries with a property identifier return that balance, even if it is zero.\n",
+       {
+           {"requests", RPCArg::Type::ARR, RPCArg::Optional::NO, "an array of addresses or of objects with \"address\" and \"propertyid\"",
+                {
+                    {"address", RPCArg::Type::STR, RPCArg::Optional::OMITTED, "an address, to return all of its balances"},
+                    {"", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "the address"},
+                            {"propertyid", RPCArg::Type::NUM, RPCArg::Optional::NO, "the property identifier"},
+                        },
+                    },
+                },
+            },
+       },
+       RPCResult{
+           RPCResult::Type::OBJ, "", "",
+           {
+               {RPCResult::Type::NUM, "block", "the height of the block the balances were resolved at"},
+               {RPCResult::Type::STR_HEX, "blockhash", "the hash of the block the balances were resolved at"},
+               {RPCResult::Type::ARR, "balances", "",
+               {
+                   {RPCResult::Type::OBJ, "", "",
+                   {
+                       {RPCResult::Type::STR, "address", "the address"},
+                       {RPCResult::Type::NUM, "propertyid", "the property identifier"},
+                       {RPCResult::Type::STR_AMOUNT, "balance", "the available balance of the address"},
+                       {RPCResult::Type::STR_AMOUNT, "reserved", "the amount reserved by sell offers and accepts"},
+                       {RPCResult::Type::STR_AMOUNT, "frozen", "the amount frozen by the issuer (applies to managed properties only)"},
+                   }},
+               }},
+           }
+       },
+       RPCExamples{
+           HelpExampleCli("omni_getbalancesbatch", "'[\"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\", {\"address\": \"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\", \"propertyid\": 1}]'")
+           + HelpExampleRpc("omni_getbalancesbatch", "[\"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\", {\"address\": \"1EXoDusjGwvnjZUyKkxZ4UHEf77z6A5S4P\", \"propertyid\": 1}]")
+       }
+    }.Check(request);
+
+    // parse all entries first, a property identifier of 0 selects all balances of the address
+    std::vector<std::pair<std::string, uint32_t> > vRequests;
+    const UniValue& uvRequests = request.params[0].get_array();
+    vRequests.reserve(uvRequests.size());
+
+    for (size_t idx = 0; idx < uvRequests.size(); idx++) {
+        const UniValue& input = uvRequests[idx];
+        if (input.isStr()) {
+            vRequests.push_back(std::make_pair(ParseAddress(input), 0));
+        } else {
+            const UniValue& o = input.get_obj();
+            std::string address = ParseAddress(find_value(o, "address"));
+            uint32_t propertyId = ParsePropertyId(find_value(o, "propertyid"));
+            vRequests.push_back(std::make_pair(address, propertyId));
+        }
+    }
+
+    // balances are resolved in chunks of addresses, the result is only built, or streamed, afterwards
+    std::vector<UniValue> vBalances;
+
+    // divisibility of each property seen so far, to avoid a property lookup per entry
+    std::map<uint32_t, bool> mapDivisible;
+    auto isDivisible = [&mapDivisible](uint32_t propertyId) -> bool {
+        std::map<uint32_t, bool>::const_iterator it = mapDivisible.find(propertyId);
+        if (it != mapDivisible.end()) return it->second;
+        CMPSPInfo::Entry property;
+        if (!pDbSpInfo->getSP(propertyId, property)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Property identifier %d does not exist", propertyId));
+        }
+        mapDivisible.insert(std::make_pair(propertyId, property.isDivisible()));
+        return property.isDivisible();
+    };
+    // empty balances are only added, when a property was requested explicitly
+    auto addBalance = [&vBalances, &isDivisible](const std::string& address, uint32_t propertyId, bool fIncludeEmpty) {
+        UniValue balanceObj(UniValue::VOBJ);
+        balanceObj.pushKV("address", address);
+        balanceObj.pushKV("propertyid", (uint64_t) propertyId);
+        bool nonEmptyBalance = BalanceToJSON(address, propertyId, balanceObj, isDivisible(propertyId));
+        if (nonEmptyBalance || fIncludeEmpty) {
+            vBalances.push_back(std::move(balanceObj));
+        }
+    };
+
+    // blocks are only connected while holding cs_main, so the locks are released between chunks, and if
+    // the tip changed in between, the balances are resolved again, so that all belong to the same block;
+    // after a few restarts the remaining entries are resolved without releasing the locks
+    const CBlockIndex* pBlockIndex = nullptr;
+    size_t nNext = 0;
+    unsigned int nRestarts = 0;
+    do {
+        LOCK2(cs_main, cs_tally);
+
+        const CBlockIndex* pTip = ChainActive().Tip();
+        if (nNext > 0 && pTip != pBlockIndex) {
+            vBalances.clear();
+            nNext = 0;
+            ++nRestarts;
+        }
+        pBlockIndex = pTip;
+
+        const size_t nChunkSize = nRestarts < BALANCES_BATCH_MAX_RESTARTS ? BALANCES_BATCH_CHUNK_SIZE : vRequests.size();
+        const size_t nEnd = std::min(nNext + nChunkSize, vRequests.size());
+        for (; nNext < nEnd; ++nNext) {
+            const std::string& address = vRequests[nNext].first;
+            if (vRequests[nNext].second != 0) {
+                addBalance(address, vRequests[nNext].second, true);
+                continue;
+            }
+
+            CMPTally* addressTally = getTally(address);
+            if (nullptr == addressTally) {
+                continue; // address has never transacted, there is nothing to return
+            }
+
+            addressTally->init();
+            uint32_t propertyId = 0;
+            while (0 != (propertyId = addressTally->next())) {
+                if (!IsPropertyIdValid(propertyId)) {
+                    continue;
+                }
+                addBalance(address, propertyId, false);
+            }
+        }
+    } while (nNext < vRequests.size());
+
+    const int nHeight = pBlockIndex ? pBlockIndex->nHeight : 0;
+    const std::string strBlockHash = pBlockIndex ? pBlockIndex->GetBlockHash().GetHex() : uint256().GetHex();
+
+    if (request.stream) {
+        JSONStreamWriter& stream = *request.stream;
+        stream.BeginObject();
+        stream.Key("block");
+        stream.Value(nHeight);
+        stream.Key("blockhash");
+        stream.Value(strBlockHash);
+        stream.Key("balances");
+        stream.BeginArray();
+        for (const UniValue& balance : vBalances) {
+            stream.Value(balance);
+        }
+        stream.EndArray();
+        stream.EndObject();
+        return NullUniValue;
+    }
+
+    UniValue balances(UniValue::VARR);
+    balances.push_backV(vBalances);
+
+    UniValue response(UniValue::VOBJ);
+    response.pushKV("block", nHeight);
+    response.pushKV("blockhash", strBlockHash);
+    response.pushKV("balances", balances);
+
+    return response;
+}
+
 /** Returns all addresses that may be mine. */
 static std::set<std::string> getWalletAddresses(const JSONRPCRequest& request, bool fIncludeWatchOnly)
 {
@@ -2297,6 +2514,15 @@ static UniValue omni_listblockstransactions(const JSONRPCRequest& request)
         pDbTransactionList->GetOmniTxsInBlockRange(blockFirst, blockLast, txs);
     }
 
+    if (request.stream) {
+        request.stream->BeginArray();
+        for (const uint256& tx : txs) {
+            request.stream->Value(tx.GetHex());
+        }
+        request.stream->EndArray();
+        return NullUniValue;
+    }
+
     for(const uint256& tx : txs) {
         response.push_back(tx.GetHex());
     }
@@ -2487,17 +2713,18 @@ static UniValue omni_listpendingtransactions(const JSONRPCRequest& request)
         filterAddress = ParseAddressOrEmpty(request.params[0]);
     }
 
-    std::vector<uint256> vTxid;
-    mempool.queryHashes(vTxid);
+    // the overlay holds the decoded Omni transactions of the memory pool, indexed by address
+    std::vector<uint256> vTxid = mempoolOverlay.GetTransactions(filterAddress);
 
     UniValue result(UniValue::VARR);
     for(const uint256& hash : vTxid) {
-        if (!IsInMarkerCache(hash)) {
+        CTransactionRef tx = mempool.get(hash);
+        if (!tx) {
             continue;
         }
 
         UniValue txObj(UniValue::VOBJ);
-        if (populateRPCTransactionObject(hash, txObj, filterAddress, false, "", pWallet.get()) == 0) {
+        if (populateRPCTransactionObject(*tx, uint256(), txObj, filterAddress, false, "", 0, pWallet.get()) == 0) {
             result.push_back(txObj);
         }
     }
@@ -2927,7 +3154,7 @@ static const CRPCCommand commands[] =
     { "omni layer (data retrieval)", "omni_getinfo",                   &omni_getinfo,                    {} },
     { "omni layer (data retrieval)", "omni_getactivations",            &omni_getactivations,             {} },
     { "omni layer (data retrieval)", "omni_getallbalancesforid",       &omni_getallbalancesforid,        {"propertyid"} },
-    { "omni layer (data retrieval)", "omni_getbalance",                &omni_getbalance,                 {"address", "propertyid"} },
+    { "omni layer (data retrieval)", "omni_getbalance",                &omni_getbalance,                 {"address", "propertyid", "includepending"} },
     { "omni layer (data retrieval)", "omni_gettransaction",            &omni_gettransaction,             {"txid"} },
     { "omni layer (data retrieval)", "omni_getproperty",               &omni_getproperty,                {"propertyid"} },
     { "omni layer (data retrieval)", "omni_listproperties",            &omni_listproperties,             {} },
@@ -2942,6 +3169,7 @@ static const CRPCCommand commands[] =
     { "omni layer (data retrieval)", "omni_listblockstransactions",    &omni_listblockstransactions,     {"firstblock", "lastblock"} },
     { "omni layer (data retrieval)", "omni_listpendingtransactions",   &omni_listpendingtransactions,    {"address"} },
     { "omni layer (data retrieval)", "omni_getallbalancesforaddress",  &omni_getallbalancesforaddress,   {"address"} },
+    { "omni layer (data retrieval)", "omni_getbalancesbatch",          &omni_getbalancesbatch,           {"requests"} },
     { "omni layer (data retrieval)", "omni_gettradehistoryforaddress", &omni_gettradehistoryforaddress,  {"address", "count", "propertyid"} },
     { "omni layer (data retrieval)", "omni_gettradehistoryforpair",    &omni_gettradehistoryforpair,     {"propertyid", "propertyidsecond", "count"} },
     { "omni layer (data retrieval)", "omni_getcurrentconsensushash",   &omni_getcurrentconsensushash,    {} },
@@ -2967,7 +3195,7 @@ static const CRPCCommand commands[] =
 
     /* deprecated: */
     { "hidden",                      "getinfo_MP",                     &omni_getinfo,                    {}  },
-    { "hidden",                      "getbalance_MP",                  &omni_getbalance,                 {"address", "propertyid"} },
+    { "hidden",                      "getbalance_MP",                  &omni_getbalance,                 {"address", "propertyid", "includepending"} },
     { "hidden",                      "getallbalancesforaddress_MP",    &omni_getallbalancesforaddress,   {"address"} },
     { "hidden",                      "getallbalancesforid_MP",         &omni_getallbalancesforid,        {"propertyid"} },
     { "hidden",                      "getproperty_MP",                 &omni_getproperty,                {"propertyid"} },
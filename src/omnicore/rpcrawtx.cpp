@@ -1,19 +1,27 @@
 #include <omnicore/createtx.h>
 #include <omnicore/omnicore.h>
+#include <omnicore/parallel.h>
 #include <omnicore/rpc.h>
 #include <omnicore/rpctxobject.h>
 #include <omnicore/rpcvalues.h>
 
+#include <omnicore/utilsxep.h>
+
+#include <chain.h>
 #include <coins.h>
 #include <core_io.h>
+#include <index/txindex.h>
 #include <interfaces/wallet.h>
 #include <primitives/transaction.h>
 #include <pubkey.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 #include <sync.h>
+#include <txmempool.h>
 #include <uint256.h>
 #include <util/strencodings.h>
+#include <util/system.h>
+#include <validation.h>
 #include <wallet/rpcwallet.h>
 #ifdef ENABLE_WALLET
 #include <wallet/wallet.h>
@@ -22,14 +30,54 @@
 #include <univalue.h>
 
 #include <stdint.h>
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <set>
 #include <stdexcept>
 #include <string>
+#include <vector>
 
 extern RecursiveMutex cs_main;
 
+using mastercore::ForEachParallel;
 using mastercore::cs_tx_cache;
 using mastercore::view;
+using mastercore::viewDummy;
+
+/** Number of transactions of a batch decoded per lock of the global coins view cache */
+static const size_t DECODE_LOCK_CHUNK_SIZE = 100;
+
+/**
+ * Temporarily backs the global coins view cache by the given inputs.
+ *
+ * The coins cached so far are set aside and moved back afterwards, so the cache is
+ * neither emptied nor polluted by the inputs looked up in the meantime.
+ *
+ * Note: cs_tx_cache must be locked for the lifetime of the object!
+ */
+class InputsViewBackend
+{
+private:
+    CCoinsViewCache viewSaved;
+
+public:
+    explicit InputsViewBackend(CCoinsViewCache& viewInputs) : viewSaved(&viewDummy)
+    {
+        AssertLockHeld(cs_tx_cache);
+        view.SetBackend(viewSaved);
+        view.Flush();
+        view.SetBackend(viewInputs);
+    }
 
+    ~InputsViewBackend()
+    {
+        view.Flush();
+        view.SetBackend(viewDummy);
+        viewSaved.SetBackend(view);
+        viewSaved.Flush();
+    }
+};
 
 static UniValue omni_decodetransaction(const JSONRPCRequest& request)
 {
@@ -107,12 +155,8 @@ static UniValue omni_decodetransaction(const JSONRPCRequest& request)
     int populateResult = -3331;
     {
         LOCK2(cs_main, cs_tx_cache);
-        // temporarily switch global coins view cache for transaction inputs
-        std::swap(view, viewTemp);
-        // then get the results
+        InputsViewBackend backend(viewTemp);
         populateResult = populateRPCTransactionObject(tx, uint256(), txObj, "", false, "", blockHeight, pWallet.get());
-        // and restore the original, unpolluted coins view cache
-        std::swap(viewTemp, view);
     }
 
     if (populateResult != 0) PopulateFailure(populateResult);
@@ -120,6 +164,159 @@ static UniValue omni_decodetransaction(const JSONRPCRequest& request)
     return txObj;
 }
 
+static UniValue omni_decodetransactions(const JSONRPCRequest& request)
+{
+#ifdef ENABLE_WALLET
+    std::shared_ptr<CWallet> const wallet = GetWalletForJSONRPCRequest(request);
+    std::unique_ptr<interfaces::Wallet> pWallet = interfaces::MakeWallet(wallet);
+#else
+    std::unique_ptr<interfaces::Wallet> pWallet;
+#endif
+
+    RPCHelpMan{"omni_decodetransactions",
+       "\nDecodes a batch of Omni transactions.\n"
+       "\nThe inputs of all transactions are looked up once for the whole batch. Inputs, which are outputs "
+       "of other transactions of the batch, are resolved as well. If the inputs are not in the chain, "
+       "then they must be provided.\n"
+       "\nA block height can be provided, which is used to determine the parsing rules.\n",
+       {
+           {"rawtxs", RPCArg::Type::ARR, RPCArg::Optional::NO, "a JSON array of raw transactions to decode\n",
+                {
+                    {"rawtx", RPCArg::Type::STR_HEX, RPCArg::Optional::OMITTED, "the raw transaction\n"},
+                }
+           },
+           {"prevtxs", RPCArg::Type::ARR, /* default */ "none", "a JSON array of transaction inputs, shared by all transactions\n",
+                {
+                    {"", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"txid:hash", RPCArg::Type::STR, RPCArg::Optional::NO, "the transaction hash\n"},
+                            {"vout:n", RPCArg::Type::NUM, RPCArg::Optional::NO, "the output number\n"},
+                            {"scriptPubKey:hex", RPCArg::Type::STR, RPCArg::Optional::NO, "the output script\n"},
+                            {"value:n.nnnnnnnn", RPCArg::Type::NUM, RPCArg::Optional::NO, "the output value\n"},
+                        }
+                    }
+                }
+           },
+           {"height", RPCArg::Type::NUM, /* default */ "0 for chain height", "the parsing block height\n"},
+       },
+       RPCResult{
+           RPCResult::Type::ARR, "", "the decoded transactions, in the order of the request",
+           {
+               {RPCResult::Type::OBJ, "", "",
+               {
+                   {RPCResult::Type::ELISION, "", "the transaction, as returned by omni_decodetransaction"},
+                   {RPCResult::Type::OBJ, "error", "the error, if the transaction could not be decoded, instead of the transaction",
+                   {
+                       {RPCResult::Type::NUM, "code", "the error code"},
+                       {RPCResult::Type::STR, "message", "the error message"},
+                   }},
+               }},
+           }
+       },
+       RPCExamples{
+           HelpExampleCli("omni_decodetransactions", "\"[\\\"0100000001...\\\",\\\"0100000001...\\\"]\"")
+           + HelpExampleRpc("omni_decodetransactions", "[\"0100000001...\", \"0100000001...\"]")
+       }
+    }.Check(request);
+
+    const UniValue& rawTxs = request.params[0].get_array();
+
+    // shared by the batch: the user provided inputs, and the inputs looked up below
+    CCoinsView viewDummyTemp;
+    CCoinsViewCache viewTemp(&viewDummyTemp);
+
+    if (request.params.size() > 1) {
+        std::vector<PrevTxsEntry> prevTxsParsed = ParsePrevTxs(request.params[1]);
+        InputsToView(prevTxsParsed, viewTemp);
+    }
+
+    int blockHeight = 0;
+    if (request.params.size() > 2) {
+        blockHeight = request.params[2].get_int();
+    }
+
+    for (size_t i = 0; i < rawTxs.size(); ++i) {
+        if (!rawTxs[i].isStr()) {
+            throw JSONRPCError(RPC_TYPE_ERROR, strprintf("Raw transaction %d is not a string", i));
+        }
+    }
+
+    // decode the transactions, failed ones are left empty
+    std::vector<CTransactionRef> batch(rawTxs.size());
+    ForEachParallel(rawTxs.size(), [&](size_t i) {
+        CMutableTransaction mtx;
+        if (DecodeHexTx(mtx, rawTxs[i].get_str())) {
+            batch[i] = MakeTransactionRef(std::move(mtx));
+        }
+    });
+
+    // outputs of the batch can be spent by other transactions of the batch
+    for (const CTransactionRef& tx : batch) {
+        if (tx) AddCoins(viewTemp, *tx, 0, true);
+    }
+
+    // look up the transactions of the remaining inputs, once per transaction
+    std::set<uint256> missingSet;
+    for (const CTransactionRef& tx : batch) {
+        if (!tx || tx->IsCoinBase()) continue;
+        for (const CTxIn& txIn : tx->vin) {
+            if (!viewTemp.HaveCoinInCache(txIn.prevout)) missingSet.insert(txIn.prevout.hash);
+        }
+    }
+    std::vector<uint256> missing(missingSet.begin(), missingSet.end());
+    std::vector<CTransactionRef> prevTxs(missing.size());
+    std::vector<int> prevHeights(missing.size(), 1);
+
+    ForEachParallel(missing.size(), [&](size_t i) {
+        prevTxs[i] = mempool.get(missing[i]);
+        if (prevTxs[i] || !g_txindex) return;
+
+        uint256 hashBlock;
+        if (!g_txindex->FindTx(missing[i], hashBlock, prevTxs[i])) return;
+        const CBlockIndex* pBlockIndex = mastercore::GetBlockIndex(hashBlock);
+        if (pBlockIndex) prevHeights[i] = pBlockIndex->nHeight;
+    });
+
+    for (size_t i = 0; i < missing.size(); ++i) {
+        if (prevTxs[i]) AddCoins(viewTemp, *prevTxs[i], prevHeights[i], true);
+    }
+
+#ifdef ENABLE_WALLET
+    if (wallet) {
+        wallet->BlockUntilSyncedToCurrentChain();
+    }
+#endif
+
+    // the locks are released every DECODE_LOCK_CHUNK_SIZE transactions, so that blocks and other calls are not held up
+    UniValue response(UniValue::VARR);
+    for (size_t nChunk = 0; nChunk < batch.size(); nChunk += DECODE_LOCK_CHUNK_SIZE) {
+        LOCK2(cs_main, cs_tx_cache);
+        InputsViewBackend backend(viewTemp);
+
+        for (size_t i = nChunk; i < std::min(nChunk + DECODE_LOCK_CHUNK_SIZE, batch.size()); ++i) {
+            UniValue txObj(UniValue::VOBJ);
+            try {
+                if (!batch[i]) {
+                    throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Transaction deserialization failed");
+                }
+                int populateResult = populateRPCTransactionObject(*batch[i], uint256(), txObj, "", false, "", blockHeight, pWallet.get());
+                if (populateResult != 0) PopulateFailure(populateResult);
+            } catch (const UniValue& objError) {
+                txObj.clear();
+                txObj.setObject();
+                txObj.pushKV("error", objError);
+            } catch (const std::exception& e) {
+                txObj.clear();
+                txObj.setObject();
+                txObj.pushKV("error", JSONRPCError(RPC_MISC_ERROR, e.what()));
+            }
+            response.push_back(txObj);
+        }
+    }
+
+    return response;
+}
+
 static UniValue omni_createrawtx_opreturn(const JSONRPCRequest& request)
 {
     RPCHelpMan{"omni_createrawtx_opreturn",
@@ -317,6 +514,7 @@ static const CRPCCommand commands[] =
 { //  category                         name                          actor (function)             okSafeMode
   //  -------------------------------- ----------------------------- ---------------------------- ----------
     { "omni layer (raw transactions)", "omni_decodetransaction",     &omni_decodetransaction,     {"rawtx", "prevtxs", "height"} },
+    { "omni layer (raw transactions)", "omni_decodetransactions",    &omni_decodetransactions,    {"rawtxs", "prevtxs", "height"} },
     { "omni layer (raw transactions)", "omni_createrawtx_opreturn",  &omni_createrawtx_opreturn,  {"rawtx", "payload"} },
     { "omni layer (raw transactions)", "omni_createrawtx_multisig",  &omni_createrawtx_multisig,  {"rawtx", "payload", "seed", "redeemkey"} },
     { "omni layer (raw transactions)", "omni_createrawtx_input",     &omni_createrawtx_input,     {"rawtx", "txid", "n"} },
@@ -637,6 +637,181 @@ static UniValue omni_sendtomany(const JSONRPCRequest& request)
     }
 }
 
+/**
+ * Plans the send-to-many transactions for the payouts of one property.
+ *
+ * As many receivers as fit into the output index of a send-to-many payload are
+ * combined into one transaction, single remaining payouts use a simple send.
+ */
+static void PlanPropertyPayouts(
+        const std::string& fromAddress,
+        uint32_t propertyId,
+        const std::vector<std::pair<std::string, uint64_t> >& payouts,
+        bool fSendToMany,
+        interfaces::Wallet* pwallet,
+        std::vector<std::pair<std::vector<std::string>, std::vector<unsigned char> > >& retTransactions,
+        std::vector<std::pair<uint16_t, int64_t> >& retPending)
+{
+    size_t pos = 0;
+    while (pos < payouts.size()) {
+        size_t count = fSendToMany ? std::min(payouts.size() - pos, (size_t) std::numeric_limits<uint8_t>::max()) : 1;
+
+        if (count == 1) {
+            const std::pair<std::string, uint64_t>& payout = payouts[pos];
+            retTransactions.push_back(std::make_pair(std::vector<std::string>(1, payout.first), CreatePayload_SimpleSend(propertyId, payout.second)));
+            retPending.push_back(std::make_pair((uint16_t) MSC_TYPE_SIMPLE_SEND, (int64_t) payout.second));
+            ++pos;
+            continue;
+        }
+
+        // shrink the batch until payload and receiver outputs fit into the output index
+        std::vector<std::tuple<uint8_t, uint64_t> > outputValues;
+        int payloadOutputCount = 0;
+        while (true) {
+            outputValues.clear();
+            for (size_t idx = 0; idx < count; ++idx) {
+                outputValues.push_back(std::make_tuple(idx, payouts[pos + idx].second)); // note, this would be an invalid position
+            }
+            payloadOutputCount = GetDryPayloadOutputCount(fromAddress, "", CreatePayload_SendToMany(propertyId, outputValues), pwallet);
+            if (payloadOutputCount < 0) {
+                throw JSONRPCError(RPC_TYPE_ERROR, "Error creating send-to-many payload");
+            }
+            if (payloadOutputCount + count <= (size_t) std::numeric_limits<uint8_t>::max() + 1) {
+                break;
+            }
+            --count;
+        }
+
+        std::vector<std::string> receiverAddresses;
+        uint64_t amountToSend = 0;
+        outputValues.clear();
+        for (size_t idx = 0; idx < count; ++idx) {
+            const std::pair<std::string, uint64_t>& payout = payouts[pos + idx];
+            receiverAddresses.push_back(payout.first);
+            outputValues.push_back(std::make_tuple(payloadOutputCount + idx, payout.second));
+            amountToSend += payout.second;
+        }
+
+        retTransactions.push_back(std::make_pair(receiverAddresses, CreatePayload_SendToMany(propertyId, outputValues)));
+        retPending.push_back(std::make_pair((uint16_t) MSC_TYPE_SEND_TO_MANY, (int64_t) amountToSend));
+        pos += count;
+    }
+}
+
+static UniValue omni_sendpayouts(const JSONRPCRequest& request)
+{
+    std::shared_ptr<CWallet> const wallet = GetWalletForJSONRPCRequest(request);
+    std::unique_ptr<interfaces::Wallet> pwallet = interfaces::MakeWallet(wallet);
+
+    RPCHelpMan{"omni_sendpayouts",
+       "\nCreate and broadcast the transactions for a list of payouts from one source.\n"
+       "\nPayouts of the same property are combined into send-to-many transactions, if available. "
+       "Either all transactions are created and broadcasted, or none.\n",
+       {
+           {"fromaddress", RPCArg::Type::STR, RPCArg::Optional::NO, "the address to send from"},
+           {"payouts", RPCArg::Type::ARR, RPCArg::Optional::NO, "an array with the receiving \"address\", the \"propertyid\" and the \"amount\" to send",
+                {
+                    {"", RPCArg::Type::OBJ, RPCArg::Optional::OMITTED, "",
+                        {
+                            {"address", RPCArg::Type::STR, RPCArg::Optional::NO, "the address of the receiver"},
+                            {"propertyid", RPCArg::Type::NUM, RPCArg::Optional::NO, "the identifier of the tokens to send"},
+                            {"amount", RPCArg::Type::STR, RPCArg::Optional::NO, "the amount of tokens to send"},
+                        },
+                    },
+                },
+            },
+       },
+       RPCResult{
+           RPCResult::Type::ARR, "", "",
+           {
+               {RPCResult::Type::STR_HEX, "hash", "the hex-encoded transaction hash"},
+           }
+       },
+       RPCExamples{
+           HelpExampleCli("omni_sendpayouts", "\"3M9qvHKtgARhqcMtM5cRT9VaiDJ5PSfQGY\" '[{\"address\": \"37FaKponF7zqoMLUjEiko25pDiuVH5YLEa\", \"propertyid\": 1, \"amount\": \"10.5\"}, {\"address\": \"1oQM6A7ZHpuuMZwJvTsLumUrut2GnFCok\", \"propertyid\": 31, \"amount\": \"0.5\"}]'")
+           + HelpExampleRpc("omni_sendpayouts", "\"3M9qvHKtgARhqcMtM5cRT9VaiDJ5PSfQGY\", '[{\"address\": \"37FaKponF7zqoMLUjEiko25pDiuVH5YLEa\", \"propertyid\": 1, \"amount\": \"10.5\"}, {\"address\": \"1oQM6A7ZHpuuMZwJvTsLumUrut2GnFCok\", \"propertyid\": 31, \"amount\": \"0.5\"}]'")
+       }
+    }.Check(request);
+
+    std::string fromAddress = ParseAddress(request.params[0]);
+    const UniValue& uvPayouts = request.params[1].get_array();
+
+    // group the payouts by property, in order of first appearance
+    std::vector<uint32_t> vPropertyIds;
+    std::map<uint32_t, std::vector<std::pair<std::string, uint64_t> > > mapPayouts;
+
+    for (size_t idx = 0; idx < uvPayouts.size(); idx++) {
+        const UniValue& o = uvPayouts[idx].get_obj();
+
+        std::string address = ParseAddress(find_value(o, "address"));
+        uint32_t propertyId = ParsePropertyId(find_value(o, "propertyid"));
+        RequireExistingProperty(propertyId);
+        uint64_t amount = ParseAmount(find_value(o, "amount"), isPropertyDivisible(propertyId));
+
+        if (mapPayouts.find(propertyId) == mapPayouts.end()) {
+            vPropertyIds.push_back(propertyId);
+        }
+        mapPayouts[propertyId].push_back(std::make_pair(address, amount));
+    }
+
+    if (vPropertyIds.empty()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "No payouts given");
+    }
+
+    // perform checks
+    for (uint32_t propertyId : vPropertyIds) {
+        int64_t amountTotal = 0;
+        for (const auto& payout : mapPayouts[propertyId]) {
+            if (payout.second > (uint64_t) (MAX_INT_8_BYTES - amountTotal)) {
+                throw JSONRPCError(RPC_TYPE_ERROR, "Total amount of payouts out of range");
+            }
+            amountTotal += payout.second;
+        }
+        RequireBalance(fromAddress, propertyId, amountTotal);
+    }
+
+    // plan the transactions
+    bool fSendToMany = IsFeatureActivated(FEATURE_SEND_TO_MANY, GetHeight());
+    std::vector<std::pair<std::vector<std::string>, std::vector<unsigned char> > > vTransactions;
+    std::vector<std::pair<uint32_t, std::pair<uint16_t, int64_t> > > vPending;
+
+    for (uint32_t propertyId : vPropertyIds) {
+        std::vector<std::pair<uint16_t, int64_t> > vPropertyPending;
+        PlanPropertyPayouts(fromAddress, propertyId, mapPayouts[propertyId], fSendToMany, pwallet.get(), vTransactions, vPropertyPending);
+        for (const auto& pending : vPropertyPending) {
+            vPending.push_back(std::make_pair(propertyId, pending));
+        }
+    }
+
+    if (wallet) {
+        wallet->BlockUntilSyncedToCurrentChain();
+    }
+
+    // request the wallet build the transactions (and if needed commit them)
+    std::vector<uint256> vTxids;
+    std::vector<std::string> vRawHex;
+    int result = WalletTxBuilderBatch(fromAddress, vTransactions, vTxids, vRawHex, autoCommit, pwallet.get());
+
+    // check error and return the txids (or raw hex depending on autocommit)
+    if (result != 0) {
+        throw JSONRPCError(result, error_str(result));
+    }
+
+    UniValue response(UniValue::VARR);
+    if (!autoCommit) {
+        for (const std::string& rawHex : vRawHex) {
+            response.push_back(rawHex);
+        }
+    } else {
+        for (size_t i = 0; i < vTxids.size(); ++i) {
+            PendingAdd(vTxids[i], fromAddress, vPending[i].second.first, vPending[i].first, vPending[i].second.second);
+            response.push_back(vTxids[i].GetHex());
+        }
+    }
+
+    return response;
+}
+
 static UniValue omni_senddexsell(const JSONRPCRequest& request)
 {
     std::shared_ptr<CWallet> const wallet = GetWalletForJSONRPCRequest(request);
@@ -2457,6 +2632,7 @@ static const CRPCCommand commands[] =
     { "omni layer (transaction creation)", "omni_sendxeppayment",          &omni_sendxeppayment,          {"fromaddress", "toaddress", "linkedTxID", "amount"} },
     { "omni layer (transaction creation)", "omni_senddexsell",             &omni_senddexsell,             {"fromaddress", "propertyidforsale", "amountforsale", "amountdesired", "paymentwindow", "minacceptfee", "action"} },
     { "omni layer (transaction creation)", "omni_sendtomany",              &omni_sendtomany,              {"fromaddress", "propertyid", "mapping"} },
+    { "omni layer (transaction creation)", "omni_sendpayouts",             &omni_sendpayouts,             {"fromaddress", "payouts"} },
     { "omni layer (transaction creation)", "omni_sendnewdexorder",         &omni_sendnewdexorder,         {"fromaddress", "propertyidforsale", "amountforsale", "amountdesired", "paymentwindow", "minacceptfee"} },
     { "omni layer (transaction creation)", "omni_sendupdatedexorder",      &omni_sendupdatedexorder,      {"fromaddress", "propertyidforsale", "amountforsale", "amountdesired", "paymentwindow", "minacceptfee"} },
     { "omni layer (transaction creation)", "omni_sendcanceldexorder",      &omni_sendcanceldexorder,      {"fromaddress", "propertyidforsale"} },
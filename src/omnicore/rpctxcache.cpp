@@ -0,0 +1,67 @@
+/**
+ * @file rpctxcache.cpp
+ *
+ * Cache of transactions, which were decoded for RPC objects.
+ */
+
+#include <omnicore/rpctxcache.h>
+
+#include <omnicore/rpctxobject.h>
+
+#include <sync.h>
+#include <uint256.h>
+#include <util/system.h>
+
+#include <stdint.h>
+#include <algorithm>
+#include <map>
+
+/**
+ * Returns the cache of decoded transactions, which is bounded by -omnirpctxcache.
+ */
+CRPCTransactionCache& GetRPCTransactionCache()
+{
+    static CRPCTransactionCache cache(std::max<int64_t>(0, gArgs.GetArg("-omnirpctxcache", DEFAULT_OMNI_RPC_TX_CACHE)));
+    return cache;
+}
+
+CachedRPCTransactionRef CRPCTransactionCache::Get(const uint256& txid)
+{
+    LOCK(cs_cache);
+    std::map<uint256, EntryList::iterator>::const_iterator it = entries.find(txid);
+    if (it == entries.end()) return nullptr;
+    lru.splice(lru.begin(), lru, it->second);
+    return it->second->second;
+}
+
+uint64_t CRPCTransactionCache::GetGeneration()
+{
+    LOCK(cs_cache);
+    return generation;
+}
+
+void CRPCTransactionCache::Put(const uint256& txid, const CachedRPCTransactionRef& entry, uint64_t nGeneration)
+{
+    LOCK(cs_cache);
+    if (nMaxSize == 0 || nGeneration != generation || entries.count(txid)) return;
+    while (lru.size() >= nMaxSize) {
+        entries.erase(lru.back().first);
+        lru.pop_back();
+    }
+    lru.emplace_front(txid, entry);
+    entries.emplace(txid, lru.begin());
+}
+
+void CRPCTransactionCache::Clear()
+{
+    LOCK(cs_cache);
+    lru.clear();
+    entries.clear();
+    ++generation;
+}
+
+size_t CRPCTransactionCache::Size()
+{
+    LOCK(cs_cache);
+    return lru.size();
+}
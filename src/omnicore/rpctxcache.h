@@ -0,0 +1,79 @@
+#ifndef XEP_OMNICORE_RPCTXCACHE_H
+#define XEP_OMNICORE_RPCTXCACHE_H
+
+#include <omnicore/tx.h>
+
+#include <sync.h>
+#include <uint256.h>
+
+#include <univalue.h>
+
+#include <stdint.h>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+/**
+ * A confirmed Omni transaction, which was decoded for an RPC object before.
+ *
+ * Everything stored here remains unchanged as long as the transaction's block
+ * is part of the active chain, so only the number of confirmations and the
+ * wallet relation have to be determined per request.
+ */
+struct CachedRPCTransaction
+{
+    //! The decoded and interpreted transaction
+    CMPTransaction mp_obj;
+    //! The block the transaction was confirmed in
+    uint256 blockHash;
+    int blockHeight;
+    int64_t blockTime;
+    //! The state recorded, when the transaction was processed
+    bool valid;
+    int positionInBlock;
+    std::string invalidReason;
+    //! The basic RPC object without "confirmations", or null, if it depends on mutable state
+    UniValue txobj;
+};
+
+typedef std::shared_ptr<const CachedRPCTransaction> CachedRPCTransactionRef;
+
+/**
+ * Bounded least-recently-used cache of decoded transactions, keyed by txid.
+ *
+ * It's cleared whenever blocks are disconnected or the state is reset. A
+ * generation counter guards against entries, which were decoded while a
+ * clearing took place, so they are not added afterwards.
+ */
+class CRPCTransactionCache
+{
+private:
+    typedef std::list<std::pair<uint256, CachedRPCTransactionRef>> EntryList;
+
+    const size_t nMaxSize;
+    Mutex cs_cache;
+    EntryList lru GUARDED_BY(cs_cache);
+    std::map<uint256, EntryList::iterator> entries GUARDED_BY(cs_cache);
+    uint64_t generation GUARDED_BY(cs_cache) = 0;
+
+public:
+    explicit CRPCTransactionCache(size_t nMaxSizeIn) : nMaxSize(nMaxSizeIn) {}
+
+    /** Returns the cached transaction and marks it as recently used, or nullptr. */
+    CachedRPCTransactionRef Get(const uint256& txid);
+    /** Returns the generation, which must be obtained before the state to be cached is read. */
+    uint64_t GetGeneration();
+    /** Adds a transaction, unless the cache was cleared since the given generation. */
+    void Put(const uint256& txid, const CachedRPCTransactionRef& entry, uint64_t nGeneration);
+    /** Removes all transactions. */
+    void Clear();
+    /** Returns the number of cached transactions. */
+    size_t Size();
+};
+
+/** Returns the cache of decoded transactions, which is shared by all RPC calls. */
+CRPCTransactionCache& GetRPCTransactionCache();
+
+#endif // XEP_OMNICORE_RPCTXCACHE_H
@@ -17,6 +17,7 @@
 #include <omnicore/omnicore.h>
 #include <omnicore/parsing.h>
 #include <omnicore/pending.h>
+#include <omnicore/rpctxcache.h>
 #include <omnicore/sp.h>
 #include <omnicore/sto.h>
 #include <omnicore/tx.h>
@@ -29,12 +30,17 @@
 #include <primitives/transaction.h>
 #include <sync.h>
 #include <uint256.h>
+#include <util/system.h>
 
 #include <univalue.h>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 
+#include <algorithm>
+#include <list>
+#include <map>
+#include <memory>
 #include <stdint.h>
 #include <string>
 #include <vector>
@@ -43,6 +49,90 @@
 // Namespaces
 using namespace mastercore;
 
+namespace {
+/** Whether the type specific RPC fields of a confirmed transaction depend on state, which may still change. */
+bool hasMutableTypeInfo(uint32_t txType)
+{
+    switch (txType) {
+        // DEx amounts are amended in the transaction list
+        case MSC_TYPE_TRADE_OFFER: return true;
+        case MSC_TYPE_ACCEPT_OFFER_XEP: return true;
+    }
+    return false;
+}
+} // anonymous namespace
+
+/**
+ * Populates the RPC object of an interpreted transaction, except for the number of confirmations.
+ */
+static void populateRPCTransactionFields(CMPTransaction& mp_obj, const uint256& blockHash, int64_t blockTime, int blockHeight, int confirmations, bool valid, int positionInBlock, const std::string& invalidReason, UniValue& txobj, bool extendedDetails, const std::string& extendedDetailsFilter, interfaces::Wallet* iWallet)
+{
+    // populate some initial info for the transaction
+    bool fMine = false;
+    if (IsMyAddress(mp_obj.getSender(), iWallet) || IsMyAddress(mp_obj.getReceiver(), iWallet)) fMine = true;
+    txobj.pushKV("txid", mp_obj.getHash().GetHex());
+    txobj.pushKV("fee", FormatDivisibleMP(mp_obj.getFeePaid()));
+    txobj.pushKV("sendingaddress", mp_obj.getSender());
+    if (showRefForTx(mp_obj.getType())) txobj.pushKV("referenceaddress", mp_obj.getReceiver());
+    txobj.pushKV("ismine", fMine);
+    txobj.pushKV("version", (uint64_t)mp_obj.getVersion());
+    txobj.pushKV("type_int", (uint64_t)mp_obj.getType());
+    if (mp_obj.getType() != MSC_TYPE_SIMPLE_SEND) { // Type 0 will add "Type" attribute during populateRPCTypeSimpleSend
+        txobj.pushKV("type", mp_obj.getTypeString());
+    }
+
+    // populate type specific info and extended details if requested
+    // extended details are not available for unconfirmed transactions
+    if (confirmations <= 0) extendedDetails = false;
+    populateRPCTypeInfo(mp_obj, txobj, mp_obj.getType(), extendedDetails, extendedDetailsFilter, confirmations, iWallet);
+
+    // state and chain related information
+    if (confirmations != 0 && !blockHash.IsNull()) {
+        txobj.pushKV("valid", valid);
+        if (!valid) {
+            txobj.pushKV("invalidreason", invalidReason);
+        }
+        txobj.pushKV("blockhash", blockHash.GetHex());
+        txobj.pushKV("blocktime", blockTime);
+        txobj.pushKV("positioninblock", positionInBlock);
+    }
+    if (confirmations != 0) {
+        txobj.pushKV("block", blockHeight);
+    }
+}
+
+/**
+ * Populates the RPC object of a transaction, which was decoded before.
+ *
+ * Returns false, if the cached transaction can't be used, because it's not confirmed relative to the given height.
+ */
+static bool populateRPCTransactionObject(const CachedRPCTransaction& cached, UniValue& txobj, const std::string& filterAddress, bool extendedDetails, const std::string& extendedDetailsFilter, int blockHeight, interfaces::Wallet* iWallet, int& rc)
+{
+    const int confirmations = 1 + blockHeight - cached.blockHeight;
+    if (confirmations <= 0) return false;
+
+    const CMPTransaction& mp_obj = cached.mp_obj;
+    if (!filterAddress.empty() && mp_obj.getSender() != filterAddress && mp_obj.getReceiver() != filterAddress) {
+        rc = -1;
+        return true;
+    }
+
+    UniValue fields(UniValue::VOBJ);
+    if (!extendedDetails && !cached.txobj.isNull()) {
+        fields = cached.txobj;
+        bool fMine = IsMyAddress(mp_obj.getSender(), iWallet) || IsMyAddress(mp_obj.getReceiver(), iWallet);
+        fields.pushKV("ismine", fMine);
+    } else {
+        CMPTransaction obj(mp_obj);
+        populateRPCTransactionFields(obj, cached.blockHash, cached.blockTime, cached.blockHeight, confirmations, cached.valid, cached.positionInBlock, cached.invalidReason, fields, extendedDetails, extendedDetailsFilter, iWallet);
+    }
+    txobj.pushKVs(fields);
+    txobj.pushKV("confirmations", confirmations);
+
+    rc = 0;
+    return true;
+}
+
 /**
  * Function to standardize RPC output for transactions into a JSON object in either basic or extended mode.
  *
@@ -50,9 +140,18 @@ using namespace mastercore;
  * Use extended mode for transaction specific calls (e.g. omni_getsto, omni_gettrade etc.)
  *
  * DEx payments and the extended mode are only available for confirmed transactions.
+ *
+ * Confirmed transactions are decoded once and then served from a cache, which is bounded by -omnirpctxcache.
  */
 int populateRPCTransactionObject(const uint256& txid, UniValue& txobj, std::string filterAddress, bool extendedDetails, std::string extendedDetailsFilter, interfaces::Wallet* iWallet)
 {
+    // a cached transaction doesn't need to be loaded from the blockchain
+    CachedRPCTransactionRef cached = GetRPCTransactionCache().Get(txid);
+    int rc = 0;
+    if (cached && populateRPCTransactionObject(*cached, txobj, filterAddress, extendedDetails, extendedDetailsFilter, GetHeight(), iWallet, rc)) {
+        return rc;
+    }
+
     bool f_txindex_ready = false;
     if (g_txindex) {
         f_txindex_ready = g_txindex->BlockUntilSyncedToCurrentChain();
@@ -82,6 +181,19 @@ int populateRPCTransactionObject(const CTransaction& tx, const uint256& blockHas
         blockHeight = GetHeight();
     }
 
+    const uint256& txid = tx.GetHash();
+
+    // the cached transaction is only used, if it was confirmed in the same block
+    CachedRPCTransactionRef cached = GetRPCTransactionCache().Get(txid);
+    if (cached && cached->blockHash == blockHash) {
+        int rc = 0;
+        if (populateRPCTransactionObject(*cached, txobj, filterAddress, extendedDetails, extendedDetailsFilter, blockHeight, iWallet, rc)) {
+            return rc;
+        }
+    }
+    // obtained before any state is read, so that nothing is cached, which was decoded during a reorg
+    const uint64_t nCacheGeneration = GetRPCTransactionCache().GetGeneration();
+
     if (!blockHash.IsNull()) {
         CBlockIndex* pBlockIndex = GetBlockIndex(blockHash);
         if (nullptr != pBlockIndex) {
@@ -92,7 +204,8 @@ int populateRPCTransactionObject(const CTransaction& tx, const uint256& blockHas
     }
 
     // attempt to parse the transaction
-    CMPTransaction mp_obj;
+    std::shared_ptr<CachedRPCTransaction> decoded = std::make_shared<CachedRPCTransaction>();
+    CMPTransaction& mp_obj = decoded->mp_obj;
     int parseRC = ParseTransaction(tx, blockHeight, 0, mp_obj, blockTime);
     if (parseRC == -101) {
         return MP_RPC_DECODE_INPUTS_MISSING;
@@ -101,8 +214,6 @@ int populateRPCTransactionObject(const CTransaction& tx, const uint256& blockHas
         return MP_TX_IS_NOT_OMNI_PROTOCOL;
     }
 
-    const uint256& txid = tx.GetHash();
-
     // DEx XEP payment needs special handling since it's not actually an Omni message - handle and return
     if (parseRC > 0) {
         if (confirmations <= 0) {
@@ -136,50 +247,49 @@ int populateRPCTransactionObject(const CTransaction& tx, const uint256& blockHas
 
     // obtain validity - only confirmed transactions can be valid
     bool valid = false;
+    bool processed = false;
     if (confirmations > 0) {
         LOCK(cs_tally);
+        processed = pDbTransactionList->exists(txid);
         valid = pDbTransactionList->getValidMPTX(txid);
         positionInBlock = pDbTransaction->FetchTransactionPosition(txid);
     }
-
-    // populate some initial info for the transaction
-    bool fMine = false;
-    if (IsMyAddress(mp_obj.getSender(), iWallet) || IsMyAddress(mp_obj.getReceiver(), iWallet)) fMine = true;
-    txobj.pushKV("txid", txid.GetHex());
-    txobj.pushKV("fee", FormatDivisibleMP(mp_obj.getFeePaid()));
-    txobj.pushKV("sendingaddress", mp_obj.getSender());
-    if (showRefForTx(mp_obj.getType())) txobj.pushKV("referenceaddress", mp_obj.getReceiver());
-    txobj.pushKV("ismine", fMine);
-    txobj.pushKV("version", (uint64_t)mp_obj.getVersion());
-    txobj.pushKV("type_int", (uint64_t)mp_obj.getType());
-    if (mp_obj.getType() != MSC_TYPE_SIMPLE_SEND) { // Type 0 will add "Type" attribute during populateRPCTypeSimpleSend
-        txobj.pushKV("type", mp_obj.getTypeString());
+    std::string invalidReason;
+    if (confirmations != 0 && !blockHash.IsNull() && !valid) {
+        invalidReason = pDbTransaction->FetchInvalidReason(txid);
     }
 
-    // populate type specific info and extended details if requested
-    // extended details are not available for unconfirmed transactions
-    if (confirmations <= 0) extendedDetails = false;
-    populateRPCTypeInfo(mp_obj, txobj, mp_obj.getType(), extendedDetails, extendedDetailsFilter, confirmations, iWallet);
+    UniValue fields(UniValue::VOBJ);
+    populateRPCTransactionFields(mp_obj, blockHash, blockTime, blockHeight, confirmations, valid, positionInBlock, invalidReason, fields, extendedDetails, extendedDetailsFilter, iWallet);
+    txobj.pushKVs(fields);
+    txobj.pushKV("confirmations", confirmations);
 
-    // state and chain related information
-    if (confirmations != 0 && !blockHash.IsNull()) {
-        txobj.pushKV("valid", valid);
-        if (!valid) {
-            txobj.pushKV("invalidreason", pDbTransaction->FetchInvalidReason(txid));
+    // only transactions, which were already processed, are final until their block is disconnected
+    if (processed) {
+        decoded->blockHash = blockHash;
+        decoded->blockHeight = blockHeight;
+        decoded->blockTime = blockTime;
+        decoded->valid = valid;
+        decoded->positionInBlock = positionInBlock;
+        decoded->invalidReason = invalidReason;
+        if (!extendedDetails && !hasMutableTypeInfo(mp_obj.getType())) {
+            decoded->txobj = fields;
         }
-        txobj.pushKV("blockhash", blockHash.GetHex());
-        txobj.pushKV("blocktime", blockTime);
-        txobj.pushKV("positioninblock", positionInBlock);
-    }
-    if (confirmations != 0) {
-        txobj.pushKV("block", blockHeight);
+        GetRPCTransactionCache().Put(txid, decoded, nCacheGeneration);
     }
-    txobj.pushKV("confirmations", confirmations);
 
     // finished
     return 0;
 }
 
+/**
+ * Clears the cache of decoded transactions, e.g. when blocks are disconnected.
+ */
+void ClearRPCTransactionCache()
+{
+    GetRPCTransactionCache().Clear();
+}
+
 /* Function to call respective populators based on message type
  */
 void populateRPCTypeInfo(CMPTransaction& mp_obj, UniValue& txobj, uint32_t txType, bool extendedDetails, std::string extendedDetailsFilter, int confirmations, interfaces::Wallet *iWallet)
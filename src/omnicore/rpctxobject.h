@@ -3,6 +3,7 @@
 
 #include <univalue.h>
 
+#include <stdint.h>
 #include <string>
 
 class uint256;
@@ -13,6 +14,9 @@ namespace interfaces {
 class Wallet;
 } // namespace interfaces
 
+/** Default for -omnirpctxcache, the number of decoded transactions kept for RPC objects. */
+static const int64_t DEFAULT_OMNI_RPC_TX_CACHE = 2000;
+
 int populateRPCTransactionObject(const uint256& txid, UniValue& txobj, std::string filterAddress = "", bool extendedDetails = false, std::string extendedDetailsFilter = "", interfaces::Wallet* iWallet = nullptr);
 int populateRPCTransactionObject(const CTransaction& tx, const uint256& blockHash, UniValue& txobj, std::string filterAddress = "", bool extendedDetails = false, std::string extendedDetailsFilter = "", int blockHeight = 0, interfaces::Wallet* iWallet = nullptr);
 
@@ -57,4 +61,7 @@ int populateRPCSendAllSubSends(const uint256& txid, UniValue& subSends);
 
 bool showRefForTx(uint32_t txType);
 
+/** Clears the cache of decoded transactions, which must be done, whenever the Omni state is rolled back. */
+void ClearRPCTransactionCache();
+
 #endif // XEP_OMNICORE_RPCTXOBJECT_H
@@ -54,7 +54,7 @@ void CMPCrowd::print(const std::string& address, FILE* fp) const
     fprintf(fp, "%s\n", toString(address).c_str());
 }
 
-void CMPCrowd::saveCrowdSale(std::ofstream& file, const std::string& addr, CHash256& hasher) const
+void CMPCrowd::saveCrowdSale(std::ostream& file, const std::string& addr, CHash256& hasher) const
 {
     // compose the outputline
     // addr,propertyId,nValue,property_desired,deadline,early_bird,percentage,created,mined
@@ -61,7 +61,7 @@ public:
 
     std::string toString(const std::string& address) const;
     void print(const std::string& address, FILE* fp = stdout) const;
-    void saveCrowdSale(std::ofstream& file, const std::string& addr, CHash256 &hasher) const;
+    void saveCrowdSale(std::ostream& file, const std::string& addr, CHash256 &hasher) const;
 };
 
 namespace mastercore
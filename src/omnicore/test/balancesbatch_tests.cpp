@@ -0,0 +1,148 @@
+#include <omnicore/omnicore.h>
+#include <omnicore/tally.h>
+
+#include <chainparamsbase.h>
+#include <key.h>
+#include <key_io.h>
+#include <rpc/server.h>
+#include <script/standard.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <string>
+
+using namespace mastercore;
+
+struct BalancesBatchTestingSetup : public TestingSetup
+{
+    BalancesBatchTestingSetup() : TestingSetup(CBaseChainParams::REGTEST)
+    {
+        StartRPC();
+        if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+    }
+
+    ~BalancesBatchTestingSetup()
+    {
+        InterruptRPC();
+        StopRPC();
+    }
+
+    UniValue CallRPC(const std::string& strMethod, const UniValue& params)
+    {
+        JSONRPCRequest request;
+        request.strMethod = strMethod;
+        request.params = params;
+        try {
+            return tableRPC.execute(request);
+        } catch (const UniValue& objError) {
+            throw std::runtime_error(find_value(objError, "message").get_str());
+        }
+    }
+};
+
+static std::string NewAddress()
+{
+    CKey key;
+    key.MakeNewKey(true);
+    return EncodeDestination(PKHash(key.GetPubKey()));
+}
+
+static UniValue BalanceRequest(const std::string& address, uint32_t propertyId)
+{
+    UniValue request(UniValue::VOBJ);
+    request.pushKV("address", address);
+    request.pushKV("propertyid", (uint64_t) propertyId);
+    return request;
+}
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_balancesbatch_tests, BalancesBatchTestingSetup)
+
+BOOST_AUTO_TEST_CASE(balancesbatch_entries)
+{
+    const std::string addressA = NewAddress();
+    const std::string addressB = NewAddress();
+    {
+        LOCK(cs_tally);
+        update_tally_map(addressA, OMNI_PROPERTY_MSC, 150000000, BALANCE);
+        update_tally_map(addressA, OMNI_PROPERTY_TMSC, 20000000, SELLOFFER_RESERVE);
+    }
+
+    UniValue requests(UniValue::VARR);
+    requests.push_back(addressA);
+    requests.push_back(BalanceRequest(addressB, OMNI_PROPERTY_MSC));
+    requests.push_back(addressB);
+    UniValue params(UniValue::VARR);
+    params.push_back(requests);
+    const UniValue result = CallRPC("omni_getbalancesbatch", params);
+
+    const CBlockIndex* pTip = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+    BOOST_CHECK_EQUAL(find_value(result, "block").get_int(), pTip->nHeight);
+    BOOST_CHECK_EQUAL(find_value(result, "blockhash").get_str(), pTip->GetBlockHash().GetHex());
+
+    // all non-empty balances of A, and the requested, empty balance of B
+    const UniValue& balances = find_value(result, "balances");
+    BOOST_REQUIRE_EQUAL(balances.size(), 3U);
+    BOOST_CHECK_EQUAL(find_value(balances[0], "address").get_str(), addressA);
+    BOOST_CHECK_EQUAL(find_value(balances[0], "propertyid").get_int(), (int) OMNI_PROPERTY_MSC);
+    BOOST_CHECK_EQUAL(find_value(balances[0], "balance").get_str(), "1.50000000");
+    BOOST_CHECK_EQUAL(find_value(balances[1], "propertyid").get_int(), (int) OMNI_PROPERTY_TMSC);
+    BOOST_CHECK_EQUAL(find_value(balances[1], "balance").get_str(), "0.00000000");
+    BOOST_CHECK_EQUAL(find_value(balances[1], "reserved").get_str(), "0.20000000");
+    BOOST_CHECK_EQUAL(find_value(balances[2], "address").get_str(), addressB);
+    BOOST_CHECK_EQUAL(find_value(balances[2], "balance").get_str(), "0.00000000");
+    BOOST_CHECK_EQUAL(find_value(balances[2], "frozen").get_str(), "0.00000000");
+
+    // the entries match the ones of omni_getbalance
+    UniValue balanceParams(UniValue::VARR);
+    balanceParams.push_back(addressA);
+    balanceParams.push_back((uint64_t) OMNI_PROPERTY_TMSC);
+    const UniValue single = CallRPC("omni_getbalance", balanceParams);
+    for (const std::string& key : single.getKeys()) {
+        BOOST_CHECK_EQUAL(find_value(balances[1], key).get_str(), find_value(single, key).get_str());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(balancesbatch_chunks)
+{
+    const std::string address = NewAddress();
+    {
+        LOCK(cs_tally);
+        update_tally_map(address, OMNI_PROPERTY_MSC, 100000000, BALANCE);
+    }
+
+    // more entries than are resolved per lock of the state
+    UniValue requests(UniValue::VARR);
+    for (int i = 0; i < 2500; ++i) {
+        requests.push_back(i % 2 ? UniValue(address) : BalanceRequest(address, OMNI_PROPERTY_MSC));
+    }
+    UniValue params(UniValue::VARR);
+    params.push_back(requests);
+    const UniValue balances = find_value(CallRPC("omni_getbalancesbatch", params), "balances");
+    BOOST_REQUIRE_EQUAL(balances.size(), 2500U);
+    for (size_t i = 0; i < balances.size(); ++i) {
+        BOOST_CHECK_EQUAL(find_value(balances[i], "balance").get_str(), "1.00000000");
+    }
+}
+
+BOOST_AUTO_TEST_CASE(balancesbatch_invalid)
+{
+    UniValue requests(UniValue::VARR);
+    requests.push_back(BalanceRequest(NewAddress(), 4000000));
+    UniValue params(UniValue::VARR);
+    params.push_back(requests);
+    BOOST_CHECK_THROW(CallRPC("omni_getbalancesbatch", params), std::runtime_error);
+
+    requests = UniValue(UniValue::VARR);
+    requests.push_back("invalid");
+    params = UniValue(UniValue::VARR);
+    params.push_back(requests);
+    BOOST_CHECK_THROW(CallRPC("omni_getbalancesbatch", params), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
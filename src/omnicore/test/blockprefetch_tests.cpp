@@ -0,0 +1,215 @@
+#include <omnicore/blockprefetch.h>
+#include <omnicore/consensushash.h>
+#include <omnicore/createpayload.h>
+#include <omnicore/encoding.h>
+#include <omnicore/omnicore.h>
+#include <omnicore/rules.h>
+#include <omnicore/tally.h>
+
+#include <amount.h>
+#include <chainparams.h>
+#include <consensus/consensus.h>
+#include <index/txindex.h>
+#include <key.h>
+#include <key_io.h>
+#include <miner.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
+#include <script/standard.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <util/strencodings.h>
+#include <util/system.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+extern void clear_all_state();
+extern int msc_initial_scan(int nFirstBlock);
+
+using namespace mastercore;
+
+/** Creates a regtest chain with Omni transactions, whose inputs are looked up in the transaction index. */
+struct BlockPrefetchTestingSetup : public RegTestingSetup
+{
+    CKey key;
+    CScript scriptPubKey;
+
+    BlockPrefetchTestingSetup()
+    {
+        key.MakeNewKey(true);
+        scriptPubKey = GetScriptForDestination(PKHash(key.GetPubKey()));
+        g_txindex = MakeUnique<TxIndex>(1 << 20, true);
+        g_txindex->Start();
+
+        // the Omni layer starts after the tip on regtest, and only rebuilding
+        // the state, with the first block as genesis, makes it process blocks
+        MutableConsensusParams().GENESIS_BLOCK = 0;
+        mastercore_handler_disc_begin(0);
+        CreateAndProcessBlock({});
+    }
+
+    ~BlockPrefetchTestingSetup()
+    {
+        blockEndObserver = nullptr;
+        ResetConsensusParams();
+        gArgs.ForceSetArg("-omniscanthreads", ToString(DEFAULT_OMNI_SCAN_THREADS));
+        g_txindex->Stop();
+        g_txindex.reset();
+    }
+
+    /**
+     * Mines a block with the given transactions.
+     *
+     * The block assembler only pays the treasury with a coinstake, so the
+     * block is put together here, to pass the treasury blocks of regtest.
+     */
+    CTransactionRef CreateAndProcessBlock(const std::vector<CMutableTransaction>& txns)
+    {
+        const CChainParams& chainparams = Params();
+        const Consensus::Params& consensus = chainparams.GetConsensus();
+        CBlock block;
+        {
+            LOCK(cs_main);
+            const CBlockIndex* pindexPrev = ::ChainActive().Tip();
+            const int nHeight = pindexPrev->nHeight + 1;
+
+            CMutableTransaction coinbase;
+            coinbase.vin.resize(1);
+            coinbase.vin[0].prevout.SetNull();
+            coinbase.vout.emplace_back(GetBlockSubsidy(nHeight, false, 0, consensus), scriptPubKey);
+            const CAmount nTreasuryPayment = GetTreasuryPayment(nHeight, consensus);
+            for (const std::pair<const CScript, unsigned int>& payee : consensus.mTreasuryPayees) {
+                if (nTreasuryPayment > 0) coinbase.vout.emplace_back(nTreasuryPayment * payee.second / 100, payee.first);
+            }
+            block.vtx.push_back(MakeTransactionRef(coinbase));
+            for (const CMutableTransaction& tx : txns) {
+                block.vtx.push_back(MakeTransactionRef(tx));
+            }
+
+            block.nVersion = ComputeBlockVersion(pindexPrev, CBlockHeader::AlgoType::ALGO_POW_SHA256, consensus);
+            block.hashPrevBlock = pindexPrev->GetBlockHash();
+            UpdateTime(&block, consensus, pindexPrev);
+            block.nBits = GetNextWorkRequired(pindexPrev, &block, consensus);
+            unsigned int extraNonce = 0;
+            IncrementExtraNonce(&block, pindexPrev, extraNonce);
+            RegenerateCommitments(block, pindexPrev, consensus);
+        }
+
+        while (!CheckProofOfWork(block.GetPoWHash(), block.nBits, CBlockHeader::GetAlgoType(block.nVersion), consensus)) ++block.nNonce;
+
+        std::shared_ptr<const CBlock> shared_pblock = std::make_shared<const CBlock>(block);
+        BOOST_REQUIRE(ProcessNewBlock(chainparams, shared_pblock, true, nullptr));
+        return block.vtx[0];
+    }
+
+    /** Creates a class C transaction, which spends the first output of the given one, and sends the change back. */
+    CMutableTransaction CreateOmniTx(const CTransactionRef& txPrev, const std::vector<unsigned char>& vchPayload, const CScript& scriptReference = CScript())
+    {
+        std::vector<std::pair<CScript, int64_t> > vecOutputs;
+        BOOST_REQUIRE(OmniCore_Encode_ClassC(vchPayload, vecOutputs));
+
+        CMutableTransaction mtx;
+        mtx.vin.emplace_back(COutPoint(txPrev->GetHash(), 0));
+        mtx.vout.emplace_back(txPrev->vout[0].nValue - COIN, scriptPubKey);
+        for (const std::pair<CScript, int64_t>& output : vecOutputs) {
+            mtx.vout.emplace_back(output.second, output.first);
+        }
+        if (!scriptReference.empty()) {
+            mtx.vout.emplace_back(COIN / 100, scriptReference);
+        }
+
+        FillableSigningProvider keystore;
+        BOOST_REQUIRE(keystore.AddKey(key));
+        BOOST_REQUIRE(SignSignature(keystore, *txPrev, mtx, 0, SIGHASH_ALL));
+        return mtx;
+    }
+
+    /** Rebuilds the Omni state from scratch, and returns the consensus hashes of all blocks. */
+    std::vector<uint256> Replay(int nThreads)
+    {
+        gArgs.ForceSetArg("-omniscanthreads", ToString(nThreads));
+        clear_all_state();
+        {
+            // the inputs must be resolved again, and not come from an earlier scan
+            LOCK(cs_tx_cache);
+            view.Flush();
+        }
+
+        std::vector<uint256> vHashes;
+        blockEndObserver = [&](int nBlock, const CBlockIndex* pBlockIndex) {
+            vHashes.push_back(GetConsensusHash());
+        };
+        BOOST_CHECK_EQUAL(msc_initial_scan(0), 0);
+        blockEndObserver = nullptr;
+        return vHashes;
+    }
+};
+
+static bool WaitForSync(TxIndex& txindex)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!txindex.BlockUntilSyncedToCurrentChain()) {
+        if (time_start + timeout_ms <= GetTimeMillis()) return false;
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+    return true;
+}
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_blockprefetch_tests, BlockPrefetchTestingSetup)
+
+BOOST_AUTO_TEST_CASE(blockprefetch_same_state)
+{
+    // a coinbase, which can be spent after the others matured
+    const CTransactionRef coinbase = CreateAndProcessBlock({});
+    for (int i = 0; i < COINBASE_MATURITY; ++i) {
+        CreateAndProcessBlock({});
+    }
+
+    // an issuance, and a send of the issued tokens, which spends the change of the issuance
+    const CMutableTransaction txIssuance = CreateOmniTx(coinbase, CreatePayload_IssuanceFixed(1, 1, 0, "Test Cat", "Test Subcat", "Test Token", "", "", 1000));
+    CreateAndProcessBlock({txIssuance});
+    CKey keyReceiver;
+    keyReceiver.MakeNewKey(true);
+    const CScript scriptReceiver = GetScriptForDestination(PKHash(keyReceiver.GetPubKey()));
+    CreateAndProcessBlock({CreateOmniTx(MakeTransactionRef(txIssuance), CreatePayload_SimpleSend(3, 400), scriptReceiver)});
+    CreateAndProcessBlock({});
+    BOOST_REQUIRE(WaitForSync(*g_txindex));
+
+    // the state of the blocks, as they were connected
+    const std::string sender = EncodeDestination(PKHash(key.GetPubKey()));
+    const std::string receiver = EncodeDestination(PKHash(keyReceiver.GetPubKey()));
+    uint256 connectedHash;
+    {
+        LOCK(cs_tally);
+        BOOST_REQUIRE_EQUAL(GetTokenBalance(sender, 3, BALANCE), 600);
+        BOOST_REQUIRE_EQUAL(GetTokenBalance(receiver, 3, BALANCE), 400);
+        connectedHash = GetConsensusHash();
+    }
+
+    // replaying the chain with blocks and inputs read ahead results in the same state, block by block
+    const std::vector<uint256> vSerial = Replay(0);
+    const std::vector<uint256> vPrefetched = Replay(2);
+    BOOST_REQUIRE_EQUAL(vSerial.size(), (size_t) WITH_LOCK(cs_main, return ::ChainActive().Height() + 1));
+    BOOST_CHECK(vPrefetched == vSerial);
+    BOOST_CHECK(vSerial.back() == connectedHash);
+
+    LOCK(cs_tally);
+    BOOST_CHECK_EQUAL(GetTokenBalance(sender, 3, BALANCE), 600);
+    BOOST_CHECK_EQUAL(GetTokenBalance(receiver, 3, BALANCE), 400);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,148 @@
+#include <omnicore/omnicore.h>
+#include <omnicore/parallel.h>
+
+#include <chainparamsbase.h>
+#include <coins.h>
+#include <core_io.h>
+#include <key.h>
+#include <key_io.h>
+#include <primitives/transaction.h>
+#include <rpc/protocol.h>
+#include <rpc/server.h>
+#include <script/script.h>
+#include <script/standard.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <util/strencodings.h>
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+struct DecodeTransactionsTestingSetup : public TestingSetup
+{
+    DecodeTransactionsTestingSetup() : TestingSetup(CBaseChainParams::REGTEST)
+    {
+        StartRPC();
+        if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+    }
+
+    ~DecodeTransactionsTestingSetup()
+    {
+        InterruptRPC();
+        StopRPC();
+    }
+
+    UniValue CallRPC(const std::string& strMethod, const UniValue& params)
+    {
+        JSONRPCRequest request;
+        request.strMethod = strMethod;
+        request.params = params;
+        return tableRPC.execute(request);
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_decodetransactions_tests, DecodeTransactionsTestingSetup)
+
+BOOST_AUTO_TEST_CASE(parallel_items)
+{
+    std::vector<std::atomic<int>> vCalls(1000);
+    for (auto& calls : vCalls) calls = 0;
+
+    mastercore::ForEachParallel(vCalls.size(), [&vCalls](size_t i) { ++vCalls[i]; });
+
+    for (const auto& calls : vCalls) {
+        BOOST_CHECK_EQUAL(calls.load(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(decode_batch)
+{
+    CKey keySender, keyReference;
+    keySender.MakeNewKey(true);
+    keyReference.MakeNewKey(true);
+    const CTxDestination sender = PKHash(keySender.GetPubKey());
+    const CTxDestination reference = PKHash(keyReference.GetPubKey());
+
+    // funds the sender, but isn't an Omni transaction itself
+    CMutableTransaction txFunding;
+    txFunding.vin.emplace_back(COutPoint(uint256S("a1"), 0));
+    txFunding.vout.emplace_back(COIN, GetScriptForDestination(sender));
+
+    // a simple send of 1.0 OMN, whose sender is only known from the funding transaction
+    CMutableTransaction txSend;
+    txSend.vin.emplace_back(COutPoint(txFunding.GetHash(), 0));
+    txSend.vout.emplace_back(546, GetScriptForDestination(reference));
+    txSend.vout.emplace_back(0, CScript() << OP_RETURN << ParseHex("6f6d6e6900000000000000010000000005f5e100"));
+
+    // the send comes before the transaction it spends, and is repeated to span several chunks of the batch
+    UniValue rawTxs(UniValue::VARR);
+    rawTxs.push_back(EncodeHexTx(CTransaction(txSend)));
+    rawTxs.push_back("zz");
+    rawTxs.push_back(EncodeHexTx(CTransaction(txFunding)));
+    for (int i = 0; i < 250; ++i) {
+        rawTxs.push_back(EncodeHexTx(CTransaction(txSend)));
+    }
+
+    UniValue params(UniValue::VARR);
+    params.push_back(rawTxs);
+    const UniValue result = CallRPC("omni_decodetransactions", params);
+    BOOST_REQUIRE_EQUAL(result.size(), rawTxs.size());
+
+    for (size_t i = 0; i < result.size(); ++i) {
+        const UniValue& txObj = result[i];
+        if (i == 1) {
+            BOOST_CHECK_EQUAL(find_value(find_value(txObj, "error").get_obj(), "code").get_int(), RPC_DESERIALIZATION_ERROR);
+        } else if (i == 2) {
+            BOOST_CHECK(find_value(txObj, "error").isObject());
+        } else {
+            BOOST_CHECK(find_value(txObj, "error").isNull());
+            BOOST_CHECK_EQUAL(find_value(txObj, "txid").get_str(), txSend.GetHash().GetHex());
+            BOOST_CHECK_EQUAL(find_value(txObj, "sendingaddress").get_str(), EncodeDestination(sender));
+            BOOST_CHECK_EQUAL(find_value(txObj, "referenceaddress").get_str(), EncodeDestination(reference));
+            BOOST_CHECK_EQUAL(find_value(txObj, "propertyid").get_int(), 1);
+            BOOST_CHECK_EQUAL(find_value(txObj, "amount").get_str(), "1.00000000");
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(decode_keeps_input_cache)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript scriptPubKey = GetScriptForDestination(PKHash(key.GetPubKey()));
+
+    // a coin cached before, while processing blocks
+    const COutPoint cached(uint256S("b1"), 0);
+    {
+        LOCK(mastercore::cs_tx_cache);
+        mastercore::view.AddCoin(cached, Coin(CTxOut(COIN, scriptPubKey), 1, false, false), true);
+    }
+
+    CMutableTransaction txFunding;
+    txFunding.vin.emplace_back(COutPoint(uint256S("a1"), 0));
+    txFunding.vout.emplace_back(COIN, scriptPubKey);
+
+    CMutableTransaction txSend;
+    txSend.vin.emplace_back(COutPoint(txFunding.GetHash(), 0));
+    txSend.vout.emplace_back(0, CScript() << OP_RETURN << ParseHex("6f6d6e6900000000000000010000000005f5e100"));
+
+    UniValue rawTxs(UniValue::VARR);
+    rawTxs.push_back(EncodeHexTx(CTransaction(txFunding)));
+    rawTxs.push_back(EncodeHexTx(CTransaction(txSend)));
+    UniValue params(UniValue::VARR);
+    params.push_back(rawTxs);
+    CallRPC("omni_decodetransactions", params);
+
+    // the cached coin is kept, while the inputs of the batch are not added
+    LOCK(mastercore::cs_tx_cache);
+    BOOST_CHECK(mastercore::view.HaveCoinInCache(cached));
+    BOOST_CHECK(!mastercore::view.HaveCoinInCache(txSend.vin[0].prevout));
+    mastercore::view.Flush();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+#include <omnicore/mempooloverlay.h>
+
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace mastercore;
+
+static CMPMempoolEntry SimpleSend(const std::string& sender, const std::string& receiver, uint32_t propertyId, int64_t amount)
+{
+    CMPMempoolEntry entry;
+    entry.sender = sender;
+    entry.receiver = receiver;
+    entry.propertyId = propertyId;
+    entry.deltas.emplace_back(sender, propertyId, -amount);
+    entry.deltas.emplace_back(receiver, propertyId, amount);
+    return entry;
+}
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_mempooloverlay_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(empty_overlay)
+{
+    CMPMempoolOverlay overlay;
+    BOOST_CHECK_EQUAL(overlay.Size(), 0U);
+    BOOST_CHECK(overlay.GetTransactions().empty());
+    BOOST_CHECK(overlay.GetTransactions("alice").empty());
+
+    CMPPendingAmounts pending = overlay.GetPendingAmounts("alice", 1);
+    BOOST_CHECK_EQUAL(pending.incoming, 0);
+    BOOST_CHECK_EQUAL(pending.outgoing, 0);
+
+    // removing unknown transactions is a no-op
+    overlay.Remove(uint256S("01"));
+    BOOST_CHECK_EQUAL(overlay.Size(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(pending_amounts)
+{
+    CMPMempoolOverlay overlay;
+    const uint256 txidA = uint256S("0a");
+    const uint256 txidB = uint256S("0b");
+
+    overlay.AddEntry(txidA, SimpleSend("alice", "bob", 3, 500));
+    overlay.AddEntry(txidB, SimpleSend("bob", "carol", 3, 200));
+    // adding the same transaction twice doesn't count twice
+    overlay.AddEntry(txidA, SimpleSend("alice", "bob", 3, 500));
+
+    BOOST_CHECK_EQUAL(overlay.Size(), 2U);
+    BOOST_CHECK(overlay.Exists(txidA));
+    BOOST_CHECK(overlay.Exists(txidB));
+
+    BOOST_CHECK_EQUAL(overlay.GetPendingAmounts("alice", 3).outgoing, 500);
+    BOOST_CHECK_EQUAL(overlay.GetPendingAmounts("alice", 3).incoming, 0);
+    BOOST_CHECK_EQUAL(overlay.GetPendingAmounts("bob", 3).incoming, 500);
+    BOOST_CHECK_EQUAL(overlay.GetPendingAmounts("bob", 3).outgoing, 200);
+    BOOST_CHECK_EQUAL(overlay.GetPendingAmounts("carol", 3).incoming, 200);
+    BOOST_CHECK_EQUAL(overlay.GetPendingAmounts("carol", 4).incoming, 0);
+
+    BOOST_CHECK_EQUAL(overlay.GetTransactions().size(), 2U);
+    BOOST_CHECK_EQUAL(overlay.GetTransactions("bob").size(), 2U);
+    std::vector<uint256> vTxid = overlay.GetTransactions("carol");
+    BOOST_CHECK_EQUAL(vTxid.size(), 1U);
+    BOOST_CHECK(vTxid[0] == txidB);
+
+    overlay.Remove(txidA);
+    BOOST_CHECK(!overlay.Exists(txidA));
+    BOOST_CHECK_EQUAL(overlay.GetPendingAmounts("alice", 3).outgoing, 0);
+    BOOST_CHECK_EQUAL(overlay.GetPendingAmounts("bob", 3).incoming, 0);
+    BOOST_CHECK_EQUAL(overlay.GetPendingAmounts("bob", 3).outgoing, 200);
+    BOOST_CHECK(overlay.GetTransactions("alice").empty());
+    BOOST_CHECK_EQUAL(overlay.GetTransactions("bob").size(), 1U);
+
+    overlay.Clear();
+    BOOST_CHECK_EQUAL(overlay.Size(), 0U);
+    BOOST_CHECK_EQUAL(overlay.GetPendingAmounts("carol", 3).incoming, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -172,4 +172,84 @@ BOOST_AUTO_TEST_CASE(nftdb_test_rollback)
     BOOST_CHECK_EQUAL("David", UITDb->GetNonFungibleTokenValueInRange(50, 1, 1000));
 }
 
+
+BOOST_AUTO_TEST_CASE(nftdb_test_block_batch)
+{
+    LOCK(cs_tally);
+    const fs::path path = GetDataDir() / "OMNI_nftdb_batch";
+    std::unique_ptr<CMPNonFungibleTokensDB> UITDb{new CMPNonFungibleTokensDB(path, true)};
+
+    // writes of a block are visible before they are committed
+    UITDb->StartBlockBatch();
+    std::pair<int64_t, int64_t> testA = UITDb->CreateNonFungibleTokens(50, 1000, "Alice", "");
+    BOOST_CHECK_EQUAL(1000, testA.second);
+    BOOST_CHECK(UITDb->MoveNonFungibleTokens(50, 1, 500, "Alice", "Bob"));
+    BOOST_CHECK_EQUAL("Bob", UITDb->GetNonFungibleTokenValueInRange(50, 1, 500));
+    BOOST_CHECK_EQUAL("Alice", UITDb->GetNonFungibleTokenValueInRange(50, 501, 1000));
+    UITDb->WriteBlockCache(1);
+    BOOST_CHECK(UITDb->CommitBlockBatch());
+
+    // writes of an incomplete block are dropped, when the database is closed
+    UITDb->StartBlockBatch();
+    BOOST_CHECK(UITDb->MoveNonFungibleTokens(50, 1, 500, "Bob", "Charles"));
+    BOOST_CHECK_EQUAL("Charles", UITDb->GetNonFungibleTokenValueInRange(50, 1, 500));
+    BOOST_CHECK_EQUAL(1000, UITDb->GetHighestRangeEnd(50));
+    UITDb.reset();
+    UITDb.reset(new CMPNonFungibleTokensDB(path, false));
+
+    BOOST_CHECK_EQUAL("Bob", UITDb->GetNonFungibleTokenValueInRange(50, 1, 500));
+    BOOST_CHECK_EQUAL("Alice", UITDb->GetNonFungibleTokenValueInRange(50, 501, 1000));
+
+    // rolled back entries are removed in the pending writes as well
+    UITDb->StartBlockBatch();
+    std::pair<int64_t, int64_t> testB = UITDb->CreateNonFungibleTokens(50, 1000, "David", "");
+    BOOST_CHECK_EQUAL(2000, testB.second);
+    UITDb->WriteBlockCache(2);
+    UITDb->RollBackAboveBlock(2);
+    BOOST_CHECK(UITDb->GetNonFungibleTokenValueInRange(50, 1001, 2000).empty());
+    BOOST_CHECK_EQUAL(1000, UITDb->GetHighestRangeEnd(50));
+    BOOST_CHECK(UITDb->CommitBlockBatch());
+    BOOST_CHECK_EQUAL("Alice", UITDb->GetNonFungibleTokenValueInRange(50, 501, 1000));
+    BOOST_CHECK_EQUAL(1000, UITDb->GetHighestRangeEnd(50));
+}
+
+BOOST_AUTO_TEST_CASE(nftdb_test_block_batch_aborted)
+{
+    LOCK(cs_tally);
+    const fs::path path = GetDataDir() / "OMNI_nftdb_batch_aborted";
+    std::unique_ptr<CMPNonFungibleTokensDB> UITDb{new CMPNonFungibleTokensDB(path, true)};
+
+    UITDb->StartBlockBatch();
+    UITDb->CreateNonFungibleTokens(50, 1000, "Alice", "");
+    UITDb->WriteBlockCache(1);
+    BOOST_CHECK(UITDb->CommitBlockBatch());
+
+    // a block, which is never committed, and is followed by the next block
+    UITDb->StartBlockBatch();
+    BOOST_CHECK(UITDb->MoveNonFungibleTokens(50, 1, 500, "Alice", "Bob"));
+    UITDb->StartBlockBatch();
+    BOOST_CHECK_EQUAL("Alice", UITDb->GetNonFungibleTokenValueInRange(50, 1, 1000));
+    BOOST_CHECK(UITDb->MoveNonFungibleTokens(50, 501, 1000, "Alice", "Charles"));
+    BOOST_CHECK(UITDb->CommitBlockBatch());
+
+    // an explicitly aborted block, followed by the next block
+    UITDb->StartBlockBatch();
+    std::pair<int64_t, int64_t> testA = UITDb->CreateNonFungibleTokens(50, 1000, "David", "");
+    BOOST_CHECK_EQUAL(2000, testA.second);
+    UITDb->AbortBlockBatch();
+    BOOST_CHECK_EQUAL(1000, UITDb->GetHighestRangeEnd(50));
+    UITDb->StartBlockBatch();
+    BOOST_CHECK(UITDb->MoveNonFungibleTokens(50, 1, 100, "Alice", "Eve"));
+    BOOST_CHECK(UITDb->CommitBlockBatch());
+
+    // only the committed blocks were stored
+    UITDb.reset();
+    UITDb.reset(new CMPNonFungibleTokensDB(path, false));
+    BOOST_CHECK_EQUAL("Eve", UITDb->GetNonFungibleTokenValueInRange(50, 1, 100));
+    BOOST_CHECK_EQUAL("Alice", UITDb->GetNonFungibleTokenValueInRange(50, 101, 500));
+    BOOST_CHECK_EQUAL("Charles", UITDb->GetNonFungibleTokenValueInRange(50, 501, 1000));
+    BOOST_CHECK(UITDb->GetNonFungibleTokenValueInRange(50, 1001, 2000).empty());
+    BOOST_CHECK_EQUAL(1000, UITDb->GetHighestRangeEnd(50));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
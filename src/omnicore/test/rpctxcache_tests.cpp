@@ -0,0 +1,154 @@
+#include <omnicore/rpctxcache.h>
+#include <omnicore/rpctxobject.h>
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <key.h>
+#include <miner.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <script/standard.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <memory>
+
+/** Creates blocks on top of the genesis block, below the first treasury block of regtest. */
+struct RPCTxCacheTestingSetup : public RegTestingSetup
+{
+    RPCTxCacheTestingSetup()
+    {
+        ClearRPCTransactionCache();
+    }
+
+    void CreateAndProcessBlock(const CScript& scriptPubKey)
+    {
+        const CChainParams& chainparams = Params();
+        std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(*m_node.mempool, chainparams).CreateNewBlock(scriptPubKey);
+        CBlock& block = pblocktemplate->block;
+
+        block.vtx.resize(1);
+        {
+            LOCK(cs_main);
+            unsigned int extraNonce = 0;
+            IncrementExtraNonce(&block, ::ChainActive().Tip(), extraNonce);
+            RegenerateCommitments(block, ::ChainActive().Tip(), chainparams.GetConsensus());
+        }
+
+        while (!CheckProofOfWork(block.GetPoWHash(), block.nBits, CBlockHeader::GetAlgoType(block.nVersion), chainparams.GetConsensus())) ++block.nNonce;
+
+        std::shared_ptr<const CBlock> shared_pblock = std::make_shared<const CBlock>(block);
+        BOOST_REQUIRE(ProcessNewBlock(chainparams, shared_pblock, true, nullptr));
+    }
+};
+
+static CachedRPCTransactionRef NewEntry(int blockHeight)
+{
+    std::shared_ptr<CachedRPCTransaction> entry = std::make_shared<CachedRPCTransaction>();
+    entry->blockHeight = blockHeight;
+    return entry;
+}
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_rpctxcache_tests, RPCTxCacheTestingSetup)
+
+BOOST_AUTO_TEST_CASE(rpctxcache_hits)
+{
+    CRPCTransactionCache cache(3);
+    const uint256 txidA = InsecureRand256();
+    const uint256 txidB = InsecureRand256();
+    const uint256 txidC = InsecureRand256();
+    const uint256 txidD = InsecureRand256();
+    BOOST_CHECK(cache.Get(txidA) == nullptr);
+
+    const CachedRPCTransactionRef entryA = NewEntry(1);
+    const uint64_t nGeneration = cache.GetGeneration();
+    cache.Put(txidA, entryA, nGeneration);
+    cache.Put(txidB, NewEntry(2), nGeneration);
+    cache.Put(txidC, NewEntry(3), nGeneration);
+    BOOST_CHECK(cache.Get(txidA) == entryA);
+    BOOST_CHECK_EQUAL(cache.Get(txidC)->blockHeight, 3);
+
+    // an entry, which is already cached, isn't replaced
+    cache.Put(txidA, NewEntry(4), nGeneration);
+    BOOST_CHECK(cache.Get(txidA) == entryA);
+
+    // the least recently used entry is evicted first
+    cache.Put(txidD, NewEntry(5), nGeneration);
+    BOOST_CHECK_EQUAL(cache.Size(), 3U);
+    BOOST_CHECK(cache.Get(txidB) == nullptr);
+    BOOST_CHECK(cache.Get(txidA) == entryA);
+    BOOST_CHECK(cache.Get(txidC) != nullptr);
+    BOOST_CHECK(cache.Get(txidD) != nullptr);
+
+    // without space, nothing is cached
+    CRPCTransactionCache disabled(0);
+    disabled.Put(txidA, entryA, disabled.GetGeneration());
+    BOOST_CHECK(disabled.Get(txidA) == nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(rpctxcache_generation)
+{
+    CRPCTransactionCache cache(10);
+    const uint256 txidA = InsecureRand256();
+    const uint256 txidB = InsecureRand256();
+    const uint64_t nGeneration = cache.GetGeneration();
+    cache.Put(txidA, NewEntry(1), nGeneration);
+
+    cache.Clear();
+    BOOST_CHECK_EQUAL(cache.Size(), 0U);
+    BOOST_CHECK(cache.Get(txidA) == nullptr);
+    BOOST_CHECK(cache.GetGeneration() != nGeneration);
+
+    // a transaction, which was decoded before the clearing, isn't added
+    cache.Put(txidB, NewEntry(2), nGeneration);
+    BOOST_CHECK(cache.Get(txidB) == nullptr);
+    cache.Put(txidB, NewEntry(2), cache.GetGeneration());
+    BOOST_CHECK(cache.Get(txidB) != nullptr);
+}
+
+BOOST_AUTO_TEST_CASE(rpctxcache_block_disconnected)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript scriptPubKey = GetScriptForDestination(PKHash(key.GetPubKey()));
+    for (int i = 0; i < 3; i++) {
+        CreateAndProcessBlock(scriptPubKey);
+    }
+
+    CRPCTransactionCache& cache = GetRPCTransactionCache();
+    const uint256 txid = InsecureRand256();
+    const uint64_t nGeneration = cache.GetGeneration();
+    cache.Put(txid, NewEntry(3), nGeneration);
+    BOOST_REQUIRE(cache.Get(txid) != nullptr);
+
+    // connecting blocks leaves the cache as it is
+    CreateAndProcessBlock(scriptPubKey);
+    BOOST_CHECK(cache.Get(txid) != nullptr);
+    BOOST_CHECK_EQUAL(cache.GetGeneration(), nGeneration);
+
+    // disconnecting a block clears it
+    CBlockIndex* tip = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+    BlockValidationState state;
+    BOOST_REQUIRE(InvalidateBlock(state, Params(), tip));
+    BOOST_CHECK(cache.Get(txid) == nullptr);
+    BOOST_CHECK(cache.GetGeneration() != nGeneration);
+
+    // and transactions decoded before aren't added afterwards
+    cache.Put(txid, NewEntry(3), nGeneration);
+    BOOST_CHECK(cache.Get(txid) == nullptr);
+
+    {
+        LOCK(cs_main);
+        ResetBlockFailureFlags(tip);
+    }
+    BOOST_REQUIRE(ActivateBestChain(state, Params()));
+    BOOST_CHECK_EQUAL(WITH_LOCK(cs_main, return ::ChainActive().Tip()), tip);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,187 @@
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <omnicore/createpayload.h>
+#include <omnicore/errors.h>
+#include <omnicore/wallettxbuilder.h>
+
+#include <interfaces/chain.h>
+#include <interfaces/wallet.h>
+#include <key_io.h>
+#include <primitives/transaction.h>
+#include <script/standard.h>
+#include <txmempool.h>
+#include <util/system.h>
+#include <validation.h>
+#include <wallet/coincontrol.h>
+#include <wallet/wallet.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+typedef std::vector<std::pair<std::vector<std::string>, std::vector<unsigned char> > > PayoutTransactions;
+
+class SendPayoutsTestingSetup : public TestChain100Setup
+{
+public:
+    SendPayoutsTestingSetup()
+    {
+        CreateAndProcessBlock({}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()));
+        wallet = std::make_shared<CWallet>(m_chain.get(), WalletLocation(), WalletDatabase::CreateMock());
+        {
+            LOCK(wallet->cs_wallet);
+            wallet->SetLastBlockProcessed(::ChainActive().Height(), ::ChainActive().Tip()->GetBlockHash());
+        }
+        bool firstRun;
+        wallet->LoadWallet(firstRun);
+        auto spk_man = wallet->GetOrCreateLegacyScriptPubKeyMan();
+        {
+            LOCK2(wallet->cs_wallet, spk_man->cs_KeyStore);
+            spk_man->AddKeyPubKey(coinbaseKey, coinbaseKey.GetPubKey());
+        }
+        WalletRescanReserver reserver(wallet.get());
+        reserver.reserve();
+        wallet->ScanForWalletTransactions(::ChainActive().Genesis()->GetBlockHash(), {}, reserver, false);
+        interface_wallet = interfaces::MakeWallet(wallet);
+        wallet->m_fallback_fee = CFeeRate(1000);
+    }
+
+    ~SendPayoutsTestingSetup()
+    {
+        gArgs.ForceSetArg("-limitancestorcount", std::to_string(DEFAULT_ANCESTOR_LIMIT));
+        gArgs.ForceSetArg("-limitdescendantcount", std::to_string(DEFAULT_DESCENDANT_LIMIT));
+        wallet.reset();
+    }
+
+    std::string GetNewAddress()
+    {
+        LOCK(wallet->cs_wallet);
+        CTxDestination dest;
+        std::string error;
+        wallet->GetNewDestination(OutputType::LEGACY, "", dest, error);
+        return EncodeDestination(dest);
+    }
+
+    /** Sends the given coins to a new address of the wallet and confirms them. */
+    std::string FundNewAddress(const std::vector<CAmount>& amounts)
+    {
+        const std::string address = GetNewAddress();
+        std::vector<CRecipient> recipients;
+        for (CAmount amount : amounts) {
+            recipients.push_back({GetScriptForDestination(DecodeDestination(address)), amount, false});
+        }
+
+        CTransactionRef tx;
+        CAmount fee;
+        int changePos = -1;
+        std::string error;
+        CCoinControl dummy;
+        {
+            auto locked_chain = m_chain->lock();
+            BOOST_REQUIRE(wallet->CreateTransaction(*locked_chain, recipients, tx, fee, changePos, error, dummy));
+        }
+        wallet->CommitTransaction(tx, {}, {});
+        CreateAndProcessBlock({CMutableTransaction(*tx)}, GetScriptForRawPubKey(coinbaseKey.GetPubKey()));
+        {
+            LOCK(wallet->cs_wallet);
+            CWalletTx::Confirmation confirm(CWalletTx::Status::CONFIRMED, ::ChainActive().Height(), ::ChainActive().Tip()->GetBlockHash(), 1);
+            wallet->mapWallet.at(tx->GetHash()).m_confirm = confirm;
+            wallet->SetLastBlockProcessed(::ChainActive().Height(), ::ChainActive().Tip()->GetBlockHash());
+        }
+        return address;
+    }
+
+    /** Plans the given number of simple sends to a new address of the wallet. */
+    PayoutTransactions CreatePayouts(size_t count)
+    {
+        PayoutTransactions transactions;
+        const std::string receiver = GetNewAddress();
+        for (size_t i = 0; i < count; ++i) {
+            transactions.push_back(std::make_pair(std::vector<std::string>{receiver}, CreatePayload_SimpleSend(1, i + 1)));
+        }
+        return transactions;
+    }
+
+    std::unique_ptr<interfaces::Chain> m_chain = interfaces::MakeChain(m_node);
+    std::shared_ptr<CWallet> wallet;
+    std::unique_ptr<interfaces::Wallet> interface_wallet;
+};
+
+static CTransactionRef GetMempoolTransaction(const uint256& txid)
+{
+    CTransactionRef tx = ::mempool.get(txid);
+    BOOST_REQUIRE(tx);
+    return tx;
+}
+
+static bool SpendsOutputOf(const CTransactionRef& tx, const uint256& txidPrev)
+{
+    for (const CTxIn& txIn : tx->vin) {
+        if (txIn.prevout.hash == txidPrev) return true;
+    }
+    return false;
+}
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_sendpayouts_tests, SendPayoutsTestingSetup)
+
+BOOST_AUTO_TEST_CASE(batch_chains_change)
+{
+    const std::string sender = FundNewAddress({1 * COIN});
+
+    std::vector<uint256> txids;
+    std::vector<std::string> rawTxs;
+    BOOST_CHECK_EQUAL(WalletTxBuilderBatch(sender, CreatePayouts(5), txids, rawTxs, true, interface_wallet.get()), 0);
+    BOOST_REQUIRE_EQUAL(txids.size(), 5U);
+
+    // all transactions are broadcasted, and each spends the change of the one before
+    for (size_t i = 1; i < txids.size(); ++i) {
+        BOOST_CHECK(SpendsOutputOf(GetMempoolTransaction(txids[i]), txids[i - 1]));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(batch_chains_capped)
+{
+    gArgs.ForceSetArg("-limitancestorcount", "3");
+    gArgs.ForceSetArg("-limitdescendantcount", "3");
+    const std::string sender = FundNewAddress({1 * COIN, 1 * COIN});
+
+    std::vector<uint256> txids;
+    std::vector<std::string> rawTxs;
+    BOOST_CHECK_EQUAL(WalletTxBuilderBatch(sender, CreatePayouts(5), txids, rawTxs, true, interface_wallet.get()), 0);
+    BOOST_REQUIRE_EQUAL(txids.size(), 5U);
+
+    // the first chain ends after three transactions, the second is funded by the other coin
+    BOOST_CHECK(SpendsOutputOf(GetMempoolTransaction(txids[1]), txids[0]));
+    BOOST_CHECK(SpendsOutputOf(GetMempoolTransaction(txids[2]), txids[1]));
+    BOOST_CHECK(!SpendsOutputOf(GetMempoolTransaction(txids[3]), txids[2]));
+    BOOST_CHECK(SpendsOutputOf(GetMempoolTransaction(txids[4]), txids[3]));
+}
+
+BOOST_AUTO_TEST_CASE(batch_rolled_back)
+{
+    gArgs.ForceSetArg("-limitancestorcount", "3");
+    gArgs.ForceSetArg("-limitdescendantcount", "3");
+    const std::string sender = FundNewAddress({1 * COIN});
+    const size_t nMempoolSize = ::mempool.size();
+
+    // a single coin can't fund more than one chain, so nothing is sent
+    std::vector<uint256> txids;
+    std::vector<std::string> rawTxs;
+    BOOST_CHECK(WalletTxBuilderBatch(sender, CreatePayouts(5), txids, rawTxs, true, interface_wallet.get()) != 0);
+    BOOST_CHECK(txids.empty());
+    BOOST_CHECK_EQUAL(::mempool.size(), nMempoolSize);
+
+    // and the coin is released again
+    std::vector<COutPoint> vLocked;
+    {
+        LOCK(wallet->cs_wallet);
+        wallet->ListLockedCoins(vLocked);
+    }
+    BOOST_CHECK(vLocked.empty());
+    BOOST_CHECK_EQUAL(WalletTxBuilderBatch(sender, CreatePayouts(3), txids, rawTxs, true, interface_wallet.get()), 0);
+    BOOST_CHECK_EQUAL(txids.size(), 3U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
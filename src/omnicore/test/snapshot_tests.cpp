@@ -0,0 +1,115 @@
+#include <omnicore/consensushash.h>
+#include <omnicore/omnicore.h>
+#include <omnicore/tally.h>
+
+#include <chainparamsbase.h>
+#include <rpc/server.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <univalue.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <string>
+
+using namespace mastercore;
+
+/** Snapshots of the testnet genesis block: Omni state is only restored from blocks since the Omni genesis block, which is never reached on regtest. */
+struct SnapshotTestingSetup : public TestingSetup
+{
+    SnapshotTestingSetup() : TestingSetup(CBaseChainParams::TESTNET)
+    {
+        StartRPC();
+        if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+    }
+
+    ~SnapshotTestingSetup()
+    {
+        InterruptRPC();
+        StopRPC();
+    }
+
+    UniValue CallRPC(const std::string& strMethod, const UniValue& params)
+    {
+        JSONRPCRequest request;
+        request.strMethod = strMethod;
+        request.params = params;
+        try {
+            return tableRPC.execute(request);
+        } catch (const UniValue& objError) {
+            throw std::runtime_error(find_value(objError, "message").get_str());
+        }
+    }
+};
+
+static const std::string ADDRESS = "yvLKPTvEUWCJTRrCfw5GCXnusEmZGTfqzL";
+
+static int64_t GetBalance(uint32_t propertyId)
+{
+    return GetTokenBalance(ADDRESS, propertyId, BALANCE);
+}
+
+static void SetBalance(uint32_t propertyId, int64_t amount)
+{
+    LOCK(cs_tally);
+    update_tally_map(ADDRESS, propertyId, amount - GetBalance(propertyId), BALANCE);
+}
+
+static uint256 GetCurrentConsensusHash()
+{
+    LOCK(cs_tally);
+    return GetConsensusHash();
+}
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_snapshot_tests, SnapshotTestingSetup)
+
+BOOST_AUTO_TEST_CASE(snapshot_round_trip)
+{
+    SetBalance(3, 1000);
+    const uint256 consensusHash = GetCurrentConsensusHash();
+
+    UniValue dumpParams(UniValue::VARR);
+    dumpParams.push_back("omni_snapshot.dat");
+    dumpParams.push_back(UniValue(true));
+    UniValue dumped = CallRPC("dumptxoutset", dumpParams);
+    BOOST_CHECK_EQUAL(find_value(dumped, "omni_consensus_hash").get_str(), consensusHash.GetHex());
+
+    // dumping doesn't change the state
+    BOOST_CHECK(GetCurrentConsensusHash() == consensusHash);
+
+    SetBalance(3, 250);
+    BOOST_CHECK(GetCurrentConsensusHash() != consensusHash);
+
+    UniValue loadParams(UniValue::VARR);
+    loadParams.push_back("omni_snapshot.dat");
+    loadParams.push_back(consensusHash.GetHex());
+    UniValue loaded = CallRPC("loadomnistatesnapshot", loadParams);
+    BOOST_CHECK_EQUAL(find_value(loaded, "omni_consensus_hash").get_str(), consensusHash.GetHex());
+    BOOST_CHECK_EQUAL(GetBalance(3), 1000);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_mismatch_rejected)
+{
+    SetBalance(3, 1000);
+
+    UniValue dumpParams(UniValue::VARR);
+    dumpParams.push_back("omni_snapshot.dat");
+    dumpParams.push_back(UniValue(true));
+    CallRPC("dumptxoutset", dumpParams);
+
+    SetBalance(3, 250);
+    const uint256 consensusHash = GetCurrentConsensusHash();
+
+    // the snapshot doesn't have the expected state, so the current one is kept
+    UniValue loadParams(UniValue::VARR);
+    loadParams.push_back("omni_snapshot.dat");
+    loadParams.push_back(consensusHash.GetHex());
+    BOOST_CHECK_THROW(CallRPC("loadomnistatesnapshot", loadParams), std::runtime_error);
+    BOOST_CHECK(GetCurrentConsensusHash() == consensusHash);
+    BOOST_CHECK_EQUAL(GetBalance(3), 250);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
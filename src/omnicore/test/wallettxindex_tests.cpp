@@ -0,0 +1,124 @@
+#include <omnicore/dbtxlist.h>
+#include <omnicore/omnicore.h>
+#include <omnicore/wallettxindex.h>
+
+#include <interfaces/chain.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <sync.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+#include <wallet/wallet.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <stdint.h>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace mastercore;
+
+class WalletTxIndexTestingSetup : public TestingSetup
+{
+public:
+    WalletTxIndexTestingSetup()
+    {
+        wallet = std::make_shared<CWallet>(m_chain.get(), WalletLocation(), WalletDatabase::CreateMock());
+        bool firstRun;
+        wallet->LoadWallet(firstRun);
+    }
+
+    ~WalletTxIndexTestingSetup()
+    {
+        walletTxIndex.Clear();
+        wallet.reset();
+    }
+
+    /** Adds a new transaction to the wallet, confirmed at the given position, if the block isn't negative. */
+    uint256 AddWalletTx(int nBlock, int nIndex)
+    {
+        CMutableTransaction mtx;
+        mtx.vin.emplace_back(COutPoint(InsecureRand256(), 0));
+        CWalletTx wtx(wallet.get(), MakeTransactionRef(mtx));
+        if (nBlock >= 0) {
+            wtx.m_confirm = CWalletTx::Confirmation(CWalletTx::Status::CONFIRMED, nBlock, InsecureRand256(), nIndex);
+        }
+        BOOST_REQUIRE(wallet->AddToWallet(wtx));
+        return wtx.GetHash();
+    }
+
+    /** Records a transaction in the Omni transaction list. */
+    void RecordOmniTx(const uint256& txid, bool fValid, int nBlock, int nIndex)
+    {
+        LOCK(cs_tally);
+        pDbTransactionList->recordTX(txid, fValid, nBlock, 0, 0);
+        walletTxIndex.RecordTransaction(txid, nBlock, nIndex);
+    }
+
+    std::vector<uint256> FetchLatest(unsigned int count, int startBlock = 0, int endBlock = std::numeric_limits<int>::max())
+    {
+        std::vector<uint256> vTxids;
+        for (const auto& entry : walletTxIndex.FetchLatest(wallet, count, startBlock, endBlock)) {
+            vTxids.push_back(entry.second);
+        }
+        return vTxids;
+    }
+
+    std::unique_ptr<interfaces::Chain> m_chain = interfaces::MakeChain(m_node);
+    std::shared_ptr<CWallet> wallet;
+};
+
+BOOST_FIXTURE_TEST_SUITE(omnicore_wallettxindex_tests, WalletTxIndexTestingSetup)
+
+BOOST_AUTO_TEST_CASE(wallettxindex_ordered)
+{
+    BOOST_REQUIRE(pDbTransactionList != nullptr);
+
+    // Omni transactions are listed, valid or not, while other transactions are not
+    const uint256 txidA = AddWalletTx(10, 2);
+    const uint256 txidB = AddWalletTx(12, 1);
+    const uint256 txidC = AddWalletTx(10, 5);
+    AddWalletTx(11, 1);
+    RecordOmniTx(txidA, true, 10, 2);
+    RecordOmniTx(txidB, false, 12, 1);
+    RecordOmniTx(txidC, true, 10, 5);
+
+    BOOST_CHECK(FetchLatest(10) == std::vector<uint256>({txidB, txidC, txidA}));
+    BOOST_CHECK(FetchLatest(2) == std::vector<uint256>({txidB, txidC}));
+    BOOST_CHECK(FetchLatest(10, 0, 11) == std::vector<uint256>({txidC, txidA}));
+    BOOST_CHECK(FetchLatest(10, 11) == std::vector<uint256>({txidB}));
+}
+
+BOOST_AUTO_TEST_CASE(wallettxindex_updated)
+{
+    BOOST_REQUIRE(pDbTransactionList != nullptr);
+
+    const uint256 txidA = AddWalletTx(10, 1);
+    RecordOmniTx(txidA, true, 10, 1);
+    BOOST_CHECK(FetchLatest(10) == std::vector<uint256>({txidA}));
+
+    // a transaction of the wallet, which is processed after the index was built
+    const uint256 txidB = AddWalletTx(-1, 0);
+    BOOST_CHECK(FetchLatest(10) == std::vector<uint256>({txidA}));
+    RecordOmniTx(txidB, false, 11, 3);
+    BOOST_CHECK(FetchLatest(10) == std::vector<uint256>({txidB, txidA}));
+
+    // rolled back transactions are resolved again, at their new position
+    walletTxIndex.RollBackAboveBlock(11);
+    RecordOmniTx(txidB, true, 12, 4);
+    const auto vEntries = walletTxIndex.FetchLatest(wallet, 10, 0, std::numeric_limits<int>::max());
+    BOOST_REQUIRE_EQUAL(vEntries.size(), 2U);
+    BOOST_CHECK(vEntries[0] == std::make_pair(OmniTxPosition(12, 4), txidB));
+
+    // removed wallet transactions are no longer listed
+    std::vector<uint256> vHashIn{txidB}, vHashOut;
+    {
+        LOCK(wallet->cs_wallet);
+        BOOST_CHECK(wallet->ZapSelectTx(vHashIn, vHashOut) == DBErrors::LOAD_OK);
+    }
+    BOOST_CHECK(FetchLatest(10) == std::vector<uint256>({txidA}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
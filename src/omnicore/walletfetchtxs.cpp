@@ -3,23 +3,23 @@
  *
  * The fetch functions provide a sorted list of transaction hashes ordered by block,
  * position in block and position in wallet including STO receipts.
+ *
+ * @see wallettxindex.cpp
  */
 
 #include <omnicore/walletfetchtxs.h>
 
 #include <omnicore/dbstolist.h>
-#include <omnicore/dbtxlist.h>
+#include <omnicore/dbtransaction.h>
 #include <omnicore/log.h>
 #include <omnicore/omnicore.h>
 #include <omnicore/pending.h>
 #include <omnicore/utilsxep.h>
+#include <omnicore/wallettxindex.h>
 
-#include <init.h>
 #include <interfaces/wallet.h>
-#include <validation.h>
 #include <sync.h>
 #include <tinyformat.h>
-#include <index/txindex.h>
 #ifdef ENABLE_WALLET
 #include <wallet/wallet.h>
 #endif
@@ -29,6 +29,7 @@
 #include <stdint.h>
 #include <list>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <utility>
@@ -36,57 +37,34 @@
 
 namespace mastercore
 {
+#ifdef ENABLE_WALLET
 /**
- * Gets the byte offset of a transaction from the transaction index.
+ * Returns the sort key of a transaction, given its block height and position in block.
  */
-static unsigned int GetTransactionByteOffset(const uint256& txid)
+static std::string GetSortKey(int blockHeight, uint32_t blockPosition)
 {
-    LOCK(cs_main);
-
-    if (g_txindex) {
-        return g_txindex->ReadTxPos(txid);
-    }
-
-    return 0;
+    return strprintf("%06d%010d", blockHeight, blockPosition);
 }
+#endif
 
 /**
  * Returns an ordered list of Omni transactions including STO receipts that are relevant to the wallet.
  *
  * Ignores order in the wallet (which can be skewed by watch addresses) and utilizes block height and position within block.
+ * The wallet transactions are obtained from the wallet transaction index, so only the returned entries are visited.
  */
 std::map<std::string, uint256> FetchWalletOmniTransactions(interfaces::Wallet& iWallet, unsigned int count, int startBlock, int endBlock)
 {
     std::map<std::string, uint256> mapResponse;
 #ifdef ENABLE_WALLET
-    if (!HasWallets()) {
+    std::shared_ptr<CWallet> wallet = GetWallet(iWallet.getWalletName());
+    if (!wallet) {
         return mapResponse;
     }
     std::set<uint256> seenHashes;
-    std::multimap<int64_t, const interfaces::WalletTx*> txOrdered;
-    const std::vector<interfaces::WalletTx>& transactions = iWallet.getWalletTxs();
-    for (const auto& transaction : transactions)
-        txOrdered.insert(std::make_pair(transaction.order_pos, &transaction));
-
-    // Iterate backwards through wallet transactions until we have count items to return:
-    for (std::multimap<int64_t, const interfaces::WalletTx*>::reverse_iterator it = txOrdered.rbegin(); it != txOrdered.rend(); ++it) {
-        const interfaces::WalletTx* pwtx = it->second;
-        const uint256& txHash = pwtx->tx->GetHash();
-        {
-            LOCK(cs_tally);
-            if (!pDbTransactionList->exists(txHash)) continue;
-        }
-        const uint256& blockHash = pwtx->hash_block;
-        if (blockHash.IsNull()) continue;
-        const CBlockIndex* pBlockIndex = GetBlockIndex(blockHash);
-        if (pBlockIndex == nullptr) continue;
-        int blockHeight = pBlockIndex->nHeight;
-        if (blockHeight < startBlock || blockHeight > endBlock) continue;
-        int blockPosition = GetTransactionByteOffset(txHash);
-        std::string sortKey = strprintf("%06d%010d", blockHeight, blockPosition);
-        mapResponse.insert(std::make_pair(sortKey, txHash));
-        seenHashes.insert(txHash);
-        if (mapResponse.size() >= count) break;
+    for (const auto& entry : walletTxIndex.FetchLatest(wallet, count, startBlock, endBlock)) {
+        mapResponse.insert(std::make_pair(GetSortKey(entry.first.first, entry.first.second), entry.second));
+        seenHashes.insert(entry.second);
     }
 
     // Insert STO receipts - receiving an STO has no inbound transaction to the wallet, so we will insert these manually into the response
@@ -110,26 +88,24 @@ std::map<std::string, uint256> FetchWalletOmniTransactions(interfaces::Wallet& i
         if (blockHeight < startBlock || blockHeight > endBlock) continue;
         uint256 txHash = uint256S(svstr[0]);
         if (seenHashes.find(txHash) != seenHashes.end()) continue; // an STO may already be in the wallet if we sent it
-        int blockPosition = GetTransactionByteOffset(txHash);
-        std::string sortKey = strprintf("%06d%010d", blockHeight, blockPosition);
-        mapResponse.insert(std::make_pair(sortKey, txHash));
+        uint32_t blockPosition = WITH_LOCK(cs_tally, return pDbTransaction->FetchTransactionPosition(txHash));
+        mapResponse.insert(std::make_pair(GetSortKey(blockHeight, blockPosition), txHash));
     }
 
     // Insert pending transactions (sets block as 999999 and position as wallet position)
     // TODO: resolve potential deadlock caused by cs_wallet, cs_pending
     // LOCK(cs_pending);
+    LOCK(wallet->cs_wallet);
     for (PendingMap::const_iterator it = my_pending.begin(); it != my_pending.end(); ++it) {
         const uint256& txHash = it->first;
         int blockHeight = 999999;
         if (blockHeight < startBlock || blockHeight > endBlock) continue;
-        int blockPosition = 0;
-        {
-            for (const auto& transaction : transactions)
-                if (transaction.tx->GetHash() == txHash)
-                    blockPosition = transaction.order_pos;
+        uint32_t blockPosition = 0;
+        std::map<uint256, CWalletTx>::const_iterator wit = wallet->mapWallet.find(txHash);
+        if (wit != wallet->mapWallet.end()) {
+            blockPosition = static_cast<uint32_t>(wit->second.nOrderPos);
         }
-        std::string sortKey = strprintf("%06d%010d", blockHeight, blockPosition);
-        mapResponse.insert(std::make_pair(sortKey, txHash));
+        mapResponse.insert(std::make_pair(GetSortKey(blockHeight, blockPosition), txHash));
     }
 #endif
     return mapResponse;
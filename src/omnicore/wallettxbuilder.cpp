@@ -19,19 +19,25 @@
 #include <net.h>
 #include <node/context.h>
 #include <node/transaction.h>
+#include <policy/policy.h>
+#include <policy/settings.h>
 #include <primitives/transaction.h>
+#include <psbt.h>
 #include <script/script.h>
 #include <script/sign.h>
 #include <script/standard.h>
 #include <sync.h>
 #include <txmempool.h>
 #include <uint256.h>
+#include <util/error.h>
+#include <util/system.h>
 #ifdef ENABLE_WALLET
 #include <wallet/coincontrol.h>
 #include <wallet/wallet.h>
 #endif
 
 #include <stdint.h>
+#include <algorithm>
 #include <string>
 #include <utility>
 #include <vector>
@@ -39,36 +45,28 @@
 using mastercore::AddressToPubKey;
 using mastercore::UseEncodingClassC;
 
-/** Creates and sends a transaction with multiple receivers. */
-int WalletTxBuilder(
+#ifdef ENABLE_WALLET
+static void UnlockCoins(interfaces::Wallet* iWallet, const std::vector<COutPoint>& vToUnlock);
+#endif
+
+#ifdef ENABLE_WALLET
+/** Encodes the payload and adds the reference outputs of a transaction. */
+static int PrepareOutputs(
         const std::string& senderAddress,
         const std::vector<std::string>& receiverAddresses,
         const std::string& redemptionAddress,
         int64_t referenceAmount,
         const std::vector<unsigned char>& payload,
-        uint256& retTxid,
-        std::string& retRawTx,
-        bool commit,
         interfaces::Wallet* iWallet,
-        CAmount minFee)
+        std::vector<CRecipient>& vecRecipients,
+        CAmount& outputAmount)
 {
-#ifdef ENABLE_WALLET
-    if (!iWallet) return MP_ERR_WALLET_ACCESS;
-
     // Determine the class to send the transaction via - default is Class C
     int omniTxClass = OMNI_CLASS_C;
     if (!UseEncodingClassC(payload.size() + 1 /* OP_RETURN */ + 2 /* pushdata opcodes */)) omniTxClass = OMNI_CLASS_B;
 
-    // Prepare the transaction - first setup some vars
-    CCoinControl coinControl;
     std::vector<std::pair<CScript, int64_t> > vecSend;
 
-    // Next, we set the change address to the sender
-    coinControl.destChange = DecodeDestination(senderAddress);
-
-    // Amount required for outputs
-    CAmount outputAmount{0};
-
     // Encode the data outputs
     switch(omniTxClass) {
         case OMNI_CLASS_B: { // declaring vars in a switch here so use an explicit code block
@@ -96,13 +94,48 @@ int WalletTxBuilder(
     }
 
     // Create CRecipients for outputs
-    std::vector<CRecipient> vecRecipients;
     for (size_t i = 0; i < vecSend.size(); ++i) {
         const std::pair<CScript, int64_t>& vec = vecSend[i];
         CRecipient recipient = {vec.first, vec.second, false};
         vecRecipients.push_back(recipient);
     }
 
+    return 0;
+}
+#endif
+
+/** Creates and sends a transaction with multiple receivers. */
+int WalletTxBuilder(
+        const std::string& senderAddress,
+        const std::vector<std::string>& receiverAddresses,
+        const std::string& redemptionAddress,
+        int64_t referenceAmount,
+        const std::vector<unsigned char>& payload,
+        uint256& retTxid,
+        std::string& retRawTx,
+        bool commit,
+        interfaces::Wallet* iWallet,
+        CAmount minFee)
+{
+#ifdef ENABLE_WALLET
+    if (!iWallet) return MP_ERR_WALLET_ACCESS;
+
+    // Prepare the transaction - first setup some vars
+    CCoinControl coinControl;
+
+    // Next, we set the change address to the sender
+    coinControl.destChange = DecodeDestination(senderAddress);
+
+    // Amount required for outputs
+    CAmount outputAmount{0};
+
+    // Encode the data and reference outputs
+    std::vector<CRecipient> vecRecipients;
+    int prepareResult = PrepareOutputs(senderAddress, receiverAddresses, redemptionAddress, referenceAmount, payload, iWallet, vecRecipients, outputAmount);
+    if (prepareResult != 0) {
+        return prepareResult;
+    }
+
     CAmount nFeeRequired{std::max(minFee, iWallet->getMinimumFee(100000, coinControl, nullptr, nullptr))};
     CTransactionRef wtxNew;
     std::string strFailReason;
@@ -194,6 +227,303 @@ int WalletTxBuilder(
             minFee);
 }
 
+#ifdef ENABLE_WALLET
+/**
+ * Creates and signs a transaction, which spends the change of the previous
+ * transaction of a batch. Further coins are taken from the pool, if the change
+ * does not cover outputs and fee.
+ */
+static int CreateChainedTransaction(
+        const CTransactionRef& prevTx,
+        int nPrevChangePos,
+        const std::vector<CRecipient>& vecRecipients,
+        const CScript& scriptChange,
+        const std::vector<std::pair<CAmount, COutPoint> >& vCoinPool,
+        size_t& nNextCoin,
+        interfaces::Wallet* iWallet,
+        CAmount minFee,
+        CTransactionRef& retTx,
+        int& retChangePos)
+{
+    CMutableTransaction mtx;
+    mtx.vin.push_back(CTxIn(COutPoint(prevTx->GetHash(), nPrevChangePos)));
+    CAmount selected{prevTx->vout[nPrevChangePos].nValue};
+
+    CAmount outputAmount{0};
+    for (const CRecipient& recipient : vecRecipients) {
+        mtx.vout.push_back(CTxOut(recipient.nAmount, recipient.scriptPubKey));
+        outputAmount += recipient.nAmount;
+    }
+    const CTxOut changeOut(0, scriptChange);
+    const CAmount nDustThreshold{OmniGetDustThreshold(scriptChange)};
+
+    CCoinControl coinControl;
+    CAmount nFeeRequired{minFee};
+
+    while (true) {
+        while (selected < outputAmount + nFeeRequired && nNextCoin < vCoinPool.size()) {
+            mtx.vin.push_back(CTxIn(vCoinPool[nNextCoin].second));
+            selected += vCoinPool[nNextCoin].first;
+            ++nNextCoin;
+        }
+        if (selected < outputAmount + nFeeRequired) {
+            return MP_INPUTS_INVALID;
+        }
+
+        // Change too small to be relayed is left to the fee
+        mtx.vout.resize(vecRecipients.size());
+        retChangePos = -1;
+        if (selected - outputAmount - nFeeRequired >= nDustThreshold) {
+            retChangePos = mtx.vout.size();
+            mtx.vout.push_back(changeOut);
+            mtx.vout.back().nValue = selected - outputAmount - nFeeRequired;
+        }
+
+        // The previous transaction is not yet known to the wallet, so it's provided for signing
+        PartiallySignedTransaction psbtx(mtx);
+        psbtx.inputs[0].non_witness_utxo = prevTx;
+        bool complete{false};
+        if (iWallet->fillPSBT(SIGHASH_ALL, true /* sign */, false /* bip32derivs */, psbtx, complete) != TransactionError::OK || !complete) {
+            PrintToLog("%s: ERROR: failed to sign transaction spending %s:%d\n", __func__, prevTx->GetHash().GetHex(), nPrevChangePos);
+            return MP_ERR_CREATE_TX;
+        }
+        CMutableTransaction mtxSigned;
+        if (!FinalizeAndExtractPSBT(psbtx, mtxSigned)) {
+            return MP_ERR_CREATE_TX;
+        }
+
+        const CTransaction txSigned(mtxSigned);
+        const unsigned int nBytes = GetVirtualTransactionSize(txSigned);
+        const CAmount nFee{std::max(minFee, iWallet->getMinimumFee(nBytes, coinControl, nullptr, nullptr))};
+        if (nFee <= selected - outputAmount - (retChangePos < 0 ? 0 : mtxSigned.vout[retChangePos].nValue)) {
+            retTx = MakeTransactionRef(std::move(mtxSigned));
+            return 0;
+        }
+
+        nFeeRequired = nFee;
+        PrintToLog("Increasing fee. nFeeRequired: %d selected: %d outputAmount: %d\n", nFeeRequired, selected, outputAmount);
+    }
+}
+
+/**
+ * Adds the in-mempool ancestry of the given inputs to the counts of a chain of
+ * transactions. Shared ancestors are counted more than once, which errs on the
+ * safe side.
+ */
+static void AddMempoolAncestry(const std::vector<CTxIn>& vin, size_t nFirst, size_t& nAncestors, size_t& nDescendants)
+{
+    for (size_t i = nFirst; i < vin.size(); ++i) {
+        size_t nTxAncestors, nTxDescendants;
+        ::mempool.GetTransactionAncestry(vin[i].prevout.hash, nTxAncestors, nTxDescendants);
+        nAncestors += nTxAncestors;
+        nDescendants = std::max(nDescendants, nTxDescendants);
+    }
+}
+
+/**
+ * Checks that the memory pool accepts the transactions of a batch.
+ *
+ * Only the first transaction of each chain can be tested against the memory
+ * pool, because the others spend outputs it does not know yet. Those are checked
+ * for standardness, while their number is already capped during creation.
+ */
+static int CheckBatchAcceptance(const std::vector<CTransactionRef>& vTxs, const std::vector<bool>& vChained)
+{
+    LOCK(cs_main);
+    for (size_t i = 0; i < vTxs.size(); ++i) {
+        std::string strReason;
+        bool fAccepted{false};
+        if (!vChained[i]) {
+            TxValidationState state;
+            fAccepted = AcceptToMemoryPool(::mempool, state, vTxs[i], nullptr /* plTxnReplaced */, false /* bypass_limits */, 0 /* nAbsurdFee */, true /* test_accept */);
+            strReason = state.ToString();
+        } else {
+            fAccepted = IsStandardTx(*vTxs[i], ::fIsBareMultisigStd, ::dustRelayFee, strReason);
+        }
+        if (!fAccepted) {
+            PrintToLog("%s: ERROR: transaction %s would be rejected by the memory pool: %s\n", __func__, vTxs[i]->GetHash().GetHex(), strReason);
+            return MP_ERR_COMMIT_TX;
+        }
+    }
+    return 0;
+}
+#endif
+
+/**
+ * Creates and sends a batch of transactions from the same sender.
+ *
+ * The first transaction is funded by the coins of the sender, and the change
+ * of each transaction is spent by the next one, so that a single coin can fund
+ * the whole batch. If the change does not suffice, further coins of the sender
+ * are added. A chain ends before it exceeds the ancestor or descendant limits of
+ * the memory pool, and the next transaction starts a new chain from other coins.
+ * Only if all transactions could be created, signed and would be accepted by the
+ * memory pool, they are committed in order. Otherwise, no transaction is
+ * committed and the coins are released again.
+ */
+int WalletTxBuilderBatch(
+        const std::string& senderAddress,
+        const std::vector<std::pair<std::vector<std::string>, std::vector<unsigned char> > >& transactions,
+        std::vector<uint256>& retTxids,
+        std::vector<std::string>& retRawTxs,
+        bool commit,
+        interfaces::Wallet* iWallet,
+        CAmount minFee)
+{
+#ifdef ENABLE_WALLET
+    if (!iWallet) return MP_ERR_WALLET_ACCESS;
+
+    // Collect the coins of the sender once, largest first, to fund all transactions
+    CCoinControl senderCoinControl;
+    mastercore::SelectAllCoins(*iWallet, senderAddress, senderCoinControl);
+
+    std::vector<COutPoint> vSenderOutpoints;
+    senderCoinControl.ListSelected(vSenderOutpoints);
+    std::vector<interfaces::WalletTxOut> vSenderCoins = iWallet->getCoins(vSenderOutpoints);
+
+    std::vector<std::pair<CAmount, COutPoint> > vCoinPool;
+    for (size_t i = 0; i < vSenderOutpoints.size() && i < vSenderCoins.size(); ++i) {
+        vCoinPool.push_back(std::make_pair(vSenderCoins[i].txout.nValue, vSenderOutpoints[i]));
+    }
+    std::sort(vCoinPool.rbegin(), vCoinPool.rend());
+    size_t nNextCoin = 0;
+
+    const CTxDestination destChange = DecodeDestination(senderAddress);
+    const CScript scriptChange = GetScriptForDestination(destChange);
+
+    // The fee rate does not change within a batch, so it is only estimated once
+    CCoinControl feeCoinControl;
+    const CAmount nFeeInitial{std::max(minFee, iWallet->getMinimumFee(100000, feeCoinControl, nullptr, nullptr))};
+
+    // Unconfirmed chains must stay within the package limits of the memory pool
+    const size_t nLimitAncestors = gArgs.GetArg("-limitancestorcount", DEFAULT_ANCESTOR_LIMIT);
+    const size_t nLimitDescendants = gArgs.GetArg("-limitdescendantcount", DEFAULT_DESCENDANT_LIMIT);
+    size_t nChainLength = 0;
+    size_t nChainAncestors = 0;
+    size_t nChainDescendants = 0;
+
+    std::vector<CTransactionRef> vCreated;
+    std::vector<bool> vChained;
+    std::vector<COutPoint> vLockedCoins;
+    int nChangePos = -1;
+    int result = 0;
+
+    for (const auto& transaction : transactions) {
+        CAmount outputAmount{0};
+        std::vector<CRecipient> vecRecipients;
+        result = PrepareOutputs(senderAddress, transaction.first, "", 0, transaction.second, iWallet, vecRecipients, outputAmount);
+        if (result != 0) break;
+
+        CTransactionRef wtxNew;
+
+        if (!vCreated.empty() && nChangePos >= 0) {
+            const size_t nNextCoinBefore = nNextCoin;
+            result = CreateChainedTransaction(vCreated.back(), nChangePos, vecRecipients, scriptChange, vCoinPool, nNextCoin, iWallet, minFee, wtxNew, nChangePos);
+            if (result != 0) break;
+
+            // Further coins taken from the pool may bring their own unconfirmed ancestors
+            size_t nAncestors = nChainAncestors;
+            size_t nDescendants = nChainDescendants;
+            AddMempoolAncestry(wtxNew->vin, 1, nAncestors, nDescendants);
+
+            if (nAncestors + nChainLength + 1 <= nLimitAncestors && nDescendants + nChainLength + 1 <= nLimitDescendants) {
+                nChainAncestors = nAncestors;
+                nChainDescendants = nDescendants;
+                ++nChainLength;
+            } else {
+                // Too long, so the transaction starts a new chain instead
+                nNextCoin = nNextCoinBefore;
+                wtxNew.reset();
+            }
+        }
+
+        if (!wtxNew) {
+            CCoinControl coinControl;
+            coinControl.destChange = destChange;
+
+            CAmount nFeeRequired{nFeeInitial};
+            CAmount nFeeRet{0};
+            CAmount selected{0};
+            std::string strFailReason;
+
+            while (true) {
+                // Take further coins from the shared pool until outputs and fee are covered
+                while (selected < outputAmount + nFeeRequired && nNextCoin < vCoinPool.size()) {
+                    coinControl.Select(vCoinPool[nNextCoin].second);
+                    selected += vCoinPool[nNextCoin].first;
+                    ++nNextCoin;
+                }
+
+                if (!coinControl.HasSelected()) {
+                    result = MP_ERR_INPUTSELECT_FAIL;
+                    break;
+                }
+                if (selected < outputAmount) {
+                    result = MP_INPUTS_INVALID;
+                    break;
+                }
+
+                nChangePos = vecRecipients.size();
+                wtxNew = iWallet->createTransaction(vecRecipients, coinControl, true /* sign */, nChangePos, nFeeRet, strFailReason, false, minFee);
+
+                // TX creation was a success, fee no longer incrementing or no coins left to add
+                if (wtxNew || nFeeRet <= nFeeRequired || nNextCoin >= vCoinPool.size()) {
+                    break;
+                }
+
+                nFeeRequired = nFeeRet;
+                PrintToLog("Increasing fee. nFeeRequired: %d selected: %d outputAmount: %d\n", nFeeRequired, selected, outputAmount);
+            }
+            if (result != 0) break;
+
+            if (!wtxNew) {
+                PrintToLog("%s: ERROR: wallet transaction creation failed: %s\n", __func__, strFailReason);
+                result = MP_ERR_CREATE_TX;
+                break;
+            }
+
+            nChainLength = 1;
+            nChainAncestors = 0;
+            nChainDescendants = 0;
+            AddMempoolAncestry(wtxNew->vin, 0, nChainAncestors, nChainDescendants);
+        }
+
+        // Keep the inputs away from other wallet activity, until the batch is committed
+        for (const CTxIn& txIn : wtxNew->vin) {
+            iWallet->lockCoin(txIn.prevout);
+            vLockedCoins.push_back(txIn.prevout);
+        }
+        vCreated.push_back(wtxNew);
+        vChained.push_back(nChainLength > 1);
+    }
+
+    // Make sure the memory pool takes the whole batch, before anything is committed
+    if (result == 0) {
+        result = CheckBatchAcceptance(vCreated, vChained);
+    }
+
+    if (result == 0) {
+        for (const CTransactionRef& wtxNew : vCreated) {
+            if (!commit) {
+                retRawTxs.push_back(EncodeHexTx(*wtxNew));
+            } else {
+                PrintToLog("%s: %s\n", __func__, wtxNew->ToString());
+                iWallet->commitTransaction(wtxNew, {}, {});
+                retTxids.push_back(wtxNew->GetHash());
+            }
+        }
+    } else {
+        PrintToLog("%s: ERROR: batch creation failed after %d of %d transactions, nothing was committed\n", __func__, vCreated.size(), transactions.size());
+    }
+
+    // Committed inputs are spent now, all others are released
+    UnlockCoins(iWallet, vLockedCoins);
+
+    return result;
+#else
+    return MP_ERR_WALLET_ACCESS;
+#endif
+}
 
 int GetDryPayloadOutputCount(
         const std::string& senderAddress,
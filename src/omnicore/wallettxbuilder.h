@@ -18,6 +18,7 @@ class Wallet;
 #include <stdint.h>
 #include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 /**
@@ -50,6 +51,21 @@ int WalletTxBuilder(
         interfaces::Wallet* iWallet = nullptr,
         CAmount minFee = 0);
 
+/**
+ * Creates and sends a batch of transactions from the same sender, each given
+ * by its receivers and payload. The change of each transaction funds the next
+ * one, up to the chain limits of the memory pool. Either all or none are
+ * committed.
+ */
+int WalletTxBuilderBatch(
+        const std::string& senderAddress,
+        const std::vector<std::pair<std::vector<std::string>, std::vector<unsigned char> > >& transactions,
+        std::vector<uint256>& retTxids,
+        std::vector<std::string>& retRawTxs,
+        bool commit,
+        interfaces::Wallet* iWallet = nullptr,
+        CAmount minFee = 0);
+
 /**
  * Simulates the creation of a payload to count the required outputs.
  */
@@ -0,0 +1,205 @@
+/**
+ * @file wallettxindex.cpp
+ *
+ * Maintains an index of the Omni transactions of each loaded wallet, ordered by
+ * block height and position in block, so that wallet transaction listings don't
+ * have to scan the whole wallet for every request.
+ */
+
+#include <omnicore/wallettxindex.h>
+
+#include <omnicore/dbtransaction.h>
+#include <omnicore/dbtxlist.h>
+#include <omnicore/log.h>
+#include <omnicore/omnicore.h>
+
+#include <sync.h>
+#include <ui_interface.h>
+#include <uint256.h>
+#ifdef ENABLE_WALLET
+#include <wallet/wallet.h>
+#endif
+
+#include <stdint.h>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using mastercore::pDbTransaction;
+using mastercore::pDbTransactionList;
+
+namespace mastercore
+{
+//! Index of Omni transactions of all loaded wallets
+COmniWalletTxIndex walletTxIndex;
+}
+
+/**
+ * Adds a transaction with a known position to the index of a wallet.
+ */
+void COmniWalletTxIndex::Insert(WalletEntries& entries, const uint256& txid, const OmniTxPosition& position)
+{
+    std::map<uint256, OmniTxPosition>::iterator it = entries.mapIndexed.find(txid);
+    if (it != entries.mapIndexed.end()) {
+        entries.setOrdered.erase(std::make_pair(it->second, txid));
+        it->second = position;
+    } else {
+        entries.mapIndexed.insert(std::make_pair(txid, position));
+    }
+    entries.setOrdered.insert(std::make_pair(position, txid));
+}
+
+/**
+ * Called by the Omni transaction handler for every recorded transaction.
+ *
+ * Wallet transactions, which were reported by the wallet before they were
+ * processed, are moved from the unresolved set into the index.
+ */
+void COmniWalletTxIndex::RecordTransaction(const uint256& txid, int nBlock, uint32_t nPosition)
+{
+    LOCK(cs_walletindex);
+
+    for (auto& wallet : mapWallets) {
+        WalletEntries& entries = *wallet.second;
+        if (entries.setUnresolved.erase(txid)) {
+            Insert(entries, txid, OmniTxPosition(nBlock, nPosition));
+        }
+    }
+}
+
+/**
+ * Returns entries in the given block and above to the unresolved set.
+ *
+ * NOTE: The nBlock parameter is inclusive, matching CMPTxList::isMPinBlockRange().
+ */
+void COmniWalletTxIndex::RollBackAboveBlock(int nBlock)
+{
+    LOCK(cs_walletindex);
+
+    for (auto& wallet : mapWallets) {
+        WalletEntries& entries = *wallet.second;
+        auto itFirst = entries.setOrdered.lower_bound(std::make_pair(OmniTxPosition(nBlock, 0), uint256()));
+        for (auto it = itFirst; it != entries.setOrdered.end(); ++it) {
+            entries.mapIndexed.erase(it->second);
+            entries.setUnresolved.insert(it->second);
+        }
+        entries.setOrdered.erase(itFirst, entries.setOrdered.end());
+    }
+}
+
+/**
+ * Drops all entries, so that the index is rebuilt on next use.
+ */
+void COmniWalletTxIndex::Clear()
+{
+    LOCK(cs_walletindex);
+
+    mapWallets.clear();
+}
+
+#ifdef ENABLE_WALLET
+/**
+ * Matches unresolved wallet transactions against the Omni transaction list.
+ *
+ * Every transaction in the Omni transaction list is indexed, whether it is
+ * valid or not. Transactions, which are confirmed, but unknown to the Omni
+ * layer, are not Omni transactions and dropped. Unconfirmed transactions stay
+ * unresolved.
+ */
+void COmniWalletTxIndex::Resolve(const CWallet& wallet, WalletEntries& entries)
+{
+    AssertLockHeld(cs_tally);
+    AssertLockHeld(wallet.cs_wallet);
+    AssertLockHeld(cs_walletindex);
+
+    for (std::set<uint256>::iterator it = entries.setUnresolved.begin(); it != entries.setUnresolved.end(); ) {
+        const uint256& txid = *it;
+        std::map<uint256, CWalletTx>::const_iterator wit = wallet.mapWallet.find(txid);
+        if (wit == wallet.mapWallet.end()) {
+            it = entries.setUnresolved.erase(it);
+            continue;
+        }
+        const CWalletTx& wtx = wit->second;
+
+        // invalid Omni transactions are listed as well, so only the existence is checked
+        if (pDbTransactionList->exists(txid)) {
+            int nBlock = 0;
+            pDbTransactionList->getValidMPTX(txid, &nBlock); // sets the block, valid or not
+            uint32_t nPosition = wtx.isConfirmed() ? wtx.m_confirm.nIndex : pDbTransaction->FetchTransactionPosition(txid);
+            Insert(entries, txid, OmniTxPosition(nBlock, nPosition));
+            it = entries.setUnresolved.erase(it);
+        } else if (wtx.isConfirmed()) {
+            it = entries.setUnresolved.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+/**
+ * Returns up to count most recent Omni transactions of the wallet within the block range, newest first.
+ *
+ * The index of the wallet is built on first use, after which it only needs to
+ * resolve transactions added to the wallet since the last request.
+ */
+std::vector<std::pair<OmniTxPosition, uint256> > COmniWalletTxIndex::FetchLatest(const std::shared_ptr<CWallet>& wallet, unsigned int count, int startBlock, int endBlock)
+{
+    std::vector<std::pair<OmniTxPosition, uint256> > vResult;
+
+    LOCK2(cs_tally, wallet->cs_wallet);
+    LOCK(cs_walletindex);
+
+    const std::string walletName = wallet->GetName();
+    std::map<std::string, std::unique_ptr<WalletEntries> >::iterator itWallet = mapWallets.find(walletName);
+    if (itWallet == mapWallets.end()) {
+        std::unique_ptr<WalletEntries> entries(new WalletEntries());
+        for (const auto& item : wallet->mapWallet) {
+            entries->setUnresolved.insert(item.first);
+        }
+        // notifications are sent with cs_wallet held, so no transaction can be missed in between
+        entries->connTransactionChanged = wallet->NotifyTransactionChanged.connect(
+            [this, walletName](CWallet* pwallet, const uint256& txid, ChangeType status) {
+                LOCK(cs_walletindex);
+                std::map<std::string, std::unique_ptr<WalletEntries> >::iterator it = mapWallets.find(walletName);
+                if (it == mapWallets.end()) return;
+                WalletEntries& walletEntries = *it->second;
+                if (status == CT_DELETED) {
+                    std::map<uint256, OmniTxPosition>::iterator itIndexed = walletEntries.mapIndexed.find(txid);
+                    if (itIndexed != walletEntries.mapIndexed.end()) {
+                        walletEntries.setOrdered.erase(std::make_pair(itIndexed->second, txid));
+                        walletEntries.mapIndexed.erase(itIndexed);
+                    }
+                    walletEntries.setUnresolved.erase(txid);
+                } else if (walletEntries.mapIndexed.count(txid) == 0) {
+                    walletEntries.setUnresolved.insert(txid);
+                }
+            });
+        entries->connUnload = wallet->NotifyUnload.connect(
+            [this, walletName]() {
+                LOCK(cs_walletindex);
+                mapWallets.erase(walletName);
+            });
+        PrintToLog("%s(): building Omni transaction index of wallet \"%s\" (%d transactions)\n", __func__, walletName, entries->setUnresolved.size());
+        itWallet = mapWallets.insert(std::make_pair(walletName, std::move(entries))).first;
+    }
+
+    WalletEntries& entries = *itWallet->second;
+    Resolve(*wallet, entries);
+
+    std::set<std::pair<OmniTxPosition, uint256> >::const_iterator itEnd = entries.setOrdered.end();
+    if (endBlock < std::numeric_limits<int>::max()) {
+        itEnd = entries.setOrdered.lower_bound(std::make_pair(OmniTxPosition(endBlock + 1, 0), uint256()));
+    }
+    std::set<std::pair<OmniTxPosition, uint256> >::const_reverse_iterator it(itEnd);
+    for (; it != entries.setOrdered.rend() && vResult.size() < count; ++it) {
+        if (it->first.first < startBlock) break;
+        vResult.push_back(*it);
+    }
+
+    return vResult;
+}
+#endif // ENABLE_WALLET
@@ -0,0 +1,78 @@
+#ifndef XEP_OMNICORE_WALLETTXINDEX_H
+#define XEP_OMNICORE_WALLETTXINDEX_H
+
+class CWallet;
+
+#include <sync.h>
+#include <uint256.h>
+
+#include <boost/signals2/connection.hpp>
+
+#include <stdint.h>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** Position of an Omni transaction in the chain, given as block height and position in block. */
+typedef std::pair<int, uint32_t> OmniTxPosition;
+
+/** Index of the Omni transactions of each loaded wallet, ordered by position in the chain.
+ *
+ * Transactions are added, when the wallet reports them and once they are processed by the
+ * Omni transaction handler. Wallet transactions that are not yet known to the Omni layer
+ * are kept as unresolved, until they are either processed, or turn out to be no Omni
+ * transactions at all. The index of a wallet is built on first use and maintained
+ * incrementally afterwards, so a query only touches the returned entries.
+ *
+ * The index is held in memory only, and rebuilt once per wallet after a restart. It is
+ * derived from the wallet and the Omni transaction list, which are both persisted.
+ *
+ * Lock order: cs_tally, CWallet::cs_wallet, cs_walletindex.
+ */
+class COmniWalletTxIndex
+{
+private:
+    struct WalletEntries
+    {
+        //! Omni transactions of the wallet, ordered by position in the chain
+        std::set<std::pair<OmniTxPosition, uint256> > setOrdered;
+        //! Position of every indexed transaction
+        std::map<uint256, OmniTxPosition> mapIndexed;
+        //! Wallet transactions not yet matched against the Omni transaction list
+        std::set<uint256> setUnresolved;
+        //! Notification connections of the wallet
+        boost::signals2::scoped_connection connTransactionChanged;
+        boost::signals2::scoped_connection connUnload;
+    };
+
+    //! Guards mapWallets
+    mutable RecursiveMutex cs_walletindex;
+    //! Index entries of all loaded wallets, keyed by wallet name
+    std::map<std::string, std::unique_ptr<WalletEntries> > mapWallets;
+
+    /** Adds a transaction with a known position to the index of a wallet. */
+    static void Insert(WalletEntries& entries, const uint256& txid, const OmniTxPosition& position);
+    /** Matches unresolved wallet transactions against the Omni transaction list. */
+    void Resolve(const CWallet& wallet, WalletEntries& entries);
+
+public:
+    /** Called by the Omni transaction handler for every recorded transaction. */
+    void RecordTransaction(const uint256& txid, int nBlock, uint32_t nPosition);
+    /** Returns entries in the given block and above to the unresolved set, when rolling back state. */
+    void RollBackAboveBlock(int nBlock);
+    /** Drops all entries, so that the index is rebuilt on next use. */
+    void Clear();
+    /** Returns up to count most recent Omni transactions of the wallet within the block range, newest first. */
+    std::vector<std::pair<OmniTxPosition, uint256> > FetchLatest(const std::shared_ptr<CWallet>& wallet, unsigned int count, int startBlock, int endBlock);
+};
+
+namespace mastercore
+{
+//! Index of Omni transactions of all loaded wallets
+extern COmniWalletTxIndex walletTxIndex;
+}
+
+#endif // XEP_OMNICORE_WALLETTXINDEX_H
@@ -0,0 +1,291 @@
+// Copyright (c) 2016-2019 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/xep-config.h>
+#endif
+
+#include <chain.h>
+#include <chainparams.h>
+#include <chainparamsbase.h>
+#include <clientversion.h>
+#include <dbwrapper.h>
+#include <fs.h>
+#include <index/txindex.h>
+#include <key.h>
+#include <logging.h>
+#include <noui.h>
+#include <omnicore/consensushash.h>
+#include <omnicore/omnicore.h>
+#include <omnicore/rules.h>
+#include <pubkey.h>
+#include <random.h>
+#include <shutdown.h>
+#include <sync.h>
+#include <txdb.h>
+#include <uint256.h>
+#include <util/strencodings.h>
+#include <util/string.h>
+#include <util/system.h>
+#include <util/translation.h>
+#include <validation.h>
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+const std::function<std::string(const char*)> G_TRANSLATION_FUN = nullptr;
+
+static void SetupReplayArgs()
+{
+    SetupHelpOptions(gArgs);
+    SetupChainParamsBaseOptions();
+
+    gArgs.AddArg("-datadir=<dir>", "Specify data directory", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-blocksdir=<dir>", "Specify directory to hold blocks subdirectory for *.dat files (default: <datadir>)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-conf=<file>", strprintf("Specify configuration file. Relative paths will be prefixed by datadir location. (default: %s)", XEP_CONF_FILENAME), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-dbcache=<n>", strprintf("Maximum database cache size <n> MiB (%d to %d, default: %d)", nMinDbCache, nMaxDbCache, nDefaultDbCache), ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-replayheight=<n>", "Stop the replay at block <n> (default: the tip of the active chain)", ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    gArgs.AddArg("-printtoconsole", "Send trace/debug info to console (default: 0)", ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+
+    gArgs.AddArg("-omnishowblockconsensushash=<n>", "Print the consensus hash of block <n>, can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+    gArgs.AddArg("-omniscanthreads=<n>", "Number of threads, which read blocks and their inputs ahead of the replay (default: number of cores)", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+    gArgs.AddArg("-omniseedblockfilter", "Set skipping of blocks without Omni transactions (default: 1)", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+    gArgs.AddArg("-omniprogressfrequency=<n>", "Time in seconds after which the replay progress is reported (default: 30)", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+    gArgs.AddArg("-omnitxcache=<n>", "The maximum number of transactions in the input transaction cache (default: 500000)", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+    gArgs.AddArg("-omnidbcache=<n>", "Block cache size in MiB, shared by the Omni databases", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+    gArgs.AddArg("-omnilogfile=<file>", "The path of the log file (default: omnicore.log)", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+    gArgs.AddArg("-omnidebug=<category>", "Enable debug output for the given category, can be specified multiple times", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+    gArgs.AddArg("-omnialertallowsender=<address>", "Whitelist senders of alerts, can be \"any\"", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+    gArgs.AddArg("-omnialertignoresender=<address>", "Ignore senders of alerts", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+    gArgs.AddArg("-omniactivationallowsender=<address>", "Whitelist senders of activations", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+    gArgs.AddArg("-omniactivationignoresender=<address>", "Ignore senders of activations", ArgsManager::ALLOW_ANY, OptionsCategory::OMNI);
+}
+
+static bool ReplayAppInit(int argc, char* argv[])
+{
+    SetupReplayArgs();
+    std::string error_message;
+    if (!gArgs.ParseParameters(argc, argv, error_message)) {
+        tfm::format(std::cerr, "Error parsing command line arguments: %s\n", error_message);
+        return false;
+    }
+    if (HelpRequested(gArgs)) {
+        std::string usage = strprintf("%s omnixep-replay version", PACKAGE_NAME) + " " + FormatFullVersion() + "\n\n" +
+                                      "omnixep-replay rebuilds the Omni state of a stopped node from its block files, block index and transaction index.\n" +
+                                      "It prints the consensus hashes of the selected blocks, compares them with the checkpoints, and leaves the\n" +
+                                      "Omni databases and state files in the data directory, where omnixepd loads them on the next start.\n" +
+                                      "Existing Omni state in the data directory is replaced. The node must have been run with -txindex.\n\n" +
+                                      "Usage:\n" +
+                                      "  omnixep-replay [options]\n\n" +
+                                      gArgs.GetHelpMessage();
+
+        tfm::format(std::cout, "%s", usage);
+        return false;
+    }
+
+    if (!CheckDataDirOption()) {
+        tfm::format(std::cerr, "Error: Specified data directory \"%s\" does not exist.\n", gArgs.GetArg("-datadir", ""));
+        return false;
+    }
+    if (!gArgs.ReadConfigFiles(error_message, true)) {
+        tfm::format(std::cerr, "Error reading configuration file: %s\n", error_message);
+        return false;
+    }
+    // Check for -testnet or -regtest parameter (Params() calls are only valid after this clause)
+    SelectParams(gArgs.GetChainName());
+
+    LogInstance().m_print_to_console = gArgs.GetBoolArg("-printtoconsole", false);
+    LogInstance().m_print_to_file = false;
+    LogInstance().StartLogging();
+
+    // the replay always starts from scratch, and reads ahead with all cores, unless told otherwise
+    gArgs.ForceSetArg("-startclean", "1");
+    gArgs.SoftSetArg("-omniscanthreads", ToString(GetNumCores()));
+
+    return true;
+}
+
+/** Opens the block index and the chainstate, read-only, and activates the chain up to the replay height. */
+static bool LoadChain(int64_t nTotalCache, int& nReplayHeight)
+{
+    const CChainParams& chainparams = Params();
+    int64_t nBlockTreeDBCache = std::min(nTotalCache / 8, nMaxBlockDBCache << 20);
+    int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23));
+
+    LOCK(cs_main);
+    g_chainstate = MakeUnique<CChainState>();
+    pblocktree.reset(new CBlockTreeDB(nBlockTreeDBCache, false, false));
+
+    if (!LoadBlockIndex(chainparams)) {
+        tfm::format(std::cerr, "Error loading block database\n");
+        return false;
+    }
+    if (fReindex) {
+        tfm::format(std::cerr, "Error: the block database is being reindexed, start omnixepd to complete it first\n");
+        return false;
+    }
+    if (!LookupBlockIndex(chainparams.GetConsensus().hashGenesisBlock)) {
+        tfm::format(std::cerr, "Error: incorrect or no genesis block found, wrong datadir for network?\n");
+        return false;
+    }
+
+    ::ChainstateActive().InitCoinsDB(nCoinDBCache, /* in_memory */ false, /* should_wipe */ false);
+    if (!::ChainstateActive().CoinsDB().GetHeadBlocks().empty()) {
+        tfm::format(std::cerr, "Error: the chainstate was not flushed completely, start omnixepd to repair it first\n");
+        return false;
+    }
+    ::ChainstateActive().InitCoinsCache();
+    if (::ChainstateActive().CoinsTip().GetBestBlock().IsNull() || !::ChainstateActive().LoadChainTip(chainparams)) {
+        tfm::format(std::cerr, "Error: there is no active chain in the data directory\n");
+        return false;
+    }
+
+    nReplayHeight = gArgs.GetArg("-replayheight", ::ChainActive().Height());
+    if (nReplayHeight < 0 || nReplayHeight > ::ChainActive().Height()) {
+        tfm::format(std::cerr, "Error: -replayheight must be between 0 and %d\n", ::ChainActive().Height());
+        return false;
+    }
+    // only the Omni layer sees the shorter chain, nothing is written back
+    ::ChainActive().SetTip(::ChainActive()[nReplayHeight]);
+
+    return true;
+}
+
+/** Opens the transaction index, which is used to identify the senders, after checking it covers the replay. */
+static bool LoadTxIndex(int64_t nTotalCache, int nReplayHeight)
+{
+    const fs::path path = GetDataDir() / "indexes" / "txindex";
+    if (!fs::exists(path)) {
+        tfm::format(std::cerr, "Error: no transaction index found, run omnixepd with -txindex first\n");
+        return false;
+    }
+
+    {
+        CDBWrapper db(path, 1 << 20, false, false);
+        CBlockLocator locator;
+        if (!db.Read('B', locator)) {
+            tfm::format(std::cerr, "Error: failed to read the best block of the transaction index\n");
+            return false;
+        }
+        LOCK(cs_main);
+        const CBlockIndex* pindex = FindForkInGlobalIndex(::ChainActive(), locator);
+        if (pindex->nHeight < nReplayHeight) {
+            tfm::format(std::cerr, "Error: the transaction index is only synced up to block %d\n", pindex->nHeight);
+            return false;
+        }
+    }
+
+    int64_t nTxIndexCache = std::min(nTotalCache / 8, nMaxTxIndexCache << 20);
+    g_txindex = MakeUnique<TxIndex>(nTxIndexCache, false, false, DEFAULT_TX_CACHE_SIZE << 20);
+
+    return true;
+}
+
+static bool Replay()
+{
+    if (!LockDirectory(GetDataDir(), ".lock")) {
+        tfm::format(std::cerr, "Error: cannot obtain a lock on data directory %s, omnixepd is probably still running\n", GetDataDir().string());
+        return false;
+    }
+
+    int64_t nTotalCache = gArgs.GetArg("-dbcache", nDefaultDbCache);
+    nTotalCache = std::max(nMinDbCache, std::min(nMaxDbCache, nTotalCache)) << 20;
+
+    int nReplayHeight = 0;
+    if (!LoadChain(nTotalCache, nReplayHeight)) return false;
+    if (!LoadTxIndex(nTotalCache, nReplayHeight)) return false;
+
+    std::set<int> hashHeights;
+    for (const std::string& value : gArgs.GetArgs("-omnishowblockconsensushash")) {
+        int64_t height = atoi64(value);
+        if (height > 0) hashHeights.insert(height);
+    }
+    std::map<int, mastercore::ConsensusCheckpoint> checkpoints;
+    for (const mastercore::ConsensusCheckpoint& checkpoint : mastercore::ConsensusParams().GetCheckpoints()) {
+        if (checkpoint.blockHeight <= nReplayHeight) checkpoints[checkpoint.blockHeight] = checkpoint;
+    }
+
+    int nLastBlock = -1;
+    int nMismatches = 0;
+    blockEndObserver = [&](int nBlock, const CBlockIndex* pBlockIndex) {
+        nLastBlock = nBlock;
+        std::map<int, mastercore::ConsensusCheckpoint>::const_iterator it = checkpoints.find(nBlock);
+        if (it == checkpoints.end() && !hashHeights.count(nBlock)) return;
+
+        uint256 consensusHash = mastercore::GetConsensusHash();
+        std::string strResult;
+        if (it != checkpoints.end()) {
+            const mastercore::ConsensusCheckpoint& checkpoint = it->second;
+            if (checkpoint.blockHash == pBlockIndex->GetBlockHash() && checkpoint.consensusHash == consensusHash) {
+                strResult = " checkpoint OK";
+            } else {
+                strResult = strprintf(" checkpoint MISMATCH, expected %s", checkpoint.consensusHash.GetHex());
+                ++nMismatches;
+            }
+        }
+        tfm::format(std::cout, "Consensus hash for block %d (%s): %s%s\n", nBlock, pBlockIndex->GetBlockHash().GetHex(), consensusHash.GetHex(), strResult);
+    };
+
+    mastercore_init();
+    // there is nothing to replay, if the chain ends before the first Omni block
+    bool fReplayed = (nLastBlock == nReplayHeight || nReplayHeight < mastercore::ConsensusParams().GENESIS_BLOCK);
+    bool fComplete = (fReplayed && nMismatches == 0 && !ShutdownRequested());
+    mastercore_shutdown();
+    blockEndObserver = nullptr;
+
+    if (!fComplete) {
+        // make sure the node doesn't continue with the state of an incomplete or failed replay
+        fs::remove_all(GetDataDir() / "MP_persist");
+        tfm::format(std::cerr, "Replay failed at block %d of %d, %d checkpoint(s) mismatched\n", nLastBlock, nReplayHeight, nMismatches);
+    } else {
+        tfm::format(std::cout, "Replayed %d blocks, %d checkpoint(s) verified, the state was stored in %s\n", nReplayHeight + 1, checkpoints.size(), GetDataDir().string());
+    }
+
+    g_txindex.reset();
+    {
+        LOCK(cs_main);
+        ::ChainstateActive().ResetCoinsViews();
+        UnloadBlockIndex();
+        pblocktree.reset();
+    }
+
+    return fComplete;
+}
+
+int main(int argc, char* argv[])
+{
+#ifdef WIN32
+    util::WinCmdLineArgs winArgs;
+    std::tie(argc, argv) = winArgs.get();
+#endif
+    SetupEnvironment();
+    noui_connect();
+    try {
+        if (!ReplayAppInit(argc, argv)) return EXIT_FAILURE;
+    } catch (const std::exception& e) {
+        PrintExceptionContinue(&e, "ReplayAppInit()");
+        return EXIT_FAILURE;
+    } catch (...) {
+        PrintExceptionContinue(nullptr, "ReplayAppInit()");
+        return EXIT_FAILURE;
+    }
+
+    RandomInit();
+    ECC_Start();
+    ECCVerifyHandle globalVerifyHandle;
+    bool fSuccess = false;
+    try {
+        fSuccess = Replay();
+    } catch (const std::exception& e) {
+        PrintExceptionContinue(&e, "Replay()");
+    } catch (...) {
+        PrintExceptionContinue(nullptr, "Replay()");
+    }
+    ECC_Stop();
+
+    return fSuccess ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -18,20 +18,36 @@
 static Mutex cs_target_cache;
 
 // peercoin: find last block index up to pindex
+// The predecessor pointers built by CBlockIndex::BuildAlgoSkip() make this O(1). If there is no such block, the first block of the
+// chain is returned. Block indexes without these pointers are walked back one block at a time.
 static inline const CBlockIndex* GetLastBlockIndex(const CBlockIndex* pindex, const bool fProofOfStake)
 {
-    while (pindex && pindex->IsProofOfStake() != fProofOfStake && pindex->pprev) {
-        pindex = pindex->pprev;
+    if (!pindex || pindex->IsProofOfStake() == fProofOfStake)
+        return pindex;
+
+    if (pindex->pprev && pindex->pprevPoS != pindex->pprev && pindex->pprevPoW != pindex->pprev) {
+        while (pindex->IsProofOfStake() != fProofOfStake && pindex->pprev)
+            pindex = pindex->pprev;
+        return pindex;
     }
-    return pindex;
+
+    const CBlockIndex* pprev = fProofOfStake ? pindex->pprevPoS : pindex->pprevPoW;
+    return pprev ? pprev : pindex->GetAncestor(0);
 }
 
 static inline const CBlockIndex* GetLastBlockIndexForAlgo(const CBlockIndex* pindex, const int algo)
 {
-    while (pindex && CBlockHeader::GetAlgoType(pindex->nVersion) != algo && pindex->pprev) {
-        pindex = pindex->pprev;
+    if (!pindex || CBlockHeader::GetAlgoType(pindex->nVersion) == algo)
+        return pindex;
+
+    if (pindex->pprev && pindex->pprevAlgo[CBlockHeader::GetAlgoType(pindex->pprev->nVersion)] != pindex->pprev) {
+        while (CBlockHeader::GetAlgoType(pindex->nVersion) != algo && pindex->pprev)
+            pindex = pindex->pprev;
+        return pindex;
     }
-    return pindex;
+
+    const CBlockIndex* pprev = pindex->pprevAlgo[algo];
+    return pprev ? pprev : pindex->GetAncestor(0);
 }
 
 static inline const CBlockIndex* GetASERTReferenceBlockForAlgo(const CBlockIndex* pindex, const int nASERTStartHeight, const int algo)
@@ -91,7 +107,7 @@ unsigned int GetNextWorkRequired(const CBlockIndex* pindexLast, const CBlockHead
             // Return the block before the last non-special-min-difficulty-rules-block
             const CBlockIndex* pindex = pindexPrev;
             while (pindex->pprev && (pindex->nBits == (nProofOfWorkLimit - 1) || CBlockHeader::GetAlgoType(pindex->nVersion) != algo))
-                pindex = pindex->pprev;
+                pindex = GetLastBlockIndexForAlgo(pindex->pprev, algo);
             const CBlockIndex* pprev = GetLastBlockIndexForAlgo(pindex->pprev, algo);
             if (pprev && pprev->nHeight > 10) {
                 // Don't return pprev->nBits if it is another min-difficulty block; instead return pindex->nBits
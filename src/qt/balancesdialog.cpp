@@ -9,14 +9,10 @@
 
 #include <omnicore/omnicore.h>
 #include <omnicore/sp.h>
-#include <omnicore/tally.h>
-#include <omnicore/walletutils.h>
 
 #include <amount.h>
-#include <key_io.h>
 #include <sync.h>
 #include <ui_interface.h>
-#include <wallet/wallet.h>
 
 #include <stdint.h>
 #include <map>
@@ -32,7 +28,7 @@
 #include <QPoint>
 #include <QResizeEvent>
 #include <QString>
-#include <QTableWidgetItem>
+#include <QThread>
 #include <QWidget>
 
 using std::ostringstream;
@@ -40,15 +36,15 @@ using std::ostringstream;
 using namespace mastercore;
 
 BalancesDialog::BalancesDialog(QWidget *parent) :
-    QDialog(parent), ui(new Ui::balancesDialog), clientModel(nullptr), walletModel(nullptr)
+    QDialog(parent), ui(new Ui::balancesDialog), clientModel(nullptr), walletModel(nullptr),
+    loaderThread(new QThread(this)), loader(nullptr), shownPropertyId(BALANCES_SUMMARY_ID),
+    loadGeneration(0), loadInProgress(false), reloadRequested(false)
 {
     // setup
     ui->setupUi(this);
-    ui->balancesTable->setColumnCount(4);
-    ui->balancesTable->setHorizontalHeaderItem(0, new QTableWidgetItem("Property ID"));
-    ui->balancesTable->setHorizontalHeaderItem(1, new QTableWidgetItem("Property Name"));
-    ui->balancesTable->setHorizontalHeaderItem(2, new QTableWidgetItem("Reserved"));
-    ui->balancesTable->setHorizontalHeaderItem(3, new QTableWidgetItem("Available"));
+    qRegisterMetaType<BalanceRows>("BalanceRows");
+    balancesModel = new OmniBalancesTableModel(this);
+    ui->balancesTable->setModel(balancesModel);
     borrowedColumnResizingFixer = new GUIUtil::TableViewLastColumnResizingFixer(ui->balancesTable, 100, 100, this);
     // note neither resizetocontents or stretch allow user to adjust - go interactive then manually set widths
     #if QT_VERSION < 0x050000
@@ -64,9 +60,8 @@ BalancesDialog::BalancesDialog(QWidget *parent) :
     #endif
     ui->balancesTable->setAlternatingRowColors(true);
 
-    // do an initial population
+    // the balances are loaded once a wallet is available, see setWalletModel
     UpdatePropSelector();
-    PopulateBalances(2147483646); // 2147483646 = summary (last possible ID for test eco props)
 
     // initial resizing
     ui->balancesTable->resizeColumnToContents(0);
@@ -114,15 +109,16 @@ BalancesDialog::BalancesDialog(QWidget *parent) :
 
 BalancesDialog::~BalancesDialog()
 {
+    loaderThread->quit();
+    loaderThread->wait();
     delete ui;
 }
 
 void BalancesDialog::reinitOmni()
 {
     ui->propSelectorWidget->clear();
-    ui->balancesTable->setRowCount(0);
     UpdatePropSelector();
-    PopulateBalances(2147483646); // 2147483646 = summary (last possible ID for test eco props)
+    PopulateBalances(BALANCES_SUMMARY_ID);
 }
 
 void BalancesDialog::setClientModel(ClientModel *model)
@@ -137,7 +133,15 @@ void BalancesDialog::setClientModel(ClientModel *model)
 void BalancesDialog::setWalletModel(WalletModel *model)
 {
     this->walletModel = model;
-    if (model != nullptr) { } // do nothing, signals from walletModel no longer needed
+    if (model != nullptr && loader == nullptr) {
+        loader = new OmniBalancesLoader(model->wallet());
+        loader->moveToThread(loaderThread);
+        connect(loaderThread, &QThread::finished, loader, &QObject::deleteLater);
+        connect(this, &BalancesDialog::loadRequested, loader, &OmniBalancesLoader::load);
+        connect(loader, &OmniBalancesLoader::balancesLoaded, this, &BalancesDialog::balancesLoaded);
+        loaderThread->start();
+        PopulateBalances(shownPropertyId);
+    }
 }
 
 void BalancesDialog::UpdatePropSelector()
@@ -150,7 +154,7 @@ void BalancesDialog::UpdatePropSelector()
     // a new property has been added to the wallet, update the property selector
     QString spId = ui->propSelectorWidget->itemData(ui->propSelectorWidget->currentIndex()).toString();
     ui->propSelectorWidget->clear();
-    ui->propSelectorWidget->addItem("Wallet Totals (Summary)","2147483646"); //use last possible ID for summary for now
+    ui->propSelectorWidget->addItem("Wallet Totals (Summary)", QString::number(BALANCES_SUMMARY_ID)); //use last possible ID for summary for now
     // populate property selector
     for (std::set<uint32_t>::iterator it = global_wallet_property_list.begin() ; it != global_wallet_property_list.end(); ++it) {
         uint32_t propertyId = *it;
@@ -164,94 +168,33 @@ void BalancesDialog::UpdatePropSelector()
     if (propIdx != -1) { ui->propSelectorWidget->setCurrentIndex(propIdx); }
 }
 
-void BalancesDialog::AddRow(const std::string& label, const std::string& address, const std::string& reserved, const std::string& available)
+void BalancesDialog::PopulateBalances(unsigned int propertyId)
 {
-    int workingRow = ui->balancesTable->rowCount();
-    ui->balancesTable->insertRow(workingRow);
-    QTableWidgetItem *labelCell = new QTableWidgetItem(QString::fromStdString(label));
-    QTableWidgetItem *addressCell = new QTableWidgetItem(QString::fromStdString(address));
-    QTableWidgetItem *reservedCell = new QTableWidgetItem(QString::fromStdString(reserved));
-    QTableWidgetItem *availableCell = new QTableWidgetItem(QString::fromStdString(available));
-    labelCell->setTextAlignment(Qt::AlignLeft + Qt::AlignVCenter);
-    addressCell->setTextAlignment(Qt::AlignLeft + Qt::AlignVCenter);
-    reservedCell->setTextAlignment(Qt::AlignRight + Qt::AlignVCenter);
-    availableCell->setTextAlignment(Qt::AlignRight + Qt::AlignVCenter);
-    ui->balancesTable->setItem(workingRow, 0, labelCell);
-    ui->balancesTable->setItem(workingRow, 1, addressCell);
-    ui->balancesTable->setItem(workingRow, 2, reservedCell);
-    ui->balancesTable->setItem(workingRow, 3, availableCell);
+    if (propertyId != shownPropertyId) {
+        // a different property starts from an empty table, balances still in flight for the old one are dropped
+        ++loadGeneration;
+        shownPropertyId = propertyId;
+        balancesModel->reset(propertyId == BALANCES_SUMMARY_ID);
+    }
+    if (loader == nullptr) return;
+    // coalesce updates that arrive while the balances are being loaded into a single follow-up load
+    if (loadInProgress) {
+        reloadRequested = true;
+        return;
+    }
+    loadInProgress = true;
+    Q_EMIT loadRequested(loadGeneration, shownPropertyId);
 }
 
-void BalancesDialog::PopulateBalances(unsigned int propertyId)
+void BalancesDialog::balancesLoaded(int generation, const BalanceRows& rows)
 {
-    ui->balancesTable->setRowCount(0); // fresh slate (note this will automatically cleanup all existing QWidgetItems in the table)
-
-    LOCK(cs_tally);
-    //are we summary?
-    if(propertyId==2147483646) {
-        ui->balancesTable->setHorizontalHeaderItem(0, new QTableWidgetItem("Property ID"));
-        ui->balancesTable->setHorizontalHeaderItem(1, new QTableWidgetItem("Property Name"));
-
-        // loop over the wallet property list and add the wallet totals
-        for (std::set<uint32_t>::iterator it = global_wallet_property_list.begin() ; it != global_wallet_property_list.end(); ++it) {
-            uint32_t propertyId = *it;
-            std::string spId = strprintf("%d", propertyId);
-            std::string spName = getPropertyName(propertyId).c_str();
-            std::string available = FormatMP(propertyId, global_balance_money[propertyId]);
-            std::string reserved = FormatMP(propertyId, global_balance_reserved[propertyId]);
-            AddRow(spId, spName, reserved, available);
-        }
-    } else {
-        ui->balancesTable->setHorizontalHeaderItem(0, new QTableWidgetItem("Label"));
-        ui->balancesTable->setHorizontalHeaderItem(1, new QTableWidgetItem("Address"));
-        bool propertyIsDivisible = isPropertyDivisible(propertyId); // only fetch the SP once, not for every address
-
-        // iterate mp_tally_map looking for addresses that hold a balance in propertyId
-        for(std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
-            const std::string& address = my_it->first;
-            CMPTally& tally = my_it->second;
-            tally.init();
-
-            uint32_t id;
-            bool watchAddress = false, includeAddress = false;
-            while (0 != (id = (tally.next()))) {
-                if (id == propertyId) {
-                    includeAddress = true;
-                    break;
-                }
-            }
-            if (!includeAddress) continue; //ignore this address, has never transacted in this propertyId
-
-            // obtain the balances for the address directly form tally
-            int64_t available = tally.getMoney(propertyId, BALANCE);
-            available += tally.getMoney(propertyId, PENDING);
-            int64_t reserved = tally.getMoney(propertyId, SELLOFFER_RESERVE);
-            reserved += tally.getMoney(propertyId, ACCEPT_RESERVE);
-            reserved += tally.getMoney(propertyId, METADEX_RESERVE);
-
-            // format the balances
-            std::string reservedStr, availableStr;
-            if (propertyIsDivisible) {
-                reservedStr = FormatDivisibleMP(reserved);
-                availableStr = FormatDivisibleMP(available);
-            } else {
-                reservedStr = FormatIndivisibleMP(reserved);
-                availableStr = FormatIndivisibleMP(available);
-            }
-
-            CTxDestination destination = DecodeDestination(address);
-            std::string name;
-            isminetype ismine;
-            walletModel->wallet().getAddress(destination, &name, &ismine, nullptr);
-            if (ismine != ISMINE_SPENDABLE) watchAddress = true;
-
-            // add the row
-            if (!watchAddress) {
-                AddRow(name, address, reservedStr, availableStr);
-            } else {
-                AddRow(name, address + " (watch-only)", reservedStr, availableStr);
-            }
-        }
+    loadInProgress = false;
+    if (generation == loadGeneration) {
+        balancesModel->applyRows(rows);
+    }
+    if (reloadRequested || generation != loadGeneration) {
+        reloadRequested = false;
+        PopulateBalances(shownPropertyId);
     }
 }
 
@@ -269,7 +212,7 @@ void BalancesDialog::contextualMenu(const QPoint &point)
     {
         QString spId = ui->propSelectorWidget->itemData(ui->propSelectorWidget->currentIndex()).toString();
         unsigned int propertyId = spId.toUInt();
-        if (propertyId == 2147483646) {
+        if (propertyId == BALANCES_SUMMARY_ID) {
             contextMenuSummary->exec(QCursor::pos());
         } else {
             contextMenu->exec(QCursor::pos());
@@ -277,24 +220,31 @@ void BalancesDialog::contextualMenu(const QPoint &point)
     }
 }
 
+void BalancesDialog::copyColumn(int column)
+{
+    QModelIndex index = ui->balancesTable->currentIndex();
+    if (!index.isValid()) return;
+    GUIUtil::setClipboard(index.sibling(index.row(), column).data(Qt::DisplayRole).toString());
+}
+
 void BalancesDialog::balancesCopyCol0()
 {
-    GUIUtil::setClipboard(ui->balancesTable->item(ui->balancesTable->currentRow(),0)->text());
+    copyColumn(OmniBalancesTableModel::Label);
 }
 
 void BalancesDialog::balancesCopyCol1()
 {
-    GUIUtil::setClipboard(ui->balancesTable->item(ui->balancesTable->currentRow(),1)->text());
+    copyColumn(OmniBalancesTableModel::Name);
 }
 
 void BalancesDialog::balancesCopyCol2()
 {
-    GUIUtil::setClipboard(ui->balancesTable->item(ui->balancesTable->currentRow(),2)->text());
+    copyColumn(OmniBalancesTableModel::Reserved);
 }
 
 void BalancesDialog::balancesCopyCol3()
 {
-    GUIUtil::setClipboard(ui->balancesTable->item(ui->balancesTable->currentRow(),3)->text());
+    copyColumn(OmniBalancesTableModel::Available);
 }
 
 void BalancesDialog::balancesUpdated()
@@ -6,6 +6,7 @@
 #define XEP_QT_BALANCESDIALOG_H
 
 #include <qt/guiutil.h>
+#include <qt/omnibalancestablemodel.h>
 
 #include <QDialog>
 
@@ -17,6 +18,7 @@ class QMenu;
 class QPoint;
 class QResizeEvent;
 class QString;
+class QThread;
 class QWidget;
 QT_END_NAMESPACE
 
@@ -34,7 +36,6 @@ public:
 
     void setClientModel(ClientModel *model);
     void setWalletModel(WalletModel *model);
-    void AddRow(const std::string& label, const std::string& address, const std::string& reserved, const std::string& available);
     void PopulateBalances(unsigned int propertyId);
     void UpdatePropSelector();
 
@@ -44,6 +45,15 @@ private:
     WalletModel *walletModel;
     QMenu *contextMenu;
     QMenu *contextMenuSummary;
+    OmniBalancesTableModel *balancesModel;
+    QThread *loaderThread;
+    OmniBalancesLoader *loader;
+    unsigned int shownPropertyId;
+    int loadGeneration; // bumped when the shown property changes, so stale balances are dropped
+    bool loadInProgress;
+    bool reloadRequested;
+
+    void copyColumn(int column);
 
     GUIUtil::TableViewLastColumnResizingFixer *borrowedColumnResizingFixer;
     virtual void resizeEvent(QResizeEvent *event);
@@ -59,10 +69,13 @@ private Q_SLOTS:
     void balancesCopyCol1();
     void balancesCopyCol2();
     void balancesCopyCol3();
+    void balancesLoaded(int generation, const BalanceRows& rows);
 
 Q_SIGNALS:
     /**  Fired when a message should be reported to the user */
     void message(const QString &title, const QString &message, unsigned int style);
+    /** Asks the loader thread for the balances of a property */
+    void loadRequested(int generation, unsigned int propertyId);
 };
 
 #endif // XEP_QT_BALANCESDIALOG_H
@@ -0,0 +1,198 @@
+// Copyright (c) 2011-2013 The Xep developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <qt/omnibalancestablemodel.h>
+
+#include <omnicore/omnicore.h>
+#include <omnicore/sp.h>
+#include <omnicore/tally.h>
+
+#include <interfaces/wallet.h>
+#include <key_io.h>
+#include <script/standard.h>
+#include <sync.h>
+#include <tinyformat.h>
+#include <wallet/ismine.h>
+
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include <QString>
+
+using namespace mastercore;
+
+OmniBalancesLoader::OmniBalancesLoader(interfaces::Wallet& wallet) :
+    QObject(),
+    m_wallet(wallet)
+{
+}
+
+void OmniBalancesLoader::load(int generation, unsigned int propertyId)
+{
+    BalanceRows rows;
+    {
+        LOCK(cs_tally);
+        if (propertyId == BALANCES_SUMMARY_ID) {
+            // loop over the wallet property list and add the wallet totals
+            for (std::set<uint32_t>::iterator it = global_wallet_property_list.begin(); it != global_wallet_property_list.end(); ++it) {
+                uint32_t id = *it;
+                BalanceRow row;
+                row.key = strprintf("%d", id);
+                row.label = row.key;
+                row.name = getPropertyName(id);
+                row.available = FormatMP(id, global_balance_money[id]);
+                row.reserved = FormatMP(id, global_balance_reserved[id]);
+                rows.push_back(row);
+            }
+        } else {
+            bool propertyIsDivisible = isPropertyDivisible(propertyId); // only fetch the SP once, not for every address
+
+            // iterate mp_tally_map looking for addresses that hold a balance in propertyId
+            for (std::unordered_map<std::string, CMPTally>::iterator my_it = mp_tally_map.begin(); my_it != mp_tally_map.end(); ++my_it) {
+                const std::string& address = my_it->first;
+                CMPTally& tally = my_it->second;
+                tally.init();
+
+                uint32_t id;
+                bool includeAddress = false;
+                while (0 != (id = (tally.next()))) {
+                    if (id == propertyId) {
+                        includeAddress = true;
+                        break;
+                    }
+                }
+                if (!includeAddress) continue; //ignore this address, has never transacted in this propertyId
+
+                // obtain the balances for the address directly form tally
+                int64_t available = tally.getMoney(propertyId, BALANCE);
+                available += tally.getMoney(propertyId, PENDING);
+                int64_t reserved = tally.getMoney(propertyId, SELLOFFER_RESERVE);
+                reserved += tally.getMoney(propertyId, ACCEPT_RESERVE);
+                reserved += tally.getMoney(propertyId, METADEX_RESERVE);
+
+                BalanceRow row;
+                row.key = address;
+                if (propertyIsDivisible) {
+                    row.reserved = FormatDivisibleMP(reserved);
+                    row.available = FormatDivisibleMP(available);
+                } else {
+                    row.reserved = FormatIndivisibleMP(reserved);
+                    row.available = FormatIndivisibleMP(available);
+                }
+
+                CTxDestination destination = DecodeDestination(address);
+                isminetype ismine = ISMINE_NO;
+                m_wallet.getAddress(destination, &row.label, &ismine, nullptr);
+                row.name = address;
+                if (ismine != ISMINE_SPENDABLE) row.name += " (watch-only)";
+                rows.push_back(row);
+            }
+        }
+    }
+    Q_EMIT balancesLoaded(generation, rows);
+}
+
+OmniBalancesTableModel::OmniBalancesTableModel(QObject *parent) :
+    QAbstractTableModel(parent),
+    m_summary(true)
+{
+}
+
+int OmniBalancesTableModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return m_rows.size();
+}
+
+int OmniBalancesTableModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return Available + 1;
+}
+
+QVariant OmniBalancesTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= (int)m_rows.size()) return QVariant();
+
+    const BalanceRow& row = m_rows[index.row()];
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+        case Label: return QString::fromStdString(row.label);
+        case Name: return QString::fromStdString(row.name);
+        case Reserved: return QString::fromStdString(row.reserved);
+        case Available: return QString::fromStdString(row.available);
+        }
+    } else if (role == Qt::TextAlignmentRole) {
+        if (index.column() == Reserved || index.column() == Available) return (int)(Qt::AlignRight | Qt::AlignVCenter);
+        return (int)(Qt::AlignLeft | Qt::AlignVCenter);
+    }
+    return QVariant();
+}
+
+QVariant OmniBalancesTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    switch (section) {
+    case Label: return m_summary ? tr("Property ID") : tr("Label");
+    case Name: return m_summary ? tr("Property Name") : tr("Address");
+    case Reserved: return tr("Reserved");
+    case Available: return tr("Available");
+    }
+    return QVariant();
+}
+
+Qt::ItemFlags OmniBalancesTableModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) return Qt::NoItemFlags;
+    return Qt::ItemIsSelectable | Qt::ItemIsEnabled;
+}
+
+void OmniBalancesTableModel::reset(bool summary)
+{
+    beginResetModel();
+    m_rows.clear();
+    m_summary = summary;
+    endResetModel();
+    Q_EMIT headerDataChanged(Qt::Horizontal, Label, Available);
+}
+
+void OmniBalancesTableModel::applyRows(const BalanceRows& rows)
+{
+    std::map<std::string, const BalanceRow*> incoming;
+    for (const BalanceRow& row : rows) {
+        incoming[row.key] = &row;
+    }
+
+    // remove rows that are gone, back to front so the remaining row numbers stay valid
+    for (int i = (int)m_rows.size() - 1; i >= 0; --i) {
+        if (incoming.count(m_rows[i].key)) continue;
+        beginRemoveRows(QModelIndex(), i, i);
+        m_rows.erase(m_rows.begin() + i);
+        endRemoveRows();
+    }
+
+    // update rows whose balances changed in place
+    for (int i = 0; i < (int)m_rows.size(); ++i) {
+        std::map<std::string, const BalanceRow*>::iterator it = incoming.find(m_rows[i].key);
+        if (*it->second != m_rows[i]) {
+            m_rows[i] = *it->second;
+            Q_EMIT dataChanged(index(i, Label), index(i, Available));
+        }
+        incoming.erase(it);
+    }
+
+    // append new rows in the order they were loaded
+    BalanceRows newRows;
+    for (const BalanceRow& row : rows) {
+        if (incoming.count(row.key)) newRows.push_back(row);
+    }
+    if (newRows.empty()) return;
+    int first = m_rows.size();
+    beginInsertRows(QModelIndex(), first, first + newRows.size() - 1);
+    m_rows.insert(m_rows.end(), newRows.begin(), newRows.end());
+    endInsertRows();
+}
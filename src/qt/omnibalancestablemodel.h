@@ -0,0 +1,105 @@
+// Copyright (c) 2011-2013 The Xep developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef XEP_QT_OMNIBALANCESTABLEMODEL_H
+#define XEP_QT_OMNIBALANCESTABLEMODEL_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <QAbstractTableModel>
+#include <QMetaType>
+#include <QObject>
+#include <QVariant>
+
+namespace interfaces {
+class Wallet;
+}
+
+/** Property ID the balances dialog uses for the wallet totals (last possible ID for test eco props) */
+static const uint32_t BALANCES_SUMMARY_ID = 2147483646;
+
+class BalanceRow
+{
+public:
+    std::string key; // property ID for wallet totals, otherwise the address
+    std::string label; // property ID or address label
+    std::string name; // property name or address
+    std::string reserved;
+    std::string available;
+
+    bool operator==(const BalanceRow& other) const
+    {
+        return key == other.key && label == other.label && name == other.name &&
+               reserved == other.reserved && available == other.available;
+    }
+    bool operator!=(const BalanceRow& other) const { return !(*this == other); }
+};
+
+typedef std::vector<BalanceRow> BalanceRows;
+
+Q_DECLARE_METATYPE(BalanceRows)
+
+/**
+ * Computes the rows of the balances table on a worker thread, either the
+ * wallet totals or the balances of every address holding one property.
+ */
+class OmniBalancesLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OmniBalancesLoader(interfaces::Wallet& wallet);
+
+public Q_SLOTS:
+    void load(int generation, unsigned int propertyId);
+
+Q_SIGNALS:
+    void balancesLoaded(int generation, const BalanceRows& rows);
+
+private:
+    interfaces::Wallet& m_wallet;
+};
+
+/**
+ * Qt model of the balances table. New balances are applied as a diff, so
+ * only rows that changed are repainted and the selection survives updates.
+ */
+class OmniBalancesTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit OmniBalancesTableModel(QObject *parent = nullptr);
+
+    enum ColumnIndex {
+        Label = 0,
+        Name = 1,
+        Reserved = 2,
+        Available = 3
+    };
+
+    /** @name Methods overridden from QAbstractTableModel
+        @{*/
+    int rowCount(const QModelIndex &parent) const;
+    int columnCount(const QModelIndex &parent) const;
+    QVariant data(const QModelIndex &index, int role) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+    /*@}*/
+
+    /** Drops all rows, switching between wallet totals and per address balances */
+    void reset(bool summary);
+
+public Q_SLOTS:
+    /** Removes vanished rows, updates changed ones and appends new ones */
+    void applyRows(const BalanceRows& rows);
+
+private:
+    BalanceRows m_rows;
+    bool m_summary;
+};
+
+#endif // XEP_QT_OMNIBALANCESTABLEMODEL_H
@@ -0,0 +1,388 @@
+// Copyright (c) 2011-2014 The Xep developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <qt/omnihistorytablemodel.h>
+
+#include <omnicore/dbspinfo.h>
+#include <omnicore/dbstolist.h>
+#include <omnicore/dbtxlist.h>
+#include <omnicore/omnicore.h>
+#include <omnicore/parsing.h>
+#include <omnicore/pending.h>
+#include <omnicore/sp.h>
+#include <omnicore/tx.h>
+#include <omnicore/utilsxep.h>
+#include <omnicore/walletfetchtxs.h>
+#include <omnicore/walletutils.h>
+
+#include <chainparams.h>
+#include <interfaces/wallet.h>
+#include <primitives/transaction.h>
+#include <shutdown.h>
+#include <sync.h>
+#include <tinyformat.h>
+#include <util/strencodings.h>
+#include <validation.h>
+
+#include <univalue.h>
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <utility>
+
+#include <QColor>
+#include <QDateTime>
+#include <QIcon>
+#include <QString>
+#include <QThread>
+
+using namespace mastercore;
+
+std::string ShrinkTxType(int txType, bool *fundsMoved)
+{
+    std::string displayType = "Unknown";
+    switch (txType) {
+        case MSC_TYPE_SIMPLE_SEND: displayType = "Send"; break;
+        case MSC_TYPE_RESTRICTED_SEND: displayType = "Rest. Send"; break;
+        case MSC_TYPE_SEND_TO_OWNERS: displayType = "Send To Owners"; break;
+        case MSC_TYPE_SEND_ALL: displayType = "Send All"; break;
+        case MSC_TYPE_SEND_TO_MANY: displayType = "Send To Many"; break;
+        case MSC_TYPE_SAVINGS_MARK: displayType = "Mark Savings"; *fundsMoved = false; break;
+        case MSC_TYPE_SAVINGS_COMPROMISED: ; displayType = "Lock Savings"; break;
+        case MSC_TYPE_RATELIMITED_MARK: displayType = "Rate Limit"; break;
+        case MSC_TYPE_AUTOMATIC_DISPENSARY: displayType = "Auto Dispense"; break;
+        case MSC_TYPE_TRADE_OFFER: displayType = "DEx Trade"; *fundsMoved = false; break;
+        case MSC_TYPE_ACCEPT_OFFER_XEP: displayType = "DEx Accept"; *fundsMoved = false; break;
+        case MSC_TYPE_METADEX_TRADE: displayType = "MetaDEx Trade"; *fundsMoved = false; break;
+        case MSC_TYPE_METADEX_CANCEL_PRICE:
+        case MSC_TYPE_METADEX_CANCEL_PAIR:
+        case MSC_TYPE_METADEX_CANCEL_ECOSYSTEM:
+            displayType = "MetaDEx Cancel"; *fundsMoved = false; break;
+        case MSC_TYPE_CREATE_PROPERTY_FIXED: displayType = "Create Property"; break;
+        case MSC_TYPE_CREATE_PROPERTY_VARIABLE: displayType = "Create Property"; *fundsMoved = false; break;
+        case MSC_TYPE_PROMOTE_PROPERTY: displayType = "Promo Property"; break;
+        case MSC_TYPE_CLOSE_CROWDSALE: displayType = "Close Crowdsale"; *fundsMoved = false; break;
+        case MSC_TYPE_CREATE_PROPERTY_MANUAL: displayType = "Create Property"; *fundsMoved = false; break;
+        case MSC_TYPE_GRANT_PROPERTY_TOKENS: displayType = "Grant Tokens"; break;
+        case MSC_TYPE_REVOKE_PROPERTY_TOKENS: displayType = "Revoke Tokens"; break;
+        case MSC_TYPE_CHANGE_ISSUER_ADDRESS: displayType = "Change Issuer"; *fundsMoved = false; break;
+        case MSC_TYPE_SEND_NONFUNGIBLE: displayType = "Unique Send"; break;
+    }
+    return displayType;
+}
+
+OmniHistoryLoader::OmniHistoryLoader(interfaces::Wallet& wallet) :
+    QObject(),
+    m_wallet(wallet),
+    m_generation(-1)
+{
+}
+
+void OmniHistoryLoader::load(int generation, unsigned int scope)
+{
+    if (generation != m_generation) {
+        m_loaded.clear();
+        m_generation = generation;
+    }
+
+    // obtain a sorted list of Omni layer wallet transactions (including STO receipts and pending)
+    std::map<std::string,uint256> walletTransactions = FetchWalletOmniTransactions(m_wallet, scope);
+
+    // reverse iterate over (now ordered) transactions, so the newest rows reach the table first
+    HistoryRows rows;
+    for (std::map<std::string,uint256>::reverse_iterator it = walletTransactions.rbegin(); it != walletTransactions.rend(); ++it) {
+        if (QThread::currentThread()->isInterruptionRequested() || ShutdownRequested()) break;
+
+        const uint256& txHash = it->second;
+        std::map<uint256, int>::const_iterator loaded_it = m_loaded.find(txHash);
+        if (loaded_it != m_loaded.end()) {
+            // confirmed transactions never change, pending transactions only once they confirm
+            if (loaded_it->second != 0) continue;
+            LOCK(cs_pending);
+            if (my_pending.count(txHash)) continue;
+        }
+
+        HistoryTXObject htxo;
+        {
+            // only hold cs_main per transaction, so block processing is never stalled for long
+            LOCK(cs_main);
+            if (!LoadRow(txHash, it->first, htxo)) continue;
+        }
+        m_loaded[txHash] = htxo.blockHeight;
+        rows.push_back(std::make_pair(txHash, htxo));
+        if (rows.size() >= HISTORY_LOAD_BATCH_SIZE) {
+            Q_EMIT rowsLoaded(generation, rows);
+            rows.clear();
+        }
+    }
+    if (!rows.empty()) {
+        Q_EMIT rowsLoaded(generation, rows);
+    }
+    Q_EMIT loadFinished(generation);
+}
+
+bool OmniHistoryLoader::LoadRow(const uint256& txHash, const std::string& sortKey, HistoryTXObject& htxo)
+{
+    AssertLockHeld(cs_main);
+
+    CTransactionRef wtx;
+    uint256 blockHash;
+    if (!GetTransaction(txHash, wtx, Params().GetConsensus(), blockHash)) return false;
+    if (blockHash.IsNull() || nullptr == GetBlockIndex(blockHash)) {
+        // this transaction is unconfirmed, should be one of our pending transactions
+        LOCK(cs_pending);
+        PendingMap::iterator pending_it = my_pending.find(txHash);
+        if (pending_it == my_pending.end()) return false;
+        const CMPPending& pending = pending_it->second;
+        htxo.blockHeight = 0;
+        if (sortKey.length() == 16) htxo.blockByteOffset = atoi(sortKey.substr(6)); // use wallet position from key in lieu of block position
+        htxo.valid = true; // all pending transactions are assumed to be valid prior to confirmation (wallet would not send them otherwise)
+        htxo.address = pending.src;
+        htxo.amount = "-" + FormatShortMP(pending.prop, pending.amount) + getTokenLabel(pending.prop);
+        bool fundsMoved = true;
+        htxo.txType = ShrinkTxType(pending.type, &fundsMoved);
+        if (pending.type == MSC_TYPE_METADEX_CANCEL_PRICE || pending.type == MSC_TYPE_METADEX_CANCEL_PAIR ||
+            pending.type == MSC_TYPE_METADEX_CANCEL_ECOSYSTEM || pending.type == MSC_TYPE_SEND_ALL) {
+            htxo.amount = "N/A";
+        }
+        return true;
+    }
+
+    // parse the transaction and setup the new history object
+    CBlockIndex* pBlockIndex = GetBlockIndex(blockHash);
+    int blockHeight = pBlockIndex->nHeight;
+    CMPTransaction mp_obj;
+    int parseRC = ParseTransaction(*wtx, blockHeight, 0, mp_obj);
+    if (sortKey.length() == 16) {
+        htxo.blockHeight = atoi(sortKey.substr(0,6));
+        htxo.blockByteOffset = atoi(sortKey.substr(6));
+    }
+    htxo.blockTime = pBlockIndex->GetBlockTime();
+
+    // positive RC means payment, potential DEx purchase
+    if (0 < parseRC) {
+        std::string tmpBuyer;
+        std::string tmpSeller;
+        uint64_t total = 0;
+        uint64_t tmpVout = 0;
+        uint64_t tmpNValue = 0;
+        uint64_t tmpPropertyId = 0;
+        int numberOfPurchases = 0;
+        {
+            LOCK(cs_tally);
+            pDbTransactionList->getPurchaseDetails(txHash, 1, &tmpBuyer, &tmpSeller, &tmpVout, &tmpPropertyId, &tmpNValue);
+            numberOfPurchases = pDbTransactionList->getNumberOfSubRecords(txHash);
+        }
+        bool bIsBuy = IsMyAddress(tmpBuyer, &m_wallet);
+        if (0 >= numberOfPurchases) return false;
+        for (int purchaseNumber = 1; purchaseNumber <= numberOfPurchases; purchaseNumber++) {
+            LOCK(cs_tally);
+            pDbTransactionList->getPurchaseDetails(txHash, purchaseNumber, &tmpBuyer, &tmpSeller, &tmpVout, &tmpPropertyId, &tmpNValue);
+            total += tmpNValue;
+        }
+        if (!bIsBuy) {
+            htxo.txType = "DEx Sell";
+            htxo.address = tmpSeller;
+        } else {
+            htxo.txType = "DEx Buy";
+            htxo.address = tmpBuyer;
+        }
+        htxo.valid = true; // only valid DEx payments are recorded in txlistdb
+        htxo.amount = (!bIsBuy ? "-" : "") + FormatDivisibleShortMP(total) + getTokenLabel(tmpPropertyId);
+        htxo.fundsMoved = true;
+        return true;
+    }
+
+    // handle Omni transaction
+    if (0 != parseRC) return false;
+    if (!mp_obj.interpret_Transaction()) return false;
+    int64_t amount = mp_obj.getAmount();
+    int tmpBlock = 0;
+    uint32_t type = 0;
+    uint64_t amountNew = 0;
+    htxo.valid = WITH_LOCK(cs_tally, return pDbTransactionList->getValidMPTX(txHash, &tmpBlock, &type, &amountNew));
+    if (htxo.valid && type == MSC_TYPE_TRADE_OFFER && amountNew > 0) amount = amountNew; // override for when amount for sale has been auto-adjusted
+    std::string displayAmount = FormatShortMP(mp_obj.getProperty(), amount) + getTokenLabel(mp_obj.getProperty());
+    htxo.fundsMoved = true;
+    htxo.txType = ShrinkTxType(mp_obj.getType(), &htxo.fundsMoved);
+    if (!htxo.valid) htxo.fundsMoved = false; // funds never move in invalid txs
+    htxo.address = mp_obj.getSender();
+    int isMyAddress = IsMyAddress(htxo.address, &m_wallet);
+    if (htxo.txType == "Send" && !isMyAddress) htxo.txType = "Receive"; // still a send transaction, but avoid confusion for end users
+    if (!isMyAddress) htxo.address = mp_obj.getReceiver();
+    if (htxo.fundsMoved && isMyAddress) displayAmount = "-" + displayAmount;
+    // override - special case for property creation (getProperty cannot get ID as createdID not stored in obj)
+    if (type == MSC_TYPE_CREATE_PROPERTY_FIXED || type == MSC_TYPE_CREATE_PROPERTY_VARIABLE || type == MSC_TYPE_CREATE_PROPERTY_MANUAL) {
+        displayAmount = "N/A";
+        if (htxo.valid) {
+            LOCK(cs_tally);
+            uint32_t propertyId = pDbSpInfo->findSPByTX(txHash);
+            if (type == MSC_TYPE_CREATE_PROPERTY_FIXED) displayAmount = FormatShortMP(propertyId, getTotalTokens(propertyId)) + getTokenLabel(propertyId);
+        }
+    }
+    // override - hide display amount for cancels and unknown transactions as we can't display amount/property as no prop exists
+    if (type == MSC_TYPE_METADEX_CANCEL_PRICE || type == MSC_TYPE_METADEX_CANCEL_PAIR ||
+        type == MSC_TYPE_METADEX_CANCEL_ECOSYSTEM || type == MSC_TYPE_SEND_ALL || htxo.txType == "Unknown") {
+        displayAmount = "N/A";
+    }
+    // override - display amount received not STO amount in packet (the total amount) for STOs I didn't send
+    if (type == MSC_TYPE_SEND_TO_OWNERS && !isMyAddress) {
+        UniValue receiveArray(UniValue::VARR);
+        uint64_t tmpAmount = 0, stoFee = 0;
+        LOCK(cs_tally);
+        pDbStoList->getRecipients(txHash, "", &receiveArray, &tmpAmount, &stoFee, &m_wallet);
+        displayAmount = FormatShortMP(mp_obj.getProperty(), tmpAmount) + getTokenLabel(mp_obj.getProperty());
+    }
+    htxo.amount = displayAmount;
+    return true;
+}
+
+OmniHistoryTableModel::OmniHistoryTableModel(QObject *parent) :
+    QAbstractTableModel(parent),
+    m_chain_height(0)
+{
+}
+
+int OmniHistoryTableModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return m_rows.size();
+}
+
+int OmniHistoryTableModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return 0;
+    return Amount + 1;
+}
+
+QVariant OmniHistoryTableModel::statusIcon(const HistoryTXObject& htxo) const
+{
+    if (!htxo.valid) return QIcon(":/icons/transaction_conflicted");
+    int confirmations = 0;
+    if (htxo.blockHeight > 0) confirmations = (m_chain_height + 1) - htxo.blockHeight;
+    switch (confirmations) {
+        case 1: return QIcon(":/icons/transaction_1");
+        case 2: return QIcon(":/icons/transaction_2");
+        case 3: return QIcon(":/icons/transaction_3");
+        case 4: return QIcon(":/icons/transaction_4");
+        case 5: return QIcon(":/icons/transaction_5");
+    }
+    if (confirmations > 5) return QIcon(":/icons/transaction_confirmed");
+    return QIcon(":/icons/transaction_0");
+}
+
+QVariant OmniHistoryTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= (int)m_rows.size()) return QVariant();
+
+    const uint256& txid = m_rows[index.row()].first;
+    const HistoryTXObject& htxo = m_rows[index.row()].second;
+
+    switch (role) {
+    case Qt::DisplayRole:
+        switch (index.column()) {
+        case Date:
+            if (htxo.blockHeight > 0) {
+                QDateTime txTime;
+                txTime.setTime_t(htxo.blockTime);
+                return txTime;
+            }
+            return QString("Unconfirmed");
+        case Type:
+            return QString::fromStdString(htxo.txType);
+        case Address:
+            return QString::fromStdString(htxo.address);
+        case Amount:
+            return QString::fromStdString(htxo.amount);
+        }
+        break;
+    case Qt::DecorationRole:
+        if (index.column() == Status) return statusIcon(htxo);
+        break;
+    case Qt::TextAlignmentRole:
+        if (index.column() == Address) return (int)(Qt::AlignLeft | Qt::AlignVCenter);
+        if (index.column() == Amount) return (int)(Qt::AlignRight | Qt::AlignVCenter);
+        break;
+    case Qt::ForegroundRole:
+        if (index.column() == Address) return QColor("#707070");
+        if (index.column() == Amount) {
+            if (!htxo.fundsMoved) return QColor("#404040");
+            if (htxo.amount.substr(0,1) == "-") return QColor("#EE0000"); // outbound
+            return QColor("#00AA00");
+        }
+        break;
+    case TxHashRole:
+        return QString::fromStdString(txid.GetHex());
+    case SortRole:
+        if (index.column() == Status || index.column() == Date) {
+            // pending transactions use a spoofed height to stay on top
+            int sortHeight = htxo.blockHeight == 0 ? 999999 : htxo.blockHeight;
+            return QString::fromStdString(strprintf("%06d%010d", sortHeight, htxo.blockByteOffset));
+        }
+        return data(index, Qt::DisplayRole);
+    }
+    return QVariant();
+}
+
+QVariant OmniHistoryTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) return QVariant();
+    switch (section) {
+    case Status: return QString(" ");
+    case Date: return tr("Date");
+    case Type: return tr("Type");
+    case Address: return tr("Address");
+    case Amount: return tr("Amount");
+    }
+    return QVariant();
+}
+
+Qt::ItemFlags OmniHistoryTableModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) return Qt::NoItemFlags;
+    return Qt::ItemIsSelectable | Qt::ItemIsEnabled;
+}
+
+void OmniHistoryTableModel::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_row_index.clear();
+    endResetModel();
+}
+
+void OmniHistoryTableModel::setChainHeight(int height)
+{
+    if (height == m_chain_height) return;
+    m_chain_height = height;
+    // only the status icons depend on the chain height
+    if (!m_rows.empty()) {
+        Q_EMIT dataChanged(index(0, Status), index((int)m_rows.size() - 1, Status));
+    }
+}
+
+void OmniHistoryTableModel::applyRows(const HistoryRows& rows)
+{
+    HistoryRows newRows;
+    for (const auto& row : rows) {
+        std::map<uint256, int>::const_iterator it = m_row_index.find(row.first);
+        if (it == m_row_index.end()) {
+            newRows.push_back(row);
+            continue;
+        }
+        // a pending transaction has confirmed, update its row in place
+        m_rows[it->second].second = row.second;
+        Q_EMIT dataChanged(index(it->second, Status), index(it->second, Amount));
+    }
+    if (newRows.empty()) return;
+
+    int first = m_rows.size();
+    beginInsertRows(QModelIndex(), first, first + newRows.size() - 1);
+    for (const auto& row : newRows) {
+        m_row_index[row.first] = m_rows.size();
+        m_rows.push_back(row);
+    }
+    endInsertRows();
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2011-2014 The Xep developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef XEP_QT_OMNIHISTORYTABLEMODEL_H
+#define XEP_QT_OMNIHISTORYTABLEMODEL_H
+
+#include <uint256.h>
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <QAbstractTableModel>
+#include <QMetaType>
+#include <QObject>
+#include <QVariant>
+
+namespace interfaces {
+class Wallet;
+}
+
+class HistoryTXObject
+{
+public:
+    HistoryTXObject()
+      : blockHeight(-1), blockByteOffset(0), blockTime(0), valid(false), fundsMoved(true) {};
+    int blockHeight; // block transaction was mined in
+    int blockByteOffset; // byte offset the tx is stored in the block (used for ordering multiple txs same block)
+    int64_t blockTime; // time of the block transaction was mined in (0 for pending transactions)
+    bool valid; // whether the transaction is valid from an Omni perspective
+    bool fundsMoved; // whether tokens actually moved in this transaction
+    std::string txType; // human readable string containing type
+    std::string address; // the address to be displayed (usually sender or recipient)
+    std::string amount; // string containing formatted amount
+};
+
+typedef std::vector<std::pair<uint256, HistoryTXObject>> HistoryRows;
+
+Q_DECLARE_METATYPE(HistoryRows)
+
+/** Number of history rows handed from the loader to the model at a time */
+static const unsigned int HISTORY_LOAD_BATCH_SIZE = 250;
+
+/** Returns the short transaction type shown in the history table */
+std::string ShrinkTxType(int txType, bool *fundsMoved);
+
+/**
+ * Builds Omni history rows for the wallet's transactions. Lives on a worker
+ * thread so parsing never blocks the GUI. Confirmed transactions are parsed
+ * once per generation; later loads only produce rows for new transactions
+ * and for pending ones that have since confirmed.
+ */
+class OmniHistoryLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OmniHistoryLoader(interfaces::Wallet& wallet);
+
+public Q_SLOTS:
+    /** Loads new and changed rows; a new generation starts from scratch */
+    void load(int generation, unsigned int scope);
+
+Q_SIGNALS:
+    /** Emitted for every batch of rows, newest transactions first */
+    void rowsLoaded(int generation, const HistoryRows& rows);
+    void loadFinished(int generation);
+
+private:
+    bool LoadRow(const uint256& txHash, const std::string& sortKey, HistoryTXObject& htxo);
+
+    interfaces::Wallet& m_wallet;
+    int m_generation;
+    //! Block height of every transaction already handed out, 0 for pending ones
+    std::map<uint256, int> m_loaded;
+};
+
+/**
+ * Qt model of the wallet's Omni transaction history. Rows are appended or
+ * replaced as the loader delivers them; confirmation changes only repaint
+ * the status column.
+ */
+class OmniHistoryTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit OmniHistoryTableModel(QObject *parent = nullptr);
+
+    enum ColumnIndex {
+        Status = 0,
+        Date = 1,
+        Type = 2,
+        Address = 3,
+        Amount = 4
+    };
+
+    enum RoleIndex {
+        /** Transaction hash as hex string */
+        TxHashRole = Qt::UserRole,
+        /** Value the proxy sorts on; status and date sort by block position */
+        SortRole
+    };
+
+    /** @name Methods overridden from QAbstractTableModel
+        @{*/
+    int rowCount(const QModelIndex &parent) const;
+    int columnCount(const QModelIndex &parent) const;
+    QVariant data(const QModelIndex &index, int role) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role) const;
+    Qt::ItemFlags flags(const QModelIndex &index) const;
+    /*@}*/
+
+    void clear();
+    void setChainHeight(int height);
+
+public Q_SLOTS:
+    /** Appends new rows and replaces rows of transactions already shown */
+    void applyRows(const HistoryRows& rows);
+
+private:
+    QVariant statusIcon(const HistoryTXObject& htxo) const;
+
+    HistoryRows m_rows;
+    std::map<uint256, int> m_row_index;
+    int m_chain_height;
+};
+
+#endif // XEP_QT_OMNIHISTORYTABLEMODEL_H
@@ -0,0 +1,163 @@
+// Copyright (c) 2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#if defined(HAVE_CONFIG_H)
+#include <config/xep-config.h>
+#endif
+
+#include <qt/test/omnitablemodeltests.h>
+
+#include <qt/omnibalancestablemodel.h>
+#include <qt/omnihistorytablemodel.h>
+
+#include <uint256.h>
+
+#include <string>
+#include <utility>
+
+#include <QModelIndex>
+#include <QString>
+#include <QVariant>
+
+namespace {
+/** Counts the structural and data changes a model reports to its views */
+struct ModelChanges
+{
+    int reset = 0;
+    int inserted = 0;
+    int removed = 0;
+    int changed = 0;
+    int firstChangedColumn = -1;
+    int lastChangedColumn = -1;
+
+    explicit ModelChanges(QAbstractItemModel& model)
+    {
+        QObject::connect(&model, &QAbstractItemModel::modelReset, [this] { ++reset; });
+        QObject::connect(&model, &QAbstractItemModel::rowsInserted, [this](const QModelIndex&, int first, int last) { inserted += last - first + 1; });
+        QObject::connect(&model, &QAbstractItemModel::rowsRemoved, [this](const QModelIndex&, int first, int last) { removed += last - first + 1; });
+        QObject::connect(&model, &QAbstractItemModel::dataChanged, [this](const QModelIndex& topLeft, const QModelIndex& bottomRight) {
+            changed += bottomRight.row() - topLeft.row() + 1;
+            firstChangedColumn = topLeft.column();
+            lastChangedColumn = bottomRight.column();
+        });
+    }
+
+    void clear() { reset = inserted = removed = changed = 0; firstChangedColumn = lastChangedColumn = -1; }
+};
+
+BalanceRow MakeBalanceRow(const std::string& key, const std::string& available)
+{
+    BalanceRow row;
+    row.key = key;
+    row.label = key;
+    row.name = "Name " + key;
+    row.reserved = "0";
+    row.available = available;
+    return row;
+}
+
+std::pair<uint256, HistoryTXObject> MakeHistoryRow(const std::string& txid, int blockHeight, const std::string& amount)
+{
+    HistoryTXObject htxo;
+    htxo.blockHeight = blockHeight;
+    htxo.valid = true;
+    htxo.txType = "Send";
+    htxo.address = "address";
+    htxo.amount = amount;
+    return std::make_pair(uint256S(txid), htxo);
+}
+
+QString DisplayText(const QAbstractItemModel& model, int row, int column)
+{
+    return model.data(model.index(row, column), Qt::DisplayRole).toString();
+}
+} // namespace
+
+void OmniTableModelTests::balancesModelTests()
+{
+    OmniBalancesTableModel model;
+    ModelChanges changes(model);
+    QCOMPARE(model.headerData(OmniBalancesTableModel::Label, Qt::Horizontal, Qt::DisplayRole).toString(), QString("Property ID"));
+
+    model.applyRows({MakeBalanceRow("1", "10"), MakeBalanceRow("2", "20"), MakeBalanceRow("3", "30")});
+    QCOMPARE(model.rowCount(QModelIndex()), 3);
+    QCOMPARE(changes.inserted, 3);
+    QCOMPARE(DisplayText(model, 1, OmniBalancesTableModel::Available), QString("20"));
+
+    // identical balances leave the model untouched
+    changes.clear();
+    model.applyRows({MakeBalanceRow("1", "10"), MakeBalanceRow("2", "20"), MakeBalanceRow("3", "30")});
+    QCOMPARE(changes.inserted + changes.removed + changes.changed + changes.reset, 0);
+
+    // vanished rows are removed, changed ones updated in place and new ones appended
+    changes.clear();
+    model.applyRows({MakeBalanceRow("1", "10"), MakeBalanceRow("3", "35"), MakeBalanceRow("4", "40")});
+    QCOMPARE(changes.removed, 1);
+    QCOMPARE(changes.changed, 1);
+    QCOMPARE(changes.inserted, 1);
+    QCOMPARE(changes.reset, 0);
+    QCOMPARE(model.rowCount(QModelIndex()), 3);
+    QCOMPARE(DisplayText(model, 0, OmniBalancesTableModel::Label), QString("1"));
+    QCOMPARE(DisplayText(model, 1, OmniBalancesTableModel::Available), QString("35"));
+    QCOMPARE(DisplayText(model, 2, OmniBalancesTableModel::Label), QString("4"));
+
+    // switching to the balances of one property, as on reinitialization, drops all rows
+    changes.clear();
+    model.reset(false);
+    QCOMPARE(changes.reset, 1);
+    QCOMPARE(model.rowCount(QModelIndex()), 0);
+    QCOMPARE(model.headerData(OmniBalancesTableModel::Label, Qt::Horizontal, Qt::DisplayRole).toString(), QString("Label"));
+    model.applyRows({MakeBalanceRow("address", "1")});
+    QCOMPARE(model.rowCount(QModelIndex()), 1);
+}
+
+void OmniTableModelTests::historyModelTests()
+{
+    const std::string txidA = "0000000000000000000000000000000000000000000000000000000000000001";
+    const std::string txidB = "0000000000000000000000000000000000000000000000000000000000000002";
+    const std::string txidC = "0000000000000000000000000000000000000000000000000000000000000003";
+
+    OmniHistoryTableModel model;
+    ModelChanges changes(model);
+    model.setChainHeight(100);
+
+    // rows arrive in batches and are appended
+    model.applyRows({MakeHistoryRow(txidA, 90, "-1"), MakeHistoryRow(txidB, 0, "-2")});
+    model.applyRows({MakeHistoryRow(txidC, 80, "3")});
+    QCOMPARE(model.rowCount(QModelIndex()), 3);
+    QCOMPARE(changes.inserted, 3);
+    QCOMPARE(model.data(model.index(2, OmniHistoryTableModel::Status), OmniHistoryTableModel::TxHashRole).toString(), QString::fromStdString(txidC));
+    QCOMPARE(DisplayText(model, 1, OmniHistoryTableModel::Date), QString("Unconfirmed"));
+
+    // the pending transaction sorts above the confirmed ones
+    QVERIFY(model.data(model.index(1, OmniHistoryTableModel::Date), OmniHistoryTableModel::SortRole).toString() >
+            model.data(model.index(0, OmniHistoryTableModel::Date), OmniHistoryTableModel::SortRole).toString());
+
+    // once confirmed, the row is replaced in place
+    changes.clear();
+    model.applyRows({MakeHistoryRow(txidB, 101, "-2")});
+    QCOMPARE(changes.inserted, 0);
+    QCOMPARE(changes.changed, 1);
+    QCOMPARE(model.rowCount(QModelIndex()), 3);
+    QVERIFY(DisplayText(model, 1, OmniHistoryTableModel::Date) != QString("Unconfirmed"));
+
+    // a new block only repaints the status column of all rows
+    changes.clear();
+    model.setChainHeight(101);
+    QCOMPARE(changes.changed, 3);
+    QCOMPARE(changes.firstChangedColumn, (int)OmniHistoryTableModel::Status);
+    QCOMPARE(changes.lastChangedColumn, (int)OmniHistoryTableModel::Status);
+    changes.clear();
+    model.setChainHeight(101);
+    QCOMPARE(changes.changed, 0);
+
+    // reinitialization drops all rows, and transactions shown before are appended again
+    changes.clear();
+    model.clear();
+    QCOMPARE(changes.reset, 1);
+    QCOMPARE(model.rowCount(QModelIndex()), 0);
+    model.applyRows({MakeHistoryRow(txidA, 90, "-1")});
+    QCOMPARE(changes.inserted, 1);
+    QCOMPARE(model.rowCount(QModelIndex()), 1);
+}
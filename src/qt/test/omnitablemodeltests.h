@@ -0,0 +1,20 @@
+// Copyright (c) 2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef XEP_QT_TEST_OMNITABLEMODELTESTS_H
+#define XEP_QT_TEST_OMNITABLEMODELTESTS_H
+
+#include <QObject>
+#include <QTest>
+
+class OmniTableModelTests : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void balancesModelTests();
+    void historyModelTests();
+};
+
+#endif // XEP_QT_TEST_OMNITABLEMODELTESTS_H
@@ -16,6 +16,7 @@
 
 #ifdef ENABLE_WALLET
 #include <qt/test/addressbooktests.h>
+#include <qt/test/omnitablemodeltests.h>
 #include <qt/test/wallettests.h>
 #endif // ENABLE_WALLET
 
@@ -95,6 +96,10 @@ int main(int argc, char *argv[])
     if (QTest::qExec(&test6) != 0) {
         fInvalid = true;
     }
+    OmniTableModelTests test7;
+    if (QTest::qExec(&test7) != 0) {
+        fInvalid = true;
+    }
 #endif
 
     return fInvalid;
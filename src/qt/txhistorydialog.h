@@ -6,21 +6,23 @@
 #define XEP_QT_TXHISTORYDIALOG_H
 
 #include <qt/guiutil.h>
+#include <qt/omnihistorytablemodel.h>
 #include <uint256.h>
 
-#include <map>
-
 #include <QDialog>
 
 class ClientModel;
 class WalletModel;
 
 QT_BEGIN_NAMESPACE
+class QDateTime;
 class QMenu;
 class QModelIndex;
 class QPoint;
 class QResizeEvent;
+class QSortFilterProxyModel;
 class QString;
+class QThread;
 class QWidget;
 QT_END_NAMESPACE
 
@@ -28,22 +30,6 @@ namespace Ui {
     class txHistoryDialog;
 }
 
-class HistoryTXObject
-{
-public:
-    HistoryTXObject()
-      : blockHeight(-1), blockByteOffset(0), valid(false), fundsMoved(true) {};
-    int blockHeight; // block transaction was mined in
-    int blockByteOffset; // byte offset the tx is stored in the block (used for ordering multiple txs same block)
-    bool valid; // whether the transaction is valid from an Omni perspective
-    bool fundsMoved; // whether tokens actually moved in this transaction
-    std::string txType; // human readable string containing type
-    std::string address; // the address to be displayed (usually sender or recipient)
-    std::string amount; // string containing formatted amount
-};
-
-typedef std::map<uint256, HistoryTXObject> HistoryMap;
-
 /** Dialog for looking up Master Protocol tokens */
 class TXHistoryDialog : public QDialog
 {
@@ -57,7 +43,6 @@ public:
     void setWalletModel(WalletModel *model);
 
     virtual void resizeEvent(QResizeEvent* event);
-    std::string shrinkTxType(int txType, bool *fundsMoved);
 
 private:
     Ui::txHistoryDialog *ui;
@@ -65,7 +50,15 @@ private:
     WalletModel *walletModel;
     GUIUtil::TableViewLastColumnResizingFixer *borrowedColumnResizingFixer;
     QMenu *contextMenu;
-    HistoryMap txHistoryMap;
+    OmniHistoryTableModel *historyModel;
+    QSortFilterProxyModel *historyProxy;
+    QThread *loaderThread;
+    OmniHistoryLoader *loader;
+    int loadGeneration; // bumped on reinit, so rows of an earlier load are dropped
+    bool loadInProgress;
+    bool reloadRequested;
+
+    QString selectedData(int column, int role) const;
 
 private Q_SLOTS:
     void contextualMenu(const QPoint &point);
@@ -74,9 +67,9 @@ private Q_SLOTS:
     void copyAmount();
     void copyTxID();
     void UpdateHistory();
-    int PopulateHistoryMap();
-    void UpdateConfirmations();
-    void checkSort(int column);
+    void UpdateConfirmations(int count, const QDateTime& blockDate, double nVerificationProgress, bool header);
+    void historyRowsLoaded(int generation, const HistoryRows& rows);
+    void historyLoadFinished(int generation);
 
 public Q_SLOTS:
     void focusTransaction(const uint256& txid);
@@ -86,6 +79,8 @@ Q_SIGNALS:
     void doubleClicked(const QModelIndex& idx);
     // Fired when a message should be reported to the user
     void message(const QString &title, const QString &message, unsigned int style);
+    // Asks the loader thread for new and changed history rows
+    void loadRequested(int generation, unsigned int scope);
 };
 
 #endif // XEP_QT_TXHISTORYDIALOG_H
@@ -13,10 +13,15 @@
 #include <consensus/validation.h>
 #include <core_io.h>
 #include <hash.h>
+#include <memusage.h>
 #include <index/blockfilterindex.h>
+#include <index/coinstatsindex.h>
 #include <node/coinstats.h>
 #include <node/context.h>
 #include <node/utxo_snapshot.h>
+#include <omnicore/consensushash.h>
+#include <omnicore/omnicore.h>
+#include <omnicore/persistence.h>
 #include <policy/feerate.h>
 #include <policy/policy.h>
 #include <policy/rbf.h>
@@ -924,6 +929,29 @@ static UniValue getblock(const JSONRPCRequest& request)
         return strHex;
     }
 
+    if (verbosity >= 2 && request.stream) {
+        // Write the transactions one by one, in place of the transaction ids
+        const UniValue result = blockToJSON(block, tip, pblockindex, false);
+        JSONStreamWriter& stream = *request.stream;
+        stream.BeginObject();
+        for (size_t i = 0; i < result.size(); ++i) {
+            stream.Key(result.getKeys()[i]);
+            if (result.getKeys()[i] != "tx") {
+                stream.Value(result.getValues()[i]);
+                continue;
+            }
+            stream.BeginArray();
+            for (const auto& tx : block.vtx) {
+                UniValue objTx(UniValue::VOBJ);
+                TxToUniv(*tx, uint256(), objTx, true, RPCSerializationFlags());
+                stream.Value(objTx);
+            }
+            stream.EndArray();
+        }
+        stream.EndObject();
+        return NullUniValue;
+    }
+
     return blockToJSON(block, tip, pblockindex, verbosity >= 2);
 }
 
@@ -982,46 +1010,132 @@ static UniValue pruneblockchain(const JSONRPCRequest& request)
     return uint64_t(block->nHeight);
 }
 
+//! Look up a block of the active chain by hash or height
+static const CBlockIndex* ParseHashOrHeight(const UniValue& param) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
+{
+    AssertLockHeld(cs_main);
+
+    if (param.isNum()) {
+        const int height = param.get_int();
+        const int current_tip = ::ChainActive().Height();
+        if (height < 0) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d is negative", height));
+        }
+        if (height > current_tip) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", height, current_tip));
+        }
+
+        return ::ChainActive()[height];
+    } else {
+        const uint256 hash(ParseHashV(param, "hash_or_height"));
+        const CBlockIndex* pindex = LookupBlockIndex(hash);
+        if (!pindex) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+        }
+        if (!::ChainActive().Contains(pindex)) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not in chain %s", Params().NetworkIDString()));
+        }
+        return pindex;
+    }
+}
+
+static CoinStatsHashType ParseHashType(const UniValue& param)
+{
+    const std::string hash_type_input = param.isNull() ? "hash_serialized_2" : param.get_str();
+    if (hash_type_input == "hash_serialized_2") {
+        return CoinStatsHashType::HASH_SERIALIZED;
+    } else if (hash_type_input == "muhash") {
+        return CoinStatsHashType::MUHASH;
+    } else if (hash_type_input == "none") {
+        return CoinStatsHashType::NONE;
+    }
+    throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("%s is not a valid hash_type", hash_type_input));
+}
+
 static UniValue gettxoutsetinfo(const JSONRPCRequest& request)
 {
             RPCHelpMan{"gettxoutsetinfo",
                 "\nReturns statistics about the unspent transaction output set.\n"
-                "Note this call may take some time.\n",
-                {},
+                "Note this call may take some time if you are not using -coinstatsindex.\n",
+                {
+                    {"hash_type", RPCArg::Type::STR, /* default */ "hash_serialized_2", "Which UTXO set hash should be calculated. Options: 'hash_serialized_2' (the legacy algorithm), 'muhash', 'none'."},
+                    {"hash_or_height", RPCArg::Type::NUM, RPCArg::Optional::OMITTED_NAMED_ARG, "The block hash or height of the target height (only available with -coinstatsindex and hash_type 'muhash' or 'none').", "", {"", "string or numeric"}},
+                    {"use_index", RPCArg::Type::BOOL, /* default */ "true", "Use -coinstatsindex, if available."},
+                },
                 RPCResult{
                     RPCResult::Type::OBJ, "", "",
                     {
-                        {RPCResult::Type::NUM, "height", "The current block height (index)"},
-                        {RPCResult::Type::STR_HEX, "bestblock", "The hash of the block at the tip of the chain"},
-                        {RPCResult::Type::NUM, "transactions", "The number of transactions with unspent outputs"},
+                        {RPCResult::Type::NUM, "height", "The block height (index) of the returned statistics"},
+                        {RPCResult::Type::STR_HEX, "bestblock", "The hash of the block at which these statistics are calculated"},
+                        {RPCResult::Type::NUM, "transactions", "The number of transactions with unspent outputs (not available when coinstatsindex is used)"},
                         {RPCResult::Type::NUM, "txouts", "The number of unspent transaction outputs"},
                         {RPCResult::Type::NUM, "bogosize", "A meaningless metric for UTXO set size"},
-                        {RPCResult::Type::STR_HEX, "hash_serialized_2", "The serialized hash"},
-                        {RPCResult::Type::NUM, "disk_size", "The estimated size of the chainstate on disk"},
+                        {RPCResult::Type::STR_HEX, "hash_serialized_2", "The serialized hash (only present if 'hash_serialized_2' hash_type is chosen)"},
+                        {RPCResult::Type::STR_HEX, "muhash", "The MuHash of the UTXO set (only present if 'muhash' hash_type is chosen)"},
+                        {RPCResult::Type::NUM, "disk_size", "The estimated size of the chainstate on disk (not available when coinstatsindex is used)"},
                         {RPCResult::Type::STR_AMOUNT, "total_amount", "The total amount"},
                     }},
                 RPCExamples{
-                    HelpExampleCli("gettxoutsetinfo", "")
-            + HelpExampleRpc("gettxoutsetinfo", "")
+                    HelpExampleCli("gettxoutsetinfo", "") +
+                    HelpExampleCli("gettxoutsetinfo", R"("none")") +
+                    HelpExampleCli("gettxoutsetinfo", R"("none" 1000)") +
+                    HelpExampleCli("gettxoutsetinfo", R"("muhash" '"00000000c937983704a73af28acdec37b049d214adbda81d7e2a3dd146f6ed09"')") +
+                    HelpExampleRpc("gettxoutsetinfo", "")
                 },
             }.Check(request);
 
     UniValue ret(UniValue::VOBJ);
 
-    CCoinsStats stats;
-    ::ChainstateActive().ForceFlushStateToDisk();
+    const CoinStatsHashType hash_type = ParseHashType(request.params[0]);
+    const bool use_index = request.params[2].isNull() ? true : request.params[2].get_bool();
+    CCoinsStats stats(hash_type, use_index);
+
+    const CBlockIndex* pindex = nullptr;
+    if (!request.params[1].isNull()) {
+        if (!g_coin_stats_index) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Querying specific block heights requires coinstatsindex");
+        }
+        if (hash_type == CoinStatsHashType::HASH_SERIALIZED) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "hash_serialized_2 hash type cannot be queried for a specific block");
+        }
+        if (!use_index) {
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Querying specific block heights requires use_index");
+        }
+        if (!g_coin_stats_index->BlockUntilSyncedToCurrentChain()) {
+            throw JSONRPCError(RPC_MISC_ERROR, "coinstatsindex is still being built, try again later");
+        }
+        LOCK(cs_main);
+        pindex = ParseHashOrHeight(request.params[1]);
+    } else if (use_index && hash_type != CoinStatsHashType::HASH_SERIALIZED &&
+               g_coin_stats_index && g_coin_stats_index->BlockUntilSyncedToCurrentChain()) {
+        pindex = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+    } else {
+        // The statistics are computed by scanning the chainstate, which has to be on disk.
+        ::ChainstateActive().ForceFlushStateToDisk();
+    }
 
     CCoinsView* coins_view = WITH_LOCK(cs_main, return &ChainstateActive().CoinsDB());
-    if (GetUTXOStats(coins_view, stats)) {
+    if (GetUTXOStats(coins_view, stats, pindex)) {
         ret.pushKV("height", (int64_t)stats.nHeight);
         ret.pushKV("bestblock", stats.hashBlock.GetHex());
-        ret.pushKV("transactions", (int64_t)stats.nTransactions);
+        if (!stats.index_used) {
+            ret.pushKV("transactions", (int64_t)stats.nTransactions);
+        }
         ret.pushKV("txouts", (int64_t)stats.nTransactionOutputs);
         ret.pushKV("bogosize", (int64_t)stats.nBogoSize);
-        ret.pushKV("hash_serialized_2", stats.hashSerialized.GetHex());
-        ret.pushKV("disk_size", stats.nDiskSize);
+        if (hash_type == CoinStatsHashType::HASH_SERIALIZED) {
+            ret.pushKV("hash_serialized_2", stats.hashSerialized.GetHex());
+        } else if (hash_type == CoinStatsHashType::MUHASH) {
+            ret.pushKV("muhash", stats.hashSerialized.GetHex());
+        }
+        if (!stats.index_used) {
+            ret.pushKV("disk_size", stats.nDiskSize);
+        }
         ret.pushKV("total_amount", ValueFromAmount(stats.nTotalAmount));
     } else {
+        if (stats.index_used) {
+            throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set statistics from coinstatsindex");
+        }
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Unable to read UTXO set");
     }
     return ret;
@@ -1409,6 +1523,49 @@ static UniValue getchaintips(const JSONRPCRequest& request)
     return res;
 }
 
+static UniValue getblockindexinfo(const JSONRPCRequest& request)
+{
+            RPCHelpMan{"getblockindexinfo",
+                "\nReturns the memory used by the block index.\n"
+                "Proof-of-stake data, which is rarely needed, is not held by the index entries, but read from the\n"
+                "block tree database. Only changes, which are not yet written, are kept in memory as cold entries.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::NUM, "entries", "The number of block index entries"},
+                        {RPCResult::Type::NUM, "entry_size", "The size of a block index entry in bytes"},
+                        {RPCResult::Type::NUM, "usage", "The memory used by the block index entries and their map in bytes"},
+                        {RPCResult::Type::NUM, "cold_entries", "The number of entries with cold data, which is not yet written to the database"},
+                        {RPCResult::Type::NUM, "cold_usage", "The memory used by the cold entries in bytes"},
+                        {RPCResult::Type::NUM, "total_usage", "The total memory used by the block index in bytes"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getblockindexinfo", "")
+            + HelpExampleRpc("getblockindexinfo", "")
+                },
+            }.Check(request);
+
+    size_t nEntries;
+    size_t nUsage;
+    {
+        LOCK(cs_main);
+        const BlockMap& blockIndex = ::BlockIndex();
+        nEntries = blockIndex.size();
+        nUsage = memusage::DynamicUsage(blockIndex) + nEntries * memusage::MallocUsage(sizeof(CBlockIndex));
+    }
+    const size_t nColdUsage = g_blockindex_cold.DynamicMemoryUsage();
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("entries", (uint64_t) nEntries);
+    obj.pushKV("entry_size", (uint64_t) sizeof(CBlockIndex));
+    obj.pushKV("usage", (uint64_t) nUsage);
+    obj.pushKV("cold_entries", (uint64_t) g_blockindex_cold.Size());
+    obj.pushKV("cold_usage", (uint64_t) nColdUsage);
+    obj.pushKV("total_usage", (uint64_t) (nUsage + nColdUsage));
+    return obj;
+}
+
 UniValue MempoolInfoToJSON(const CTxMemPool& pool)
 {
     // Make sure this call is atomic in the pool.
@@ -1758,29 +1915,7 @@ static UniValue getblockstats(const JSONRPCRequest& request)
 
     LOCK(cs_main);
 
-    CBlockIndex* pindex;
-    if (request.params[0].isNum()) {
-        const int height = request.params[0].get_int();
-        const int current_tip = ::ChainActive().Height();
-        if (height < 0) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d is negative", height));
-        }
-        if (height > current_tip) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Target block height %d after current tip %d", height, current_tip));
-        }
-
-        pindex = ::ChainActive()[height];
-    } else {
-        const uint256 hash(ParseHashV(request.params[0], "hash_or_height"));
-        pindex = LookupBlockIndex(hash);
-        if (!pindex) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
-        }
-        if (!::ChainActive().Contains(pindex)) {
-            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Block is not in chain %s", Params().NetworkIDString()));
-        }
-    }
-
+    const CBlockIndex* pindex = ParseHashOrHeight(request.params[0]);
     CHECK_NONFATAL(pindex != nullptr);
 
     std::set<std::string> stats;
@@ -2280,6 +2415,7 @@ UniValue dumptxoutset(const JSONRPCRequest& request)
                 RPCArg::Optional::NO,
                 /* default_val */ "",
                 "path to the output file. If relative, will be prefixed by datadir."},
+            {"include_omni", RPCArg::Type::BOOL, /* default */ "false", "append the Omni state of the base block to the snapshot"},
         },
         RPCResult{
             RPCResult::Type::OBJ, "", "",
@@ -2287,14 +2423,18 @@ UniValue dumptxoutset(const JSONRPCRequest& request)
                     {RPCResult::Type::NUM, "coins_written", "the number of coins written in the snapshot"},
                     {RPCResult::Type::STR_HEX, "base_hash", "the hash of the base of the snapshot"},
                     {RPCResult::Type::NUM, "base_height", "the height of the base of the snapshot"},
+                    {RPCResult::Type::STR_HEX, "omni_consensus_hash", /* optional */ true, "the consensus hash of the included Omni state"},
                     {RPCResult::Type::STR, "path", "the absolute path that the snapshot was written to"},
                 }
         },
         RPCExamples{
             HelpExampleCli("dumptxoutset", "utxo.dat")
+    + HelpExampleCli("dumptxoutset", "utxo.dat true")
         }
     }.Check(request);
 
+    const bool fIncludeOmni = !request.params[1].isNull() && request.params[1].get_bool();
+
     fs::path path = fs::absolute(request.params[0].get_str(), GetDataDir());
     // Write to a temporary path and then move into `path` on completion
     // to avoid confusion due to an interruption.
@@ -2310,6 +2450,7 @@ UniValue dumptxoutset(const JSONRPCRequest& request)
     FILE* file{fsbridge::fopen(temppath, "wb")};
     CAutoFile afile{file, SER_DISK, CLIENT_VERSION};
     std::unique_ptr<CCoinsViewCursor> pcursor;
+    std::unique_ptr<OmniStateSnapshot> omniState;
     CCoinsStats stats;
     CBlockIndex* tip;
 
@@ -2337,6 +2478,12 @@ UniValue dumptxoutset(const JSONRPCRequest& request)
         pcursor = std::unique_ptr<CCoinsViewCursor>(::ChainstateActive().CoinsDB().Cursor());
         tip = LookupBlockIndex(stats.hashBlock);
         CHECK_NONFATAL(tip);
+
+        // Omni state is only updated while cs_main is held, so it belongs to the same block
+        if (fIncludeOmni) {
+            LOCK(cs_tally);
+            omniState = CaptureStateSnapshot(tip);
+        }
     }
 
     SnapshotMetadata metadata{tip->GetBlockHash(), stats.coins_count, tip->nChainTx};
@@ -2360,6 +2507,10 @@ UniValue dumptxoutset(const JSONRPCRequest& request)
         pcursor->Next();
     }
 
+    if (omniState) {
+        WriteStateSnapshot(afile, *omniState);
+    }
+
     afile.fclose();
     fs::rename(temppath, path);
 
@@ -2367,10 +2518,121 @@ UniValue dumptxoutset(const JSONRPCRequest& request)
     result.pushKV("coins_written", stats.coins_count);
     result.pushKV("base_hash", tip->GetBlockHash().ToString());
     result.pushKV("base_height", tip->nHeight);
+    if (omniState) {
+        result.pushKV("omni_consensus_hash", omniState->consensusHash.GetHex());
+    }
     result.pushKV("path", path.string());
     return result;
 }
 
+/**
+ * Load the Omni state of a UTXO snapshot, written by dumptxoutset.
+ *
+ * Unlike an assumeutxo snapshot, the coins aren't loaded into a chainstate: the
+ * node must already have the base block in its active chain.
+ *
+ * @see SnapshotMetadata
+ */
+UniValue loadomnistatesnapshot(const JSONRPCRequest& request)
+{
+    RPCHelpMan{
+        "loadomnistatesnapshot",
+        "\nLoad the Omni state from a snapshot written by dumptxoutset with include_omni.\n"
+        "\nOnly the Omni state is loaded, no chainstate is created from the coins of the snapshot. The base block\n"
+        "of the snapshot must already be part of the active chain, so the node has to be synced up to it first.\n"
+        "The coins are only checked against the snapshot metadata. The Omni state of the snapshot must have the\n"
+        "expected consensus hash, as reported by dumptxoutset on a trusted node, and match the consensus checkpoint\n"
+        "of the base block, if there is one. Otherwise the current Omni state is kept.\n"
+        "The Omni state replaces the current one and is brought up to the tip afterwards, so no full reparse of\n"
+        "Omni transactions is needed. If the state can't be restored, all Omni state is cleared and reparsed with\n"
+        "the next block.\n",
+        {
+            {"path",
+                RPCArg::Type::STR,
+                RPCArg::Optional::NO,
+                /* default_val */ "",
+                "path to the snapshot file. If relative, will be prefixed by datadir."},
+            {"omni_consensus_hash", RPCArg::Type::STR_HEX, RPCArg::Optional::NO, "the expected consensus hash of the Omni state of the snapshot"},
+        },
+        RPCResult{
+            RPCResult::Type::OBJ, "", "",
+                {
+                    {RPCResult::Type::NUM, "coins_read", "the number of coins in the snapshot"},
+                    {RPCResult::Type::STR_HEX, "base_hash", "the hash of the base of the snapshot"},
+                    {RPCResult::Type::NUM, "base_height", "the height of the base of the snapshot"},
+                    {RPCResult::Type::STR_HEX, "omni_consensus_hash", "the consensus hash of the Omni state at the tip"},
+                }
+        },
+        RPCExamples{
+            HelpExampleCli("loadomnistatesnapshot", "utxo.dat \"8a1ca48c6ad1ba0e0a5a4c1cb9e2a4e4d7bb1b7ea4a2cd4d1e8ac3c6b6f0e1d2\"")
+        }
+    }.Check(request);
+
+    const uint256 expectedConsensusHash = ParseHashV(request.params[1], "omni_consensus_hash");
+
+    fs::path path = fs::absolute(request.params[0].get_str(), GetDataDir());
+    FILE* file{fsbridge::fopen(path, "rb")};
+    CAutoFile afile{file, SER_DISK, CLIENT_VERSION};
+    if (afile.IsNull()) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Couldn't open file " + path.string() + " for reading");
+    }
+
+    SnapshotMetadata metadata;
+    afile >> metadata;
+
+    const CBlockIndex* pindexBase;
+    {
+        LOCK(cs_main);
+        pindexBase = LookupBlockIndex(metadata.m_base_blockhash);
+        if (!pindexBase) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Base block of the snapshot not found");
+        }
+        if (!::ChainActive().Contains(pindexBase)) {
+            throw JSONRPCError(RPC_MISC_ERROR, "Base block of the snapshot is not in the active chain");
+        }
+        if (metadata.m_nchaintx != pindexBase->nChainTx) {
+            throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Snapshot does not match the transaction count of its base block");
+        }
+    }
+
+    COutPoint key;
+    Coin coin;
+    for (uint64_t i = 0; i < metadata.m_coins_count; ++i) {
+        if (i % 5000 == 0 && !IsRPCRunning()) {
+            throw JSONRPCError(RPC_CLIENT_NOT_CONNECTED, "Shutting down");
+        }
+        try {
+            afile >> key;
+            afile >> coin;
+        } catch (const std::ios_base::failure&) {
+            throw JSONRPCError(RPC_DESERIALIZATION_ERROR, strprintf("Snapshot ends after %d of %d coins", i, metadata.m_coins_count));
+        }
+        if (coin.nHeight > (uint32_t)pindexBase->nHeight) {
+            throw JSONRPCError(RPC_DESERIALIZATION_ERROR, "Snapshot contains a coin above its base block");
+        }
+    }
+
+    // Omni state is only updated while cs_main is held, so no block is connected in between
+    LOCK(cs_main);
+    if (!::ChainActive().Contains(pindexBase)) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Base block of the snapshot is no longer in the active chain");
+    }
+    std::string strError;
+    if (!mastercore_load_state_snapshot(afile, pindexBase, expectedConsensusHash, strError)) {
+        throw JSONRPCError(RPC_MISC_ERROR, strError);
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.pushKV("coins_read", metadata.m_coins_count);
+    result.pushKV("base_hash", pindexBase->GetBlockHash().ToString());
+    result.pushKV("base_height", pindexBase->nHeight);
+    {
+        LOCK(cs_tally);
+        result.pushKV("omni_consensus_hash", mastercore::GetConsensusHash().GetHex());
+    }
+    return result;
+}
+
 void RegisterBlockchainRPCCommands(CRPCTable &t)
 {
 // clang-format off
@@ -2386,6 +2648,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getblockhash",           &getblockhash,           {"height"} },
     { "blockchain",         "getblockheader",         &getblockheader,         {"blockhash","verbose"} },
     { "blockchain",         "getchaintips",           &getchaintips,           {} },
+    { "blockchain",         "getblockindexinfo",      &getblockindexinfo,      {} },
     { "blockchain",         "getdifficulty",          &getdifficulty,          {} },
     { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    {"txid","verbose"} },
     { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  {"txid","verbose"} },
@@ -2394,7 +2657,7 @@ static const CRPCCommand commands[] =
     { "blockchain",         "clearmempool",           &clearmempool,           {} },
     { "blockchain",         "getrawmempool",          &getrawmempool,          {"verbose"} },
     { "blockchain",         "gettxout",               &gettxout,               {"txid","n","include_mempool"} },
-    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {} },
+    { "blockchain",         "gettxoutsetinfo",        &gettxoutsetinfo,        {"hash_type", "hash_or_height", "use_index"} },
     { "blockchain",         "pruneblockchain",        &pruneblockchain,        {"height"} },
     { "blockchain",         "savemempool",            &savemempool,            {} },
     { "blockchain",         "verifychain",            &verifychain,            {"checklevel","nblocks"} },
@@ -2410,7 +2673,8 @@ static const CRPCCommand commands[] =
     { "hidden",             "waitforblock",           &waitforblock,           {"blockhash","timeout"} },
     { "hidden",             "waitforblockheight",     &waitforblockheight,     {"height","timeout"} },
     { "hidden",             "syncwithvalidationinterfacequeue", &syncwithvalidationinterfacequeue, {} },
-    { "hidden",             "dumptxoutset",           &dumptxoutset,           {"path"} },
+    { "hidden",             "dumptxoutset",           &dumptxoutset,           {"path", "include_omni"} },
+    { "hidden",             "loadomnistatesnapshot",  &loadomnistatesnapshot,  {"path", "omni_consensus_hash"} },
 };
 // clang-format on
 
@@ -73,6 +73,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "sendmany", 6 , "conf_target" },
     { "deriveaddresses", 1, "range" },
     { "scantxoutset", 1, "scanobjects" },
+    { "dumptxoutset", 1, "include_omni" },
     { "addmultisigaddress", 0, "nrequired" },
     { "addmultisigaddress", 1, "keys" },
     { "createmultisig", 0, "nrequired" },
@@ -136,6 +137,8 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "verifychain", 1, "nblocks" },
     { "getblockstats", 0, "hash_or_height" },
     { "getblockstats", 1, "stats" },
+    { "gettxoutsetinfo", 1, "hash_or_height" },
+    { "gettxoutsetinfo", 2, "use_index" },
     { "pruneblockchain", 0, "height" },
     { "keypoolrefill", 0, "newsize" },
     { "getrawmempool", 0, "verbose" },
@@ -194,12 +197,14 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "omni_getcrowdsale", 1, "verbose" },
     { "omni_getgrants", 0, "propertyid" },
     { "omni_getbalance", 1, "propertyid" },
+    { "omni_getbalance", 2, "includepending" },
     { "omni_getproperty", 0, "propertyid" },
     { "omni_listtransactions", 1, "count" },
     { "omni_listtransactions", 2, "skip" },
     { "omni_listtransactions", 3, "startblock" },
     { "omni_listtransactions", 4, "endblock" },
     { "omni_getallbalancesforid", 0, "propertyid" },
+    { "omni_getbalancesbatch", 0, "requests" },
     { "omni_listblocktransactions", 0, "index" },
     { "omni_listblockstransactions", 0, "firstblock" },
     { "omni_listblockstransactions", 1, "lastblock" },
@@ -230,6 +235,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "omni_sendall", 2, "ecosystem" },
     { "omni_sendtomany", 1, "propertyid" },
     { "omni_sendtomany", 2, "mapping" },
+    { "omni_sendpayouts", 1, "payouts" },
     { "omni_sendtrade", 1, "propertyidforsale" },
     { "omni_sendtrade", 3, "propertiddesired" },
     { "omni_sendcanceltradesbyprice", 1, "propertyidforsale" },
@@ -290,6 +296,9 @@ static const CRPCConvertParam vRPCConvertParams[] =
     /* Omni Core - raw transaction calls */
     { "omni_decodetransaction", 1, "prevtxs" },
     { "omni_decodetransaction", 2, "height" },
+    { "omni_decodetransactions", 0, "rawtxs" },
+    { "omni_decodetransactions", 1, "prevtxs" },
+    { "omni_decodetransactions", 2, "height" },
     { "omni_createrawtx_input", 2, "n" },
     { "omni_createrawtx_change", 1, "prevtxs" },
     { "omni_createrawtx_change", 3, "fee" },
@@ -350,6 +359,7 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "getgrants_MP", 0, "propertyid" },
     { "send_MP", 2, "propertyid" },
     { "getbalance_MP", 1, "propertyid" },
+    { "getbalance_MP", 2, "includepending" },
     { "sendtoowners_MP", 1, "propertyid" },
     { "sendtoowners_MP", 4, "distributionproperty" },
     { "getproperty_MP", 0, "propertyid" },
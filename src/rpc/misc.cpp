@@ -4,6 +4,10 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <httpserver.h>
+#include <index/addressindex.h>
+#include <index/blockfilterindex.h>
+#include <index/coinstatsindex.h>
+#include <index/txindex.h>
 #include <key_io.h>
 #include <node/context.h>
 #include <outputtype.h>
@@ -22,6 +26,7 @@
 #include <txmempool.h>
 
 #include <stdint.h>
+#include <limits>
 #include <tuple>
 #ifdef HAVE_MALLOC_INFO
 #include <malloc.h>
@@ -118,6 +123,17 @@ bool timestampSort(std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> a,
     return a.second.time < b.second.time;
 }
 
+/** Throws, if the address index is not enabled or still being built. */
+static void EnsureAddressIndexSynced()
+{
+    if (!fAddressIndex || !g_addressindex) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index not enabled");
+    }
+    if (!g_addressindex->BlockUntilSyncedToCurrentChain()) {
+        throw JSONRPCError(RPC_MISC_ERROR, "Address index is still being built, try again later");
+    }
+}
+
 bool getAddressFromIndex(const int &type, const uint256 &hash, std::string &address)
 {
     if (type == 2) {
@@ -177,9 +193,7 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         },
     }.Check(request);
 
-    if (!fAddressIndex) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Address index not enabled");
-    }
+    EnsureAddressIndexSynced();
 
     UniValue startValue = find_value(request.params[0].get_obj(), "start");
     UniValue endValue = find_value(request.params[0].get_obj(), "end");
@@ -297,9 +311,7 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         },
     }.Check(request);
 
-    if (!fAddressIndex) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Address index not enabled");
-    }
+    EnsureAddressIndexSynced();
 
     std::vector<std::pair<uint256, int> > addresses;
 
@@ -307,25 +319,38 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    CAmount balance = 0;
+    CAmount received = 0;
+    CAmount immature = 0;
+
+    const int nHeight = WITH_LOCK(cs_main, return ::ChainActive().Height());
+    // only coinbase outputs of the last COINBASE_MATURITY blocks can be immature
+    const int nImmatureStart = nHeight - COINBASE_MATURITY + 1;
 
     for (std::vector<std::pair<uint256, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
+        CAmount addressBalance = 0;
+        CAmount addressReceived = 0;
+        if (!GetAddressBalance((*it).first, (*it).second, addressBalance, addressReceived)) {
             throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
-    }
+        balance += addressBalance;
+        received += addressReceived;
 
-    CAmount balance = 0;
-    CAmount received = 0;
-    CAmount immature = 0;
+        std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+        if (nImmatureStart > 0) {
+            if (!GetAddressIndex((*it).first, (*it).second, addressIndex, nImmatureStart, std::numeric_limits<int>::max())) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+        } else {
+            if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+        }
 
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
+        for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator itIndex = addressIndex.begin(); itIndex != addressIndex.end(); itIndex++) {
+            if (itIndex->first.txindex == 0 && ((nHeight - itIndex->first.blockHeight) < COINBASE_MATURITY))
+                immature += itIndex->second;
         }
-        balance += it->second;
-        if (it->first.txindex == 0 && ((::ChainActive().Height() - it->first.blockHeight) < COINBASE_MATURITY))
-            immature += it->second;
     }
 
     UniValue result(UniValue::VOBJ);
@@ -375,9 +400,7 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         },
     }.Check(request);
 
-    if (!fAddressIndex) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Address index not enabled");
-    }
+    EnsureAddressIndexSynced();
 
     bool includeChainInfo = false;
     if (request.params[0].isObject()) {
@@ -539,9 +562,7 @@ UniValue getblockhashes(const JSONRPCRequest& request)
         },
     }.Check(request);
 
-    if (!fAddressIndex) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Address index not enabled");
-    }
+    EnsureAddressIndexSynced();
 
     unsigned int high = request.params[0].get_int();
     unsigned int low = request.params[1].get_int();
@@ -609,9 +630,7 @@ UniValue getspentinfo(const JSONRPCRequest& request)
         },
     }.Check(request);
 
-    if (!fAddressIndex) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Address index not enabled");
-    }
+    EnsureAddressIndexSynced();
 
     UniValue txidValue = find_value(request.params[0].get_obj(), "txid");
     UniValue indexValue = find_value(request.params[0].get_obj(), "index");
@@ -670,9 +689,7 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         },
     }.Check(request);
 
-    if (!fAddressIndex) {
-        throw JSONRPCError(RPC_MISC_ERROR, "Address index not enabled");
-    }
+    EnsureAddressIndexSynced();
 
     std::vector<std::pair<uint256, int> > addresses;
 
@@ -1250,6 +1267,90 @@ static UniValue echo(const JSONRPCRequest& request)
     return request.params;
 }
 
+static UniValue SummaryToJSON(const IndexSummary&& summary, std::string index_name)
+{
+    UniValue ret_summary(UniValue::VOBJ);
+    if (!index_name.empty() && index_name != summary.name) return ret_summary;
+
+    UniValue entry(UniValue::VOBJ);
+    entry.pushKV("synced", summary.synced);
+    entry.pushKV("best_block_height", summary.best_block_height);
+    ret_summary.pushKV(summary.name, entry);
+    return ret_summary;
+}
+
+static UniValue getindexinfo(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"getindexinfo",
+                "\nReturns the status of one or all available indices currently running in the node.\n",
+                {
+                    {"index_name", RPCArg::Type::STR, RPCArg::Optional::OMITTED_NAMED_ARG, "Filter results for an index with a specific name."},
+                },
+                RPCResult{
+                    RPCResult::Type::OBJ_DYN, "", "", {
+                        {
+                            RPCResult::Type::OBJ, "name", "The name of the index",
+                            {
+                                {RPCResult::Type::BOOL, "synced", "Whether the index is synced or not"},
+                                {RPCResult::Type::NUM, "best_block_height", "The block height to which the index is synced"},
+                                {RPCResult::Type::OBJ, "cache", /* optional */ true, "Statistics of the in-memory transaction cache (txindex only)",
+                                {
+                                    {RPCResult::Type::NUM, "hits", "Number of lookups served from the cache"},
+                                    {RPCResult::Type::NUM, "misses", "Number of lookups that had to read the block files"},
+                                    {RPCResult::Type::NUM, "hitrate", "Fraction of lookups served from the cache"},
+                                    {RPCResult::Type::NUM, "entries", "Number of cached transactions"},
+                                    {RPCResult::Type::NUM, "usage", "Memory usage of the cache in bytes"},
+                                    {RPCResult::Type::NUM, "maxusage", "Maximum memory usage of the cache in bytes (-txcachesize)"},
+                                }},
+                            }
+                        },
+                    },
+                },
+                RPCExamples{
+                    HelpExampleCli("getindexinfo", "")
+                  + HelpExampleRpc("getindexinfo", "")
+                  + HelpExampleCli("getindexinfo", "txindex")
+                  + HelpExampleRpc("getindexinfo", "txindex")
+                },
+            }.Check(request);
+
+    UniValue result(UniValue::VOBJ);
+    const std::string index_name = request.params[0].isNull() ? "" : request.params[0].get_str();
+
+    if (g_txindex) {
+        UniValue summary = SummaryToJSON(g_txindex->GetSummary(), index_name);
+        if (!summary.empty()) {
+            const TxCacheStats stats = g_txindex->GetCacheStats();
+            const uint64_t lookups = stats.hits + stats.misses;
+            UniValue cache(UniValue::VOBJ);
+            cache.pushKV("hits", stats.hits);
+            cache.pushKV("misses", stats.misses);
+            cache.pushKV("hitrate", lookups > 0 ? (double)stats.hits / lookups : 0.0);
+            cache.pushKV("entries", (uint64_t)stats.entries);
+            cache.pushKV("usage", (uint64_t)stats.usage);
+            cache.pushKV("maxusage", (uint64_t)stats.max_usage);
+            UniValue entry = find_value(summary, "txindex");
+            entry.pushKV("cache", cache);
+            summary.pushKV("txindex", entry);
+        }
+        result.pushKVs(summary);
+    }
+
+    if (g_addressindex) {
+        result.pushKVs(SummaryToJSON(g_addressindex->GetSummary(), index_name));
+    }
+
+    if (g_coin_stats_index) {
+        result.pushKVs(SummaryToJSON(g_coin_stats_index->GetSummary(), index_name));
+    }
+
+    ForEachBlockFilterIndex([&result, &index_name](const BlockFilterIndex& index) {
+        result.pushKVs(SummaryToJSON(index.GetSummary(), index_name));
+    });
+
+    return result;
+}
+
 void RegisterMiscRPCCommands(CRPCTable &t)
 {
 // clang-format off
@@ -1264,6 +1365,7 @@ static const CRPCCommand commands[] =
     { "util",               "getdescriptorinfo",      &getdescriptorinfo,      {"descriptor"} },
     { "util",               "verifymessage",          &verifymessage,          {"address","signature","message"} },
     { "util",               "signmessagewithprivkey", &signmessagewithprivkey, {"privkey","message"} },
+    { "util",               "getindexinfo",           &getindexinfo,           {"index_name"} },
 
     /* Not shown in help */
     { "hidden",             "setmocktime",            &setmocktime,            {"timestamp"}},
@@ -12,6 +12,8 @@
 #include <util/system.h>
 #include <util/strencodings.h>
 
+#include <assert.h>
+
 /**
  * JSON-RPC protocol.  Xep speaks version 1.0 for maximum compatibility,
  * but uses JSON-RPC 1.1/2.0 standards for parts of the 1.0 standard that were
@@ -56,6 +58,94 @@ UniValue JSONRPCError(int code, const std::string& message)
     return error;
 }
 
+void JSONStreamWriter::Separate()
+{
+    if (fAfterKey) {
+        fAfterKey = false;
+    } else if (fNeedComma) {
+        strBuffer += ',';
+    }
+}
+
+void JSONStreamWriter::Written()
+{
+    fOutput = true;
+    fNeedComma = true;
+    if (strBuffer.size() >= nChunkSize) {
+        Flush();
+    }
+}
+
+void JSONStreamWriter::BeginObject()
+{
+    Separate();
+    strBuffer += '{';
+    vOpen.push_back('}');
+    fOutput = true;
+    fNeedComma = false;
+}
+
+void JSONStreamWriter::EndObject()
+{
+    assert(!vOpen.empty() && vOpen.back() == '}' && !fAfterKey);
+    strBuffer += vOpen.back();
+    vOpen.pop_back();
+    Written();
+}
+
+void JSONStreamWriter::BeginArray()
+{
+    Separate();
+    strBuffer += '[';
+    vOpen.push_back(']');
+    fOutput = true;
+    fNeedComma = false;
+}
+
+void JSONStreamWriter::EndArray()
+{
+    assert(!vOpen.empty() && vOpen.back() == ']');
+    strBuffer += vOpen.back();
+    vOpen.pop_back();
+    Written();
+}
+
+void JSONStreamWriter::Key(const std::string& key)
+{
+    assert(!vOpen.empty() && vOpen.back() == '}' && !fAfterKey);
+    Separate();
+    strBuffer += UniValue(key).write();
+    strBuffer += ':';
+    fOutput = true;
+    fAfterKey = true;
+}
+
+void JSONStreamWriter::Value(const UniValue& value)
+{
+    Separate();
+    strBuffer += value.write();
+    Written();
+}
+
+void JSONStreamWriter::Close()
+{
+    if (fAfterKey) {
+        Value(NullUniValue);
+    }
+    while (!vOpen.empty()) {
+        strBuffer += vOpen.back();
+        vOpen.pop_back();
+        Written();
+    }
+}
+
+void JSONStreamWriter::Flush()
+{
+    if (strBuffer.empty()) return;
+    sink(strBuffer);
+    strBuffer.clear();
+}
+
 /** Username used when cookie authentication is in use (arbitrary, only for
  * recognizability in debugging/logging purposes)
  */
@@ -6,7 +6,9 @@
 #ifndef XEP_RPC_REQUEST_H
 #define XEP_RPC_REQUEST_H
 
+#include <functional>
 #include <string>
+#include <vector>
 
 #include <univalue.h>
 
@@ -24,6 +26,50 @@ void DeleteAuthCookie();
 /** Parse JSON-RPC batch reply into a vector */
 std::vector<UniValue> JSONRPCProcessBatchReply(const UniValue &in, size_t num);
 
+/**
+ * Writes a JSON value piece by piece, so that large results don't have to be built in memory as a whole.
+ *
+ * Output is collected in a buffer, which is handed to the sink, once it exceeds the chunk size.
+ * Chunks always end on a token boundary.
+ */
+class JSONStreamWriter
+{
+public:
+    typedef std::function<void(const std::string&)> Sink;
+
+    static const size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    explicit JSONStreamWriter(const Sink& sinkIn, size_t nChunkSizeIn = DEFAULT_CHUNK_SIZE) : sink(sinkIn), nChunkSize(nChunkSizeIn) {}
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+    /** Writes the key of the next object member */
+    void Key(const std::string& key);
+    /** Writes a complete value, as array element or object member */
+    void Value(const UniValue& value);
+    /** Closes all open arrays and objects, for example after an error */
+    void Close();
+    /** Hands all buffered output to the sink */
+    void Flush();
+    /** Whether anything was written so far */
+    bool HasOutput() const { return fOutput; }
+
+private:
+    Sink sink;
+    size_t nChunkSize;
+    std::string strBuffer;
+    //! Open arrays and objects, innermost last
+    std::vector<char> vOpen;
+    bool fOutput{false};
+    bool fNeedComma{false};
+    bool fAfterKey{false};
+
+    void Separate();
+    void Written();
+};
+
 class JSONRPCRequest
 {
 public:
@@ -34,8 +80,10 @@ public:
     std::string URI;
     std::string authUser;
     std::string peerAddr;
+    //! Set, if the caller accepts results written to a stream instead of returned by the handler
+    JSONStreamWriter* stream;
 
-    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false) {}
+    JSONRPCRequest() : id(NullUniValue), params(NullUniValue), fHelp(false), stream(nullptr) {}
     void parse(const UniValue& valRequest);
 };
 
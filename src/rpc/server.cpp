@@ -15,6 +15,9 @@
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <memory> // for unique_ptr
 #include <unordered_map>
 
@@ -360,11 +363,70 @@ static UniValue JSONRPCExecOne(JSONRPCRequest jreq, const UniValue& req)
     return rpc_result;
 }
 
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq)
+namespace {
+/**
+ * State of a batch request, whose elements are claimed one by one by the executing threads.
+ * Helpers may still run after the batch was answered, so the request is held by value.
+ */
+struct BatchExecution
 {
+    JSONRPCRequest jreq;
+    const std::vector<UniValue> vReq;
+    std::vector<UniValue> vReplies;
+    std::atomic<unsigned int> nNext{0};
+
+    Mutex cs;
+    std::condition_variable cond;
+    unsigned int nDone GUARDED_BY(cs){0};
+
+    BatchExecution(const JSONRPCRequest& jreqIn, const UniValue& vReqIn) : jreq(jreqIn), vReq(vReqIn.getValues()), vReplies(vReqIn.size())
+    {
+        // replies of batch elements are collected, not streamed
+        jreq.stream = nullptr;
+    }
+
+    /** Executes elements, until all are claimed. */
+    void Run()
+    {
+        unsigned int reqIdx;
+        while ((reqIdx = nNext++) < vReq.size()) {
+            int64_t nTimeStart = GetTimeMicros();
+            vReplies[reqIdx] = JSONRPCExecOne(jreq, vReq[reqIdx]);
+            if (LogAcceptCategory(BCLog::RPC)) {
+                const UniValue& method = find_value(vReq[reqIdx], "method");
+                LogPrint(BCLog::RPC, "Batch element %u/%u (%s) done in %.2fms\n", reqIdx + 1, vReq.size(), method.isStr() ? method.get_str() : "?", 0.001 * (GetTimeMicros() - nTimeStart));
+            }
+
+            LOCK(cs);
+            if (++nDone == vReq.size()) {
+                cond.notify_all();
+            }
+        }
+    }
+};
+} // namespace
+
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const RPCTaskRunner& runner, unsigned int nThreads)
+{
+    // Helpers hold a reference to the state, in case they run only after the batch is done
+    std::shared_ptr<BatchExecution> batch = std::make_shared<BatchExecution>(jreq, vReq);
+
+    if (runner) {
+        const size_t nHelpers = std::max<size_t>(std::min<size_t>(nThreads, vReq.size()), 1) - 1;
+        for (size_t i = 0; i < nHelpers; i++) {
+            if (!runner([batch] { batch->Run(); })) break;
+        }
+    }
+    batch->Run();
+
+    {
+        WAIT_LOCK(batch->cs, lock);
+        while (batch->nDone < vReq.size())
+            batch->cond.wait(lock);
+    }
+
     UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(jreq, vReq[reqIdx]));
+    ret.push_backV(batch->vReplies);
 
     return ret.write() + "\n";
 }
@@ -162,7 +162,16 @@ extern CRPCTable tableRPC;
 void StartRPC();
 void InterruptRPC();
 void StopRPC();
-std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq);
+
+/** Runs a task on another thread, returns false, if the task could not be scheduled */
+typedef std::function<bool(const std::function<void()>&)> RPCTaskRunner;
+/**
+ * Executes the elements of a batch request and returns the replies in request order.
+ * Up to nThreads - 1 helper tasks are handed to runner, which execute elements
+ * concurrently with the calling thread. The calling thread executes all elements,
+ * which aren't picked up by a helper.
+ */
+std::string JSONRPCExecBatch(const JSONRPCRequest& jreq, const UniValue& vReq, const RPCTaskRunner& runner = nullptr, unsigned int nThreads = 1);
 
 // Retrieves any serialization flags requested in command line argument
 int RPCSerializationFlags();
@@ -10,54 +10,49 @@
 #include <uint256.h>
 #include <util/system.h>
 
-#include <cuckoocache.h>
-#include <boost/thread.hpp>
+CSignatureCache::CSignatureCache()
+{
+    uint256 nonce = GetRandHash();
+    // The nonce is padded to 64 bytes, so that the hasher processes this chunk
+    // once, with 'E' for signatures of scripts and 'B' for block signatures.
+    static constexpr unsigned char PADDING_ECDSA[32] = {'E'};
+    static constexpr unsigned char PADDING_BLOCK[32] = {'B'};
+    m_salted_hasher_ecdsa.Write(nonce.begin(), 32);
+    m_salted_hasher_ecdsa.Write(PADDING_ECDSA, 32);
+    m_salted_hasher_block.Write(nonce.begin(), 32);
+    m_salted_hasher_block.Write(PADDING_BLOCK, 32);
+}
 
-namespace {
-/**
- * Valid signature cache, to avoid doing expensive ECDSA signature checking
- * twice for every transaction (once when accepted into memory pool, and
- * again when accepted into the block chain)
- */
-class CSignatureCache
+void CSignatureCache::ComputeEntryECDSA(uint256& entry, const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey) const
 {
-private:
-     //! Entries are SHA256(nonce || signature hash || public key || signature):
-    uint256 nonce;
-    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
-    map_type setValid;
-    boost::shared_mutex cs_sigcache;
+    CSHA256 hasher = m_salted_hasher_ecdsa;
+    hasher.Write(hash.begin(), 32).Write(&pubkey[0], pubkey.size()).Write(&vchSig[0], vchSig.size()).Finalize(entry.begin());
+}
 
-public:
-    CSignatureCache()
-    {
-        GetRandBytes(nonce.begin(), 32);
-    }
+void CSignatureCache::ComputeEntryBlock(uint256& entry, const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey) const
+{
+    CSHA256 hasher = m_salted_hasher_block;
+    hasher.Write(hash.begin(), 32).Write(&pubkey[0], pubkey.size()).Write(&vchSig[0], vchSig.size()).Finalize(entry.begin());
+}
 
-    void
-    ComputeEntry(uint256& entry, const uint256 &hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey)
-    {
-        CSHA256().Write(nonce.begin(), 32).Write(hash.begin(), 32).Write(&pubkey[0], pubkey.size()).Write(&vchSig[0], vchSig.size()).Finalize(entry.begin());
-    }
+bool CSignatureCache::Get(const uint256& entry, const bool erase)
+{
+    boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
+    return setValid.contains(entry, erase);
+}
 
-    bool
-    Get(const uint256& entry, const bool erase)
-    {
-        boost::shared_lock<boost::shared_mutex> lock(cs_sigcache);
-        return setValid.contains(entry, erase);
-    }
+void CSignatureCache::Set(const uint256& entry)
+{
+    boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
+    setValid.insert(entry);
+}
 
-    void Set(uint256& entry)
-    {
-        boost::unique_lock<boost::shared_mutex> lock(cs_sigcache);
-        setValid.insert(entry);
-    }
-    uint32_t setup_bytes(size_t n)
-    {
-        return setValid.setup_bytes(n);
-    }
-};
+uint32_t CSignatureCache::setup_bytes(size_t n)
+{
+    return setValid.setup_bytes(n);
+}
 
+namespace {
 /* In previous versions of this code, signatureCache was a local static variable
  * in CachingTransactionSignatureChecker::VerifySignature.  We initialize
  * signatureCache outside of VerifySignature to avoid the atomic operation per
@@ -82,7 +77,7 @@ void InitSignatureCache()
 bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& sighash) const
 {
     uint256 entry;
-    signatureCache.ComputeEntry(entry, sighash, vchSig, pubkey);
+    signatureCache.ComputeEntryECDSA(entry, sighash, vchSig, pubkey);
     if (signatureCache.Get(entry, !store))
         return true;
     if (!TransactionSignatureChecker::VerifySignature(vchSig, pubkey, sighash))
@@ -91,3 +86,26 @@ bool CachingTransactionSignatureChecker::VerifySignature(const std::vector<unsig
         signatureCache.Set(entry);
     return true;
 }
+
+bool CachingVerifyBlockSignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& hash)
+{
+    if (vchSig.empty())
+        return false;
+
+    // Block signatures are checked once when the block is accepted and again when it is connected
+    uint256 entry;
+    signatureCache.ComputeEntryBlock(entry, hash, vchSig, pubkey);
+    if (signatureCache.Get(entry, false))
+        return true;
+
+    if (CPubKey::GetSigType(vchSig[0]) == CPubKey::SigType::SIG_COMPACT) {
+        CPubKey recoveredPubKey;
+        // Only compressed pubkeys are supported and RecoverCompact already checks sig size
+        if (!(vchSig[0] & 4) || !recoveredPubKey.RecoverCompact(hash, vchSig, CPubKey::SigFlag::VERSION_SIG_COMPACT) || recoveredPubKey != pubkey)
+            return false;
+    } else if (!pubkey.Verify(hash, vchSig)) {
+        return false;
+    }
+    signatureCache.Set(entry);
+    return true;
+}
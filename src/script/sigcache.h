@@ -6,10 +6,14 @@
 #ifndef XEP_SCRIPT_SIGCACHE_H
 #define XEP_SCRIPT_SIGCACHE_H
 
+#include <crypto/sha256.h>
+#include <cuckoocache.h>
 #include <script/interpreter.h>
 
 #include <vector>
 
+#include <boost/thread/shared_mutex.hpp>
+
 // DoS prevention: limit cache size to 32MB (over 1000000 entries on 64-bit
 // systems). Due to how we count cache size, actual memory usage is slightly
 // more (~32.25 MB)
@@ -40,6 +44,34 @@ public:
     }
 };
 
+/**
+ * Valid signature cache, to avoid doing expensive ECDSA signature checking
+ * twice for every transaction (once when accepted into memory pool, and
+ * again when accepted into the block chain)
+ *
+ * Block signatures are verified by other rules than signatures of scripts, so
+ * their entries are salted differently and never satisfy a lookup of the other.
+ */
+class CSignatureCache
+{
+private:
+    //! Entries are SHA256(nonce || 'E' or 'B' || 31 zero bytes || signature hash || public key || signature):
+    CSHA256 m_salted_hasher_ecdsa;
+    CSHA256 m_salted_hasher_block;
+    typedef CuckooCache::cache<uint256, SignatureCacheHasher> map_type;
+    map_type setValid;
+    boost::shared_mutex cs_sigcache;
+
+public:
+    CSignatureCache();
+
+    void ComputeEntryECDSA(uint256& entry, const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey) const;
+    void ComputeEntryBlock(uint256& entry, const uint256& hash, const std::vector<unsigned char>& vchSig, const CPubKey& pubkey) const;
+    bool Get(const uint256& entry, const bool erase);
+    void Set(const uint256& entry);
+    uint32_t setup_bytes(size_t n);
+};
+
 class CachingTransactionSignatureChecker : public TransactionSignatureChecker
 {
 private:
@@ -51,6 +83,9 @@ public:
     bool VerifySignature(const std::vector<unsigned char>& vchSig, const CPubKey& vchPubKey, const uint256& sighash) const override;
 };
 
+/** Verifies a signature of a block hash (see CheckBlockSignature), consulting and updating the signature cache. */
+bool CachingVerifyBlockSignature(const std::vector<unsigned char>& vchSig, const CPubKey& pubkey, const uint256& hash);
+
 void InitSignatureCache();
 
 #endif // XEP_SCRIPT_SIGCACHE_H
@@ -0,0 +1,320 @@
+// Copyright (c) 2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <index/addressindex.h>
+#include <miner.h>
+#include <pow.h>
+#include <script/interpreter.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+typedef std::tuple<int, unsigned int, uint256, size_t, bool, CAmount> AddressDelta;
+typedef std::tuple<uint256, size_t, CAmount, int, bool> AddressUnspent;
+
+/** Creates blocks on top of the genesis block, below the first treasury block of regtest. */
+struct AddressIndexTestingSetup : public RegTestingSetup {
+    CKey keyA, keyB, keyC;
+    CScript scriptA, scriptB, scriptC;
+    //! An output without address, which funds the transactions of the tests
+    COutPoint fundingOutpoint;
+    CTxOut fundingOut;
+
+    AddressIndexTestingSetup()
+    {
+        keyA.MakeNewKey(true);
+        keyB.MakeNewKey(true);
+        keyC.MakeNewKey(true);
+        scriptA = GetScriptForDestination(PKHash(keyA.GetPubKey()));
+        scriptB = GetScriptForDestination(PKHash(keyB.GetPubKey()));
+        scriptC = GetScriptForDestination(PKHash(keyC.GetPubKey()));
+
+        fundingOutpoint = COutPoint(InsecureRand256(), 0);
+        fundingOut = CTxOut(100 * COIN, CScript() << OP_TRUE);
+        // undo data of height 0 is taken as missing, so it's confirmed in the first block
+        LOCK(cs_main);
+        ::ChainstateActive().CoinsTip().AddCoin(fundingOutpoint, Coin(fundingOut, 1, false, false), false);
+    }
+
+    CBlock CreateAndProcessBlock(const std::vector<CMutableTransaction>& txns, const CScript& scriptPubKey)
+    {
+        const CChainParams& chainparams = Params();
+        // Transactions of invalidated blocks return to the mempool, their fees must not end up in the coinbase
+        m_node.mempool->clear();
+        std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(*m_node.mempool, chainparams).CreateNewBlock(scriptPubKey);
+        CBlock& block = pblocktemplate->block;
+
+        block.vtx.resize(1);
+        for (const CMutableTransaction& tx : txns) {
+            block.vtx.push_back(MakeTransactionRef(tx));
+        }
+        {
+            LOCK(cs_main);
+            unsigned int extraNonce = 0;
+            IncrementExtraNonce(&block, ::ChainActive().Tip(), extraNonce);
+            RegenerateCommitments(block, ::ChainActive().Tip(), chainparams.GetConsensus());
+        }
+
+        while (!CheckProofOfWork(block.GetPoWHash(), block.nBits, CBlockHeader::GetAlgoType(block.nVersion), chainparams.GetConsensus())) ++block.nNonce;
+
+        std::shared_ptr<const CBlock> shared_pblock = std::make_shared<const CBlock>(block);
+        BOOST_REQUIRE(ProcessNewBlock(chainparams, shared_pblock, true, nullptr));
+        BOOST_REQUIRE_EQUAL(WITH_LOCK(cs_main, return ::ChainActive().Tip()->GetBlockHash()), block.GetHash());
+        return block;
+    }
+
+    /** Spends the funding output to A and B. */
+    CMutableTransaction CreateFundingTx() const
+    {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(fundingOutpoint);
+        tx.vout.emplace_back(60 * COIN, scriptA);
+        tx.vout.emplace_back(39 * COIN, scriptB);
+        return tx;
+    }
+
+    /** Spends the output of A created by the funding transaction to B, with change to A. */
+    CMutableTransaction CreatePaymentTx(const CMutableTransaction& funding_tx) const
+    {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(COutPoint(funding_tx.GetHash(), 0));
+        tx.vout.emplace_back(20 * COIN, scriptB);
+        tx.vout.emplace_back(39 * COIN, scriptA);
+
+        std::vector<unsigned char> vchSig;
+        const uint256 hash = SignatureHash(scriptA, tx, 0, SIGHASH_ALL, funding_tx.vout[0].nValue, SigVersion::BASE);
+        BOOST_REQUIRE(keyA.Sign(hash, vchSig));
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        tx.vin[0].scriptSig << vchSig << ToByteVector(keyA.GetPubKey());
+        return tx;
+    }
+
+    void InvalidateTip()
+    {
+        CBlockIndex* pindex = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+        BlockValidationState state;
+        BOOST_REQUIRE(InvalidateBlock(state, Params(), pindex));
+    }
+};
+
+void SyncIndex(AddressIndex& index)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+}
+
+std::pair<int, uint256> GetAddressKey(const CScript& script)
+{
+    CTxDestination dest;
+    BOOST_REQUIRE(ExtractDestination(script, dest));
+    std::vector<unsigned char> bytesID(boost::apply_visitor(DataVisitor(), dest));
+    std::vector<unsigned char> addressBytes(32);
+    std::copy(bytesID.begin(), bytesID.end(), addressBytes.begin());
+    return std::make_pair(dest.which(), uint256(addressBytes));
+}
+
+/**
+ * Computes the entries of an address, as they were written by ConnectBlock,
+ * before the address index was built in the background.
+ */
+void ComputeExpectedEntries(const CScript& script, const COutPoint& funding_outpoint, const CTxOut& funding_out,
+                            std::vector<AddressDelta>& deltas, std::vector<AddressUnspent>& unspent)
+{
+    struct Output {
+        CTxOut out;
+        int nHeight;
+        bool fCoinBase;
+    };
+    std::map<COutPoint, Output> outputs;
+    outputs[funding_outpoint] = Output{funding_out, 1, false};
+
+    LOCK(cs_main);
+    for (const CBlockIndex* pindex = ::ChainActive()[1]; pindex; pindex = ::ChainActive().Next(pindex)) {
+        CBlock block;
+        BOOST_REQUIRE(ReadBlockFromDisk(block, pindex, Params().GetConsensus()));
+        for (size_t i = 0; i < block.vtx.size(); i++) {
+            const CTransaction& tx = *block.vtx[i];
+            if (!tx.IsCoinBase()) {
+                for (size_t j = 0; j < tx.vin.size(); j++) {
+                    const auto it = outputs.find(tx.vin[j].prevout);
+                    BOOST_REQUIRE(it != outputs.end());
+                    if (it->second.out.scriptPubKey == script) {
+                        deltas.emplace_back(pindex->nHeight, i, tx.GetHash(), j, true, -it->second.out.nValue);
+                    }
+                    outputs.erase(it);
+                }
+            }
+            for (size_t k = 0; k < tx.vout.size(); k++) {
+                outputs[COutPoint(tx.GetHash(), k)] = Output{tx.vout[k], pindex->nHeight, tx.IsCoinBase()};
+                if (tx.vout[k].scriptPubKey == script) {
+                    deltas.emplace_back(pindex->nHeight, i, tx.GetHash(), k, false, tx.vout[k].nValue);
+                }
+            }
+        }
+    }
+
+    for (const auto& output : outputs) {
+        if (output.second.out.scriptPubKey == script) {
+            unspent.emplace_back(output.first.hash, output.first.n, output.second.out.nValue, output.second.nHeight, output.second.fCoinBase);
+        }
+    }
+    std::sort(deltas.begin(), deltas.end());
+    std::sort(unspent.begin(), unspent.end());
+}
+
+/** Checks the entries and the running totals of an address against the ones computed from the active chain. */
+void CheckAddress(const AddressIndex& index, const CScript& script, const COutPoint& funding_outpoint, const CTxOut& funding_out)
+{
+    std::vector<AddressDelta> expected_deltas;
+    std::vector<AddressUnspent> expected_unspent;
+    ComputeExpectedEntries(script, funding_outpoint, funding_out, expected_deltas, expected_unspent);
+
+    const std::pair<int, uint256> key = GetAddressKey(script);
+
+    std::vector<std::pair<CAddressIndexKey, CAmount>> address_index;
+    BOOST_REQUIRE(index.ReadAddressIndex(key.second, key.first, address_index));
+    std::vector<AddressDelta> deltas;
+    for (const auto& entry : address_index) {
+        deltas.emplace_back(entry.first.blockHeight, entry.first.txindex, entry.first.txhash, entry.first.index, entry.first.spending, entry.second);
+    }
+    std::sort(deltas.begin(), deltas.end());
+    BOOST_CHECK(deltas == expected_deltas);
+
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> unspent_index;
+    BOOST_REQUIRE(index.ReadAddressUnspentIndex(key.second, key.first, unspent_index));
+    std::vector<AddressUnspent> unspent;
+    for (const auto& entry : unspent_index) {
+        BOOST_CHECK(entry.second.script == script);
+        unspent.emplace_back(entry.first.txhash, entry.first.index, entry.second.satoshis, entry.second.blockHeight, entry.second.coinBase);
+    }
+    std::sort(unspent.begin(), unspent.end());
+    BOOST_CHECK(unspent == expected_unspent);
+
+    // getaddressbalance summed up the deltas
+    CAmount nBalance = 0;
+    CAmount nReceived = 0;
+    for (const AddressDelta& delta : expected_deltas) {
+        nBalance += std::get<5>(delta);
+        if (std::get<5>(delta) > 0) nReceived += std::get<5>(delta);
+    }
+    CAddressBalance balance;
+    BOOST_REQUIRE(index.ReadAddressBalance(key.second, key.first, balance));
+    BOOST_CHECK_EQUAL(balance.nBalance, nBalance);
+    BOOST_CHECK_EQUAL(balance.nReceived, nReceived);
+}
+
+CAmount GetBalance(const AddressIndex& index, const CScript& script)
+{
+    const std::pair<int, uint256> key = GetAddressKey(script);
+    CAddressBalance balance;
+    BOOST_REQUIRE(index.ReadAddressBalance(key.second, key.first, balance));
+    return balance.nBalance;
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(addressindex_tests, AddressIndexTestingSetup)
+
+BOOST_AUTO_TEST_CASE(addressindex_connect_disconnect)
+{
+    CreateAndProcessBlock({}, scriptA);
+    CreateAndProcessBlock({}, scriptA);
+    const CMutableTransaction funding_tx = CreateFundingTx();
+    CreateAndProcessBlock({funding_tx}, scriptC);
+    const CMutableTransaction payment_tx = CreatePaymentTx(funding_tx);
+    CreateAndProcessBlock({payment_tx}, scriptC);
+
+    AddressIndex index(1 << 20, true);
+    index.Start();
+    SyncIndex(index);
+
+    for (const CScript& script : {scriptA, scriptB, scriptC}) {
+        CheckAddress(index, script, fundingOutpoint, fundingOut);
+    }
+    BOOST_CHECK_EQUAL(GetBalance(index, scriptB), 59 * COIN);
+
+    CSpentIndexValue spent;
+    BOOST_CHECK(index.ReadSpentIndex(CSpentIndexKey(funding_tx.GetHash(), 0), spent));
+    BOOST_CHECK_EQUAL(spent.txid, payment_tx.GetHash());
+    BOOST_CHECK_EQUAL(spent.inputIndex, 0U);
+    BOOST_CHECK_EQUAL(spent.satoshis, 60 * COIN);
+
+    // Replace the block of the payment, the index rewinds before connecting the new one
+    InvalidateTip();
+    const CBlock block = CreateAndProcessBlock({}, scriptB);
+    SyncIndex(index);
+
+    for (const CScript& script : {scriptA, scriptB, scriptC}) {
+        CheckAddress(index, script, fundingOutpoint, fundingOut);
+    }
+    BOOST_CHECK_EQUAL(GetBalance(index, scriptB), 39 * COIN + block.vtx[0]->vout[0].nValue);
+    BOOST_CHECK(!index.ReadSpentIndex(CSpentIndexKey(funding_tx.GetHash(), 0), spent));
+
+    index.Stop();
+    m_node.scheduler->stop();
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+}
+
+BOOST_AUTO_TEST_CASE(addressindex_init_rollback)
+{
+    CreateAndProcessBlock({}, scriptA);
+    const CMutableTransaction funding_tx = CreateFundingTx();
+    CreateAndProcessBlock({funding_tx}, scriptC);
+    const CMutableTransaction payment_tx = CreatePaymentTx(funding_tx);
+    CreateAndProcessBlock({payment_tx}, scriptC);
+
+    {
+        AddressIndex index(1 << 20, false, true);
+        index.Start();
+        SyncIndex(index);
+        index.Stop();
+    }
+
+    // While the index is stopped, the last two blocks are reorganized away and
+    // the payment is confirmed again in a longer chain
+    InvalidateTip();
+    InvalidateTip();
+    CreateAndProcessBlock({}, scriptB);
+    CreateAndProcessBlock({funding_tx, payment_tx}, scriptB);
+    CreateAndProcessBlock({}, scriptA);
+
+    // The index rolls back to the fork on start and resumes from there
+    AddressIndex index(1 << 20, false, false);
+    index.Start();
+    SyncIndex(index);
+
+    for (const CScript& script : {scriptA, scriptB, scriptC}) {
+        CheckAddress(index, script, fundingOutpoint, fundingOut);
+    }
+    BOOST_CHECK_EQUAL(GetBalance(index, scriptC), 0);
+
+    CSpentIndexValue spent;
+    BOOST_CHECK(index.ReadSpentIndex(CSpentIndexKey(funding_tx.GetHash(), 0), spent));
+    BOOST_CHECK_EQUAL(spent.txid, payment_tx.GetHash());
+    BOOST_CHECK_EQUAL(spent.blockHeight, 3);
+
+    index.Stop();
+    m_node.scheduler->stop();
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -8,6 +8,8 @@
 
 #include <chain.h>
 #include <rpc/blockchain.h>
+#include <txdb.h>
+#include <validation.h>
 #include <util/string.h>
 #include <test/util/setup_common.h>
 
@@ -74,4 +76,39 @@ BOOST_AUTO_TEST_CASE(get_difficulty_for_very_high_target)
     TestDifficulty(0x12345678, 5913134931067755359633408.0);
 }
 
+BOOST_FIXTURE_TEST_CASE(blockindex_cold_data, TestingSetup)
+{
+    const uint256 hash = InsecureRand256();
+    const uint256 hashProofOfStake = InsecureRand256();
+    CBlockIndex index;
+    index.phashBlock = &hash;
+    index.SetProofOfStake();
+
+    // unknown blocks have no cold data
+    BOOST_CHECK(index.GetHashProofOfStake().IsNull());
+    BOOST_CHECK_EQUAL(g_blockindex_cold.Size(), 0U);
+
+    // changes are kept in the side table, until they are written
+    index.SetHashProofOfStake(hashProofOfStake);
+    BOOST_CHECK(index.GetHashProofOfStake() == hashProofOfStake);
+    BOOST_CHECK_EQUAL(g_blockindex_cold.Size(), 1U);
+    BOOST_CHECK(CDiskBlockIndex(&index).cold.hashProofOfStake == hashProofOfStake);
+
+    const std::vector<const CBlockIndex*> vIndex{&index};
+    BOOST_CHECK(pblocktree->WriteBatchSync({}, 0, vIndex));
+    g_blockindex_cold.Release(vIndex);
+    BOOST_CHECK_EQUAL(g_blockindex_cold.Size(), 0U);
+
+    // and read back from the block tree database afterwards
+    BOOST_CHECK(index.GetHashProofOfStake() == hashProofOfStake);
+    BOOST_CHECK_EQUAL(index.GetTreasuryPayment(), 0);
+    BOOST_CHECK(index.GetStakeModifierV2().IsNull());
+    BOOST_CHECK_EQUAL(g_blockindex_cold.Size(), 0U);
+
+    // fields, which don't apply to a block, are not read
+    CBlockIndex indexPoW;
+    indexPoW.phashBlock = &hash;
+    BOOST_CHECK(indexPoW.GetHashProofOfStake().IsNull());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
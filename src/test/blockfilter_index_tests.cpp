@@ -23,6 +23,40 @@ struct BuildChainTestingSetup : public TestChain100Setup {
     bool BuildChain(const CBlockIndex* pindex, const CScript& coinbase_script_pub_key, size_t length, std::vector<std::shared_ptr<CBlock>>& chain);
 };
 
+/** Creates blocks on top of the genesis block, below the first treasury block of regtest. */
+struct FilterRangeTestingSetup : public RegTestingSetup {
+    void CreateAndProcessBlock(const CScript& scriptPubKey)
+    {
+        const CChainParams& chainparams = Params();
+        std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(*m_node.mempool, chainparams).CreateNewBlock(scriptPubKey);
+        CBlock& block = pblocktemplate->block;
+
+        block.vtx.resize(1);
+        {
+            LOCK(cs_main);
+            unsigned int extraNonce = 0;
+            IncrementExtraNonce(&block, ::ChainActive().Tip(), extraNonce);
+            RegenerateCommitments(block, ::ChainActive().Tip(), chainparams.GetConsensus());
+        }
+
+        while (!CheckProofOfWork(block.GetPoWHash(), block.nBits, CBlockHeader::GetAlgoType(block.nVersion), chainparams.GetConsensus())) ++block.nNonce;
+
+        std::shared_ptr<const CBlock> shared_pblock = std::make_shared<const CBlock>(block);
+        BOOST_REQUIRE(ProcessNewBlock(chainparams, shared_pblock, true, nullptr));
+    }
+};
+
+static bool WaitForSync(BlockFilterIndex& filter_index)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!filter_index.BlockUntilSyncedToCurrentChain()) {
+        if (time_start + timeout_ms <= GetTimeMillis()) return false;
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+    return true;
+}
+
 static bool CheckFilterLookups(BlockFilterIndex& filter_index, const CBlockIndex* block_index,
                                uint256& last_header)
 {
@@ -76,7 +110,7 @@ CBlock BuildChainTestingSetup::CreateBlock(const CBlockIndex* prev,
     unsigned int extraNonce = 0;
     IncrementExtraNonce(&block, prev, extraNonce);
 
-    while (!CheckProofOfWork(block.GetPoWHash(), block.nBits, chainparams.GetConsensus())) ++block.nNonce;
+    while (!CheckProofOfWork(block.GetPoWHash(), block.nBits, CBlockHeader::GetAlgoType(block.nVersion), chainparams.GetConsensus())) ++block.nNonce;
 
     return block;
 }
@@ -265,6 +299,55 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync, BuildChainTestingSetup)
     filter_index.Stop();
 }
 
+BOOST_FIXTURE_TEST_CASE(blockfilter_index_lookup_range, FilterRangeTestingSetup)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript script_pub_key = GetScriptForDestination(PKHash(key.GetPubKey()));
+    for (int i = 0; i < 10; i++) {
+        CreateAndProcessBlock(script_pub_key);
+    }
+
+    BlockFilterIndex filter_index(BlockFilterType::BASIC, 1 << 20, true);
+    filter_index.Start();
+    BOOST_REQUIRE(WaitForSync(filter_index));
+
+    const CBlockIndex* tip = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+    std::vector<BlockFilter> filters;
+    std::vector<uint256> filter_hashes;
+    BOOST_CHECK(filter_index.LookupFilterRange(0, tip, filters));
+    BOOST_CHECK(filter_index.LookupFilterHashRange(0, tip, filter_hashes));
+    BOOST_REQUIRE_EQUAL(filters.size(), tip->nHeight + 1);
+    BOOST_REQUIRE_EQUAL(filter_hashes.size(), tip->nHeight + 1);
+
+    // Filters read in one pass over the filter file must match those read one by one.
+    for (const CBlockIndex* block_index = tip; block_index; block_index = block_index->pprev) {
+        BlockFilter filter;
+        BOOST_CHECK(filter_index.LookupFilter(block_index, filter));
+        BOOST_CHECK_EQUAL(filters[block_index->nHeight].GetHash(), filter.GetHash());
+        BOOST_CHECK_EQUAL(filter_hashes[block_index->nHeight], filter.GetHash());
+    }
+
+    // A range in the middle of the chain starts at the requested height.
+    std::vector<BlockFilter> partial_filters;
+    BOOST_CHECK(filter_index.LookupFilterRange(3, tip->GetAncestor(7), partial_filters));
+    BOOST_REQUIRE_EQUAL(partial_filters.size(), 5U);
+    for (size_t i = 0; i < partial_filters.size(); i++) {
+        BOOST_CHECK_EQUAL(partial_filters[i].GetHash(), filters[3 + i].GetHash());
+    }
+
+    // The genesis block is at a checkpoint height, so its header is served from the cache the
+    // second time it is looked up.
+    uint256 genesis_header, cached_genesis_header;
+    BOOST_CHECK(filter_index.LookupFilterHeader(tip->GetAncestor(0), genesis_header));
+    BOOST_CHECK(filter_index.LookupFilterHeader(tip->GetAncestor(0), cached_genesis_header));
+    BOOST_CHECK_EQUAL(genesis_header, cached_genesis_header);
+    BOOST_CHECK_EQUAL(genesis_header, filters[0].ComputeHeader(uint256()));
+
+    filter_index.Interrupt();
+    filter_index.Stop();
+}
+
 BOOST_FIXTURE_TEST_CASE(blockfilter_index_init_destroy, BasicTestingSetup)
 {
     BlockFilterIndex* filter_index;
@@ -0,0 +1,123 @@
+// Copyright (c) 2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chainparams.h>
+#include <consensus/validation.h>
+#include <index/coinstatsindex.h>
+#include <miner.h>
+#include <node/coinstats.h>
+#include <pow.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <boost/test/unit_test.hpp>
+
+namespace {
+
+/** Creates blocks on top of the genesis block, below the first treasury block of regtest. */
+struct CoinStatsIndexTestingSetup : public RegTestingSetup {
+    CBlock CreateAndProcessBlock(const CScript& scriptPubKey)
+    {
+        const CChainParams& chainparams = Params();
+        std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(*m_node.mempool, chainparams).CreateNewBlock(scriptPubKey);
+        CBlock& block = pblocktemplate->block;
+
+        block.vtx.resize(1);
+        {
+            LOCK(cs_main);
+            unsigned int extraNonce = 0;
+            IncrementExtraNonce(&block, ::ChainActive().Tip(), extraNonce);
+            RegenerateCommitments(block, ::ChainActive().Tip(), chainparams.GetConsensus());
+        }
+
+        while (!CheckProofOfWork(block.GetPoWHash(), block.nBits, CBlockHeader::GetAlgoType(block.nVersion), chainparams.GetConsensus())) ++block.nNonce;
+
+        std::shared_ptr<const CBlock> shared_pblock = std::make_shared<const CBlock>(block);
+        BOOST_REQUIRE(ProcessNewBlock(chainparams, shared_pblock, true, nullptr));
+        BOOST_REQUIRE_EQUAL(WITH_LOCK(cs_main, return ::ChainActive().Tip()->GetBlockHash()), block.GetHash());
+        return block;
+    }
+};
+
+void SyncIndex(CoinStatsIndex& index)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!index.BlockUntilSyncedToCurrentChain()) {
+        BOOST_REQUIRE(time_start + timeout_ms > GetTimeMillis());
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+}
+
+/** Checks the statistics of gettxoutsetinfo, as looked up in the index, against the ones of a full scan of the UTXO set. */
+void CheckStats()
+{
+    CCoinsView* coins_view = WITH_LOCK(cs_main, return &::ChainstateActive().CoinsDB());
+
+    CCoinsStats index_stats(CoinStatsHashType::MUHASH);
+    BOOST_REQUIRE(GetUTXOStats(coins_view, index_stats, WITH_LOCK(cs_main, return ::ChainActive().Tip())));
+    BOOST_CHECK(index_stats.index_used);
+
+    ::ChainstateActive().ForceFlushStateToDisk();
+    CCoinsStats scan_stats(CoinStatsHashType::MUHASH, false);
+    BOOST_REQUIRE(GetUTXOStats(coins_view, scan_stats));
+    BOOST_CHECK(!scan_stats.index_used);
+
+    BOOST_CHECK_EQUAL(index_stats.nHeight, scan_stats.nHeight);
+    BOOST_CHECK_EQUAL(index_stats.hashBlock, scan_stats.hashBlock);
+    BOOST_CHECK_EQUAL(index_stats.hashSerialized, scan_stats.hashSerialized);
+    BOOST_CHECK_EQUAL(index_stats.nTransactionOutputs, scan_stats.nTransactionOutputs);
+    BOOST_CHECK_EQUAL(index_stats.nBogoSize, scan_stats.nBogoSize);
+    BOOST_CHECK_EQUAL(index_stats.nTotalAmount, scan_stats.nTotalAmount);
+}
+
+} // namespace
+
+BOOST_FIXTURE_TEST_SUITE(coinstatsindex_tests, CoinStatsIndexTestingSetup)
+
+BOOST_AUTO_TEST_CASE(coinstatsindex_matches_utxo_scan)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript script_pub_key = GetScriptForDestination(PKHash(key.GetPubKey()));
+    for (int i = 0; i < 5; i++) {
+        CreateAndProcessBlock(script_pub_key);
+    }
+
+    g_coin_stats_index = MakeUnique<CoinStatsIndex>(1 << 20, false, true);
+    g_coin_stats_index->Start();
+    SyncIndex(*g_coin_stats_index);
+    CheckStats();
+
+    // Replace the tip, the index reverts the block before connecting the new one
+    {
+        CBlockIndex* pindex = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+        BlockValidationState state;
+        BOOST_REQUIRE(InvalidateBlock(state, Params(), pindex));
+    }
+    CreateAndProcessBlock(GetScriptForDestination(WitnessV0KeyHash(PKHash(key.GetPubKey()))));
+    SyncIndex(*g_coin_stats_index);
+    CheckStats();
+
+    // The running MuHash is read back on restart and continues from there
+    g_coin_stats_index->Stop();
+    g_coin_stats_index.reset();
+    g_coin_stats_index = MakeUnique<CoinStatsIndex>(1 << 20, false, false);
+    for (int i = 0; i < 3; i++) {
+        CreateAndProcessBlock(script_pub_key);
+    }
+    g_coin_stats_index->Start();
+    SyncIndex(*g_coin_stats_index);
+    CheckStats();
+
+    g_coin_stats_index->Stop();
+    m_node.scheduler->stop();
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+    g_coin_stats_index.reset();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -38,6 +38,7 @@ void test_one_input(const std::vector<uint8_t>& buffer)
             const int current_height = (previous_block != nullptr && previous_block->nHeight != std::numeric_limits<int>::max()) ? previous_block->nHeight + 1 : 0;
             if (fuzzed_data_provider.ConsumeBool()) {
                 current_block.pprev = previous_block;
+                current_block.BuildAlgoSkip();
             }
             if (fuzzed_data_provider.ConsumeBool()) {
                 current_block.nHeight = current_height;
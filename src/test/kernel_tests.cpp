@@ -0,0 +1,324 @@
+// Copyright (c) 2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <chain.h>
+#include <chainparams.h>
+#include <coins.h>
+#include <consensus/validation.h>
+#include <kernel.h>
+#include <key.h>
+#include <miner.h>
+#include <pow.h>
+#include <primitives/block.h>
+#include <script/sign.h>
+#include <script/signingprovider.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(kernel_tests, BasicTestingSetup)
+
+// Reference V0.5 stake modifier selection, walking back one block at a time
+static bool WalkKernelStakeModifier(const CBlockIndex* pindexPrev, unsigned int nTimeTx, const Consensus::Params& params, uint64_t& nStakeModifier, int& nStakeModifierHeight, int64_t& nStakeModifierTime)
+{
+    const CBlockIndex* pindex = pindexPrev;
+    nStakeModifierHeight = pindex->nHeight;
+    nStakeModifierTime = pindex->GetBlockTime();
+    const int64_t nStakeModifierSelectionInterval = GetStakeModifierSelectionInterval();
+
+    if (nStakeModifierTime + params.nStakeMinAge - nStakeModifierSelectionInterval <= (int64_t)nTimeTx)
+        return false;
+    while (nStakeModifierTime + params.nStakeMinAge - nStakeModifierSelectionInterval > (int64_t)nTimeTx) {
+        if (!pindex->pprev)
+            return false;
+        pindex = pindex->pprev;
+        if (pindex->GeneratedStakeModifier()) {
+            nStakeModifierHeight = pindex->nHeight;
+            nStakeModifierTime = pindex->GetBlockTime();
+        }
+    }
+    nStakeModifier = pindex->nStakeModifier;
+    return true;
+}
+
+static void BuildChain(std::vector<CBlockIndex>& vIndex, CBlockIndex* pindexFork)
+{
+    for (size_t i = 0; i < vIndex.size(); i++) {
+        CBlockIndex* pprev = i ? &vIndex[i - 1] : pindexFork;
+        vIndex[i].pprev = pprev;
+        vIndex[i].nHeight = pprev ? pprev->nHeight + 1 : 0;
+        vIndex[i].nTime = pprev ? pprev->nTime + 1 + InsecureRandRange(200) : 1600000000;
+        vIndex[i].SetStakeModifier(InsecureRand32(), !pprev || InsecureRandRange(8) == 0);
+        vIndex[i].BuildSkip();
+    }
+}
+
+static void CheckStakeModifiers(const std::vector<CBlockIndex>& vIndex, const Consensus::Params& params)
+{
+    for (int i = 0; i < 2000; i++) {
+        const CBlockIndex* pindexPrev = &vIndex[InsecureRandRange(vIndex.size())];
+        if ((unsigned)(pindexPrev->nHeight + 1) < params.nMinerConfirmationWindow)
+            continue;
+        const unsigned int nTimeTx = pindexPrev->nTime + InsecureRandRange(2 * params.nStakeMinAge) - params.nStakeMinAge;
+
+        uint64_t nModifierExpected = 0;
+        int nHeightExpected = 0;
+        int64_t nTimeExpected = 0;
+        if (!WalkKernelStakeModifier(pindexPrev, nTimeTx, params, nModifierExpected, nHeightExpected, nTimeExpected)) {
+            // falls back to the modifier of the previous block
+            nModifierExpected = pindexPrev->nStakeModifier;
+            nHeightExpected = pindexPrev->nHeight;
+            nTimeExpected = pindexPrev->GetBlockTime();
+        }
+
+        uint64_t nModifier = 0;
+        uint256 nModifierV2;
+        int nHeight = 0;
+        int64_t nTime = 0;
+        BOOST_CHECK(GetKernelStakeModifier(pindexPrev, uint256(), nTimeTx, params, nModifier, nModifierV2, nHeight, nTime, false));
+        BOOST_CHECK_EQUAL(nModifier, nModifierExpected);
+        BOOST_CHECK_EQUAL(nHeight, nHeightExpected);
+        BOOST_CHECK_EQUAL(nTime, nTimeExpected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(kernel_stake_modifier_v05)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+
+    std::vector<CBlockIndex> vMain(2 * params.nMinerConfirmationWindow);
+    BuildChain(vMain, nullptr);
+    CheckStakeModifiers(vMain, params);
+
+    // A competing branch with different modifiers, as seen after a reorg
+    std::vector<CBlockIndex> vFork(params.nMinerConfirmationWindow / 2);
+    BuildChain(vFork, &vMain[vMain.size() - vFork.size()]);
+    CheckStakeModifiers(vFork, params);
+    CheckStakeModifiers(vMain, params);
+}
+
+// Reference V0.3 stake modifier selection, walking forward one block at a time from the block of the coin
+static bool WalkKernelStakeModifierV03(const CBlockIndex* pindexPrev, const CBlockIndex* pindexFrom, uint64_t& nStakeModifier, int& nStakeModifierHeight, int64_t& nStakeModifierTime)
+{
+    const CBlockIndex* pindex = pindexFrom;
+    nStakeModifierHeight = pindexFrom->nHeight;
+    nStakeModifierTime = pindexFrom->GetBlockTime();
+    const int64_t nStakeModifierSelectionInterval = GetStakeModifierSelectionInterval();
+
+    while (nStakeModifierTime < pindexFrom->GetBlockTime() + nStakeModifierSelectionInterval) {
+        if (pindex == pindexPrev)
+            return false;
+        pindex = pindexPrev->GetAncestor(pindex->nHeight + 1);
+        if (pindex->GeneratedStakeModifier()) {
+            nStakeModifierHeight = pindex->nHeight;
+            nStakeModifierTime = pindex->GetBlockTime();
+        }
+    }
+    nStakeModifier = pindex->nStakeModifier;
+    return true;
+}
+
+static void CheckStakeModifiersV03(const std::vector<CBlockIndex>& vIndex, const Consensus::Params& params)
+{
+    for (int i = 0; i < 2000; i++) {
+        const CBlockIndex* pindexPrev = &vIndex[InsecureRandRange(vIndex.size())];
+        const CBlockIndex* pindexFrom = pindexPrev->GetAncestor(InsecureRandRange(pindexPrev->nHeight + 1));
+
+        uint64_t nModifierExpected = 0;
+        int nHeightExpected = 0;
+        int64_t nTimeExpected = 0;
+        if (!WalkKernelStakeModifierV03(pindexPrev, pindexFrom, nModifierExpected, nHeightExpected, nTimeExpected)) {
+            // falls back to the modifier of the previous block
+            nModifierExpected = pindexPrev->nStakeModifier;
+            nHeightExpected = pindexPrev->nHeight;
+            nTimeExpected = pindexPrev->GetBlockTime();
+        }
+
+        uint64_t nModifier = 0;
+        uint256 nModifierV2;
+        int nHeight = 0;
+        int64_t nTime = 0;
+        BOOST_CHECK(GetKernelStakeModifier(pindexPrev, pindexFrom->GetBlockHash(), pindexPrev->nTime + 1, params, nModifier, nModifierV2, nHeight, nTime, false));
+        BOOST_CHECK_EQUAL(nModifier, nModifierExpected);
+        BOOST_CHECK_EQUAL(nHeight, nHeightExpected);
+        BOOST_CHECK_EQUAL(nTime, nTimeExpected);
+    }
+}
+
+// The V0.3 modifiers are used on regtest, by blocks below the first confirmation window
+BOOST_AUTO_TEST_CASE(kernel_stake_modifier_v03)
+{
+    SelectParams(CBaseChainParams::REGTEST);
+    const Consensus::Params& params = Params().GetConsensus();
+
+    std::vector<CBlockIndex> vMain(std::min(params.nMinerConfirmationWindow - 1, 1000U));
+    BuildChain(vMain, nullptr);
+    std::vector<CBlockIndex> vFork(vMain.size() / 4);
+    BuildChain(vFork, &vMain[vMain.size() - vFork.size()]);
+
+    // the block of the coin is looked up by hash
+    std::vector<uint256> vHashes(vMain.size() + vFork.size());
+    {
+        LOCK(cs_main);
+        for (size_t i = 0; i < vHashes.size(); i++) {
+            CBlockIndex& index = i < vMain.size() ? vMain[i] : vFork[i - vMain.size()];
+            vHashes[i] = InsecureRand256();
+            index.phashBlock = &vHashes[i];
+            ::BlockIndex().emplace(vHashes[i], &index);
+        }
+
+        CheckStakeModifiersV03(vMain, params);
+        CheckStakeModifiersV03(vFork, params);
+
+        for (const uint256& hash : vHashes) {
+            ::BlockIndex().erase(hash);
+        }
+    }
+    SelectParams(CBaseChainParams::MAIN);
+}
+
+BOOST_AUTO_TEST_CASE(kernel_search_matches_check)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+
+    std::vector<CBlockIndex> vIndex(params.nMinerConfirmationWindow + params.nStakeMinDepth);
+    std::vector<uint256> vHashes(vIndex.size());
+    BuildChain(vIndex, nullptr);
+    for (size_t i = 0; i < vIndex.size(); i++) {
+        vHashes[i] = InsecureRand256();
+        vIndex[i].phashBlock = &vHashes[i];
+    }
+    const CBlockIndex* pindexPrev = &vIndex.back();
+    const unsigned int nTimeTx = (pindexPrev->nTime + 1 + params.nStakeTimestampMask) & ~params.nStakeTimestampMask;
+    const unsigned int nBits = UintToArith256(params.powLimit[CBlockHeader::ALGO_POS]).GetCompactBase256();
+
+    // Values spread over a wide range, so that some kernels meet the target and some don't
+    std::vector<StakeKernelCandidate> vCandidates;
+    for (int i = 0; i < 500; i++) {
+        const CBlockIndex* pindexFrom = &vIndex[InsecureRandRange(vIndex.size())];
+        vCandidates.emplace_back(COutPoint(InsecureRand256(), InsecureRandRange(4)), (CAmount)1 << InsecureRandRange(48), pindexFrom);
+    }
+
+    std::vector<StakeKernelModifier> vModifiers;
+    {
+        LOCK(cs_main);
+        GetStakeKernelModifiers(pindexPrev, vCandidates, nTimeTx, vModifiers);
+    }
+
+    const std::atomic<bool> fStop{false};
+    int nHits = 0;
+    for (size_t i = 0; i < vCandidates.size(); i++) {
+        const StakeKernelCandidate& candidate = vCandidates[i];
+        const CTxOut txout(candidate.nValue, CScript());
+        unsigned int nTimeCheck = nTimeTx;
+        uint256 hashCheck;
+        const bool fEligible = candidate.pindexFrom->GetBlockTime() + params.nStakeMinAge <= nTimeTx && pindexPrev->nHeight + 1 - candidate.pindexFrom->nHeight >= params.nStakeMinDepth;
+        const bool fCheck = fEligible && CheckStakeKernelHash(nBits, pindexPrev, candidate.pindexFrom, txout, candidate.pindexFrom->GetBlockTime(), candidate.prevout, nTimeCheck, 0, true, hashCheck);
+
+        size_t nFound = vCandidates.size();
+        uint256 hashSearch;
+        uint64_t nAttempts = 0;
+        BOOST_CHECK_EQUAL(vModifiers[i].fValid, fEligible);
+        BOOST_CHECK_EQUAL(SearchStakeKernels(nBits, pindexPrev, vCandidates, vModifiers, i, i + 1, nTimeTx, fStop, nFound, hashSearch, nAttempts), fCheck);
+        BOOST_CHECK_EQUAL(nAttempts, fEligible ? 1U : 0U);
+        if (fCheck) {
+            BOOST_CHECK_EQUAL(nFound, i);
+            BOOST_CHECK(hashSearch == hashCheck);
+            nHits++;
+        }
+    }
+    BOOST_CHECK(nHits > 0);
+
+    // A search over all candidates stops at the first hit
+    size_t nFound = vCandidates.size();
+    uint256 hashSearch;
+    uint64_t nAttempts = 0;
+    BOOST_CHECK(SearchStakeKernels(nBits, pindexPrev, vCandidates, vModifiers, 0, vCandidates.size(), nTimeTx, fStop, nFound, hashSearch, nAttempts));
+    BOOST_CHECK(nAttempts <= nFound + 1);
+}
+
+// Stake an output the way the stake miner does: search a kernel, assemble the block around the coinstake, sign
+// both and check that the result is a valid proof-of-stake block
+BOOST_FIXTURE_TEST_CASE(kernel_create_stake_block, RegTestingSetup)
+{
+    const CChainParams& chainparams = Params();
+    const Consensus::Params& params = chainparams.GetConsensus();
+
+    CKey key;
+    key.MakeNewKey(true);
+    FillableSigningProvider keystore;
+    BOOST_CHECK(keystore.AddKey(key));
+    const CScript scriptPubKey = GetScriptForDestination(PKHash(key.GetPubKey()));
+
+    // An output confirmed in the genesis block
+    CBlockIndex* pindexPrev = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+    const COutPoint prevout(InsecureRand256(), 0);
+    const CAmount nValue = 1000 * COIN;
+    {
+        LOCK(cs_main);
+        ::ChainstateActive().CoinsTip().AddCoin(prevout, Coin(CTxOut(nValue, scriptPubKey), 0, false, false), false);
+    }
+    const std::vector<StakeKernelCandidate> vCandidates{StakeKernelCandidate(prevout, nValue, pindexPrev)};
+
+    // Search the time slots for a kernel, once the output is old enough to earn a reward
+    unsigned int nTimeTx = (pindexPrev->GetBlockTime() + 10 * 24 * 60 * 60 + params.nStakeTimestampMask) & ~params.nStakeTimestampMask;
+    unsigned int nBits = 0;
+    bool fFound = false;
+    for (int i = 0; i < 1000 && !fFound; i++, nTimeTx += params.nStakeTimestampMask + 1) {
+        CBlockHeader header;
+        header.nVersion = ComputeBlockVersion(pindexPrev, CBlockHeader::AlgoType::ALGO_POS, params);
+        header.nTime = nTimeTx;
+        nBits = GetNextWorkRequired(pindexPrev, &header, params);
+
+        std::vector<StakeKernelModifier> vModifiers;
+        WITH_LOCK(cs_main, GetStakeKernelModifiers(pindexPrev, vCandidates, nTimeTx, vModifiers));
+        size_t nFound = 0;
+        uint256 hashProofOfStake;
+        uint64_t nAttempts = 0;
+        const std::atomic<bool> fStop{false};
+        fFound = SearchStakeKernels(nBits, pindexPrev, vCandidates, vModifiers, 0, vCandidates.size(), nTimeTx, fStop, nFound, hashProofOfStake, nAttempts);
+        if (fFound) break;
+    }
+    BOOST_REQUIRE(fFound);
+
+    CMutableTransaction txCoinStake;
+    txCoinStake.vin.emplace_back(prevout);
+    txCoinStake.vout.emplace_back();
+    txCoinStake.vout[0].SetEmpty();
+    txCoinStake.vout.emplace_back(nValue, scriptPubKey);
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(*m_node.mempool, chainparams).CreateNewBlock(CScript(), &txCoinStake, nTimeTx);
+    CBlock& block = pblocktemplate->block;
+    BOOST_CHECK(block.IsProofOfStake());
+    BOOST_CHECK(block.hashPrevBlock == pindexPrev->GetBlockHash());
+    BOOST_CHECK_EQUAL(block.nTime, nTimeTx);
+    BOOST_CHECK_EQUAL(block.nBits, nBits);
+    BOOST_REQUIRE(block.vtx.size() >= 2);
+    BOOST_CHECK(block.vtx[0]->vout[0].IsEmpty());
+    BOOST_CHECK(block.vtx[1]->IsCoinStake());
+    BOOST_CHECK(block.vtx[1]->vin[0].prevout == prevout);
+    BOOST_CHECK(block.vtx[1]->vout[1].nValue > nValue);
+
+    // An unsigned coinstake doesn't pass validation
+    BlockValidationState state;
+    BOOST_CHECK(!WITH_LOCK(cs_main, return TestBlockValidity(state, chainparams, block, pindexPrev)));
+
+    CMutableTransaction txSigned(*block.vtx[1]);
+    BOOST_CHECK(SignSignature(keystore, scriptPubKey, txSigned, 0, nValue, SIGHASH_ALL));
+    block.vtx[1] = MakeTransactionRef(std::move(txSigned));
+    RegenerateCommitments(block, pindexPrev, params);
+    BOOST_CHECK(key.Sign(block.GetHash(), block.vchBlockSig));
+
+    state = BlockValidationState();
+    BOOST_CHECK_MESSAGE(WITH_LOCK(cs_main, return TestBlockValidity(state, chainparams, block, pindexPrev)), state.ToString());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -12,13 +12,19 @@
 #include <streams.h>
 #include <net.h>
 #include <netbase.h>
+#include <netmessagemaker.h>
 #include <chainparams.h>
+#include <test/util/net.h>
 #include <util/memory.h>
 #include <util/system.h>
 #include <util/string.h>
 
 #include <memory>
 
+#ifndef WIN32
+#include <sys/socket.h>
+#endif
+
 class CAddrManSerializationMock : public CAddrMan
 {
 public:
@@ -77,6 +83,69 @@ static CDataStream AddrmanToStream(CAddrManSerializationMock& _addrman)
     return CDataStream(vchData, SER_DISK, CLIENT_VERSION);
 }
 
+#ifndef WIN32
+/** Message processing, which leaves received messages queued */
+class NoopNetEvents : public NetEventsInterface
+{
+public:
+    bool ProcessMessages(CNode* pnode, std::atomic<bool>& interrupt) override { return false; }
+    bool SendMessages(CNode* pnode) override { return true; }
+    void InitializeNode(CNode* pnode) override {}
+    void FinalizeNode(NodeId id, bool& update_connection_time) override {}
+};
+
+static std::unique_ptr<ConnmanTestMsg> MakeSocketTestConnman(NetEventsInterface& events)
+{
+    std::unique_ptr<ConnmanTestMsg> connman = MakeUnique<ConnmanTestMsg>(0x1337, 0x1337);
+    CConnman::Options options;
+    options.m_msgproc = &events;
+    options.nReceiveFloodSize = 1000 * DEFAULT_MAXRECEIVEBUFFER;
+    options.m_peer_connect_timeout = DEFAULT_PEER_CONNECT_TIMEOUT;
+    connman->Init(options);
+    return connman;
+}
+
+/** Creates an inbound node, connected to the returned peer socket through a pair of local sockets */
+static CNode* NewSocketPairNode(NodeId id, SOCKET& hPeerSocket)
+{
+    int fds[2];
+    BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    hPeerSocket = fds[1];
+
+    in_addr ipv4Addr;
+    ipv4Addr.s_addr = 0xa0b0c001;
+    CAddress addr = CAddress(CService(ipv4Addr, 7777), NODE_NONE);
+    CNode* pnode = new CNode(id, NODE_NETWORK, 0, fds[0], addr, 0, 0, CAddress(), "", true);
+    // held by the connection manager, as for accepted connections
+    pnode->AddRef();
+    return pnode;
+}
+
+static void SendPing(SOCKET hSocket)
+{
+    CSerializedNetMsg msg = CNetMsgMaker(INIT_PROTO_VERSION).Make(NetMsgType::PING, (uint64_t) 1);
+    std::vector<unsigned char> vData;
+    V1TransportSerializer().prepareForTransport(msg, vData);
+    vData.insert(vData.end(), msg.data.begin(), msg.data.end());
+    BOOST_REQUIRE_EQUAL(send(hSocket, vData.data(), vData.size(), MSG_NOSIGNAL), (ssize_t) vData.size());
+}
+
+static size_t ReceivedMessages(CNode* pnode)
+{
+    LOCK(pnode->cs_vProcessMsg);
+    return pnode->vProcessMsg.size();
+}
+
+/** Runs the socket handler until the node has received the given number of messages */
+static bool WaitForMessages(ConnmanTestMsg& connman, CNode* pnode, size_t nMessages)
+{
+    for (int i = 0; i < 100 && ReceivedMessages(pnode) < nMessages; i++) {
+        connman.SocketHandlerOnce();
+    }
+    return ReceivedMessages(pnode) == nMessages;
+}
+#endif
+
 BOOST_FIXTURE_TEST_SUITE(net_tests, BasicTestingSetup)
 
 BOOST_AUTO_TEST_CASE(cnode_listen_port)
@@ -304,6 +373,73 @@ BOOST_AUTO_TEST_CASE(LocalAddress_BasicLifecycle)
     BOOST_CHECK_EQUAL(IsLocal(addr), false);
 }
 
+#ifdef USE_EPOLL
+BOOST_AUTO_TEST_CASE(socket_handler_epoll)
+{
+    NoopNetEvents events;
+    std::unique_ptr<ConnmanTestMsg> connman = MakeSocketTestConnman(events);
+    connman->StartTestEpoll();
+    BOOST_REQUIRE(connman->EpollActive());
+
+    SOCKET hPeerSocket;
+    CNode* pnode = NewSocketPairNode(1, hPeerSocket);
+    connman->AddTestNode(*pnode);
+
+    // the node is registered on the next iteration, and data sent before is reported
+    SendPing(hPeerSocket);
+    BOOST_CHECK(WaitForMessages(*connman, pnode, 1));
+    BOOST_CHECK(connman->EpollRegistered(1));
+
+    // the short read drained the socket, so only new data reports the node again
+    BOOST_CHECK(!connman->EpollReadable(1));
+    connman->SocketHandlerOnce();
+    BOOST_CHECK_EQUAL(ReceivedMessages(pnode), 1U);
+    SendPing(hPeerSocket);
+    BOOST_CHECK(WaitForMessages(*connman, pnode, 2));
+
+    // disconnected nodes are removed, and their socket is closed
+    pnode->fDisconnect = true;
+    connman->SocketHandlerOnce();
+    BOOST_CHECK(!connman->EpollRegistered(1));
+    BOOST_CHECK(!connman->EpollReadable(1));
+    char ch;
+    BOOST_CHECK_EQUAL(recv(hPeerSocket, &ch, 1, MSG_DONTWAIT), 0);
+    close(hPeerSocket);
+
+    connman->StopTestEpoll();
+    BOOST_CHECK(!connman->EpollActive());
+}
+#endif
+
+#ifndef WIN32
+BOOST_AUTO_TEST_CASE(socket_handler_fallback)
+{
+    NoopNetEvents events;
+    std::unique_ptr<ConnmanTestMsg> connman = MakeSocketTestConnman(events);
+#ifdef USE_EPOLL
+    // without epoll, as after a failed setup, the nodes are polled
+    connman->StartTestEpoll();
+    connman->StopTestEpoll();
+    BOOST_REQUIRE(!connman->EpollActive());
+#endif
+
+    SOCKET hPeerSocket;
+    CNode* pnode = NewSocketPairNode(1, hPeerSocket);
+    connman->AddTestNode(*pnode);
+
+    SendPing(hPeerSocket);
+    BOOST_CHECK(WaitForMessages(*connman, pnode, 1));
+    SendPing(hPeerSocket);
+    BOOST_CHECK(WaitForMessages(*connman, pnode, 2));
+
+    pnode->fDisconnect = true;
+    connman->SocketHandlerOnce();
+    char ch;
+    BOOST_CHECK_EQUAL(recv(hPeerSocket, &ch, 1, MSG_DONTWAIT), 0);
+    close(hPeerSocket);
+}
+#endif
+
 BOOST_AUTO_TEST_CASE(PoissonNextSend)
 {
     g_mock_deterministic_tests = true;
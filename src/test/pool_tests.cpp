@@ -0,0 +1,98 @@
+// Copyright (c) 2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <memusage.h>
+#include <support/allocators/pool.h>
+
+#include <test/util/setup_common.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(pool_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(basic_allocating)
+{
+    PoolResource<8, 8> resource;
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+
+    // A freed block is handed out again for the next allocation of its size.
+    void* block = resource.Allocate(8, 8);
+    resource.Deallocate(block, 8, 8);
+    BOOST_CHECK(block == resource.Allocate(8, 8));
+
+    // Consecutive allocations are carved out of the chunk.
+    void* next = resource.Allocate(8, 8);
+    BOOST_CHECK(static_cast<char*>(block) + 8 == next);
+
+    // Blocks larger than the pool's limit, or with a larger alignment, fall back to operator new.
+    void* large = resource.Allocate(16, 8);
+    void* aligned = resource.Allocate(8, 16);
+    resource.Deallocate(large, 16, 8);
+    resource.Deallocate(aligned, 8, 16);
+
+    resource.Deallocate(block, 8, 8);
+    resource.Deallocate(next, 8, 8);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+}
+
+BOOST_AUTO_TEST_CASE(allocate_many)
+{
+    PoolResource<128, 8> resource(1024);
+    BOOST_CHECK_EQUAL(resource.ChunkSizeBytes(), 1024U);
+
+    std::vector<std::pair<void*, size_t>> blocks;
+    for (size_t i = 0; i < 1000; ++i) {
+        const size_t size = 1 + i % 128;
+        void* p = resource.Allocate(size, 8);
+        BOOST_CHECK(reinterpret_cast<uintptr_t>(p) % 8 == 0);
+        blocks.emplace_back(p, size);
+    }
+    const size_t chunks = resource.NumAllocatedChunks();
+    BOOST_CHECK(chunks > 1);
+
+    // Freeing and allocating the same blocks again is served from the freelists.
+    for (const auto& block : blocks) {
+        resource.Deallocate(block.first, block.second, 8);
+    }
+    for (auto& block : blocks) {
+        block.first = resource.Allocate(block.second, 8);
+    }
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), chunks);
+    for (const auto& block : blocks) {
+        resource.Deallocate(block.first, block.second, 8);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(memusage_test)
+{
+    typedef std::pair<const int, int> Value;
+    typedef std::unordered_map<int, int, std::hash<int>, std::equal_to<int>,
+                               PoolAllocator<Value, sizeof(Value) + sizeof(void*) * 4, alignof(void*)>> Map;
+    Map::allocator_type::ResourceType resource;
+    Map map{0, std::hash<int>{}, std::equal_to<int>{}, &resource};
+
+    for (int i = 0; i < 100000; ++i) {
+        map[i];
+    }
+
+    // The pool accounts for its chunks rather than for each node.
+    const size_t usage = memusage::DynamicUsage(map);
+    BOOST_CHECK(resource.NumAllocatedChunks() > 1);
+    BOOST_CHECK(usage >= resource.NumAllocatedChunks() * resource.ChunkSizeBytes());
+    BOOST_CHECK(usage >= map.size() * sizeof(Value));
+
+    // Erased nodes return to the pool, which keeps its chunks until it is destroyed.
+    const size_t chunks = resource.NumAllocatedChunks();
+    map.clear();
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), chunks);
+    for (int i = 0; i < 100000; ++i) {
+        map[i];
+    }
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), chunks);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -12,6 +12,8 @@
 #include <test/util/setup_common.h>
 #include <util/time.h>
 
+#include <thread>
+
 #include <boost/algorithm/string.hpp>
 #include <boost/test/unit_test.hpp>
 
@@ -413,4 +415,93 @@ BOOST_AUTO_TEST_CASE(rpc_getblockstats_calculate_percentiles_by_weight)
     }
 }
 
+BOOST_AUTO_TEST_CASE(rpc_batch_order)
+{
+    if (RPCIsInWarmup(nullptr)) SetRPCWarmupFinished();
+
+    UniValue vReq(UniValue::VARR);
+    for (int i = 0; i < 50; i++) {
+        UniValue params(UniValue::VARR);
+        params.push_back(i);
+        vReq.push_back(JSONRPCRequestObj(i % 10 == 9 ? "nosuchmethod" : "echo", params, i));
+    }
+    vReq.push_back(1); // not a request object
+
+    std::vector<std::thread> vThreads;
+    const RPCTaskRunner runner = [&vThreads](const std::function<void()>& task) {
+        vThreads.emplace_back(task);
+        return true;
+    };
+    const RPCTaskRunner failing_runner = [](const std::function<void()>& task) { return false; };
+
+    for (const std::pair<const RPCTaskRunner*, unsigned int>& config : std::vector<std::pair<const RPCTaskRunner*, unsigned int>>{{nullptr, 1}, {&runner, 4}, {&runner, 100}, {&failing_runner, 4}}) {
+        const std::string strReply = JSONRPCExecBatch(JSONRPCRequest(), vReq, config.first ? *config.first : nullptr, config.second);
+        for (std::thread& thread : vThreads) thread.join();
+        vThreads.clear();
+
+        UniValue replies;
+        BOOST_CHECK(replies.read(strReply));
+        BOOST_CHECK_EQUAL(replies.size(), vReq.size());
+        for (int i = 0; i < 50; i++) {
+            BOOST_CHECK_EQUAL(find_value(replies[i], "id").get_int(), i);
+            if (i % 10 == 9) {
+                BOOST_CHECK_EQUAL(find_value(find_value(replies[i], "error"), "code").get_int(), RPC_METHOD_NOT_FOUND);
+            } else {
+                BOOST_CHECK_EQUAL(find_value(replies[i], "result")[0].get_int(), i);
+            }
+        }
+        BOOST_CHECK(find_value(replies[50], "id").isNull());
+        BOOST_CHECK(find_value(replies[50], "error").isObject());
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(rpc_stream_writer)
+{
+    std::vector<std::string> vChunks;
+    JSONStreamWriter writer([&vChunks](const std::string& chunk) { vChunks.push_back(chunk); }, 16);
+    BOOST_CHECK(!writer.HasOutput());
+
+    writer.BeginObject();
+    writer.Key("a");
+    writer.Value(1);
+    writer.Key("b");
+    writer.BeginArray();
+    for (int i = 0; i < 10; i++) {
+        UniValue obj(UniValue::VOBJ);
+        obj.pushKV("i", i);
+        writer.Value(obj);
+    }
+    writer.BeginArray();
+    writer.EndArray();
+    writer.EndArray();
+    writer.Key("c\"");
+    writer.Value("x");
+    writer.EndObject();
+    writer.Flush();
+    BOOST_CHECK(writer.HasOutput());
+    BOOST_CHECK(vChunks.size() > 1);
+
+    UniValue result;
+    BOOST_CHECK(result.read(boost::algorithm::join(vChunks, "")));
+    BOOST_CHECK_EQUAL(find_value(result, "a").get_int(), 1);
+    BOOST_CHECK_EQUAL(find_value(result, "b").size(), 11U);
+    BOOST_CHECK_EQUAL(find_value(find_value(result, "b")[9], "i").get_int(), 9);
+    BOOST_CHECK_EQUAL(find_value(result, "c\"").get_str(), "x");
+
+    // An interrupted result is closed, so that the reply stays valid JSON
+    vChunks.clear();
+    JSONStreamWriter interrupted([&vChunks](const std::string& chunk) { vChunks.push_back(chunk); });
+    interrupted.BeginArray();
+    interrupted.Value(1);
+    interrupted.BeginObject();
+    interrupted.Key("k");
+    // Nothing is handed to the sink before the buffer is full, so an error can still be replied on its own
+    BOOST_CHECK(interrupted.HasOutput());
+    BOOST_CHECK(vChunks.empty());
+    interrupted.Close();
+    interrupted.Flush();
+    BOOST_CHECK_EQUAL(boost::algorithm::join(vChunks, ""), "[1,{\"k\":null}]");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,75 @@
+// Copyright (c) 2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <key.h>
+#include <primitives/transaction.h>
+#include <pubkey.h>
+#include <random.h>
+#include <script/sigcache.h>
+#include <test/util/setup_common.h>
+#include <uint256.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(sigcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(sigcache_domains_separated)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const uint256 hash = InsecureRand256();
+    std::vector<unsigned char> vchSig;
+    BOOST_REQUIRE(key.Sign(hash, vchSig));
+
+    // a cached script signature doesn't satisfy a lookup of a block signature
+    {
+        CSignatureCache cache;
+        cache.setup_bytes(1 << 20);
+        uint256 entryECDSA, entryBlock;
+        cache.ComputeEntryECDSA(entryECDSA, hash, vchSig, key.GetPubKey());
+        cache.ComputeEntryBlock(entryBlock, hash, vchSig, key.GetPubKey());
+        BOOST_CHECK(entryECDSA != entryBlock);
+
+        cache.Set(entryECDSA);
+        BOOST_CHECK(cache.Get(entryECDSA, false));
+        BOOST_CHECK(!cache.Get(entryBlock, false));
+    }
+
+    // and a cached block signature doesn't satisfy a lookup of a script signature
+    {
+        CSignatureCache cache;
+        cache.setup_bytes(1 << 20);
+        uint256 entryECDSA, entryBlock;
+        cache.ComputeEntryECDSA(entryECDSA, hash, vchSig, key.GetPubKey());
+        cache.ComputeEntryBlock(entryBlock, hash, vchSig, key.GetPubKey());
+
+        cache.Set(entryBlock);
+        BOOST_CHECK(cache.Get(entryBlock, false));
+        BOOST_CHECK(!cache.Get(entryECDSA, false));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(sigcache_compact_block_signature)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const uint256 hash = InsecureRand256();
+    std::vector<unsigned char> vchSig;
+    BOOST_REQUIRE(key.SignCompact(hash, vchSig, CPubKey::VERSION_SIG_COMPACT));
+
+    // the compact signature is valid for the block, and is cached
+    BOOST_CHECK(CachingVerifyBlockSignature(vchSig, key.GetPubKey(), hash));
+    BOOST_CHECK(CachingVerifyBlockSignature(vchSig, key.GetPubKey(), hash));
+
+    // but it isn't a valid signature in a script, cached or not
+    CMutableTransaction mtx;
+    const CTransaction tx(mtx);
+    PrecomputedTransactionData txdata(tx);
+    CachingTransactionSignatureChecker checker(&tx, 0, 0, nullptr, true, txdata);
+    BOOST_CHECK(!checker.VerifySignature(vchSig, key.GetPubKey(), hash));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
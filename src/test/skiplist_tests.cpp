@@ -2,7 +2,10 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <arith_uint256.h>
 #include <chain.h>
+#include <chainparams.h>
+#include <pow.h>
 #include <test/util/setup_common.h>
 
 #include <vector>
@@ -42,6 +45,71 @@ BOOST_AUTO_TEST_CASE(skiplist_test)
     }
 }
 
+BOOST_AUTO_TEST_CASE(algoskip_test)
+{
+    std::vector<CBlockIndex> vIndex(10000);
+
+    for (int i = 0; i < (int)vIndex.size(); i++) {
+        // Long single-algo stretches mixed with random blocks
+        const bool fProofOfStake = (i / 500) % 2 ? InsecureRandBool() : (i / 1000) % 2;
+        vIndex[i].nHeight = i;
+        vIndex[i].nVersion = CBlockHeader::GetAlgoFlag(fProofOfStake ? CBlockHeader::AlgoType::ALGO_POS : CBlockHeader::AlgoType::ALGO_POW_SHA256);
+        if (fProofOfStake)
+            vIndex[i].SetProofOfStake();
+        vIndex[i].pprev = (i == 0) ? nullptr : &vIndex[i - 1];
+        vIndex[i].BuildSkip();
+        vIndex[i].BuildAlgoSkip();
+    }
+
+    for (int i = 0; i < (int)vIndex.size(); i++) {
+        const CBlockIndex* pindexPoS = nullptr;
+        const CBlockIndex* pindexPoW = nullptr;
+        for (const CBlockIndex* pindex = vIndex[i].pprev; pindex && (!pindexPoS || !pindexPoW); pindex = pindex->pprev) {
+            if (!pindexPoS && pindex->IsProofOfStake())
+                pindexPoS = pindex;
+            if (!pindexPoW && pindex->IsProofOfWork())
+                pindexPoW = pindex;
+        }
+        BOOST_CHECK(vIndex[i].pprevPoS == pindexPoS);
+        BOOST_CHECK(vIndex[i].pprevPoW == pindexPoW);
+        BOOST_CHECK(vIndex[i].pprevAlgo[CBlockHeader::AlgoType::ALGO_POS] == pindexPoS);
+        BOOST_CHECK(vIndex[i].pprevAlgo[CBlockHeader::AlgoType::ALGO_POW_SHA256] == pindexPoW);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(algoskip_difficulty_test)
+{
+    // The same chain, once with and once without the per-algo predecessor pointers
+    const Consensus::Params& params = Params().GetConsensus();
+    std::vector<CBlockIndex> vIndex(5000), vIndexNoSkip(5000);
+
+    for (int i = 0; i < (int)vIndex.size(); i++) {
+        const bool fProofOfStake = (i / 500) % 2 ? InsecureRandBool() : (i / 1000) % 2;
+        for (std::vector<CBlockIndex>* pvIndex : {&vIndex, &vIndexNoSkip}) {
+            CBlockIndex& index = (*pvIndex)[i];
+            index.nHeight = i;
+            index.nVersion = CBlockHeader::GetAlgoFlag(fProofOfStake ? CBlockHeader::AlgoType::ALGO_POS : CBlockHeader::AlgoType::ALGO_POW_SHA256);
+            if (fProofOfStake)
+                index.SetProofOfStake();
+            index.nTime = 1600000000 + i * 60 + (i % 7) * 5;
+            index.nBits = UintToArith256(params.powLimit[CBlockHeader::GetAlgoType(index.nVersion)]).GetCompactBase256();
+            index.pprev = (i == 0) ? nullptr : &(*pvIndex)[i - 1];
+            index.BuildSkip();
+        }
+        vIndex[i].BuildAlgoSkip();
+    }
+
+    // Block indexes without the pointers are walked back one block at a time, with the same result
+    for (int i = 0; i < 1000; i++) {
+        const int nHeight = InsecureRandRange(vIndex.size());
+        CBlockHeader header;
+        header.nVersion = CBlockHeader::GetAlgoFlag(InsecureRandBool() ? CBlockHeader::AlgoType::ALGO_POS : CBlockHeader::AlgoType::ALGO_POW_SHA256);
+        header.nTime = vIndex[nHeight].nTime + 1 + InsecureRandRange(120);
+        BOOST_CHECK_EQUAL(GetNextWorkRequired(&vIndex[nHeight], &header, params), GetNextWorkRequired(&vIndexNoSkip[nHeight], &header, params));
+        BOOST_CHECK_EQUAL(WeightedTargetExponentialMovingAverage(&vIndex[nHeight], &header, params), WeightedTargetExponentialMovingAverage(&vIndexNoSkip[nHeight], &header, params));
+    }
+}
+
 BOOST_AUTO_TEST_CASE(getlocator_test)
 {
     // Build a main chain 100000 blocks long.
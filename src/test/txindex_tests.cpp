@@ -3,15 +3,54 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <consensus/validation.h>
 #include <index/txindex.h>
+#include <miner.h>
+#include <pow.h>
 #include <script/standard.h>
 #include <test/util/setup_common.h>
 #include <util/time.h>
+#include <validation.h>
 
 #include <boost/test/unit_test.hpp>
 
 BOOST_AUTO_TEST_SUITE(txindex_tests)
 
+/** Creates blocks on top of the genesis block, below the first treasury block of regtest. */
+struct TxCacheTestingSetup : public RegTestingSetup {
+    CTransactionRef CreateAndProcessBlock(const CScript& scriptPubKey)
+    {
+        const CChainParams& chainparams = Params();
+        std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(*m_node.mempool, chainparams).CreateNewBlock(scriptPubKey);
+        CBlock& block = pblocktemplate->block;
+
+        block.vtx.resize(1);
+        {
+            LOCK(cs_main);
+            unsigned int extraNonce = 0;
+            IncrementExtraNonce(&block, ::ChainActive().Tip(), extraNonce);
+            RegenerateCommitments(block, ::ChainActive().Tip(), chainparams.GetConsensus());
+        }
+
+        while (!CheckProofOfWork(block.GetPoWHash(), block.nBits, CBlockHeader::GetAlgoType(block.nVersion), chainparams.GetConsensus())) ++block.nNonce;
+
+        std::shared_ptr<const CBlock> shared_pblock = std::make_shared<const CBlock>(block);
+        BOOST_REQUIRE(ProcessNewBlock(chainparams, shared_pblock, true, nullptr));
+        return block.vtx[0];
+    }
+};
+
+static bool WaitForSync(TxIndex& txindex)
+{
+    constexpr int64_t timeout_ms = 10 * 1000;
+    int64_t time_start = GetTimeMillis();
+    while (!txindex.BlockUntilSyncedToCurrentChain()) {
+        if (time_start + timeout_ms <= GetTimeMillis()) return false;
+        UninterruptibleSleep(std::chrono::milliseconds{100});
+    }
+    return true;
+}
+
 BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
 {
     TxIndex txindex(1 << 20, true);
@@ -78,4 +117,77 @@ BOOST_FIXTURE_TEST_CASE(txindex_initial_sync, TestChain100Setup)
     // Rest of shutdown sequence and destructors happen in ~TestingSetup()
 }
 
+BOOST_FIXTURE_TEST_CASE(txindex_tx_cache, TxCacheTestingSetup)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    const CScript coinbase_script_pub_key = GetScriptForDestination(PKHash(key.GetPubKey()));
+    std::vector<CTransactionRef> txns;
+    for (int i = 0; i < 5; i++) {
+        txns.push_back(CreateAndProcessBlock(coinbase_script_pub_key));
+    }
+
+    TxIndex txindex(1 << 20, true, false, 1 << 20);
+    TxIndex txindex_uncached(1 << 20, true);
+    txindex.Start();
+    txindex_uncached.Start();
+    BOOST_REQUIRE(WaitForSync(txindex));
+    BOOST_REQUIRE(WaitForSync(txindex_uncached));
+
+    CTransactionRef tx_disk;
+    uint256 block_hash, cached_block_hash;
+
+    // The first lookups are read from disk, and cached.
+    for (const auto& txn : txns) {
+        BOOST_CHECK(txindex.FindTx(txn->GetHash(), block_hash, tx_disk));
+        BOOST_CHECK_EQUAL(tx_disk->GetHash(), txn->GetHash());
+    }
+    TxCacheStats stats = txindex.GetCacheStats();
+    BOOST_CHECK_EQUAL(stats.hits, 0U);
+    BOOST_CHECK_EQUAL(stats.misses, txns.size());
+    BOOST_CHECK_EQUAL(stats.entries, txns.size());
+    BOOST_CHECK(stats.usage > 0 && stats.usage <= stats.max_usage);
+
+    // Repeated lookups are served from the cache, with the same result.
+    for (const auto& txn : txns) {
+        BOOST_CHECK(txindex.FindTx(txn->GetHash(), cached_block_hash, tx_disk));
+        BOOST_CHECK_EQUAL(tx_disk->GetHash(), txn->GetHash());
+        BOOST_CHECK(txindex_uncached.FindTx(txn->GetHash(), block_hash, tx_disk));
+        BOOST_CHECK_EQUAL(cached_block_hash, block_hash);
+    }
+    stats = txindex.GetCacheStats();
+    BOOST_CHECK_EQUAL(stats.hits, txns.size());
+    BOOST_CHECK_EQUAL(stats.misses, txns.size());
+
+    // Transactions of a reconnected block are evicted, once the block is indexed again.
+    CBlockIndex* tip = WITH_LOCK(cs_main, return ::ChainActive().Tip());
+    BlockValidationState state;
+    BOOST_REQUIRE(InvalidateBlock(state, Params(), tip));
+    {
+        LOCK(cs_main);
+        ResetBlockFailureFlags(tip);
+    }
+    BOOST_REQUIRE(ActivateBestChain(state, Params()));
+    BOOST_REQUIRE(WaitForSync(txindex));
+    stats = txindex.GetCacheStats();
+    BOOST_CHECK_EQUAL(stats.entries, txns.size() - 1);
+    BOOST_CHECK(txindex.FindTx(txns.back()->GetHash(), block_hash, tx_disk));
+    BOOST_CHECK_EQUAL(block_hash, tip->GetBlockHash());
+
+    // Without a cache, nothing is counted.
+    stats = txindex_uncached.GetCacheStats();
+    BOOST_CHECK_EQUAL(stats.hits, 0U);
+    BOOST_CHECK_EQUAL(stats.entries, 0U);
+    BOOST_CHECK_EQUAL(stats.max_usage, 0U);
+
+    // shutdown sequence (c.f. Shutdown() in init.cpp)
+    txindex.Stop();
+    txindex_uncached.Stop();
+
+    // txindex job may be scheduled, so stop scheduler before destructing
+    m_node.scheduler->stop();
+    threadGroup.interrupt_all();
+    threadGroup.join_all();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
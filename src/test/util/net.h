@@ -13,6 +13,9 @@ struct ConnmanTestMsg : public CConnman {
     {
         LOCK(cs_vNodes);
         vNodes.push_back(&node);
+#ifdef USE_EPOLL
+        if (m_epoll_fd != -1) m_nodes_pending_registration.push_back(&node);
+#endif
     }
     void ClearTestNodes()
     {
@@ -23,6 +26,27 @@ struct ConnmanTestMsg : public CConnman {
         vNodes.clear();
     }
 
+    /** Runs one iteration of the socket handler, with epoll if it is set up */
+    void SocketHandlerOnce()
+    {
+        DisconnectNodes();
+#ifdef USE_EPOLL
+        if (m_epoll_fd != -1) {
+            SocketHandlerEpoll();
+            return;
+        }
+#endif
+        SocketHandler();
+    }
+
+#ifdef USE_EPOLL
+    void StartTestEpoll() { StartEpoll(); }
+    void StopTestEpoll() { StopEpoll(); }
+    bool EpollActive() const { return m_epoll_fd != -1; }
+    bool EpollRegistered(NodeId id) const { return m_epoll_nodes.count(id) > 0; }
+    bool EpollReadable(NodeId id) const { return m_epoll_readable.count(id) > 0; }
+#endif
+
     void ProcessMessagesOnce(CNode& node) { m_msgproc->ProcessMessages(&node, flagInterruptMsgProc); }
 
     void NodeReceiveMsgBytes(CNode& node, const char* pch, unsigned int nBytes, bool& complete) const;
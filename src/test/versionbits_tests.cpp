@@ -82,6 +82,7 @@ public:
             pindex->nTime = nTime;
             pindex->nVersion = nVersion;
             pindex->BuildSkip();
+            pindex->BuildAlgoSkip();
             vpblock.push_back(pindex);
         }
         return *this;
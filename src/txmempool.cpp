@@ -20,6 +20,7 @@
 #include <validationinterface.h>
 #include <script/sign.h>
 
+#include <omnicore/mempooloverlay.h>
 #include <omnicore/omnicore.h> // RemoveFromMarkerCache
 
 CTxMemPoolEntry::CTxMemPoolEntry(const CTransactionRef& _tx, const CAmount& _nFee,
@@ -425,6 +426,9 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason)
     for (const CTxIn& txin : it->GetTx().vin)
         mapNextTx.erase(txin.prevout);
 
+    // Omni Core: pending state of the transaction is gone, whether confirmed or evicted
+    mastercore::mempoolOverlay.Remove(hash);
+
     if (vTxHashes.size() > 1) {
         vTxHashes[it->vTxHashesIdx] = std::move(vTxHashes.back());
         vTxHashes[it->vTxHashesIdx].second->vTxHashesIdx = it->vTxHashesIdx;
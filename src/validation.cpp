@@ -17,6 +17,7 @@
 #include <cuckoocache.h>
 #include <flatfile.h>
 #include <hash.h>
+#include <index/addressindex.h>
 #include <index/txindex.h>
 #include <logging.h>
 #include <logging/timer.h>
@@ -196,6 +197,10 @@ CBlockIndex* FindForkInGlobalIndex(const CChain& chain, const CBlockLocator& loc
 
 std::unique_ptr<CBlockTreeDB> pblocktree;
 
+CBlockIndexColdStore g_blockindex_cold([](const uint256& hash, CBlockIndexColdData& data) {
+    return pblocktree && pblocktree->ReadBlockIndexColdData(hash, data);
+});
+
 // See definition for documentation
 static void FindFilesToPruneManual(std::set<int>& setFilesToPrune, int nManualPruneHeight);
 static void FindFilesToPrune(std::set<int>& setFilesToPrune, uint64_t nPruneAfterHeight);
@@ -1317,7 +1322,7 @@ CAmount GetTreasuryPayment(int nHeight, const Consensus::Params& consensusParams
                     GetCoinAge(*block.vtx[1], ::ChainstateActive().CoinsTip(), block.nTime, i, nCoinAge);
                 }
                 blockValue += GetBlockSubsidy(i, pindex->IsProofOfStake(), nCoinAge, consensusParams, false);*/
-                blockValue += pindex->nMint - pindex->nTreasuryPayment;
+                blockValue += pindex->nMint - pindex->GetTreasuryPayment();
             }
         }
         return blockValue * consensusParams.nTreasuryRewardPercentage / std::max(100 - consensusParams.nTreasuryRewardPercentage, 1u); // 10% of block value paid to treasury
@@ -1793,7 +1798,7 @@ int ApplyTxInUndo(Coin&& undo, CCoinsViewCache& view, const COutPoint& out)
 
 /** Undo the effects of this block (with given index) on the UTXO set represented by coins.
  *  When FAILED is returned, view is left in an indeterminate state. */
-DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view, bool clean)
+DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockIndex* pindex, CCoinsViewCache& view)
 {
     bool fClean = true;
 
@@ -1808,9 +1813,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
         return DISCONNECT_FAILED;
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount>> addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> addressUnspentIndex;
-
     // undo transactions in reverse order
     for (int i = block.vtx.size() - 1; i >= 0; i--) {
         const CTransaction& tx = *(block.vtx[i]);
@@ -1835,26 +1837,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
             }
         }
 
-        if (!clean && fAddressIndex) {
-            for (unsigned int k = tx.vout.size(); k-- > 0;) {
-                const CTxOut& out = tx.vout[k];
-
-                CTxDestination dest;
-                if (ExtractDestination(out.scriptPubKey, dest)) {
-                    std::vector<unsigned char> bytesID(boost::apply_visitor(DataVisitor(), dest));
-                    if (bytesID.empty()) {
-                        continue;
-                    }
-                    std::vector<unsigned char> addressBytes(32);
-                    std::copy(bytesID.begin(), bytesID.end(), addressBytes.begin());
-                    // undo receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(dest.which(), uint256(addressBytes), pindex->nHeight, i, hash, k, false), out.nValue));
-                    // undo unspent index
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(dest.which(), uint256(addressBytes), hash, k), CAddressUnspentValue()));
-                }
-            }
-        }
-
         // restore inputs
         if (i > 0) { // not coinbases
             CTxUndo& txundo = blockUndo.vtxundo[i - 1];
@@ -1867,27 +1849,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
                 int res = ApplyTxInUndo(std::move(txundo.vprevout[j]), view, out);
                 if (res == DISCONNECT_FAILED) return DISCONNECT_FAILED;
                 fClean = fClean && res != DISCONNECT_UNCLEAN;
-
-                const auto& undo = txundo.vprevout[j];
-                const bool isTxCoinBase = tx.IsCoinBase();
-                const CTxIn input = tx.vin[j];
-                if (!clean && fAddressIndex) {
-                    const CTxOut& prevout = view.GetOutputFor(input);
-
-                    CTxDestination dest;
-                    if (ExtractDestination(prevout.scriptPubKey, dest)) {
-                        std::vector<unsigned char> bytesID(boost::apply_visitor(DataVisitor(), dest));
-                        if (bytesID.empty()) {
-                            continue;
-                        }
-                        std::vector<unsigned char> addressBytes(32);
-                        std::copy(bytesID.begin(), bytesID.end(), addressBytes.begin());
-                        // undo spending activity
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(dest.which(), uint256(addressBytes), pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
-                        // restore unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(dest.which(), uint256(addressBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undo.nHeight, isTxCoinBase)));
-                    }
-                }
             }
             // At this point, all of txundo.vprevout should have been moved out.
         }
@@ -1896,17 +1857,6 @@ DisconnectResult CChainState::DisconnectBlock(const CBlock& block, const CBlockI
     // move best block pointer to prevout block
     view.SetBestBlock(pindex->pprev->GetBlockHash());
 
-    if (!clean && fAddressIndex) {
-        if (!pblocktree->EraseAddressIndex(addressIndex)) {
-            error("Failed to delete address index");
-            return DISCONNECT_FAILED;
-        }
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            error("Failed to write address unspent index");
-            return DISCONNECT_FAILED;
-        }
-    }
-
     return fClean ? DISCONNECT_OK : DISCONNECT_UNCLEAN;
 }
 
@@ -2061,11 +2011,12 @@ static unsigned int GetBlockScriptFlags(const CBlockIndex* pindex, const Consens
 }
 
 // These checks can only be done when all previous blocks have been added.
-static inline bool ContextualCheckPoSBlock(const CBlock& block, const bool& fProofOfStake, BlockValidationState& state, const CCoinsViewCache& view, CBlockIndex* pindex, const Consensus::Params& params, bool fJustCheck)
+// If pvChecks is not nullptr, the coinstake script check is appended to it instead of being run (see CheckProofOfStake).
+static inline bool ContextualCheckPoSBlock(const CBlock& block, const bool& fProofOfStake, BlockValidationState& state, const CCoinsViewCache& view, CBlockIndex* pindex, const Consensus::Params& params, bool fJustCheck, bool cacheStore = true, PrecomputedTransactionData* txdata = nullptr, std::vector<CScriptCheck>* pvChecks = nullptr)
 {
     uint256 hashProofOfStake = uint256();
     // peercoin: verify hash target and signature of coinstake tx
-    if (fProofOfStake && !CheckProofOfStake(state, view, pindex->pprev, block.vtx[1], block.nBits, block.nTime, hashProofOfStake)) {
+    if (fProofOfStake && !CheckProofOfStake(state, view, pindex->pprev, block.vtx[1], block.nBits, block.nTime, hashProofOfStake, cacheStore, txdata, pvChecks)) {
         LogPrintf("WARNING: %s: check proof-of-stake failed for block %s %d\n", __func__, pindex->GetBlockHash().ToString(), fProofOfStake);
         return false; // do not error here as we expect this during initial block download
     }
@@ -2094,24 +2045,17 @@ static inline bool ContextualCheckPoSBlock(const CBlock& block, const bool& fPro
     // compute nStakeModifierChecksum begin
     const unsigned int nFlagsBackup = pindex->nFlags;
     const uint64_t nStakeModifierBackup = pindex->nStakeModifier;
-    const uint256 hashProofOfStakeBackup = pindex->hashProofOfStake;
 
     // set necessary pindex fields
     if (!pindex->SetStakeEntropyBit(nEntropyBit))
         return error("ConnectBlock(): SetStakeEntropyBit() failed");
     pindex->SetStakeModifier(nStakeModifier, fGeneratedStakeModifier);
-    if (fProofOfStake) {
-        pindex->hashProofOfStake = hashProofOfStake;
-    }
 
-    const unsigned int nStakeModifierChecksum = GetStakeModifierChecksum(pindex);
+    const unsigned int nStakeModifierChecksum = GetStakeModifierChecksum(pindex, hashProofOfStake);
 
     // undo pindex fields
     pindex->nFlags = nFlagsBackup;
     pindex->nStakeModifier = nStakeModifierBackup;
-    if (fProofOfStake) {
-        pindex->hashProofOfStake = hashProofOfStakeBackup;
-    }
     // compute nStakeModifierChecksum end
 
     if (!CheckStakeModifierCheckpoints(pindex->nHeight, nStakeModifierChecksum))
@@ -2127,7 +2071,7 @@ static inline bool ContextualCheckPoSBlock(const CBlock& block, const bool& fPro
     pindex->SetStakeModifier(nStakeModifier, fGeneratedStakeModifier);
     // pindex->SetStakeModifierV2(nStakeModifierV2, fGeneratedStakeModifier);
     if (fProofOfStake) {
-        pindex->hashProofOfStake = hashProofOfStake;
+        pindex->SetHashProofOfStake(hashProofOfStake);
     }
     pindex->nStakeModifierChecksum = nStakeModifierChecksum;
     setDirtyBlockIndex.insert(pindex); // queue a write to disk
@@ -2210,10 +2154,17 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
     else if (!fProofOfStake && pindex->nHeight > chainparams.GetConsensus().nLastPoWBlock)
         return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "PoW-ended", strprintf("%s: PoW period ended", __func__));
 
-    if (!pindex->GeneratedStakeModifier() && /*pindex->nStakeModifierChecksum == 0 &&*/ !ContextualCheckPoSBlock(block, fProofOfStake, state, view, pindex, chainparams.GetConsensus(), fJustCheck))
-    {
-        return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-pos", "proof of stake is incorrect"); // return invalid state here because we don't check in AcceptBlock
-        // return error("%s: failed PoS check %s", __func__, state.ToString());
+    // The coinstake script check is run by the script check queue along with the checks of all other inputs
+    std::vector<CScriptCheck> vPoSChecks;
+    std::unique_ptr<PrecomputedTransactionData> txdataCoinStake;
+    if (!pindex->GeneratedStakeModifier() /*&& pindex->nStakeModifierChecksum == 0*/) {
+        if (fProofOfStake)
+            txdataCoinStake.reset(new PrecomputedTransactionData(*block.vtx[1]));
+        if (!ContextualCheckPoSBlock(block, fProofOfStake, state, view, pindex, chainparams.GetConsensus(), fJustCheck, fJustCheck, txdataCoinStake.get(), g_parallel_script_checks ? &vPoSChecks : nullptr))
+        {
+            return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-pos", "proof of stake is incorrect"); // return invalid state here because we don't check in AcceptBlock
+            // return error("%s: failed PoS check %s", __func__, state.ToString());
+        }
     }
 
     bool fScriptChecks = true;
@@ -2359,7 +2310,8 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     CBlockUndo blockundo;
 
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && g_parallel_script_checks ? &scriptcheckqueue : nullptr);
+    CCheckQueueControl<CScriptCheck> control((fScriptChecks || !vPoSChecks.empty()) && g_parallel_script_checks ? &scriptcheckqueue : nullptr);
+    control.Add(vPoSChecks);
 
     std::vector<int> prevheights;
     CAmount nFees = 0;
@@ -2371,10 +2323,6 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
     int64_t nSigOpsCost = 0;
     blockundo.vtxundo.reserve(block.vtx.size() - 1);
 
-    std::vector<std::pair<CAddressIndexKey, CAmount>> addressIndex;
-    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>> addressUnspentIndex;
-    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue>> spentIndex;
-
     std::vector<PrecomputedTransactionData> txdata;
     txdata.reserve(block.vtx.size()); // Required so that pointers to individual PrecomputedTransactionData don't get invalidated
     for (unsigned int i = 0; i < block.vtx.size(); i++) {
@@ -2412,28 +2360,6 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
                 LogPrintf("ERROR: %s: contains a non-BIP68-final transaction\n", __func__);
                 return state.Invalid(BlockValidationResult::BLOCK_CONSENSUS, "bad-txns-nonfinal");
             }
-
-            if (fAddressIndex) {
-                for (size_t j = 0; j < tx.vin.size(); j++) {
-                    const CTxIn input = tx.vin[j];
-                    const CTxOut& prevout = view.GetOutputFor(tx.vin[j]);
-
-                    CTxDestination dest;
-                    if (ExtractDestination(prevout.scriptPubKey, dest)) {
-                        std::vector<unsigned char> bytesID(boost::apply_visitor(DataVisitor(), dest));
-                        if (bytesID.empty()) {
-                            continue;
-                        }
-                        std::vector<unsigned char> addressBytes(32);
-                        std::copy(bytesID.begin(), bytesID.end(), addressBytes.begin());
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(dest.which(), uint256(addressBytes), pindex->nHeight, i, tx.GetHash(), j, true), prevout.nValue * -1));
-
-                        // remove address from unspent index
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(dest.which(), uint256(addressBytes), input.prevout.hash, input.prevout.n), CAddressUnspentValue()));
-                        spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n), CSpentIndexValue(tx.GetHash(), j, pindex->nHeight, prevout.nValue, dest.which(), uint256(addressBytes))));
-                    }
-                }
-            }
         }
         nValueOut += tx.GetValueOut();
         for (const CTxOut& tx_out : tx.vout) {
@@ -2467,27 +2393,6 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
             control.Add(vChecks);
         }
 
-        if (fAddressIndex) {
-            for (unsigned int k = 0; k < tx.vout.size(); k++) {
-                const CTxOut& out = tx.vout[k];
-                const bool isTxCoinBase = tx.IsCoinBase();
-
-                CTxDestination dest;
-                if (ExtractDestination(out.scriptPubKey, dest)) {
-                    std::vector<unsigned char> bytesID(boost::apply_visitor(DataVisitor(), dest));
-                    if (bytesID.empty()) {
-                        continue;
-                    }
-                    std::vector<unsigned char> addressBytes(32);
-                    std::copy(bytesID.begin(), bytesID.end(), addressBytes.begin());
-                    // record receiving activity
-                    addressIndex.push_back(std::make_pair(CAddressIndexKey(dest.which(), uint256(addressBytes), pindex->nHeight, i, tx.GetHash(), k, false), out.nValue));
-                    // record unspent output
-                    addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(dest.which(), uint256(addressBytes), tx.GetHash(), k), CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight, isTxCoinBase)));
-                }
-            }
-        }
-
         CTxUndo undoDummy;
         if (i > 0) {
             blockundo.vtxundo.push_back(CTxUndo());
@@ -2549,7 +2454,9 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
     // peercoin: track money supply and mint amount info
     pindex->nMint = nActualBlockReward;
     pindex->nMoneySupply = (pindex->pprev ? pindex->pprev->nMoneySupply : 0) + pindex->nMint - nAmountBurned - nFees; // Fees are not added to nMoneySupply because they are already part of the circulating supply
-    pindex->nTreasuryPayment = nTreasuryPayment;
+    if (pindex->IsTreasuryBlock()) {
+        pindex->SetTreasuryPayment(nTreasuryPayment);
+    }
     // LogPrintf("ConnectBlock(): INFO: nValueOut: %s, nValueIn: %s, nFees: %s, nMint: %s\n", FormatMoney(nValueOut), FormatMoney(nValueIn), FormatMoney(nFees), FormatMoney(pindex->nMint));
 
     // peercoin: fees are not collected by miners as in xep
@@ -2567,37 +2474,6 @@ bool CChainState::ConnectBlock(const CBlock& block, BlockValidationState& state,
 
     assert(pindex->phashBlock);
 
-    if (fAddressIndex) {
-        if (!pblocktree->WriteAddressIndex(addressIndex)) {
-            return AbortNode(state, "Failed to write address index");
-        }
-        if (!pblocktree->UpdateAddressUnspentIndex(addressUnspentIndex)) {
-            return AbortNode(state, "Failed to write address unspent index");
-        }
-
-        if (!pblocktree->UpdateSpentIndex(spentIndex))
-            return AbortNode(state, "Failed to write transaction index");
-
-        unsigned int logicalTS = pindex->nTime;
-        unsigned int prevLogicalTS = 0;
-
-        // retrieve logical timestamp of the previous block
-        if (pindex->pprev)
-            if (!pblocktree->ReadTimestampBlockIndex(pindex->pprev->GetBlockHash(), prevLogicalTS))
-                LogPrintf("%s: Failed to read previous block's logical timestamp\n", __func__);
-
-        if (logicalTS <= prevLogicalTS) {
-            logicalTS = prevLogicalTS + 1;
-            LogPrintf("%s: Previous logical timestamp is newer Actual[%d] prevLogical[%d] Logical[%d]\n", __func__, pindex->nTime, prevLogicalTS, logicalTS);
-        }
-
-        if (!pblocktree->WriteTimestampIndex(CTimestampIndexKey(logicalTS, pindex->GetBlockHash())))
-            return AbortNode(state, "Failed to write timestamp index");
-
-        if (!pblocktree->WriteTimestampBlockIndex(CTimestampBlockIndexKey(pindex->GetBlockHash()), CTimestampBlockIndexValue(logicalTS)))
-            return AbortNode(state, "Failed to write blockhash index");
-    }
-
     // add this block to the view's block chain
     view.SetBestBlock(pindex->GetBlockHash());
 
@@ -2735,6 +2611,8 @@ bool CChainState::FlushStateToDisk(
                     if (!pblocktree->WriteBatchSync(vFiles, nLastBlockFile, vBlocks)) {
                         return AbortNode(state, "Failed to write to block index database");
                     }
+                    // the cold data of these entries is read back from the database from now on
+                    g_blockindex_cold.Release(vBlocks);
                 }
                 // Finally remove any pruned files
                 if (fFlushForPrune) {
@@ -2882,7 +2760,7 @@ bool CChainState::DisconnectTip(BlockValidationState& state, const CChainParams&
     {
         CCoinsViewCache view(&CoinsTip());
         assert(view.GetBestBlock() == pindexDelete->GetBlockHash());
-        if (DisconnectBlock(block, pindexDelete, view, false) != DISCONNECT_OK)
+        if (DisconnectBlock(block, pindexDelete, view) != DISCONNECT_OK)
             return error("DisconnectTip(): DisconnectBlock %s failed", pindexDelete->GetBlockHash().ToString());
         bool flushed = view.Flush();
         assert(flushed);
@@ -3612,6 +3490,7 @@ CBlockIndex* BlockManager::AddToBlockIndex(const CBlockHeader& block)
         pindexNew->pprev = (*miPrev).second;
         pindexNew->nHeight = pindexNew->pprev->nHeight + 1;
         pindexNew->BuildSkip();
+        pindexNew->BuildAlgoSkip();
     }
     pindexNew->nTimeMax = (pindexNew->pprev ? std::max(pindexNew->pprev->nTimeMax, pindexNew->nTime) : pindexNew->nTime);
     if (block.IsProofOfStake()) {
@@ -4638,8 +4517,11 @@ bool BlockManager::LoadBlockIndex(
     CBlockTreeDB& blocktree,
     std::set<CBlockIndex*, CBlockIndexWorkComparator>& block_index_candidates)
 {
-    if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }))
+    // peercoin: proof-of-stake hashes are only needed for the stake modifier checksums below
+    std::vector<std::pair<const CBlockIndex*, uint256>> vProofOfStake;
+    if (!blocktree.LoadBlockIndexGuts(consensus_params, [this](const uint256& hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) { return this->InsertBlockIndex(hash); }, vProofOfStake))
         return false;
+    std::sort(vProofOfStake.begin(), vProofOfStake.end());
 
     // Calculate nChainWork
     std::vector<std::pair<int, CBlockIndex*>> vSortedByHeight;
@@ -4677,13 +4559,20 @@ bool BlockManager::LoadBlockIndex(
         }
         if (pindex->nStatus & BLOCK_FAILED_MASK && (!pindexBestInvalid || pindex->nChainWork > pindexBestInvalid->nChainWork))
             pindexBestInvalid = pindex;
-        if (pindex->pprev)
+        if (pindex->pprev) {
             pindex->BuildSkip();
+            pindex->BuildAlgoSkip();
+        }
         if (pindex->IsValid(BLOCK_VALID_TREE) && (pindexBestHeader == nullptr || CBlockIndexWorkComparator()(pindexBestHeader, pindex)))
             pindexBestHeader = pindex;
 
         // peercoin: calculate stake modifier checksum
-        pindex->nStakeModifierChecksum = GetStakeModifierChecksum(pindex);
+        uint256 hashProofOfStake;
+        auto itProofOfStake = std::lower_bound(vProofOfStake.begin(), vProofOfStake.end(), std::pair<const CBlockIndex*, uint256>(pindex, uint256()));
+        if (itProofOfStake != vProofOfStake.end() && itProofOfStake->first == pindex) {
+            hashProofOfStake = itProofOfStake->second;
+        }
+        pindex->nStakeModifierChecksum = GetStakeModifierChecksum(pindex, hashProofOfStake);
         if (::ChainActive().Contains(pindex))
             if (!CheckStakeModifierCheckpoints(pindex->nHeight, pindex->nStakeModifierChecksum))
                 return error("LoadBlockIndex() : Failed stake modifier checkpoint height=%d, modifier=0x%016llx", pindex->nHeight, pindex->nStakeModifier);
@@ -4702,6 +4591,7 @@ void BlockManager::Unload()
     }
 
     m_block_index.clear();
+    g_blockindex_cold.Clear();
 }
 
 bool static LoadBlockIndexDB(const CChainParams& chainparams) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
@@ -4753,9 +4643,6 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams) EXCLUSIVE_LOCKS_RE
     pblocktree->ReadReindexing(fReindexing);
     if (fReindexing) fReindex = true;
 
-    pblocktree->ReadFlag("addressindex", fAddressIndex);
-    LogPrintf("LoadBlockIndexDB(): address index %s\n", fAddressIndex ? "enabled" : "disabled");
-
     return true;
 }
 
@@ -5183,9 +5070,6 @@ bool LoadBlockIndex(const CChainParams& chainparams)
         // needs_init.
 
         LogPrintf("Initializing databases...\n");
-
-        fAddressIndex = gArgs.GetBoolArg("-experimental-xep-balances", DEFAULT_ADDRINDEX);
-        pblocktree->WriteFlag("addressindex", fAddressIndex);
     }
     return true;
 }
@@ -5723,15 +5607,29 @@ static CMainCleanup instance_of_cmaincleanup;
 
 bool GetAddressIndex(uint256 addressHash, int type, std::vector<std::pair<CAddressIndexKey, CAmount>>& addressIndex, int start, int end)
 {
-    if (!fAddressIndex)
+    if (!g_addressindex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressIndex(addressHash, type, addressIndex, start, end))
+    if (!g_addressindex->ReadAddressIndex(addressHash, type, addressIndex, start, end))
         return error("unable to get txids for address");
 
     return true;
 }
 
+bool GetAddressBalance(uint256 addressHash, int type, CAmount& balance, CAmount& received)
+{
+    if (!g_addressindex)
+        return error("address index not enabled");
+
+    CAddressBalance totals;
+    if (!g_addressindex->ReadAddressBalance(addressHash, type, totals))
+        return error("unable to get balance for address");
+
+    balance = totals.nBalance;
+    received = totals.nReceived;
+    return true;
+}
+
 bool GetSpentIndex(CSpentIndexKey& key, CSpentIndexValue& value)
 {
     if (!fAddressIndex)
@@ -5740,7 +5638,7 @@ bool GetSpentIndex(CSpentIndexKey& key, CSpentIndexValue& value)
     if (mempool.getSpentIndex(key, value))
         return true;
 
-    if (!pblocktree->ReadSpentIndex(key, value))
+    if (!g_addressindex || !g_addressindex->ReadSpentIndex(key, value))
         return false;
 
     return true;
@@ -5748,10 +5646,10 @@ bool GetSpentIndex(CSpentIndexKey& key, CSpentIndexValue& value)
 
 bool GetAddressUnspent(uint256 addressHash, int type, std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue>>& unspentOutputs)
 {
-    if (!fAddressIndex)
+    if (!g_addressindex)
         return error("address index not enabled");
 
-    if (!pblocktree->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
+    if (!g_addressindex->ReadAddressUnspentIndex(addressHash, type, unspentOutputs))
         return error("unable to get txids for address");
 
     return true;
@@ -5759,10 +5657,10 @@ bool GetAddressUnspent(uint256 addressHash, int type, std::vector<std::pair<CAdd
 
 bool GetTimestampIndex(const unsigned int& high, const unsigned int& low, const bool fActiveOnly, std::vector<std::pair<uint256, unsigned int>>& hashes)
 {
-    if (!fAddressIndex)
+    if (!g_addressindex)
         return error("Timestamp index not enabled");
 
-    if (!pblocktree->ReadTimestampIndex(high, low, fActiveOnly, hashes))
+    if (!g_addressindex->ReadTimestampIndex(high, low, fActiveOnly, hashes))
         return error("Unable to get hashes for timestamps");
 
     return true;
@@ -5903,13 +5801,5 @@ bool CheckBlockSignature(const CBlock& block)
     if (!pubkey.IsCompressed())
         return error("%s : invalid pubkey %s", __func__, HexStr(pubkey));
 
-    if (CPubKey::GetSigType(block.vchBlockSig[0]) == CPubKey::SigType::SIG_COMPACT) {
-        CPubKey recoveredPubKey;
-        // Only compressed pubkeys are supported and RecoverCompact already checks sig size
-        return ((block.vchBlockSig[0] & 4) &&
-                recoveredPubKey.RecoverCompact(blockHash, block.vchBlockSig, CPubKey::SigFlag::VERSION_SIG_COMPACT) &&
-                recoveredPubKey == pubkey);
-    } else {
-        return pubkey.Verify(blockHash, block.vchBlockSig);
-    }
+    return CachingVerifyBlockSignature(block.vchBlockSig, pubkey, blockHash);
 }
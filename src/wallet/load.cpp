@@ -10,6 +10,7 @@
 #include <util/string.h>
 #include <util/system.h>
 #include <util/translation.h>
+#include <wallet/staking.h>
 #include <wallet/wallet.h>
 
 bool VerifyWallets(interfaces::Chain& chain, const std::vector<std::string>& wallet_files)
@@ -95,10 +96,17 @@ void StartWallets(CScheduler& scheduler)
     scheduler.scheduleEvery(MaybeCompactWalletDB, std::chrono::milliseconds{500});
     scheduler.scheduleEvery(MaybeResendWalletTxs, std::chrono::milliseconds{1000});
     scheduler.scheduleEvery(AbandonOrphanedCoinStakes, std::chrono::seconds{600});
+
+    if (gArgs.GetBoolArg("-staking", DEFAULT_STAKING)) {
+        StartStaking();
+    }
 }
 
 void FlushWallets()
 {
+    // This is the first wallet hook on shutdown, so stop staking while the chainstate and mempool are still around
+    StopStaking();
+
     for (const std::shared_ptr<CWallet>& pwallet : GetWallets()) {
         pwallet->Flush(false);
     }
@@ -106,6 +114,8 @@ void FlushWallets()
 
 void StopWallets()
 {
+    StopStaking();
+
     for (const std::shared_ptr<CWallet>& pwallet : GetWallets()) {
         pwallet->Flush(true);
     }
@@ -28,6 +28,7 @@
 #include <wallet/coincontrol.h>
 #include <wallet/feebumper.h>
 #include <wallet/rpcwallet.h>
+#include <wallet/staking.h>
 #include <wallet/wallet.h>
 #include <wallet/walletdb.h>
 #include <wallet/walletutil.h>
@@ -2428,6 +2429,53 @@ static UniValue getbalances(const JSONRPCRequest& request)
     return balances;
 }
 
+static UniValue getstakinginfo(const JSONRPCRequest& request)
+{
+    RPCHelpMan{"getstakinginfo",
+                "Returns an object containing the state of the stake miner, which stakes with all loaded wallets when started with -staking.\n",
+                {},
+                RPCResult{
+                    RPCResult::Type::OBJ, "", "",
+                    {
+                        {RPCResult::Type::BOOL, "enabled", "whether the stake miner is running"},
+                        {RPCResult::Type::BOOL, "staking", "whether the last time slot was searched for a kernel"},
+                        {RPCResult::Type::STR, "status", /* optional */ true, "why the last time slot was not searched, if it wasn't"},
+                        {RPCResult::Type::NUM, "threads", "the number of kernel search threads"},
+                        {RPCResult::Type::NUM, "candidates", "the number of outputs considered in the last search"},
+                        {RPCResult::Type::STR_AMOUNT, "weight", "the total value of the outputs considered in the last search"},
+                        {RPCResult::Type::NUM_TIME, "searchtime", "the coinstake time searched last, as " + UNIX_EPOCH_TIME},
+                        {RPCResult::Type::NUM, "searchattempts", "the number of kernels hashed by the last search"},
+                        {RPCResult::Type::NUM, "searchduration", "the duration of the last search in milliseconds"},
+                        {RPCResult::Type::NUM, "attemptspersec", "the kernels hashed per second by the last search"},
+                        {RPCResult::Type::NUM, "totalattempts", "the number of kernels hashed since the stake miner was started"},
+                        {RPCResult::Type::NUM, "blocksfound", "the number of blocks staked since the stake miner was started"},
+                    }},
+                RPCExamples{
+                    HelpExampleCli("getstakinginfo", "")
+            + HelpExampleRpc("getstakinginfo", "")
+                },
+    }.Check(request);
+
+    const StakingStats stats = GetStakingStats();
+
+    UniValue obj(UniValue::VOBJ);
+    obj.pushKV("enabled", stats.fEnabled);
+    obj.pushKV("staking", stats.fStaking);
+    if (!stats.strStatus.empty()) {
+        obj.pushKV("status", stats.strStatus);
+    }
+    obj.pushKV("threads", stats.nThreads);
+    obj.pushKV("candidates", (uint64_t)stats.nCandidates);
+    obj.pushKV("weight", ValueFromAmount(stats.nWeight));
+    obj.pushKV("searchtime", stats.nLastSearchTime);
+    obj.pushKV("searchattempts", stats.nLastSearchAttempts);
+    obj.pushKV("searchduration", stats.nLastSearchMicros / 1000);
+    obj.pushKV("attemptspersec", stats.nLastSearchMicros > 0 ? (uint64_t)(stats.nLastSearchAttempts * 1000000.0 / stats.nLastSearchMicros) : 0);
+    obj.pushKV("totalattempts", stats.nTotalAttempts);
+    obj.pushKV("blocksfound", stats.nBlocksFound);
+    return obj;
+}
+
 static UniValue getwalletinfo(const JSONRPCRequest& request)
 {
     std::shared_ptr<CWallet> const wallet = GetWalletForJSONRPCRequest(request);
@@ -4285,6 +4333,7 @@ static const CRPCCommand commands[] =
     { "wallet",             "getrawchangeaddress",              &getrawchangeaddress,           {"address_type"} },
     { "wallet",             "getreceivedbyaddress",             &getreceivedbyaddress,          {"address","minconf"} },
     { "wallet",             "getreceivedbylabel",               &getreceivedbylabel,            {"label","minconf"} },
+    { "wallet",             "getstakinginfo",                   &getstakinginfo,                {} },
     { "wallet",             "gettransaction",                   &gettransaction,                {"txid","include_watchonly","verbose"} },
     { "wallet",             "getunconfirmedbalance",            &getunconfirmedbalance,         {} },
     { "wallet",             "getbalances",                      &getbalances,                   {} },
@@ -399,6 +399,8 @@ public:
     bool HaveWatchOnly(const CScript &dest) const;
     //! Returns whether there are any watch-only things in the wallet
     bool HaveWatchOnly() const;
+    //! Returns the scriptPubKeys this wallet recognizes as its own, used to match block filters
+    std::set<CScript> GetScriptPubKeys() const;
     //! Remove a watch only script from the keystore
     bool RemoveWatchOnly(const CScript &dest);
     bool AddWatchOnly(const CScript& dest, int64_t nCreateTime) EXCLUSIVE_LOCKS_REQUIRED(cs_KeyStore);
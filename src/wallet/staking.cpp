@@ -0,0 +1,434 @@
+// Copyright (c) 2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <wallet/staking.h>
+
+#include <chain.h>
+#include <chainparams.h>
+#include <checkqueue.h>
+#include <consensus/validation.h>
+#include <interfaces/chain.h>
+#include <kernel.h>
+#include <key.h>
+#include <miner.h>
+#include <pow.h>
+#include <pubkey.h>
+#include <script/standard.h>
+#include <sync.h>
+#include <threadinterrupt.h>
+#include <timedata.h>
+#include <tinyformat.h>
+#include <txmempool.h>
+#include <util/memory.h>
+#include <util/system.h>
+#include <util/threadnames.h>
+#include <util/time.h>
+#include <validation.h>
+#include <wallet/wallet.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <boost/thread/thread.hpp>
+
+namespace {
+
+//! Minimum number of candidates worth handing to another search thread
+static const size_t MIN_CANDIDATES_PER_THREAD = 256;
+
+/** Outputs of a wallet eligible for staking, rebuilt once per block */
+struct WalletStakeCandidates
+{
+    uint256 hashTip;
+    std::vector<StakeKernelCandidate> vCandidates;
+    CAmount nWeight{0};
+};
+
+/** A range of candidates, searched by a worker of the kernel search queue */
+class StakeSearchCheck
+{
+private:
+    std::function<void()> m_search;
+
+public:
+    StakeSearchCheck() {}
+    explicit StakeSearchCheck(std::function<void()> search) : m_search(std::move(search)) {}
+
+    bool operator()()
+    {
+        m_search();
+        return true;
+    }
+
+    void swap(StakeSearchCheck& check) { m_search.swap(check.m_search); }
+};
+
+Mutex cs_staking;
+StakingStats g_staking_stats GUARDED_BY(cs_staking);
+
+std::thread g_staking_thread;
+CThreadInterrupt g_staking_interrupt;
+
+//! Kernel search workers, which are started and stopped with the stake miner
+std::unique_ptr<CCheckQueue<StakeSearchCheck>> g_staking_queue;
+boost::thread_group g_staking_workers;
+
+} // namespace
+
+/** Whether the wallet holds the private key of keyid, and its public key is compressed, as block signatures require */
+static bool HaveCompressedKey(const LegacyScriptPubKeyMan& spk_man, const CKeyID& keyid)
+{
+    CPubKey pubkey;
+    return spk_man.HaveKey(keyid) && spk_man.GetPubKey(keyid, pubkey) && pubkey.IsCompressed();
+}
+
+/** Whether the key to sign a block with can be found for a coinstake spending and paying to scriptPubKey (see CheckBlockSignature) */
+static bool IsStakeableScript(const LegacyScriptPubKeyMan& spk_man, const CScript& scriptPubKey)
+{
+    std::vector<std::vector<unsigned char>> vSolutions;
+    switch (Solver(scriptPubKey, vSolutions)) {
+    case txnouttype::TX_PUBKEY:
+        return vSolutions[0].size() == CPubKey::COMPRESSED_SIZE;
+    case txnouttype::TX_PUBKEYHASH:
+    case txnouttype::TX_WITNESS_V0_KEYHASH:
+        return HaveCompressedKey(spk_man, CKeyID(uint160(vSolutions[0])));
+    case txnouttype::TX_SCRIPTHASH: {
+        CScript redeemScript;
+        if (!spk_man.GetCScript(CScriptID(uint160(vSolutions[0])), redeemScript)) return false;
+        return Solver(redeemScript, vSolutions) == txnouttype::TX_WITNESS_V0_KEYHASH && HaveCompressedKey(spk_man, CKeyID(uint160(vSolutions[0])));
+    }
+    default:
+        return false;
+    }
+}
+
+/** Get the key the block signature is checked against, from the signed coinstake (see CheckBlockSignature) */
+static bool GetBlockSigningKey(const LegacyScriptPubKeyMan& spk_man, const CTransaction& txCoinStake, CKey& key)
+{
+    const CTxIn& txin = txCoinStake.vin[0];
+    std::vector<std::vector<unsigned char>> vSolutions;
+    CPubKey pubkey;
+
+    if (Solver(txCoinStake.vout[1].scriptPubKey, vSolutions) == txnouttype::TX_PUBKEY) {
+        pubkey = CPubKey(vSolutions[0]);
+    } else if (txin.scriptWitness.stack.size() == 2) {
+        pubkey = CPubKey(txin.scriptWitness.stack.back());
+    } else {
+        // p2pkh: the public key is the last push of the scriptSig
+        CScript::const_iterator pc = txin.scriptSig.begin();
+        opcodetype opcode;
+        std::vector<unsigned char> vch;
+        while (txin.scriptSig.GetOp(pc, opcode, vch)) {
+            if (pc == txin.scriptSig.end()) pubkey = CPubKey(vch);
+        }
+    }
+
+    return pubkey.IsCompressed() && spk_man.GetKey(pubkey.GetID(), key);
+}
+
+/** Rebuild the staking candidates of a wallet, if the chain tip changed since they were built */
+static void UpdateStakeCandidates(CWallet& wallet, WalletStakeCandidates& candidates)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    auto locked_chain = wallet.chain().lock();
+    LOCK(wallet.cs_wallet);
+
+    const CBlockIndex* pindexTip = ::ChainActive().Tip();
+    if (candidates.hashTip == pindexTip->GetBlockHash()) return;
+
+    candidates.hashTip = pindexTip->GetBlockHash();
+    candidates.vCandidates.clear();
+    candidates.nWeight = 0;
+
+    const LegacyScriptPubKeyMan* spk_man = wallet.GetLegacyScriptPubKeyMan();
+    if (!spk_man) return;
+
+    std::vector<COutput> vCoins;
+    wallet.AvailableCoins(*locked_chain, vCoins, true);
+    for (const COutput& out : vCoins) {
+        if (!out.fSpendable || out.nDepth < std::max(params.nStakeMinDepth, 1)) continue;
+
+        const CTxOut& txout = out.tx->tx->vout[out.i];
+        if (!IsStakeableScript(*spk_man, txout.scriptPubKey)) continue;
+
+        const CBlockIndex* pindexFrom = LookupBlockIndex(out.tx->m_confirm.hashBlock);
+        if (!pindexFrom || !::ChainActive().Contains(pindexFrom)) continue;
+
+        candidates.vCandidates.emplace_back(COutPoint(out.tx->GetHash(), out.i), txout.nValue, pindexFrom);
+        candidates.nWeight += txout.nValue;
+    }
+
+    // Keep outputs of the same block together, so the search looks up their stake modifier only once
+    std::stable_sort(candidates.vCandidates.begin(), candidates.vCandidates.end(),
+        [](const StakeKernelCandidate& a, const StakeKernelCandidate& b) { return a.pindexFrom->nHeight < b.pindexFrom->nHeight; });
+}
+
+/**
+ * Search all candidates for a kernel at nTimeTx, split into contiguous ranges across the kernel search workers.
+ *
+ * The stake modifiers are looked up by the caller, so that the workers don't need cs_main. The search stops
+ * on all workers as soon as one of them finds a kernel.
+ */
+static bool SearchKernel(const std::vector<StakeKernelCandidate>& vCandidates, const std::vector<StakeKernelModifier>& vModifiers, const CBlockIndex* pindexPrev, unsigned int nBits, unsigned int nTimeTx, int nThreads, size_t& nFound, uint64_t& nAttempts)
+{
+    nThreads = std::max(1, std::min<int>(nThreads, vCandidates.size() / MIN_CANDIDATES_PER_THREAD));
+
+    std::atomic<bool> fFound{false};
+    std::vector<size_t> vFound(nThreads, vCandidates.size());
+    std::vector<uint64_t> vAttempts(nThreads, 0);
+    std::vector<StakeSearchCheck> vChecks;
+    for (int nThread = 0; nThread < nThreads; nThread++) {
+        vChecks.emplace_back([&, nThread] {
+            const size_t nBegin = vCandidates.size() * nThread / nThreads;
+            const size_t nEnd = vCandidates.size() * (nThread + 1) / nThreads;
+            uint256 hashProofOfStake;
+            if (SearchStakeKernels(nBits, pindexPrev, vCandidates, vModifiers, nBegin, nEnd, nTimeTx, fFound, vFound[nThread], hashProofOfStake, vAttempts[nThread])) {
+                fFound = true;
+            }
+        });
+    }
+
+    if (nThreads > 1) {
+        CCheckQueueControl<StakeSearchCheck> control(g_staking_queue.get());
+        control.Add(vChecks);
+        control.Wait();
+    } else {
+        vChecks[0]();
+    }
+
+    nAttempts = 0;
+    for (uint64_t n : vAttempts) nAttempts += n;
+    nFound = *std::min_element(vFound.begin(), vFound.end());
+    return nFound < vCandidates.size();
+}
+
+/** Assemble, sign and submit a proof-of-stake block with the given kernel */
+static bool CreateStakeBlock(CWallet& wallet, const StakeKernelCandidate& kernel, const CBlockIndex* pindexPrev, unsigned int nTimeTx)
+{
+    const CChainParams& chainparams = Params();
+
+    // The coinstake pays the kernel back to its own script, the block reward is added by the block assembler
+    CMutableTransaction txCoinStake;
+    {
+        auto locked_chain = wallet.chain().lock();
+        LOCK(wallet.cs_wallet);
+
+        const CWalletTx* wtx = wallet.GetWalletTx(kernel.prevout.hash);
+        if (::ChainActive().Tip() != pindexPrev || !wtx || wallet.IsSpent(kernel.prevout.hash, kernel.prevout.n) || wallet.IsLockedCoin(kernel.prevout.hash, kernel.prevout.n)) {
+            return false;
+        }
+        txCoinStake.vin.emplace_back(kernel.prevout);
+        txCoinStake.vout.emplace_back();
+        txCoinStake.vout[0].SetEmpty();
+        txCoinStake.vout.emplace_back(kernel.nValue, wtx->tx->vout[kernel.prevout.n].scriptPubKey);
+    }
+
+    std::unique_ptr<CBlockTemplate> pblocktemplate = BlockAssembler(::mempool, chainparams).CreateNewBlock(CScript(), &txCoinStake, nTimeTx);
+    CBlock& block = pblocktemplate->block;
+    if (block.hashPrevBlock != pindexPrev->GetBlockHash()) {
+        return false;
+    }
+
+    {
+        auto locked_chain = wallet.chain().lock();
+        LOCK(wallet.cs_wallet);
+
+        CMutableTransaction txSigned(*block.vtx[1]);
+        if (!wallet.SignTransaction(txSigned)) {
+            wallet.WalletLogPrintf("%s: failed to sign coinstake spending %s\n", __func__, kernel.prevout.ToString());
+            return false;
+        }
+        block.vtx[1] = MakeTransactionRef(std::move(txSigned));
+        RegenerateCommitments(block, pindexPrev, chainparams.GetConsensus());
+
+        CKey key;
+        const LegacyScriptPubKeyMan* spk_man = wallet.GetLegacyScriptPubKeyMan();
+        if (!spk_man || !GetBlockSigningKey(*spk_man, *block.vtx[1], key) || !key.Sign(block.GetHash(), block.vchBlockSig)) {
+            wallet.WalletLogPrintf("%s: failed to sign block with kernel %s\n", __func__, kernel.prevout.ToString());
+            return false;
+        }
+    }
+
+    {
+        LOCK(cs_main);
+        if (::ChainActive().Tip() != pindexPrev) {
+            return false;
+        }
+        BlockValidationState state;
+        if (!TestBlockValidity(state, chainparams, block, ::ChainActive().Tip())) {
+            wallet.WalletLogPrintf("%s: TestBlockValidity failed: %s\n", __func__, state.ToString());
+            return false;
+        }
+    }
+
+    std::shared_ptr<const CBlock> shared_pblock = std::make_shared<const CBlock>(block);
+    if (!ProcessNewBlock(chainparams, shared_pblock, true, nullptr)) {
+        wallet.WalletLogPrintf("%s: block %s was not accepted\n", __func__, block.GetHash().ToString());
+        return false;
+    }
+
+    wallet.WalletLogPrintf("%s: new proof-of-stake block %s at height %d, kernel %s\n", __func__, block.GetHash().ToString(), pindexPrev->nHeight + 1, kernel.prevout.ToString());
+    return true;
+}
+
+/**
+ * Searches every time slot for a kernel among the outputs of all loaded wallets.
+ *
+ * The outputs of each wallet are collected once per block. A slot is searched once, as soon as it
+ * begins, so that a found block can be relayed during the rest of the slot.
+ */
+static void ThreadStakeMiner(int nThreads)
+{
+    const Consensus::Params& params = Params().GetConsensus();
+    std::map<std::string, WalletStakeCandidates> mapCandidates;
+    int64_t nLastTimeTx = 0;
+
+    while (!g_staking_interrupt) {
+        const unsigned int nTimeTx = GetAdjustedTime() & ~params.nStakeTimestampMask;
+        if (nTimeTx <= nLastTimeTx) {
+            if (!g_staking_interrupt.sleep_for(std::chrono::milliseconds(250))) break;
+            continue;
+        }
+        nLastTimeTx = nTimeTx;
+
+        std::string strStatus;
+        const CBlockIndex* pindexPrev;
+        unsigned int nBits = 0;
+        {
+            LOCK(cs_main);
+            pindexPrev = ::ChainActive().Tip();
+            if (::ChainstateActive().IsInitialBlockDownload()) {
+                strStatus = "Initial block download in progress";
+            } else if (nTimeTx <= pindexPrev->GetMedianTimePast()) {
+                strStatus = "Waiting for the time slot after the chain tip";
+            } else {
+                CBlockHeader header;
+                header.nVersion = ComputeBlockVersion(pindexPrev, CBlockHeader::AlgoType::ALGO_POS, params);
+                header.nTime = nTimeTx;
+                nBits = GetNextWorkRequired(pindexPrev, &header, params);
+            }
+        }
+
+        const int64_t nTimeStart = GetTimeMicros();
+        size_t nCandidates = 0;
+        CAmount nWeight = 0;
+        uint64_t nAttempts = 0;
+        bool fFound = false;
+
+        if (strStatus.empty()) {
+            const std::vector<std::shared_ptr<CWallet>> vWallets = GetWallets();
+            if (vWallets.empty()) strStatus = "No wallet loaded";
+
+            for (const std::shared_ptr<CWallet>& pwallet : vWallets) {
+                if (pwallet->IsLocked() || pwallet->IsWalletFlagSet(WALLET_FLAG_DISABLE_PRIVATE_KEYS)) {
+                    strStatus = "Wallet is locked";
+                    continue;
+                }
+
+                WalletStakeCandidates& candidates = mapCandidates[pwallet->GetName()];
+                UpdateStakeCandidates(*pwallet, candidates);
+                nCandidates += candidates.vCandidates.size();
+                nWeight += candidates.nWeight;
+
+                std::vector<StakeKernelModifier> vModifiers;
+                {
+                    LOCK(cs_main);
+                    if (::ChainActive().Tip() != pindexPrev) break;
+                    GetStakeKernelModifiers(pindexPrev, candidates.vCandidates, nTimeTx, vModifiers);
+                }
+
+                size_t nFound = 0;
+                uint64_t nWalletAttempts = 0;
+                fFound = SearchKernel(candidates.vCandidates, vModifiers, pindexPrev, nBits, nTimeTx, nThreads, nFound, nWalletAttempts);
+                nAttempts += nWalletAttempts;
+                if (!fFound) continue;
+
+                try {
+                    fFound = CreateStakeBlock(*pwallet, candidates.vCandidates[nFound], pindexPrev, nTimeTx);
+                } catch (const std::runtime_error& e) {
+                    pwallet->WalletLogPrintf("%s: %s\n", __func__, e.what());
+                    fFound = false;
+                }
+                if (fFound) break;
+            }
+
+            // Drop the candidates of unloaded wallets
+            for (auto it = mapCandidates.begin(); it != mapCandidates.end(); ) {
+                bool fLoaded = false;
+                for (const std::shared_ptr<CWallet>& pwallet : vWallets) {
+                    fLoaded |= pwallet->GetName() == it->first;
+                }
+                it = fLoaded ? std::next(it) : mapCandidates.erase(it);
+            }
+        }
+
+        LOCK(cs_staking);
+        g_staking_stats.fStaking = strStatus.empty() || nCandidates > 0;
+        g_staking_stats.strStatus = strStatus;
+        if (nAttempts > 0 || nCandidates > 0) {
+            g_staking_stats.nCandidates = nCandidates;
+            g_staking_stats.nWeight = nWeight;
+            g_staking_stats.nLastSearchTime = nTimeTx;
+            g_staking_stats.nLastSearchAttempts = nAttempts;
+            g_staking_stats.nLastSearchMicros = GetTimeMicros() - nTimeStart;
+            g_staking_stats.nTotalAttempts += nAttempts;
+        }
+        if (fFound) g_staking_stats.nBlocksFound++;
+    }
+}
+
+void StartStaking()
+{
+    if (g_staking_thread.joinable()) return;
+
+    int nThreads = gArgs.GetArg("-stakingthreads", DEFAULT_STAKING_THREADS);
+    if (nThreads <= 0) nThreads = GetNumCores();
+    nThreads = std::max(1, std::min(nThreads, MAX_STAKING_THREADS));
+    LogPrintf("Staking with %d kernel search thread(s)\n", nThreads);
+
+    {
+        LOCK(cs_staking);
+        g_staking_stats = StakingStats();
+        g_staking_stats.fEnabled = true;
+        g_staking_stats.nThreads = nThreads;
+    }
+
+    // The stake miner thread joins the search as the last worker
+    g_staking_queue = MakeUnique<CCheckQueue<StakeSearchCheck>>(1);
+    for (int i = 0; i < nThreads - 1; i++) {
+        g_staking_workers.create_thread([i]() {
+            util::ThreadRename(strprintf("stakesearch.%i", i));
+            g_staking_queue->Thread();
+        });
+    }
+
+    g_staking_interrupt.reset();
+    g_staking_thread = std::thread(&TraceThread<std::function<void()> >, "staker", std::function<void()>(std::bind(&ThreadStakeMiner, nThreads)));
+}
+
+void StopStaking()
+{
+    if (!g_staking_thread.joinable()) return;
+
+    g_staking_interrupt();
+    g_staking_thread.join();
+    g_staking_workers.interrupt_all();
+    g_staking_workers.join_all();
+    g_staking_queue.reset();
+
+    LOCK(cs_staking);
+    g_staking_stats.fEnabled = false;
+    g_staking_stats.fStaking = false;
+}
+
+StakingStats GetStakingStats()
+{
+    LOCK(cs_staking);
+    return g_staking_stats;
+}
@@ -0,0 +1,52 @@
+// Copyright (c) 2022 The Xep Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef XEP_WALLET_STAKING_H
+#define XEP_WALLET_STAKING_H
+
+#include <amount.h>
+
+#include <stdint.h>
+#include <string>
+
+//! Default for -staking
+static const bool DEFAULT_STAKING = false;
+//! -stakingthreads default (0 = one thread per core)
+static const int DEFAULT_STAKING_THREADS = 0;
+//! Maximum number of kernel search threads
+static const int MAX_STAKING_THREADS = 64;
+
+/** Stake miner statistics, as reported by getstakinginfo */
+struct StakingStats
+{
+    //! Whether the stake miner is running
+    bool fEnabled{false};
+    //! Whether the last time slot was searched
+    bool fStaking{false};
+    //! Why the last time slot was not searched, if it wasn't
+    std::string strStatus;
+    //! Number of kernel search threads
+    int nThreads{0};
+    //! Outputs and their value considered in the last search
+    size_t nCandidates{0};
+    CAmount nWeight{0};
+    //! Coinstake time of the last search
+    int64_t nLastSearchTime{0};
+    //! Kernels hashed and time taken by the last search
+    uint64_t nLastSearchAttempts{0};
+    int64_t nLastSearchMicros{0};
+    //! Kernels hashed since start
+    uint64_t nTotalAttempts{0};
+    //! Blocks created since start
+    uint64_t nBlocksFound{0};
+};
+
+/** Start the stake miner, which tries to stake with all loaded wallets */
+void StartStaking();
+/** Stop the stake miner and wait for it to exit */
+void StopStaking();
+/** Get the current stake miner statistics */
+StakingStats GetStakingStats();
+
+#endif // XEP_WALLET_STAKING_H
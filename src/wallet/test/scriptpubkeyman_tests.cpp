@@ -40,4 +40,47 @@ BOOST_AUTO_TEST_CASE(CanProvide)
     BOOST_CHECK(keyman.CanProvide(p2sh_script, data));
 }
 
+// Test LegacyScriptPubKeyMan::GetScriptPubKeys returns exactly the scripts IsMine
+// recognizes, which a rescan matches against block filters.
+BOOST_AUTO_TEST_CASE(GetScriptPubKeys)
+{
+    NodeContext node;
+    std::unique_ptr<interfaces::Chain> chain = interfaces::MakeChain(node);
+    CWallet wallet(chain.get(), WalletLocation(), WalletDatabase::CreateDummy());
+    LegacyScriptPubKeyMan& keyman = *wallet.GetOrCreateLegacyScriptPubKeyMan();
+    LOCK(keyman.cs_KeyStore);
+
+    CKey key;
+    key.MakeNewKey(true);
+    const CPubKey pubkey = key.GetPubKey();
+    BOOST_CHECK(keyman.AddKeyPubKey(key, pubkey));
+
+    // A key alone is paid to by P2PK and P2PKH
+    std::set<CScript> spks = keyman.GetScriptPubKeys();
+    BOOST_CHECK_EQUAL(spks.size(), 2U);
+    BOOST_CHECK(spks.count(GetScriptForRawPubKey(pubkey)));
+    BOOST_CHECK(spks.count(GetScriptForDestination(PKHash(pubkey))));
+
+    // Learning the segwit script of the key adds P2WPKH and P2SH-P2WPKH
+    const CScript p2wpkh = GetScriptForDestination(WitnessV0KeyHash(PKHash(pubkey)));
+    BOOST_CHECK(keyman.AddCScript(p2wpkh));
+    spks = keyman.GetScriptPubKeys();
+    BOOST_CHECK_EQUAL(spks.size(), 4U);
+    BOOST_CHECK(spks.count(p2wpkh));
+    BOOST_CHECK(spks.count(GetScriptForDestination(ScriptHash(p2wpkh))));
+
+    // Watch-only scripts are included as they are
+    CKey watch_key;
+    watch_key.MakeNewKey(true);
+    const CScript watch_script = GetScriptForDestination(PKHash(watch_key.GetPubKey()));
+    BOOST_CHECK(keyman.AddWatchOnly(watch_script, 0));
+    spks = keyman.GetScriptPubKeys();
+    BOOST_CHECK_EQUAL(spks.size(), 5U);
+    BOOST_CHECK(spks.count(watch_script));
+
+    for (const CScript& spk : spks) {
+        BOOST_CHECK(keyman.IsMine(spk) != ISMINE_NO);
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
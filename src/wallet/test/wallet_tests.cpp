@@ -574,6 +574,35 @@ BOOST_FIXTURE_TEST_CASE(ListCoins, ListCoinsTestingSetup)
     BOOST_CHECK_EQUAL(list.begin()->second.size(), 2U);
 }
 
+BOOST_FIXTURE_TEST_CASE(GetAddressBalances, ListCoinsTestingSetup)
+{
+    const CTxDestination coinbase_dest = PKHash(coinbaseKey.GetPubKey());
+
+    // Only the mature coinbase output counts initially.
+    std::map<CTxDestination, CAmount> balances;
+    {
+        auto locked_chain = m_chain->lock();
+        balances = wallet->GetAddressBalances(*locked_chain);
+    }
+    BOOST_CHECK_EQUAL(balances.size(), 1U);
+    BOOST_CHECK_EQUAL(balances[coinbase_dest], 50 * COIN);
+
+    // Spend it. The spent output drops out and the change address appears
+    // next to the coinbase output that matured with the new block.
+    AddTx(CRecipient{GetScriptForRawPubKey({}), 1 * COIN, false /* subtract fee */});
+    {
+        auto locked_chain = m_chain->lock();
+        balances = wallet->GetAddressBalances(*locked_chain);
+    }
+    BOOST_CHECK_EQUAL(balances.size(), 2U);
+    BOOST_CHECK_EQUAL(balances[coinbase_dest], 50 * COIN);
+    CAmount total = 0;
+    for (const auto& balance : balances) {
+        total += balance.second;
+    }
+    BOOST_CHECK_EQUAL(total, wallet->GetAvailableBalance());
+}
+
 BOOST_FIXTURE_TEST_CASE(wallet_disableprivkeys, TestChain100Setup)
 {
     NodeContext node;
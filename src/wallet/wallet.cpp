@@ -5,6 +5,7 @@
 
 #include <wallet/wallet.h>
 
+#include <blockfilter.h>
 #include <chain.h>
 #include <consensus/consensus.h>
 #include <consensus/validation.h>
@@ -49,6 +50,9 @@ const std::map<uint64_t,std::string> WALLET_FLAG_CAVEATS{
 
 static const size_t OUTPUT_GROUP_MAX_ENTRIES = 10;
 
+//! Number of blocks whose filters are tested at once during a rescan
+static const int RESCAN_FILTER_BATCH_SIZE = 1000;
+
 static RecursiveMutex cs_wallets;
 static std::vector<std::shared_ptr<CWallet>> vpwallets GUARDED_BY(cs_wallets);
 static std::list<LoadWalletFn> g_load_wallet_fns GUARDED_BY(cs_wallets);
@@ -531,6 +535,74 @@ void CWallet::AddToSpends(const uint256& wtxid)
         AddToSpends(txin.prevout, wtxid);
 }
 
+bool CWallet::HasConfirmedSpender(const COutPoint& outpoint) const
+{
+    AssertLockHeld(cs_wallet);
+    auto range = mapTxSpends.equal_range(outpoint);
+    for (TxSpends::const_iterator it = range.first; it != range.second; ++it) {
+        auto mit = mapWallet.find(it->second);
+        if (mit != mapWallet.end() && mit->second.isConfirmed()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CWallet::UpdateUnspentOutput(const COutPoint& outpoint)
+{
+    AssertLockHeld(cs_wallet);
+    bool unspent = false;
+    CTxDestination dest = CNoDestination();
+    auto it = mapWallet.find(outpoint.hash);
+    if (it != mapWallet.end() && outpoint.n < it->second.tx->vout.size()) {
+        const CTxOut& txout = it->second.tx->vout[outpoint.n];
+        unspent = IsMine(txout) != ISMINE_NO && !HasConfirmedSpender(outpoint);
+        if (unspent && !ExtractDestination(txout.scriptPubKey, dest)) {
+            dest = CNoDestination();
+        }
+    }
+
+    auto unspent_it = m_unspent_outputs.find(outpoint);
+    if (unspent_it != m_unspent_outputs.end()) {
+        if (unspent && unspent_it->second == dest) return;
+        auto dest_it = m_unspent_outputs_by_dest.find(unspent_it->second);
+        dest_it->second.erase(outpoint);
+        if (dest_it->second.empty()) m_unspent_outputs_by_dest.erase(dest_it);
+        m_unspent_outputs.erase(unspent_it);
+    }
+    if (unspent) {
+        m_unspent_outputs.emplace(outpoint, dest);
+        m_unspent_outputs_by_dest[dest].insert(outpoint);
+    }
+}
+
+void CWallet::UpdateUnspentOutputs(const CWalletTx& wtx)
+{
+    AssertLockHeld(cs_wallet);
+    const uint256& hash = wtx.GetHash();
+    for (unsigned int i = 0; i < wtx.tx->vout.size(); ++i) {
+        UpdateUnspentOutput(COutPoint(hash, i));
+    }
+    if (wtx.IsCoinBase()) return;
+    for (const CTxIn& txin : wtx.tx->vin) {
+        if (mapWallet.count(txin.prevout.hash)) {
+            UpdateUnspentOutput(txin.prevout);
+        }
+    }
+}
+
+void CWallet::RebuildUnspentOutputs()
+{
+    AssertLockHeld(cs_wallet);
+    m_unspent_outputs.clear();
+    m_unspent_outputs_by_dest.clear();
+    for (const auto& entry : mapWallet) {
+        for (unsigned int i = 0; i < entry.second.tx->vout.size(); ++i) {
+            UpdateUnspentOutput(COutPoint(entry.first, i));
+        }
+    }
+}
+
 bool CWallet::EncryptWallet(const SecureString& strWalletPassphrase)
 {
     if (IsCrypted())
@@ -705,6 +777,8 @@ void CWallet::MarkDirty()
         LOCK(cs_wallet);
         for (std::pair<const uint256, CWalletTx>& item : mapWallet)
             item.second.MarkDirty();
+        // imported keys and scripts may have made existing outputs ours
+        RebuildUnspentOutputs();
     }
 }
 
@@ -860,6 +934,10 @@ bool CWallet::AddToWallet(const CWalletTx& wtxIn, bool fFlushOnClose)
     // Break debit/credit balance caches:
     wtx.MarkDirty();
 
+    if (fInsertedNew || fUpdated) {
+        UpdateUnspentOutputs(wtx);
+    }
+
     // Notify UI of new or updated transaction
     NotifyTransactionChanged(this, hash, fInsertedNew ? CT_NEW : CT_UPDATED);
 
@@ -1031,6 +1109,7 @@ bool CWallet::AbandonTransaction(const uint256& hashTx)
             wtx.setAbandoned();
             wtx.MarkDirty();
             batch.WriteTx(wtx);
+            UpdateUnspentOutputs(wtx);
             NotifyTransactionChanged(this, wtx.GetHash(), CT_UPDATED);
             // Iterate over all its outputs, and mark transactions in the wallet that spend them abandoned too
             TxSpends::const_iterator iter = mapTxSpends.lower_bound(COutPoint(now, 0));
@@ -1087,6 +1166,7 @@ void CWallet::MarkConflicted(const uint256& hashBlock, int conflicting_height, c
             wtx.setConflicted();
             wtx.MarkDirty();
             batch.WriteTx(wtx);
+            UpdateUnspentOutputs(wtx);
             // Iterate over all its outputs, and mark transactions in the wallet that spend them conflicted too
             TxSpends::const_iterator iter = mapTxSpends.lower_bound(COutPoint(now, 0));
             while (iter != mapTxSpends.end() && iter->first.hash == now) {
@@ -1692,6 +1772,74 @@ int64_t CWallet::RescanFromTime(int64_t startTime, const WalletRescanReserver& r
     return startTime;
 }
 
+namespace {
+/**
+ * Tests the BIP 158 basic filters of upcoming blocks against the scriptPubKeys of
+ * a wallet, so that a rescan only needs to read the blocks that may contain
+ * transactions of the wallet. Filters are fetched and tested in batches.
+ */
+class FastWalletRescanFilter
+{
+public:
+    FastWalletRescanFilter(const CWallet& wallet, interfaces::Chain& chain) : m_wallet(wallet), m_chain(chain)
+    {
+        UpdateScriptPubKeys();
+    }
+
+    //! Rebuild the element set, to include keys the keypool gained during the rescan.
+    void UpdateScriptPubKeys()
+    {
+        m_filter_set.clear();
+        if (LegacyScriptPubKeyMan* spk_man = m_wallet.GetLegacyScriptPubKeyMan()) {
+            for (const CScript& script : spk_man->GetScriptPubKeys()) {
+                m_filter_set.emplace(script.begin(), script.end());
+            }
+        }
+        // matches of the old set are stale
+        m_matches.clear();
+    }
+
+    //! Returns whether the block may contain transactions of the wallet, or nullopt
+    //! if its filter is not available.
+    Optional<bool> MatchesBlock(int height, const uint256& block_hash, const uint256& stop_block)
+    {
+        if (height < m_start_height || height >= m_start_height + (int)m_matches.size()) {
+            m_start_height = height;
+            m_matches.clear();
+
+            uint256 batch_stop_block;
+            {
+                auto locked_chain = m_chain.lock();
+                Optional<int> tip_height = locked_chain->getHeight();
+                if (!tip_height || *tip_height < height) return nullopt;
+                int stop_height = std::min(*tip_height, height + RESCAN_FILTER_BATCH_SIZE - 1);
+                if (!stop_block.IsNull()) {
+                    Optional<int> last_height = locked_chain->getBlockHeight(stop_block);
+                    if (last_height && *last_height >= height) stop_height = std::min(stop_height, *last_height);
+                }
+                batch_stop_block = locked_chain->getBlockHash(stop_height);
+            }
+            if (!m_chain.blockFiltersMatchAny(BlockFilterType::BASIC, height, batch_stop_block, m_filter_set, m_matches)) {
+                m_matches.clear();
+                return nullopt;
+            }
+        }
+
+        const std::pair<uint256, bool>& match = m_matches[height - m_start_height];
+        // the batch belongs to another chain if a reorg happened since it was fetched
+        if (match.first != block_hash) return nullopt;
+        return match.second;
+    }
+
+private:
+    const CWallet& m_wallet;
+    interfaces::Chain& m_chain;
+    GCSFilter::ElementSet m_filter_set;
+    int m_start_height{0};
+    std::vector<std::pair<uint256, bool>> m_matches;
+};
+} // namespace
+
 /**
  * Scan the block chain (starting in start_block) for transactions
  * from or to us. If fUpdate is true, found transactions that already
@@ -1742,6 +1890,14 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
         progress_end = chain().guessVerificationProgress(stop_block.IsNull() ? tip_hash : stop_block);
     }
     double progress_current = progress_begin;
+
+    // Blocks whose filter matches none of our scriptPubKeys cannot contain our transactions and are not read.
+    std::unique_ptr<FastWalletRescanFilter> fast_rescan_filter;
+    if (gArgs.GetBoolArg("-rescanfilters", DEFAULT_RESCAN_FILTERS) && chain().hasBlockFilterIndex(BlockFilterType::BASIC)) {
+        fast_rescan_filter = MakeUnique<FastWalletRescanFilter>(*this, chain());
+        WalletLogPrintf("Rescan uses the basic block filter index\n");
+    }
+
     while (block_height && !fAbortRescan && !chain().shutdownRequested()) {
         m_scanning_progress = (progress_current - progress_begin) / (progress_end - progress_begin);
         if (*block_height % 100 == 0 && progress_end - progress_begin > 0.0) {
@@ -1752,8 +1908,17 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
             WalletLogPrintf("Still rescanning. At block %d. Progress=%f\n", *block_height, progress_current);
         }
 
+        Optional<bool> matches_block;
+        if (fast_rescan_filter) {
+            matches_block = fast_rescan_filter->MatchesBlock(*block_height, block_hash, stop_block);
+        }
+
         CBlock block;
-        if (chain().findBlock(block_hash, &block) && !block.IsNull()) {
+        if (matches_block && !*matches_block) {
+            // the block filter rules out any transaction of ours, so the block counts as scanned
+            result.last_scanned_block = block_hash;
+            result.last_scanned_height = *block_height;
+        } else if (chain().findBlock(block_hash, &block) && !block.IsNull()) {
             auto locked_chain = chain().lock();
             LOCK(cs_wallet);
             if (!locked_chain->getBlockHeight(block_hash)) {
@@ -1765,9 +1930,14 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(const uint256& start_bloc
                 result.status = ScanResult::FAILURE;
                 break;
             }
+            const size_t wallet_size = mapWallet.size();
             for (size_t posInBlock = 0; posInBlock < block.vtx.size(); ++posInBlock) {
                 SyncTransaction(block.vtx[posInBlock], {CWalletTx::Status::CONFIRMED, *block_height, block_hash, (int)posInBlock}, fUpdate);
             }
+            if (fast_rescan_filter && mapWallet.size() != wallet_size) {
+                // new transactions may have used keypool keys and topped up the keypool
+                fast_rescan_filter->UpdateScriptPubKeys();
+            }
             // scan succeeded, record block as most recent successfully scanned
             result.last_scanned_block = block_hash;
             result.last_scanned_height = *block_height;
@@ -2186,10 +2356,16 @@ void CWallet::AvailableCoins(interfaces::Chain::Lock& locked_chain, std::vector<
     const int max_depth = {coinControl ? coinControl->m_max_depth : DEFAULT_MAX_DEPTH};
 
     std::set<uint256> trusted_parents;
-    for (const auto& entry : mapWallet)
+    auto it = m_unspent_outputs.begin();
+    while (it != m_unspent_outputs.end())
     {
-        const uint256& wtxid = entry.first;
-        const CWalletTx& wtx = entry.second;
+        // Outputs of one transaction are adjacent in the index, so the
+        // per-transaction checks below run once for all of them.
+        const uint256 wtxid = it->first.hash;
+        const auto outputs_begin = it;
+        while (it != m_unspent_outputs.end() && it->first.hash == wtxid) ++it;
+        const auto outputs_end = it;
+        const CWalletTx& wtx = mapWallet.at(wtxid);
 
         if (!locked_chain.checkFinalTx(*wtx.tx)) {
             continue;
@@ -2248,14 +2424,15 @@ void CWallet::AvailableCoins(interfaces::Chain::Lock& locked_chain, std::vector<
             continue;
         }
 
-        for (unsigned int i = 0; i < wtx.tx->vout.size(); i++) {
+        for (auto output = outputs_begin; output != outputs_end; ++output) {
+            const unsigned int i = output->first.n;
             if (wtx.tx->vout[i].nValue < nMinimumAmount || wtx.tx->vout[i].nValue > nMaximumAmount)
                 continue;
 
-            if (coinControl && coinControl->HasSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsSelected(COutPoint(entry.first, i)))
+            if (coinControl && coinControl->HasSelected() && !coinControl->fAllowOtherInputs && !coinControl->IsSelected(output->first))
                 continue;
 
-            if (IsLockedCoin(entry.first, i))
+            if (IsLockedCoin(wtxid, i))
                 continue;
 
             if (IsSpent(wtxid, i))
@@ -3254,6 +3431,9 @@ DBErrors CWallet::LoadWallet(bool& fFirstRunRet)
     if (nLoadWalletRet != DBErrors::LOAD_OK)
         return nLoadWalletRet;
 
+    // transactions are loaded before the keys that make their outputs ours
+    RebuildUnspentOutputs();
+
     return DBErrors::LOAD_OK;
 }
 
@@ -3267,6 +3447,8 @@ DBErrors CWallet::ZapSelectTx(std::vector<uint256>& vHashIn, std::vector<uint256
         mapWallet.erase(it);
         NotifyTransactionChanged(this, hash, CT_DELETED);
     }
+    // the index must not refer to erased transactions, even if an error is returned below
+    RebuildUnspentOutputs();
 
     if (nZapSelectTxRet == DBErrors::NEED_REWRITE)
     {
@@ -3453,34 +3635,32 @@ std::map<CTxDestination, CAmount> CWallet::GetAddressBalances(interfaces::Chain:
     {
         LOCK(cs_wallet);
         std::set<uint256> trusted_parents;
-        for (const auto& walletEntry : mapWallet)
+        // Whether a transaction's outputs count towards the balances, computed once per transaction
+        std::map<uint256, bool> tx_eligible;
+        for (const auto& dest_entry : m_unspent_outputs_by_dest)
         {
-            const CWalletTx& wtx = walletEntry.second;
-
-            if (!wtx.IsTrusted(locked_chain, trusted_parents))
+            if (!IsValidDestination(dest_entry.first))
                 continue;
 
-            if (wtx.IsImmatureCoinBase())
-                continue;
-
-            int nDepth = wtx.GetDepthInMainChain();
-            if (nDepth < (wtx.IsFromMe(ISMINE_ALL) ? 0 : 1))
-                continue;
-
-            for (unsigned int i = 0; i < wtx.tx->vout.size(); i++)
+            CAmount balance = 0;
+            for (const COutPoint& outpoint : dest_entry.second)
             {
-                CTxDestination addr;
-                if (!IsMine(wtx.tx->vout[i]))
-                    continue;
-                if(!ExtractDestination(wtx.tx->vout[i].scriptPubKey, addr))
+                const CWalletTx& wtx = mapWallet.at(outpoint.hash);
+                auto eligible_it = tx_eligible.find(outpoint.hash);
+                if (eligible_it == tx_eligible.end()) {
+                    bool eligible = wtx.IsTrusted(locked_chain, trusted_parents) &&
+                                    !wtx.IsImmatureCoinBase() &&
+                                    wtx.GetDepthInMainChain() >= (wtx.IsFromMe(ISMINE_ALL) ? 0 : 1);
+                    eligible_it = tx_eligible.emplace(outpoint.hash, eligible).first;
+                }
+                if (!eligible_it->second)
                     continue;
 
-                CAmount n = IsSpent(walletEntry.first, i) ? 0 : wtx.tx->vout[i].nValue;
-
-                if (!balances.count(addr))
-                    balances[addr] = 0;
-                balances[addr] += n;
+                if (!IsSpent(outpoint.hash, outpoint.n))
+                    balance += wtx.tx->vout[outpoint.n].nValue;
             }
+            if (balance > 0)
+                balances[dest_entry.first] = balance;
         }
     }
 
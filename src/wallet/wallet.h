@@ -85,6 +85,8 @@ static const unsigned int DEFAULT_TX_CONFIRM_TARGET = 6;
 static const bool DEFAULT_WALLET_RBF = false;
 static const bool DEFAULT_WALLETBROADCAST = true;
 static const bool DEFAULT_DISABLE_WALLET = false;
+//! -rescanfilters default
+static const bool DEFAULT_RESCAN_FILTERS = false;
 //! -maxtxfee default
 constexpr CAmount DEFAULT_TRANSACTION_MAXFEE{10 * COIN}; // 10000 * DEFAULT_TRANSACTION_MINFEE
 //! Discourage users to set fees higher than this amount (in satoshis) per kB
@@ -661,6 +663,21 @@ private:
     void AddToSpends(const COutPoint& outpoint, const uint256& wtxid) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
     void AddToSpends(const uint256& wtxid) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
 
+    /**
+     * Outputs of wallet transactions that are ours and not spent by a confirmed
+     * wallet transaction, keyed by outpoint and grouped by destination. Outputs
+     * spent only by unconfirmed transactions stay in the set and are checked with
+     * IsSpent when queried. Coin listing and balance queries walk these instead of
+     * the whole wallet history.
+     */
+    std::map<COutPoint, CTxDestination> m_unspent_outputs GUARDED_BY(cs_wallet);
+    std::map<CTxDestination, std::set<COutPoint>> m_unspent_outputs_by_dest GUARDED_BY(cs_wallet);
+    bool HasConfirmedSpender(const COutPoint& outpoint) const EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    void UpdateUnspentOutput(const COutPoint& outpoint) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    //! Update the unspent outputs a transaction creates and spends after it was added or its state changed.
+    void UpdateUnspentOutputs(const CWalletTx& wtx) EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+    void RebuildUnspentOutputs() EXCLUSIVE_LOCKS_REQUIRED(cs_wallet);
+
     /**
      * Add a transaction to the wallet, or update it.  pIndex and posInBlock should
      * be set when the transaction was known to be included in a block.  When
@@ -0,0 +1,95 @@
+#!/usr/bin/env python3
+# Copyright (c) 2017-2018 The Xep Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test omni_sendpayouts with chains limited by the memory pool."""
+
+from test_framework.test_framework import XepTestFramework
+from test_framework.util import assert_equal, assert_raises_rpc_error
+
+class OmniSendPayouts(XepTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.setup_clean_chain = True
+        self.extra_args = [['-omniactivationallowsender=any', '-limitancestorcount=5', '-limitdescendantcount=5']]
+
+    def run_test(self):
+        self.log.info("test omni_sendpayouts")
+
+        # Preparing some mature Xeps
+        coinbase_address = self.nodes[0].getnewaddress()
+        self.nodes[0].generatetoaddress(101, coinbase_address)
+
+        # Obtaining a master address to work with
+        address = self.nodes[0].getnewaddress()
+
+        # Funding the address with two coins, enough for two chains of payouts
+        self.nodes[0].sendtoaddress(address, 20)
+        self.nodes[0].sendtoaddress(address, 20)
+        self.nodes[0].generatetoaddress(1, coinbase_address)
+
+        # Participating in the Exodus crowdsale to obtain some OMNI
+        txid = self.nodes[0].sendmany("", {"moneyqMan7uh8FqdCA2BV5yZ8qVrc9ikLP": 10, address: 4})
+        self.nodes[0].generatetoaddress(10, coinbase_address)
+
+        # Checking the transaction was valid.
+        result = self.nodes[0].gettransaction(txid)
+        assert_equal(result['confirmations'], 10)
+
+        # Creating an indivisible test property
+        self.nodes[0].omni_sendissuancefixed(address, 1, 1, 0, "Z_TestCat", "Z_TestSubCat", "Z_IndivisTestProperty", "Z_TestURL", "Z_TestData", "100")
+        self.nodes[0].generatetoaddress(1, coinbase_address)
+
+        # Deactivating send-to-many, so that each payout is sent on its own
+        txid = self.nodes[0].omni_senddeactivation(address, 19)
+        self.nodes[0].generatetoaddress(1, coinbase_address)
+        result = self.nodes[0].omni_gettransaction(txid)
+        assert_equal(result['valid'], True)
+
+        # Sending more payouts than a single chain of unconfirmed transactions may hold
+        receivers = [self.nodes[0].getnewaddress() for x in range(0, 8)]
+        payouts = [{"address": receiver, "propertyid": 3, "amount": "1"} for receiver in receivers]
+        txids = self.nodes[0].omni_sendpayouts(address, payouts)
+        assert_equal(len(txids), 8)
+
+        # Checking all transactions were accepted by the memory pool...
+        mempool = self.nodes[0].getrawmempool()
+        for txid in txids:
+            assert txid in mempool
+
+        self.nodes[0].generatetoaddress(1, coinbase_address)
+
+        # Checking the payouts were valid and received...
+        for txid in txids:
+            result = self.nodes[0].omni_gettransaction(txid)
+            assert_equal(result['valid'], True)
+        for receiver in receivers:
+            result = self.nodes[0].omni_getbalance(receiver, 3)
+            assert_equal(result['balance'], "1")
+
+        # Funding a second address with a single coin and some tokens
+        single_address = self.nodes[0].getnewaddress()
+        self.nodes[0].sendtoaddress(single_address, 20)
+        self.nodes[0].omni_send(address, single_address, 3, "10")
+        self.nodes[0].generatetoaddress(1, coinbase_address)
+
+        # The coin can only fund one chain, so no payout is sent at all
+        receivers = [self.nodes[0].getnewaddress() for x in range(0, 8)]
+        payouts = [{"address": receiver, "propertyid": 3, "amount": "1"} for receiver in receivers]
+        assert_raises_rpc_error(None, None, self.nodes[0].omni_sendpayouts, single_address, payouts)
+        assert_equal(self.nodes[0].getrawmempool(), [])
+
+        # Checking the tokens and the coin are still available...
+        result = self.nodes[0].omni_getbalance(single_address, 3)
+        assert_equal(result['balance'], "10")
+        assert_equal(self.nodes[0].listlockunspent(), [])
+
+        # A batch within the limits is still sent
+        txids = self.nodes[0].omni_sendpayouts(single_address, payouts[:4])
+        assert_equal(len(txids), 4)
+        self.nodes[0].generatetoaddress(1, coinbase_address)
+        result = self.nodes[0].omni_getbalance(single_address, 3)
+        assert_equal(result['balance'], "6")
+
+if __name__ == '__main__':
+    OmniSendPayouts().main()